@@ -0,0 +1,148 @@
+// Microbenchmarks for cabin's own hot paths.  Run via `cabin bench micro`;
+// each case prints one JSON record so CI can diff runs and catch planning
+// regressions instead of waiting for bug reports.
+
+#include "Algos.hpp"
+#include "Builder/NinjaPlan.hpp"
+#include "Manifest.hpp"
+#include "Semver.hpp"
+#include "VersionReq.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/format.h>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <toml.hpp>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Runs `body` repeatedly until `minMs` of wall time has elapsed and
+// reports the mean iteration cost.  Coarse on purpose: regressions we
+// care about are 2x, not 2%.
+void bench(const std::string& name, const std::function<void()>& body,
+           const std::int64_t minMs = 200) {
+  using Clock = std::chrono::steady_clock;
+
+  body(); // warm up caches and lazy state
+
+  std::size_t iterations = 0;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point now = start;
+  while (std::chrono::duration_cast<std::chrono::milliseconds>(now - start)
+             .count()
+         < minMs) {
+    body();
+    ++iterations;
+    now = Clock::now();
+  }
+
+  const std::int64_t totalNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+  const std::int64_t nsPerIter =
+      static_cast<std::int64_t>(totalNs / static_cast<std::int64_t>(iterations));
+  fmt::print("{}\n", nlohmann::json{ { "name", name },
+                                     { "iterations", iterations },
+                                     { "ns_per_iter", nsPerIter } }
+                         .dump());
+}
+
+std::string syntheticManifest(const std::size_t numDeps) {
+  std::string toml = "[package]\n"
+                     "name = \"bench\"\n"
+                     "version = \"0.1.0\"\n"
+                     "edition = \"23\"\n\n"
+                     "[dependencies]\n";
+  for (std::size_t i = 0; i < numDeps; ++i) {
+    toml += fmt::format("dep{} = {{version = \">={}.0 && <{}.0\", "
+                        "system = true}}\n",
+                        i, i % 9, (i % 9) + 1);
+  }
+  return toml;
+}
+
+} // namespace
+
+int main() {
+  // levDistance / findSimilarStr: the typo-suggestion path taken on
+  // every unknown CLI argument and manifest key.
+  const std::vector<std::string> candidateStore = [] {
+    std::vector<std::string> names;
+    names.reserve(1000);
+    for (std::size_t i = 0; i < 1000; ++i) {
+      names.push_back(fmt::format("candidate-option-{}", i));
+    }
+    return names;
+  }();
+  const std::vector<std::string_view> candidates(candidateStore.begin(),
+                                                 candidateStore.end());
+
+  bench("levDistance", [] {
+    (void)cabin::levDistance("incremental-compilation-cache",
+                             "incrementel-compilation-cach");
+  });
+  bench("findSimilarStr/1000", [&] {
+    (void)cabin::findSimilarStr("candidate-optoin-500", candidates);
+  });
+
+  // VersionReq::satisfiedBy: dependency resolution evaluates this per
+  // candidate version.
+  const VersionReq req = VersionReq::parse(">=1.2.3 && <2.0.0").unwrap();
+  const std::vector<Version> versions = [] {
+    std::vector<Version> vers;
+    vers.reserve(1000);
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      vers.push_back(
+          Version::parse(fmt::format("1.{}.{}", i % 50, i % 10)).unwrap());
+    }
+    return vers;
+  }();
+  bench("VersionReq::satisfiedBy/1000", [&] {
+    std::size_t matched = 0;
+    for (const Version& ver : versions) {
+      matched += req.satisfiedBy(ver) ? 1 : 0;
+    }
+    (void)matched;
+  });
+
+  // Manifest::tryFromToml over a dependency-heavy manifest; parsed once
+  // so the TOML reader is measured separately from manifest validation.
+  const toml::value manifestData = toml::parse_str(syntheticManifest(100));
+  bench("Manifest::tryFromToml/100deps", [&] {
+    (void)cabin::Manifest::tryFromToml(manifestData, "cabin.toml").unwrap();
+  });
+  bench("toml::parse_str/100deps", [toml = syntheticManifest(100)] {
+    (void)toml::parse_str(toml);
+  });
+
+  // NinjaPlan::writeFiles with a 5,000-edge plan: first write renders and
+  // writes everything; the rewrite measures the no-op replan path, which
+  // must stay cheap for `cabin watch`.
+  const fs::path planDir =
+      fs::temp_directory_path() / "cabin-bench-ninja-plan";
+  fs::create_directories(planDir);
+  cabin::NinjaPlan plan(planDir);
+  for (std::size_t i = 0; i < 5000; ++i) {
+    cabin::NinjaEdge edge;
+    edge.outputs = { fmt::format("src/file{}.o", i) };
+    edge.rule = "cxx_compile";
+    edge.inputs = { fmt::format("src/file{}.cc", i) };
+    edge.implicitInputs = { "include/common.hpp",
+                            fmt::format("include/file{}.hpp", i % 500) };
+    edge.bindings.emplace_back("out_dir", "src");
+    plan.addEdge(std::move(edge));
+  }
+  cabin::NinjaToolchain toolchain;
+  toolchain.cxx = "c++";
+  bench("NinjaPlan::writeFiles/5000-edges",
+        [&] { plan.writeFiles(toolchain); });
+  fs::remove_all(planDir);
+
+  return 0;
+}
@@ -3,16 +3,41 @@
 #include "Command.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <limits>
 #include <optional>
 #include <rs/result.hpp>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace cabin {
 
+/// An immutable string set sorted at compile time.  Membership is a
+/// binary search over string_views -- no hashing, no heap-allocated
+/// keys -- which matters when a lookup sits on a per-file path like
+/// discovery classifying every entry of a large vendored tree.
+/// Duplicate entries are tolerated.
+template <std::size_t N>
+class StaticStringSet {
+public:
+  consteval explicit StaticStringSet(
+      std::array<std::string_view, N> entries) noexcept
+      : entries_(entries) {
+    std::ranges::sort(entries_);
+  }
+
+  constexpr bool contains(const std::string_view value) const noexcept {
+    return std::ranges::binary_search(entries_, value);
+  }
+
+private:
+  std::array<std::string_view, N> entries_;
+};
+
 std::string toMacroName(std::string_view name) noexcept;
 std::string replaceAll(std::string str, std::string_view from,
                        std::string_view to) noexcept;
@@ -27,41 +52,52 @@ constexpr char toLower(char c) noexcept {
 }
 
 // ref: https://wandbox.org/permlink/zRjT41alOHdwcf00
-constexpr std::size_t levDistance(const std::string_view lhs,
-                                  const std::string_view rhs) noexcept {
-  const std::size_t lhsSize = lhs.size();
-  const std::size_t rhsSize = rhs.size();
-
-  // for all i and j, d[i,j] will hold the Levenshtein distance between the
-  // first i characters of s and the first j characters of t
-  std::vector<std::vector<std::size_t>> dist(
-      lhsSize + 1, std::vector<std::size_t>(rhsSize + 1));
-  dist[0][0] = 0;
-
-  // source prefixes can be transformed into empty string by dropping all
-  // characters
-  for (std::size_t i = 1; i <= lhsSize; ++i) {
-    dist[i][0] = i;
+//
+// Two rolling rows of the DP matrix instead of the full (n+1)x(m+1)
+// allocation.  When `maxDist` is given, a row whose minimum already
+// exceeds it aborts early (row minima never decrease); the return value
+// is then only guaranteed to be greater than `maxDist`, not exact.
+constexpr std::size_t
+levDistance(std::string_view lhs, std::string_view rhs,
+            const std::size_t maxDist
+            = std::numeric_limits<std::size_t>::max()) noexcept {
+  // Keep the rows sized by the shorter string.
+  if (lhs.size() < rhs.size()) {
+    std::swap(lhs, rhs);
+  }
+
+  // The length difference is a lower bound on the distance.
+  if (lhs.size() - rhs.size() > maxDist) {
+    return lhs.size() - rhs.size();
   }
 
-  // target prefixes can be reached from empty source prefix by inserting every
-  // character
-  for (std::size_t j = 1; j <= rhsSize; ++j) {
-    dist[0][j] = j;
+  // prev[j] holds the distance between the first i-1 characters of lhs
+  // and the first j characters of rhs; cur[j] the same for i characters.
+  std::vector<std::size_t> prev(rhs.size() + 1);
+  std::vector<std::size_t> cur(rhs.size() + 1);
+  for (std::size_t j = 0; j <= rhs.size(); ++j) {
+    prev[j] = j; // inserting every character into an empty prefix
   }
 
-  for (std::size_t i = 1; i <= lhsSize; ++i) {
-    for (std::size_t j = 1; j <= rhsSize; ++j) {
+  for (std::size_t i = 1; i <= lhs.size(); ++i) {
+    cur[0] = i; // dropping every character of the prefix
+    std::size_t rowMin = cur[0];
+    for (std::size_t j = 1; j <= rhs.size(); ++j) {
       const std::size_t substCost = lhs[i - 1] == rhs[j - 1] ? 0 : 1;
-      dist[i][j] = std::min({
-          dist[i - 1][j] + 1,            // deletion
-          dist[i][j - 1] + 1,            // insertion
-          dist[i - 1][j - 1] + substCost // substitution
+      cur[j] = std::min({
+          prev[j] + 1,            // deletion
+          cur[j - 1] + 1,         // insertion
+          prev[j - 1] + substCost // substitution
       });
+      rowMin = std::min(rowMin, cur[j]);
+    }
+    if (rowMin > maxDist) {
+      return rowMin; // hopeless: later rows can only be worse
     }
+    std::swap(prev, cur);
   }
 
-  return dist[lhsSize][rhsSize];
+  return prev[rhs.size()];
 }
 
 constexpr bool equalsInsensitive(const std::string_view lhs,
@@ -100,7 +136,7 @@ findSimilarStr(std::string_view lhs,
   std::optional<std::pair<std::string_view, std::size_t>> similarStr =
       std::nullopt;
   for (const std::string_view str : candidates) {
-    const std::size_t curDist = levDistance(lhs, str);
+    const std::size_t curDist = levDistance(lhs, str, maxDist);
     if (curDist <= maxDist) {
       // The first similar string found || More similar string found
       if (!similarStr.has_value() || curDist < similarStr->second) {
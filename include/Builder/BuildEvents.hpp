@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Newline-delimited JSON build events for tooling
+/// (`--message-format=json`): one compact JSON object per line on
+/// stdout, while human diagnostics stay on stderr, so orchestrators can
+/// consume builds without scraping display output.  Every emitter
+/// returns immediately when the stream is not enabled, so the hot path
+/// costs one branch by default.
+class BuildEvents {
+public:
+  static void enable() noexcept;
+  static bool enabled() noexcept;
+
+  /// `{"reason":"edge-started","rule":…,"target":…}`
+  static void edgeStarted(std::string_view rule,
+                          std::string_view target) noexcept;
+  /// `{"reason":"edge-finished","rule":…,"target":…,"duration_ms":…,
+  ///   "success":…,"cached":…}`
+  static void edgeFinished(std::string_view rule, std::string_view target,
+                           std::int64_t durationMs, bool success,
+                           bool cached) noexcept;
+  /// `{"reason":"artifact","path":…}` — an executable or library landed.
+  static void artifact(const fs::path& path) noexcept;
+  /// `{"reason":"build-finished","success":…}`
+  static void buildFinished(bool success) noexcept;
+};
+
+} // namespace cabin
@@ -3,13 +3,17 @@
 #include "Builder/BuildProfile.hpp"
 #include "Builder/Compiler.hpp"
 #include "Builder/NinjaPlan.hpp"
+#include "Builder/PathTable.hpp"
 #include "Builder/Project.hpp"
+#include "Builder/ScanCache.hpp"
 #include "Builder/SourceLayout.hpp"
 #include "Command.hpp"
 #include "Manifest.hpp"
 
 #include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <rs/result.hpp>
 #include <string>
@@ -34,25 +38,71 @@ public:
     TestKind kind = TestKind::Unit;
   };
 
-  static rs::Result<BuildGraph> create(const Manifest& manifest,
-                                       const BuildProfile& buildProfile);
+  struct BenchTarget {
+    std::string ninjaTarget;
+    std::string sourcePath;
+  };
+
+  static rs::Result<BuildGraph>
+  create(const Manifest& manifest, const BuildProfile& buildProfile,
+         const std::optional<ProfileOverride>& profileOverride = {});
 
   const fs::path& outBasePath() const { return outBasePath_; }
   const Manifest& manifest() const { return project.manifest; }
+  /// The effective profile, with any workspace override applied.
+  const Profile& profile() const { return project.profile; }
   const BuildProfile& buildProfile() const { return buildProfile_; }
 
   bool hasBinaryTarget() const { return hasBinaryTarget_; }
+  const std::string& cxxPath() const { return compiler.cxx; }
   bool hasLibraryTarget() const { return hasLibraryTarget_; }
   const std::string& libraryName() const { return libName; }
   const std::vector<TestTarget>& testTargets() const { return testTargets_; }
+  const std::vector<BenchTarget>& benchTargets() const {
+    return benchTargets_;
+  }
 
   rs::Result<void> installDeps(bool includeDevDeps, bool suppressDepDiag);
+  /// Walks the first-party source roots and caches the listings for the
+  /// next plan.  Touches no dependency state, so the scheduler runs it
+  /// concurrently with `installDeps` to overlap directory IO with
+  /// network-bound clones and downloads.  Listings are consumed once;
+  /// replans walk the tree again.
+  void prediscoverSources();
   void enableCoverage();
+  void enableBenches() { benchesEnabled = true; }
+  void setUnityGroupSize(std::size_t groupSize) { unityGroupSize = groupSize; }
+  /// When set, parallel scans keep going after a failure and aggregate
+  /// every error; by default they cancel as soon as one TU fails so the
+  /// first error reaches the developer without waiting for the rest.
+  void setKeepGoing(bool keepGoing) { keepGoing_ = keepGoing; }
+  /// Opt-in explicit-instantiation coordination (see TemplateDedup).
+  void enableTemplateDedup() { templateDedup_ = true; }
+  /// Compile every TU with -ftime-trace so the per-object traces can be
+  /// merged into one report after the build (see TimeTraceReport).
+  void enableTimeTrace() { timeTrace_ = true; }
+  /// Combine every unit-test TU into one runner binary instead of one
+  /// binary per file: each TU's `main` is renamed to a unique symbol and
+  /// a generated dispatcher forks once per file, so one link replaces
+  /// one per test while runs keep per-file process isolation.
+  void enableCombinedTests() { combinedTests_ = true; }
+  bool timeTracePending() const { return timeTrace_; }
+  /// True when the last plan was a dedup calibration pass whose time
+  /// traces should be harvested once the build finishes.
+  bool dedupCalibrationPending() const { return dedupCalibration_; }
   rs::Result<void> plan(bool logAnalysis = true);
   rs::Result<void> writeBuildFilesIfNeeded() const;
   rs::Result<void> generateCompdb() const;
 
+  /// True if the stat journal from the last plan still matches the source
+  /// tree (one stat per journaled path).
+  bool sourceTreeUnchanged() const;
+
   rs::Result<bool> needsBuild(const std::vector<std::string>& targets) const;
+  /// The subset of `targets` whose dependency closure is out of date
+  /// (all of them under the ninja fallback, which cannot tell).
+  rs::Result<std::vector<std::string>>
+  affectedTargets(const std::vector<std::string>& targets) const;
   Command ninjaCommand(bool dryRun = false) const;
   rs::Result<ExitStatus> buildTargets(const std::vector<std::string>& targets,
                                       std::string_view displayName) const;
@@ -60,7 +110,7 @@ public:
 private:
   struct CompileUnit {
     std::string source;
-    std::unordered_set<std::string> dependencies;
+    std::vector<std::uint32_t> dependencies; // interned via pathTable
     bool isTest = false;
   };
 
@@ -76,39 +126,107 @@ private:
   BuildGraph(BuildProfile buildProfile, std::string libName, Project project,
              Compiler compiler);
 
+  std::vector<fs::path> watchedPaths() const;
   bool isUpToDate(std::string_view fileName) const;
   std::string mapHeaderToObj(const fs::path& headerPath) const;
 
   void registerCompileUnit(const std::string& objTarget,
                            const std::string& sourceFile,
                            const std::unordered_set<std::string>& dependencies,
-                           bool isTest);
+                           bool isTest,
+                           std::string_view extraCompileFlags = {});
 
   rs::Result<std::string> runMM(const std::string& sourceFile,
                                 bool isTest = false) const;
-  rs::Result<bool> containsTestCode(const std::string& sourceFile) const;
+  rs::Result<std::pair<std::string, std::unordered_set<std::string>>>
+  scanDeps(const fs::path& sourceFilePath, bool isTest);
+  rs::Result<bool> containsTestCode(const std::string& sourceFile);
+
+  rs::Result<void> prescanSources(const std::vector<fs::path>& sourceFilePaths,
+                                  bool isTest);
+
+  rs::Result<void> planModules(const fs::path& srcDir, const fs::path& libDir);
 
+  struct ScannedUnit {
+    std::string objTarget; // relative to outBasePath_
+    std::string source;
+    std::unordered_set<std::string> dependencies;
+  };
+
+  /// The pure half of processSrc: scans dependencies and derives the
+  /// object target without touching any plan state, so parallel workers
+  /// can run it lock-free.
+  rs::Result<ScannedUnit> scanSrc(const fs::path& sourceFilePath,
+                                  const SourceRoot& root);
   rs::Result<void> processSrc(const fs::path& sourceFilePath,
                               const SourceRoot& root,
-                              std::unordered_set<std::string>& buildObjTargets,
-                              tbb::spin_mutex* mtx = nullptr);
+                              std::unordered_set<std::string>& buildObjTargets);
   rs::Result<std::unordered_set<std::string>>
   processSources(const std::vector<fs::path>& sourceFilePaths,
                  const SourceRoot& root);
+  rs::Result<std::unordered_set<std::string>>
+  processSourcesUnity(const std::vector<fs::path>& sourceFilePaths,
+                      const SourceRoot& root);
+
+  /// Object/binary placement for a unit test source under `unit/`:
+  /// the relative base directory and whether the source sits in src/.
+  rs::Result<std::pair<fs::path, bool>>
+  unitTestRelBase(const fs::path& sourceFilePath);
 
   rs::Result<std::optional<TestTarget>>
   processUnittestSrc(const fs::path& sourceFilePath,
                      tbb::spin_mutex* mtx = nullptr);
+  /// The combined-runner alternative to per-file processUnittestSrc:
+  /// plans every test TU with a renamed `main`, generates the forking
+  /// dispatcher TU, and emits one link edge for the whole set.
+  rs::Result<std::optional<TestTarget>>
+  planCombinedUnitTests(const std::vector<fs::path>& sourceFilePaths);
   rs::Result<std::optional<TestTarget>>
   processIntegrationTestSrc(const fs::path& sourceFilePath,
                             tbb::spin_mutex* mtx = nullptr);
 
+  rs::Result<std::optional<BenchTarget>>
+  processBenchSrc(const fs::path& sourceFilePath);
+
+  const SourceClassifier& classifier();
+
+  std::vector<std::uint32_t>
+  internPaths(const std::unordered_set<std::string>& paths);
+
   void collectBinDepObjs( // NOLINT(misc-no-recursion)
       std::unordered_set<std::string>& deps, std::string_view sourceFileName,
-      const std::unordered_set<std::string>& objTargetDeps,
+      const std::vector<std::uint32_t>& objTargetDeps,
       const std::unordered_set<std::string>& buildObjTargets) const;
 
+  std::vector<fs::path> sourceFilesUnder(const fs::path& dir);
+
+  /// Appends what an executable link needs from the library target: the
+  /// shared library itself, or the exact object list for static
+  /// libraries so links stop waiting on the archive serialization
+  /// point.  Objects whose stem matches `underTestStem` are skipped
+  /// (the test's own TU replaces them); `linkSeen` deduplicates when
+  /// provided.
+  void appendLibraryObjects(std::vector<std::string>& linkInputs,
+                            std::string_view underTestStem,
+                            std::unordered_set<std::string>* linkSeen) const;
+
+  /// Rewrites link edges whose whole input closure is attributed with a
+  /// per-edge LIBS binding containing only the libraries some input
+  /// actually consumed; edges with any unattributed input keep the full
+  /// global set.
+  void pruneLinkLibs();
+
+  /// Rewrites compile edges to carry only their direct includes plus one
+  /// shared per-header alias node, replacing the per-TU flat `-MM`
+  /// closure (see HeaderGraph).  TUs whose lexical include walk diverges
+  /// from the scan keep the flat listing.
+  void reduceHeaderEdges();
+
   rs::Result<void> configure();
+  bool buildWithNinja() const;
+  bool restoreFromPlanCache();
+  void savePlanCache() const;
+  NinjaToolchain makeToolchain() const;
   void writeBuildFiles() const;
 
   fs::path outBasePath_;
@@ -120,11 +238,66 @@ private:
   bool hasBinaryTarget_{ false };
   bool hasLibraryTarget_{ false };
 
-  std::unordered_map<std::string, CompileUnit> compileUnits;
+  PathTable pathTable;
+  // Monotonic arena for the plan-phase unit map: its nodes and buckets
+  // are all freed together when the graph goes away, so they
+  // bump-allocate from large blocks instead of one malloc per node.
+  // Heap-owned so the resource address stays stable when the graph is
+  // moved out of create().  (Dependency path sets are interned through
+  // pathTable, and ninja edges render into one buffer at write time, so
+  // the unit map is the remaining freed-together structure.)
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> planArena_ =
+      std::make_unique<std::pmr::monotonic_buffer_resource>();
+  std::pmr::unordered_map<std::string, CompileUnit> compileUnits{
+    planArena_.get()
+  };
   std::vector<TestTarget> testTargets_;
+  std::vector<BenchTarget> benchTargets_;
+  bool benchesEnabled = false;
   std::unordered_set<std::string> srcObjectTargets;
   std::unordered_set<std::string> libSupportObjects;
+  std::vector<std::string> modulePcmTargets_; // sorted; empty without modules
+  std::unordered_set<std::string> srcModuleObjects;
+  std::unordered_set<std::string> libModuleObjects;
+  std::vector<std::string> libObjectList_; // sorted; the archive's inputs
+
+  /// Link-what-you-use attribution, recorded by installDeps: each
+  /// dependency's install-time include roots and the libraries it adds.
+  struct DepLinkUse {
+    std::vector<std::string> includeDirs; // normalized, trailing '/'
+    std::vector<std::string> libs;        // library names (no -l)
+  };
+  std::vector<DepLinkUse> depLinkUses_;
+  /// objTarget → bitmask over depLinkUses_ of the dependencies whose
+  /// headers the TU's scan actually touched.
+  std::unordered_map<std::string, std::uint64_t> tuDepLibMask_;
   std::string archiver = "ar";
+  std::string archiveFlags = "rcs";
+  std::string pchTarget; // empty unless the profile requests a PCH
+  std::size_t unityGroupSize = 0; // 0: normal per-file compilation
+  bool keepGoing_ = false; // scan every TU even after one fails
+  bool combinedTests_ = false; // one runner binary for all unit tests
+  bool templateDedup_ = false;
+  bool dedupCalibration_ = false;
+  bool timeTrace_ = false;
+  std::string dedupObject_; // empty unless a dedup TU joined the plan
+  bool splitDwarf_ = false; // profile split-debuginfo: .dwo side outputs
+
+  ScanCache scanCache;
+  std::string scanFlagsDigest;
+
+  /// Source listings prefetched by prediscoverSources, keyed by
+  /// directory; sourceFilesUnder moves each entry out on first use.
+  std::unordered_map<std::string, std::vector<fs::path>> sourceListings_;
+
+  /// Built on first use; canonicalizes the src/lib roots once per plan.
+  std::optional<SourceClassifier> sourceClassifier_;
+
+  /// mapHeaderToObj state, cached for the graph's lifetime: the relative
+  /// object base is constant, and header→object mappings recur across the
+  /// whole collectBinDepObjs recursion (keyed by interned path id).
+  mutable std::optional<fs::path> headerObjBase_;
+  mutable std::unordered_map<std::uint32_t, std::string> headerObjMemo_;
 
   std::string cxxFlags;
   std::string defines;
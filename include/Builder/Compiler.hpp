@@ -6,7 +6,9 @@
 #include <filesystem>
 #include <fmt/format.h>
 #include <fmt/std.h>
+#include <optional>
 #include <rs/result.hpp>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -93,6 +95,14 @@ struct CompilerOpts {
   void merge(const CompilerOpts& other) noexcept;
 };
 
+/// Module-level dependency info for one translation unit, in P1689 terms:
+/// the logical name it provides (empty for non-interface units) and the
+/// logical names it imports.
+struct ModuleDeps {
+  std::string provides;
+  std::vector<std::string> imports;
+};
+
 class Compiler {
 public:
   const std::string cxx;
@@ -105,9 +115,32 @@ public:
                          const std::string& objFile) const;
   Command makeMMCmd(const CompilerOpts& opts,
                     const std::string& sourceFile) const;
+  Command makeMMCmd(const CompilerOpts& opts,
+                    std::span<const std::string> sourceFiles) const;
   Command makePreprocessCmd(const CompilerOpts& opts,
                             const std::string& sourceFile) const;
   std::string detectArchiver(bool useLTO) const;
+  static bool archiverSupportsThinArchives(const std::string& archiver);
+
+  /// Whether the configured compiler driver is a clang variant, probed
+  /// from its predefined-macro dump (binary name as the fallback when it
+  /// cannot run); decides e.g. the coverage instrumentation kind.
+  bool isClang() const;
+
+  /// Name for `-fuse-ld=` of the fastest linker installed (mold, lld, or
+  /// gold, in that order), honoring $CABIN_LINKER; nullopt leaves the
+  /// driver's default.
+  std::optional<std::string> detectFasterLinker() const;
+  /// Appends link-time flags derived from the environment: the faster
+  /// linker (unless the user already passed -fuse-ld=) and, for GCC with
+  /// LTO, a parallel LTO job count.
+  void addLinkFlags(CompilerOpts& opts, bool useLTO) const;
+
+  /// Scans `sourceFile` for module provides/imports, preferring
+  /// clang-scan-deps' P1689 output and falling back to a lexical scan of
+  /// the module declarations when the tool is unavailable.
+  rs::Result<ModuleDeps> scanModuleDeps(const CompilerOpts& opts,
+                                        const std::string& sourceFile) const;
 
 private:
   explicit Compiler(std::string cxx) noexcept : cxx(std::move(cxx)) {}
@@ -19,7 +19,9 @@ public:
 
   rs::Result<void> resolve();
   rs::Result<BuildGraph>
-  computeBuildGraph(const BuildProfile& buildProfile) const;
+  computeBuildGraph(const BuildProfile& buildProfile,
+                    const std::optional<ProfileOverride>& profileOverride = {})
+      const;
 
 private:
   fs::path rootPath;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Maps build outputs to a digest of (command line + input contents),
+/// persisted under `cabin-out/<profile>/`.  Lets the executor skip edges
+/// whose inputs are byte-identical even when mtimes changed (e.g. fresh CI
+/// checkouts).
+class DigestDb {
+public:
+  static constexpr const char* FILE_NAME = "digest-db.json";
+
+  void load(const fs::path& outBasePath);
+  void save(const fs::path& outBasePath) const;
+
+  std::optional<std::string> lookup(const std::string& output) const;
+  void update(const std::string& output, std::string digest);
+
+private:
+  mutable tbb::spin_mutex mtx;
+  std::unordered_map<std::string, std::string> entries;
+};
+
+} // namespace cabin
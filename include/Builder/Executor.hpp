@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Builder/DigestDb.hpp"
+#include "Builder/NinjaPlan.hpp"
+#include "Builder/ObjectCache.hpp"
+#include "Command.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <rs/result.hpp>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// In-process executor for the plan held in `NinjaPlan`.  Consumes the edge
+/// list directly — no serialize/reparse round trip through build.ninja —
+/// schedules out-of-date edges topologically, and runs them in parallel
+/// waves bounded by `getParallelism()`.  The external ninja binary remains
+/// available as a fallback (CABIN_BUILD_WITH_NINJA=1).
+class Executor {
+public:
+  Executor(std::span<const NinjaEdge> edges, NinjaToolchain toolchain,
+           fs::path workDir);
+
+  /// True if any edge in the closure of `targets` is out of date.
+  rs::Result<bool> needsBuild(const std::vector<std::string>& targets) const;
+
+  /// The subset of `targets` whose dependency closure contains an
+  /// out-of-date edge; the rest cannot have changed behavior.
+  rs::Result<std::vector<std::string>>
+  affected(const std::vector<std::string>& targets) const;
+
+  /// Builds `targets`, returning the exit status of the first failing
+  /// command (or success).
+  rs::Result<ExitStatus> build(const std::vector<std::string>& targets) const;
+
+  /// Renders the shell command for `edge` from the rule templates that
+  /// NinjaPlan::writeRulesNinja emits.
+  static std::string renderCommand(const NinjaEdge& edge,
+                                   const NinjaToolchain& toolchain);
+
+private:
+  /// Indices of out-of-date edges reachable from `targets`, in topological
+  /// order (dependencies first).
+  rs::Result<std::vector<std::size_t>>
+  schedule(const std::vector<std::string>& targets) const;
+
+  rs::Result<ExitStatus> runEdge(const NinjaEdge& edge) const;
+
+  /// For a static-library edge whose archive already exists with the same
+  /// member list, renders an `ar` command that replaces only the changed
+  /// members; empty when the full rule command must run instead.
+  std::string renderArchiveCommand(const NinjaEdge& edge) const;
+
+  /// Digest of the edge's command line and the contents of all its inputs.
+  std::string edgeDigest(const NinjaEdge& edge) const;
+
+  /// Like edgeDigest but over the explicit inputs only; unchanged when a
+  /// compile edge was scheduled purely because a header it includes moved.
+  std::string sourceDigest(const NinjaEdge& edge) const;
+
+  /// Digest of the edge's preprocessed output (`-E -P`), or nullopt when
+  /// preprocessing fails; a match proves a header change cannot affect
+  /// the object.
+  std::optional<std::string> preprocessedDigest(const NinjaEdge& edge) const;
+
+  /// Output-path-independent key for the shared object cache: compile flags,
+  /// input contents, and compiler version.
+  std::string objectCacheKey(const NinjaEdge& edge) const;
+
+  /// True if the edge produces exactly one cacheable object file.
+  bool isCacheableCompile(const NinjaEdge& edge) const;
+
+  /// Inputs with header-alias nodes (phony edges from the include-graph
+  /// reduction) expanded to the files they stand for, duplicates
+  /// dropped, so input digests still cover the whole header closure.
+  std::vector<std::string>
+  expandInputs(const std::vector<std::string>& inputs) const;
+
+  std::span<const NinjaEdge> edges_;
+  NinjaToolchain toolchain_;
+  fs::path workDir_;
+  std::unordered_map<std::string, std::size_t> producers_;
+  mutable DigestDb digestDb_;
+  ObjectCache objectCache_;
+  std::string compilerVersionDigest_;
+};
+
+/// True if the external ninja binary should be used instead of the embedded
+/// executor.
+bool useNinjaFallback() noexcept;
+
+} // namespace cabin
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// One-file "nothing to do" certificate under `cabin-out/<profile>/`,
+/// written after a successful `cabin build`.  `cabin build` consults it
+/// before constructing a Builder at all: when the manifest bytes, the
+/// compiler, and the recorded stat journal are all unchanged, the whole
+/// manifest-parse/plan/executor pipeline is skipped.  Watch loops and
+/// git hooks hit this path constantly, so it must stay at a handful of
+/// stats plus one journal replay.
+class FreshToken {
+public:
+  static constexpr const char* FILE_NAME = "fresh-token.json";
+
+  /// What the finished build covered.  `cabin run` only links the binary
+  /// closure, so its token must not certify a full `cabin build`.
+  enum class Scope : std::uint8_t { All, Binary };
+
+  /// True if the token exists, certifies a full build, its recorded
+  /// inputs still hash the same, and the stat journal from the last plan
+  /// matches the current tree.
+  static bool isFresh(const fs::path& manifestPath,
+                      const fs::path& outBasePath);
+
+  /// When the token is valid (either scope) and memoizes a binary name
+  /// whose file still exists, returns that binary's path.  `cabin run`
+  /// uses this to exec without parsing the manifest or planning.
+  static std::optional<fs::path> freshBinary(const fs::path& manifestPath,
+                                             const fs::path& outBasePath);
+
+  /// Records the current manifest digest, compiler identity, and journal
+  /// snapshot, plus the binary target's file name when the package has
+  /// one.  Call only after a build finished successfully.
+  static void write(const fs::path& manifestPath, const fs::path& outBasePath,
+                    const std::string& cxx, Scope scope = Scope::All,
+                    const std::string& binaryName = "");
+
+  /// Drops the token so an interrupted build can never be mistaken for a
+  /// finished one.
+  static void invalidate(const fs::path& outBasePath);
+};
+
+} // namespace cabin
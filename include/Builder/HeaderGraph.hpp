@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Shared include DAG for one plan.  `-MM` hands the planner a flat
+/// header closure per translation unit, so a widely-included header is
+/// repeated in every compile edge that reaches it; the graph instead
+/// stores each file's direct includes exactly once and reconstructs
+/// closures by walking it on demand.  Compile edges can then carry only
+/// their direct includes (through one shared alias node per header in
+/// targets.ninja), shrinking the emitted plan by roughly the average
+/// closure depth.
+///
+/// The scanner is a lexer, not a preprocessor: computed includes and
+/// conditionally-compiled directives make it diverge from the compiler.
+/// It is therefore only trusted where `reduce` proves the walked
+/// closure identical to the scanned one; every diverging TU keeps its
+/// flat listing, so correctness never rests on the lexer.
+class HeaderGraph {
+public:
+  /// `searchDirs` mirrors the compile line's -I order; `baseDir` anchors
+  /// relative paths (the directory the dependency scans ran from).
+  HeaderGraph(std::vector<fs::path> searchDirs, fs::path baseDir);
+
+  /// Registers a scanned header as part of the known universe.  Include
+  /// directives only ever resolve to universe members — anything else is
+  /// assumed external (system headers never appear in `-MM` output).
+  /// Must precede the first `reduce`; parses are memoized against the
+  /// universe they first saw.
+  void addKnownHeader(std::string_view path);
+
+  /// The direct includes of `sourceFile` if walking them through the
+  /// graph reproduces exactly `closure` (the TU's scanned header set,
+  /// normalized); nullopt when the lexical scan diverges and the caller
+  /// must keep the flat closure.
+  std::optional<std::vector<std::string>>
+  reduce(const std::string& sourceFile,
+         const std::unordered_set<std::string>& closure);
+
+  /// Direct includes of `path`, resolved into the universe and
+  /// normalized; parsed once per file and memoized.
+  const std::vector<std::string>& directIncludes(const std::string& path);
+
+  /// Absolute, lexically normal form; relative paths resolve against
+  /// the base directory.
+  std::string normalize(std::string_view path) const;
+
+private:
+  std::vector<fs::path> searchDirs_;
+  fs::path baseDir_;
+  std::unordered_set<std::string> universe_;
+  std::unordered_map<std::string, std::vector<std::string>> parsed_;
+};
+
+} // namespace cabin
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -9,6 +11,7 @@ namespace cabin {
 
 struct NinjaEdge {
   std::vector<std::string> outputs;
+  std::vector<std::string> implicitOutputs; // e.g. .dwo files (split DWARF)
   std::string rule;
   std::vector<std::string> inputs;
   std::vector<std::string> implicitInputs;
@@ -18,12 +21,14 @@ struct NinjaEdge {
 
 struct NinjaToolchain {
   std::string cxx;
+  std::string cxxWrapper; // compile-edge prefix (distcc etc.); may be empty
   std::string cxxFlags;
   std::string defines;
   std::string includes;
   std::string ldFlags;
   std::string libs;
   std::string archiver;
+  std::string archiveFlags = "rcs"; // "rcsT" when thin archives are supported
 };
 
 class NinjaPlan {
@@ -32,15 +37,35 @@ public:
 
   void reset();
   void addEdge(NinjaEdge edge);
+  std::span<const NinjaEdge> edges() const { return edges_; }
+  /// Mutable view for post-passes that refine already-added edges (e.g.
+  /// per-edge LIBS pruning once attribution is complete).
+  std::span<NinjaEdge> mutableEdges() { return edges_; }
+  const std::vector<std::string>& defaultTargets() const {
+    return defaultTargets_;
+  }
+  const std::vector<std::string>& testTargets() const { return testTargets_; }
   void addDefaultTarget(std::string target);
   void setTestTargets(std::vector<std::string> testTargets);
+
+  /// Replaces the whole plan with one restored from a snapshot.
+  void restore(std::vector<NinjaEdge> edges,
+               std::vector<std::string> defaultTargets,
+               std::vector<std::string> testTargets);
+
+  /// Renders each ninja file into one preallocated string and writes it
+  /// only when it differs from what is on disk, so no-op replans leave
+  /// every mtime alone and ninja has nothing to re-stat.
   void writeFiles(const NinjaToolchain& toolchain) const;
 
 private:
-  void writeBuildNinja() const;
-  void writeConfigNinja(const NinjaToolchain& toolchain) const;
-  void writeRulesNinja() const;
-  void writeTargetsNinja() const;
+  std::string renderBuildNinja() const;
+  std::string renderConfigNinja(const NinjaToolchain& toolchain) const;
+  std::string renderRulesNinja() const;
+  std::string renderTargetsNinja() const;
+
+  void writeIfChanged(std::string_view fileName, const std::string& content)
+      const;
 
   std::filesystem::path outBasePath_;
   std::vector<NinjaEdge> edges_;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Content-addressed store of compiled objects shared across profiles and
+/// packages, living under `$XDG_CACHE_HOME/cabin/objects` (or
+/// `~/.cache/cabin/objects`).  Objects are keyed by a digest of the compile
+/// flags, the input contents, and the compiler version, and materialized
+/// into the build tree by hard link when possible.  Best-effort: every
+/// failure degrades to a normal compile.  Disable with
+/// CABIN_OBJECT_CACHE=0.
+class ObjectCache {
+public:
+  ObjectCache();
+  explicit ObjectCache(fs::path root);
+
+  static fs::path defaultRoot();
+
+  bool enabled() const { return enabled_; }
+
+  /// True if an object is cached under `key`.
+  bool contains(const std::string& key) const;
+
+  /// Materializes the object cached under `key` at `dst`.  Returns false if
+  /// the key is absent or materialization fails.
+  bool fetch(const std::string& key, const fs::path& dst) const;
+
+  /// Publishes in-memory object bytes under `key` (e.g. a remote cache
+  /// download).  Failures are logged and ignored.
+  void storeBuffer(const std::string& key, std::string_view bytes) const;
+
+  /// Publishes `src` under `key`.  Failures are logged and ignored.
+  void store(const std::string& key, const fs::path& src) const;
+
+  /// Returns the compiler diagnostics stored alongside `key`, or nullopt
+  /// if the compile that produced the object was silent.
+  std::optional<std::string> fetchDiag(const std::string& key) const;
+
+  /// Publishes the compiler's stderr alongside the object under `key`, so
+  /// a later cache hit can replay its warnings.  Empty diagnostics are
+  /// not stored.
+  void storeDiag(const std::string& key, const std::string& diag) const;
+
+private:
+  fs::path objectPath(const std::string& key) const;
+
+  fs::path root_;
+  bool enabled_ = false;
+};
+
+} // namespace cabin
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+
+namespace cabin {
+
+/// Project-wide interned path table.  Header paths recur across thousands
+/// of compile units; storing one copy and passing 32-bit ids around keeps
+/// the planner's dependency sets small.  Thread-safe: parallel scan tasks
+/// intern concurrently, and ids are never invalidated.
+class PathTable {
+public:
+  std::uint32_t intern(std::string_view path);
+
+  /// The reference stays valid for the table's lifetime.
+  const std::string& str(std::uint32_t id) const;
+
+  std::size_t size() const;
+
+private:
+  mutable tbb::spin_mutex mtx;
+  std::unordered_map<std::string_view, std::uint32_t> ids;
+  // Deque keeps addresses stable, so the string_view keys above and the
+  // references str() hands out never dangle.
+  std::deque<std::string> strings;
+};
+
+} // namespace cabin
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Builder/NinjaPlan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Everything needed to rebuild without replanning: the toolchain strings,
+/// the edge list, and the discovered targets.
+struct PlanSnapshot {
+  struct TestTarget {
+    std::string ninjaTarget;
+    std::string sourcePath;
+    std::uint8_t kind = 0; // BuildGraph::TestKind
+  };
+
+  NinjaToolchain toolchain;
+  bool hasBinaryTarget = false;
+  bool hasLibraryTarget = false;
+  bool combinedTests = false;
+  std::size_t unityGroupSize = 0;
+  std::vector<NinjaEdge> edges;
+  std::vector<std::string> defaultTargets;
+  std::vector<std::string> phonyTestTargets;
+  std::vector<TestTarget> testTargets;
+};
+
+/// Versioned binary serialization of a `PlanSnapshot`, persisted as
+/// `cabin-out/<profile>/plan.bin`: a string table followed by flat records
+/// referencing it by index.  Loading mmaps the file and validates every
+/// index, so a no-op plan is one map plus bounds checks instead of
+/// re-deriving edges.
+class PlanCache {
+public:
+  static constexpr const char* FILE_NAME = "plan.bin";
+
+  /// Empty on a missing, truncated, or version-mismatched file.
+  static std::optional<PlanSnapshot> load(const fs::path& outBasePath);
+  static void save(const fs::path& outBasePath, const PlanSnapshot& snapshot);
+};
+
+} // namespace cabin
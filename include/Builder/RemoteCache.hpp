@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Builder/ObjectCache.hpp"
+
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Client for a shared HTTP content-addressed object store, configured
+/// through the manifest's `[cache]` table.  Objects use the same keys as
+/// the local object cache — compile flags, input contents, and compiler
+/// version — so a hit is hermetic by construction: a different compiler
+/// release or flag set can never alias another machine's object.
+///
+/// Downloads happen up front in one multiplexed batch (see
+/// Executor::build) and land in the local object cache, so the hot edge
+/// loop never waits on the network.  Uploads of locally compiled objects
+/// are queued to a background thread and complete by process exit.
+/// Everything is best-effort: a dead endpoint degrades to local compiles.
+class RemoteCache {
+public:
+  static RemoteCache& instance() noexcept;
+
+  /// Applies the manifest's `[cache]` table.  Idempotent.
+  void configure(std::string baseUrl, bool upload) noexcept;
+
+  bool enabled() const noexcept;
+
+  /// Downloads every object in `keys` in one multiplexed batch and stores
+  /// the hits into `localCache`.  Missing keys are not an error.
+  void prefetch(std::span<const std::string> keys,
+                const ObjectCache& localCache) const noexcept;
+
+  /// Queues an asynchronous upload of the object at `src` under `key`
+  /// and returns immediately.  No-op unless uploads are enabled.
+  void enqueueUpload(std::string key, fs::path src) noexcept;
+
+private:
+  RemoteCache() noexcept = default;
+
+  std::string baseUrl_;
+  bool upload_ = false;
+};
+
+} // namespace cabin
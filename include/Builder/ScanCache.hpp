@@ -0,0 +1,77 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// A single cached `-MM` scan result.  An entry is valid only if the source
+/// file's content digest, the digest of the scan flags, and the combined
+/// digest of all recorded header dependencies are unchanged.
+struct ScanEntry {
+  std::string contentDigest;
+  std::string flagsDigest;
+  std::string depsDigest;
+  std::string objTarget;
+  std::unordered_set<std::string> dependencies;
+};
+
+/// On-disk cache of preprocessor dependency scans, stored under
+/// `cabin-out/<profile>/`.  Lets the planner skip spawning the compiler for
+/// sources whose inputs did not change since the last plan.
+class ScanCache {
+public:
+  static constexpr const char* FILE_NAME = "scan-cache.json";
+
+  void load(const fs::path& outBasePath);
+  void save(const fs::path& outBasePath) const;
+
+  /// Returns the cached entry for `sourceFile` if its content, flags, and
+  /// dependency digests all still match; otherwise std::nullopt.
+  std::optional<ScanEntry> lookup(const std::string& sourceFile,
+                                  const std::string& contentDigest,
+                                  const std::string& flagsDigest);
+  void insert(const std::string& sourceFile, ScanEntry entry);
+
+  /// Cached verdict of BuildGraph::containsTestCode, valid while the
+  /// source content and scan flags are unchanged.
+  std::optional<bool> lookupTestVerdict(const std::string& sourceFile,
+                                        const std::string& contentDigest,
+                                        const std::string& flagsDigest) const;
+  void insertTestVerdict(const std::string& sourceFile,
+                         const std::string& contentDigest,
+                         const std::string& flagsDigest, bool verdict);
+
+  /// Content digest of `path`, memoized for the lifetime of this cache so
+  /// shared headers are read at most once per invocation.
+  std::string fileDigest(const fs::path& path);
+
+  /// Combined digest over `dependencies` (order-independent).
+  std::string depsDigest(const std::unordered_set<std::string>& dependencies);
+
+private:
+  struct TestVerdict {
+    std::string contentDigest;
+    std::string flagsDigest;
+    bool verdict = false;
+  };
+
+  mutable tbb::spin_mutex mtx;
+  std::unordered_map<std::string, ScanEntry> entries;
+  std::unordered_map<std::string, TestVerdict> testVerdicts;
+
+  tbb::spin_mutex digestMtx;
+  std::unordered_map<std::string, std::string> digestMemo;
+};
+
+std::string digestString(std::string_view data) noexcept;
+std::string digestFile(const fs::path& path);
+
+} // namespace cabin
@@ -1,17 +1,65 @@
 #pragma once
 
+#include "Algos.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <vector>
 
 namespace cabin {
 
+namespace fs = std::filesystem;
+
 // clang-format off
-inline const std::unordered_set<std::string> SOURCE_FILE_EXTS{
+inline constexpr StaticStringSet SOURCE_FILE_EXTS{ std::array<std::string_view, 5>{
   ".c", ".c++", ".cc", ".cpp", ".cxx"
-};
-inline const std::unordered_set<std::string> HEADER_FILE_EXTS{
+} };
+inline constexpr StaticStringSet HEADER_FILE_EXTS{ std::array<std::string_view, 5>{
   ".h", ".h++", ".hh", ".hpp", ".hxx"
-};
+} };
+inline constexpr StaticStringSet MODULE_FILE_EXTS{ std::array<std::string_view, 5>{
+  ".c++m", ".ccm", ".cppm", ".cxxm", ".ixx"
+} };
 // clang-format on
 
+/// Callbacks for walkDirParallel.  Either may be empty (accept everything);
+/// both may be invoked from multiple threads concurrently.
+struct WalkOptions {
+  std::function<bool(const fs::directory_entry&)> includeEntry;
+  std::function<bool(const fs::path&)> enterDir;
+};
+
+/// Recursively collects the entries of `dir` that `includeEntry` accepts,
+/// in sorted order.  The walk fans out one task per immediate subdirectory
+/// of `dir`, so large trees are statted in parallel.
+std::vector<fs::path> walkDirParallel(const fs::path& dir,
+                                      const WalkOptions& options = {});
+
+/// Classifies discovered sources against the project's `src` and `lib`
+/// roots.  The roots are canonicalized once at construction, so
+/// classifying a path costs one canonicalization and a prefix check
+/// instead of re-canonicalizing every root per source.
+class SourceClassifier {
+public:
+  enum class Root : uint8_t { Src, Lib, Other };
+
+  struct Classification {
+    Root root = Root::Other;
+    /// The source relative to its root; empty for `Other`.
+    fs::path relPath;
+  };
+
+  explicit SourceClassifier(const fs::path& projectRoot);
+
+  Classification classify(const fs::path& source) const;
+
+private:
+  std::string srcRoot_; // canonical, generic separators; empty if absent
+  std::string libRoot_;
+};
+
 } // namespace cabin
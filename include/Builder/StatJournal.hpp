@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Snapshot of (path, size, mtime) for every entry the planner watches,
+/// persisted under `cabin-out/<profile>/` after each plan.  Up-to-date checks
+/// replay the journal with one stat per recorded path instead of re-walking
+/// the whole tree, and bail out at the first mismatch.
+class StatJournal {
+public:
+  static constexpr const char* FILE_NAME = "stat-journal.json";
+
+  /// Walks `watchedPaths` (directories are recursed into, files are recorded
+  /// as-is) and captures their current stat data.  Missing paths are recorded
+  /// too, so their later appearance invalidates the journal.
+  static StatJournal record(std::span<const fs::path> watchedPaths);
+
+  static std::optional<StatJournal> load(const fs::path& outBasePath);
+  void save(const fs::path& outBasePath) const;
+
+  /// True if every journaled path still has the recorded size and mtime and
+  /// no journaled directory gained or lost entries.
+  bool matchesCurrentTree() const;
+
+  bool empty() const { return entries.empty(); }
+
+private:
+  struct Entry {
+    std::int64_t mtime = -1; // -1: path did not exist when recorded
+    std::uint64_t size = 0;
+    bool isDir = false;
+  };
+
+  std::unordered_map<std::string, Entry> entries;
+};
+
+} // namespace cabin
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Explicit-instantiation coordination for `cabin build --dedup-templates`.
+///
+/// Heavy class-template instantiations (formatters, parser accessors)
+/// tend to be compiled into dozens of objects.  The first dedup build is
+/// a calibration pass: every TU compiles with `-ftime-trace`, and the
+/// traces are harvested into a registry of the costliest instantiations
+/// that appear in more than one TU.  Subsequent dedup builds generate a
+/// shared header of `extern template` declarations (force-included into
+/// every TU) plus one TU that provides the definitions, so each
+/// instantiation is compiled exactly once.
+class TemplateDedup {
+public:
+  static constexpr const char* REGISTRY_FILE = "template-dedup.json";
+  static constexpr const char* HEADER_FILE = "cabin-dedup.hpp";
+  static constexpr const char* SOURCE_FILE = "cabin-dedup.cc";
+
+  /// The registry written by a previous calibration pass, or nullopt
+  /// when none exists yet (the next dedup build must calibrate).
+  static std::optional<std::vector<std::string>>
+  loadRegistry(const fs::path& outBasePath);
+
+  /// Walks the time-trace JSON files a calibration build left next to
+  /// its objects, ranks class instantiations duplicated across TUs by
+  /// total time, and writes the registry.  Returns how many were kept.
+  static std::size_t harvestTimeTraces(const fs::path& outBasePath);
+
+  /// Regenerates HEADER_FILE and SOURCE_FILE under `outBasePath` from
+  /// the registry names.  `preamble` lists the headers that declare the
+  /// instantiated templates (the profile's `pch` list); files are only
+  /// rewritten on change so their edges stay clean across plans.
+  static void writeGeneratedFiles(const fs::path& outBasePath,
+                                  std::span<const std::string> names,
+                                  std::span<const std::string> preamble);
+};
+
+} // namespace cabin
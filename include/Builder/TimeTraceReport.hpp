@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Aggregated compile-time report for `cabin build --time-trace`.
+///
+/// A traced build leaves one Chrome-trace JSON per object (clang's
+/// `-ftime-trace`).  This merges them: the top headers by cumulative
+/// parse time and the top template instantiations are printed as
+/// tables, and every TU's events are combined into a single
+/// `time-trace.json` loadable in a trace viewer, with one process lane
+/// per TU.  Returns how many per-TU traces were merged.
+std::size_t writeTimeTraceReport(const fs::path& outBasePath);
+
+} // namespace cabin
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <rs/result.hpp>
+#include <string>
+#include <tbb/concurrent_vector.h>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Collects per-phase and per-edge timing spans for `cabin build --timings`
+/// and writes them as Chrome trace_event JSON (loadable in Perfetto or
+/// chrome://tracing) plus a small standalone HTML summary.  Recording is a
+/// no-op until enable() is called, so instrumented call sites cost one
+/// branch in normal builds.
+class Timings {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static Timings& instance() noexcept;
+
+  void enable() noexcept { enabled = true; }
+  bool isEnabled() const noexcept { return enabled; }
+
+  /// Records one completed span.  Thread-safe.
+  void record(std::string category, std::string name, Clock::time_point start,
+              Clock::time_point end) noexcept;
+
+  /// RAII helper recording the span of its own lifetime.  Does nothing
+  /// when timing collection is disabled.
+  class Span {
+  public:
+    Span(std::string category, std::string name) noexcept;
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span(Span&&) = delete;
+    Span& operator=(const Span&) = delete;
+    Span& operator=(Span&&) = delete;
+
+  private:
+    std::string category;
+    std::string name;
+    Clock::time_point start;
+    bool active;
+  };
+
+  /// Writes `timings.json` (Chrome trace) and `timings.html` (summary)
+  /// under `outDir`.  No-op when disabled or nothing was recorded.
+  rs::Result<void> write(const fs::path& outDir) const noexcept;
+
+  Timings(const Timings&) = delete;
+  Timings(Timings&&) = delete;
+  Timings& operator=(const Timings&) = delete;
+  Timings& operator=(Timings&&) = delete;
+
+private:
+  Timings() = default;
+  ~Timings() = default;
+
+  struct Event {
+    std::string category;
+    std::string name;
+    std::size_t threadId;
+    std::int64_t startUs; // relative to `origin`, in microseconds
+    std::int64_t durationUs;
+  };
+
+  bool enabled = false;
+  Clock::time_point origin = Clock::now();
+  tbb::concurrent_vector<Event> events;
+};
+
+} // namespace cabin
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Persists the results of pure tool probes (`--version` output and the
+/// like) across cabin invocations, keyed by the probed binary's resolved
+/// path, size, and mtime.  Lives in ~/.cache/cabin/toolchain.json and is
+/// disabled when no cache directory can be determined.
+class ToolchainCache {
+public:
+  static ToolchainCache& instance() noexcept;
+
+  /// Returns the cached result of `probeName` against `tool`, or runs
+  /// `compute`, persists its result, and returns it.  A changed binary
+  /// (different path, size, or mtime) invalidates its entries; a nullopt
+  /// from `compute` is returned but never cached.
+  std::optional<std::string>
+  probe(const std::string& tool, const std::string& probeName,
+        const std::function<std::optional<std::string>()>& compute);
+
+  ToolchainCache(const ToolchainCache&) = delete;
+  ToolchainCache(ToolchainCache&&) = delete;
+  ToolchainCache& operator=(const ToolchainCache&) = delete;
+  ToolchainCache& operator=(ToolchainCache&&) = delete;
+
+private:
+  ToolchainCache();
+  ~ToolchainCache();
+
+  struct Entry {
+    std::string stat;  // resolved path, size, and mtime of the binary
+    std::string value; // the probe's output
+  };
+
+  fs::path path_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_; // "<tool>\x1f<probe>"
+  bool dirty_ = false;
+};
+
+} // namespace cabin
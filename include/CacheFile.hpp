@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Shared primitives for the on-disk caches.  Several cabin processes
+/// can hit the same cache at once (parallel CI jobs in one checkout,
+/// two first builds sharing ~/.cache/cabin); these keep every cache
+/// correct under that parallelism without readers ever blocking:
+/// writers stage into a temp file and publish with one atomic rename,
+/// so a reader always maps a complete epoch — the previous one or the
+/// new one — and a crash mid-write leaves the previous epoch in place.
+/// Locks are only for mutations that cannot be published atomically
+/// (materializing whole directories, read-modify-write merges).
+
+/// Exclusive advisory lock (flock) on `path`, created on demand;
+/// serializes cabin processes mutating the same shared cache entry.
+class FileLock {
+public:
+  explicit FileLock(const fs::path& path);
+  ~FileLock();
+
+  FileLock(const FileLock&) = delete;
+  FileLock(FileLock&&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+  FileLock& operator=(FileLock&&) = delete;
+
+  bool held() const { return fd_ >= 0; }
+
+private:
+  int fd_ = -1;
+};
+
+/// Publishes `content` at `path` via a same-directory temp file and an
+/// atomic rename.  Concurrent writers each publish a complete file
+/// (last rename wins); false means the save was skipped, never that
+/// the previous content was damaged.
+bool writeFileAtomic(const fs::path& path, std::string_view content) noexcept;
+
+} // namespace cabin
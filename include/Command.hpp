@@ -38,6 +38,10 @@ struct CommandOutput {
   const ExitStatus exitStatus;
   const std::string stdOut;
   const std::string stdErr;
+  /// Wall-clock run time; only measured by waitAllWithOutput (0 elsewhere).
+  const std::int64_t durationMs = 0;
+  /// Peak resident set size of the child in KiB (0 when unavailable).
+  const std::int64_t peakRssKb = 0;
 };
 
 class Child {
@@ -45,22 +49,44 @@ private:
   const pid_t pid;
   const int stdOutFd;
   const int stdErrFd;
+  // Where teed output is forwarded as it arrives; -1 for plain pipes.
+  const int stdOutMirrorFd;
+  const int stdErrMirrorFd;
 
-  Child(pid_t pid, int stdOutFd, int stdErrFd) noexcept
-      : pid(pid), stdOutFd(stdOutFd), stdErrFd(stdErrFd) {}
+  Child(pid_t pid, int stdOutFd, int stdErrFd, int stdOutMirrorFd = -1,
+        int stdErrMirrorFd = -1) noexcept
+      : pid(pid), stdOutFd(stdOutFd), stdErrFd(stdErrFd),
+        stdOutMirrorFd(stdOutMirrorFd), stdErrMirrorFd(stdErrMirrorFd) {}
 
   friend struct Command;
+  friend rs::Result<std::vector<CommandOutput>>
+  waitAllWithOutput(const std::vector<Child>& children) noexcept;
 
 public:
   rs::Result<ExitStatus> wait() const noexcept;
   rs::Result<CommandOutput> waitWithOutput() const noexcept;
 };
 
+/// Supervises several spawned children at once: every pipe is drained
+/// from a single poll() loop with large buffers, and each child is reaped
+/// once its output completes.  Outputs are returned in the order of
+/// `children`.
+rs::Result<std::vector<CommandOutput>>
+waitAllWithOutput(const std::vector<Child>& children) noexcept;
+
 struct Command {
   enum class IOConfig : uint8_t {
     Null,
     Inherit,
     Piped,
+    /// Like Piped, but every chunk is forwarded to cabin's own
+    /// corresponding stream the moment it is read, and only a bounded
+    /// tail is retained in CommandOutput for error context.  Output
+    /// streams live without buffering the whole flood, so huge compiler
+    /// error spews neither balloon cabin's RSS nor wait for the child to
+    /// exit.  Meant for one foreground child at a time -- concurrent
+    /// teed children would interleave on the terminal.
+    Tee,
   };
 
   std::string command;
@@ -112,6 +138,14 @@ struct Command {
 
   rs::Result<Child> spawn() const noexcept;
   rs::Result<CommandOutput> output() const noexcept;
+
+private:
+  /// posix_spawn-based fast path: avoids duplicating cabin's page tables,
+  /// so process creation stays flat as cabin's own RSS grows.
+  rs::Result<Child> spawnPosix() const noexcept;
+  /// fork/exec fallback for platforms whose posix_spawn cannot change the
+  /// working directory.
+  rs::Result<Child> spawnFork() const noexcept;
 };
 
 } // namespace cabin
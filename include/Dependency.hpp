@@ -9,6 +9,7 @@
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace cabin {
 
@@ -18,6 +19,18 @@ struct GitDependency {
   const std::optional<std::string> target;
 
   [[nodiscard]] std::filesystem::path installDir() const;
+  /// Path of the shared bare mirror for this dependency's URL.
+  [[nodiscard]] std::filesystem::path mirrorDir() const;
+  /// Creates or refreshes the bare mirror so it can resolve `target`.
+  rs::Result<void> updateMirror(const std::filesystem::path& mirrorPath) const;
+  /// Materializes the checkout under installDir() if it is missing, cloning
+  /// from the shared bare mirror and holding a per-directory file lock so
+  /// concurrent cabin invocations (or parallel fetches) never race on the
+  /// same target.  Safe to call from multiple threads for distinct
+  /// dependencies.
+  rs::Result<void> fetch() const;
+  /// Commit OID the checkout under installDir() currently points at.
+  rs::Result<std::string> resolvedOid() const;
   rs::Result<CompilerOpts> install() const;
 
   GitDependency(std::string name, std::string url,
@@ -25,6 +38,28 @@ struct GitDependency {
       : name(std::move(name)), url(std::move(url)), target(std::move(target)) {}
 };
 
+struct TarballDependency {
+  const std::string name;
+  const std::string url;
+  /// FNV-1a content digest of the archive, when the manifest pins one.
+  const std::optional<std::string> digest;
+
+  [[nodiscard]] std::filesystem::path installDir() const;
+  /// Downloads and extracts the archive under installDir() if it is
+  /// missing, using the same per-directory lock scheme as git
+  /// dependencies.
+  rs::Result<void> fetch() const;
+  /// Downloads every missing archive in `deps` over one multiplexed HTTP
+  /// session, then extracts them.  Warm dependencies are skipped.
+  static rs::Result<void> fetchAll(const std::vector<TarballDependency>& deps);
+  rs::Result<CompilerOpts> install() const;
+
+  TarballDependency(std::string name, std::string url,
+                    std::optional<std::string> digest)
+      : name(std::move(name)), url(std::move(url)),
+        digest(std::move(digest)) {}
+};
+
 struct PathDependency {
   const std::string name;
   const std::string path;
@@ -45,7 +80,7 @@ struct SystemDependency {
       : name(std::move(name)), versionReq(std::move(versionReq)) {}
 };
 
-using Dependency =
-    std::variant<GitDependency, PathDependency, SystemDependency>;
+using Dependency = std::variant<GitDependency, TarballDependency,
+                                PathDependency, SystemDependency>;
 
 } // namespace cabin
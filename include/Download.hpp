@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+#include <rs/result.hpp>
+#include <string>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// One file to download.  `expectedDigest`, when non-empty, is the FNV-1a
+/// content digest (see digestFile) the finished file must match.
+struct DownloadRequest {
+  std::string url;
+  fs::path dest;
+  std::string expectedDigest;
+};
+
+/// Downloads every request concurrently over a single curl multi handle,
+/// multiplexing onto one HTTP/2 connection per host where the server
+/// allows it.  Partially downloaded files (`<dest>.part`) are resumed,
+/// and completed files are digest-verified before being moved into place.
+rs::Result<void> downloadAll(std::vector<DownloadRequest> requests) noexcept;
+
+} // namespace cabin
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Builder/StatJournal.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <rs/result.hpp>
+#include <vector>
+
+#ifdef __linux__
+#  include <string>
+#  include <unordered_map>
+#endif
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Blocks until something under the watched roots changes.
+///
+/// On Linux every directory under the roots gets an inotify watch, so
+/// waiting costs nothing until the kernel reports an event; elsewhere an
+/// in-memory stat journal of the same roots is polled.  Either way,
+/// events are debounced so one save that touches several files (editors
+/// write a temp file and rename it) wakes the caller once.
+class FileWatcher {
+public:
+  static rs::Result<FileWatcher> create(std::vector<fs::path> roots);
+
+  ~FileWatcher();
+  FileWatcher(FileWatcher&& other) noexcept;
+  FileWatcher& operator=(FileWatcher&&) = delete;
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+
+  /// Waits for the next change, then keeps draining events until the
+  /// tree has been quiet for `debounce`.
+  rs::Result<void> waitForChange(std::chrono::milliseconds debounce);
+
+  /// Resynchronizes with the current tree; call after each run so
+  /// changes the run itself made (in-place formatting, regenerated
+  /// files) are not reported as new work.
+  void drainPendingEvents();
+
+private:
+  explicit FileWatcher(std::vector<fs::path> roots);
+
+  std::vector<fs::path> roots_;
+
+#ifdef __linux__
+  rs::Result<void> watchTree(const fs::path& root);
+  rs::Result<void> watchPath(const fs::path& path);
+  // Reads every queued event without blocking; registers watches for
+  // newly created directories.  Returns true if anything was queued.
+  bool drainEvents();
+
+  int inotifyFd_ = -1;
+  std::unordered_map<int, std::string> watchDirs_; // wd -> directory path
+#else
+  StatJournal journal_;
+#endif
+};
+
+} // namespace cabin
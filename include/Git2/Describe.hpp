@@ -84,6 +84,13 @@ struct Describe : public GlobalState {
   Describe& workdir(const Repository& repo, DescribeOptions& opts);
 
   std::string format(const DescribeFormatOptions& opts) const;
+
+  /// Describes the repository's HEAD stopping at the first tag
+  /// boundary: with a single candidate tag the walk ends as soon as any
+  /// tag is reached instead of weighing every candidate, which keeps
+  /// describe cheap on histories with hundreds of thousands of commits.
+  /// Falls back to the commit id when no tag is reachable.
+  static std::string firstTag(const Repository& repo);
 };
 
 } // namespace git2
@@ -49,6 +49,25 @@ struct Repository : public GlobalState {
   Repository& clone(const std::string& url, const std::string& path,
                     const git_clone_options* opts = nullptr);
 
+  /// Clone only the tip commits (`depth` deep) when the linked libgit2
+  /// supports shallow fetches; falls back to a full clone otherwise.
+  Repository& cloneShallow(const std::string& url, const std::string& path,
+                           int depth = 1);
+
+  /// Clone into a bare repository (no working tree).  `depth > 0` limits
+  /// history like cloneShallow.
+  Repository& cloneBare(const std::string& url, const std::string& path,
+                        int depth = 0);
+
+  /// Clone from a repository on the local filesystem, hardlinking the
+  /// object database instead of copying it — no network, near-zero disk.
+  Repository& cloneLocal(const std::string& srcPath,
+                         const std::string& dstPath);
+
+  /// Fetch new objects from `origin`.  `depth > 0` limits the fetched
+  /// history when supported; a negative depth unshallows the repository.
+  Repository& fetchOrigin(int depth = 0);
+
   /// Find a single object, as specified by a revision string.
   Object revparseSingle(const std::string& spec) const;
 
@@ -4,8 +4,11 @@
 #include "Oid.hpp"
 #include "Repository.hpp"
 
+#include <cstddef>
 #include <git2/revwalk.h>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace git2 {
 
@@ -97,6 +100,18 @@ struct Revwalk : public GlobalState {
   ///
   /// The reference must point to a committish.
   Revwalk& hideRef(const std::string& reference);
+
+  /// Fetch the next commit OID, or nullopt when the walk is complete.
+  std::optional<Oid> next();
+
+  /// Drain up to `max` OIDs into `out` in one call, returning how many
+  /// were appended; fewer than `max` means the walk is complete.
+  ///
+  /// Batching amortizes the per-commit call overhead, and commits
+  /// visited together keep their pack windows hot for the header
+  /// lookups that typically follow, so walking a deep history in
+  /// batches is much cheaper than one-at-a-time iteration.
+  std::size_t nextMany(std::vector<Oid>& out, std::size_t max);
 };
 
 } // end namespace git2
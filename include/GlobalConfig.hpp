@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+/// Machine-wide settings from `$XDG_CONFIG_HOME/cabin/config.toml`
+/// (`~/.config/cabin/config.toml` by default):
+///
+/// ```toml
+/// [registry]
+/// url = "https://registry.corp/v1/graphql"
+///
+/// [git.rewrite]
+/// "https://github.com/" = "https://mirror.corp/github/"
+///
+/// [build]
+/// jobs = 16
+///
+/// [cache]
+/// remote = "https://cache.corp"
+/// ```
+///
+/// The file sits on every command's startup path, so like the manifest
+/// it is parsed once and snapshotted as JSON under the user cache dir,
+/// keyed by the config file's size and mtime; warm starts are one stat
+/// plus one mmap of the snapshot.
+class GlobalConfig {
+public:
+  static const GlobalConfig& instance() noexcept;
+
+  /// Rewrites a git URL through the longest matching `[git.rewrite]`
+  /// prefix (e.g. pointing github.com at a corporate mirror); returns
+  /// the URL unchanged when no prefix matches.
+  std::string rewriteGitUrl(std::string_view url) const noexcept;
+
+  /// Registry endpoint override; empty means the built-in default.
+  const std::string& registryUrl() const noexcept { return registryUrl_; }
+
+  /// Startup parallelism default; 0 leaves hardware concurrency in
+  /// charge.  An explicit `-j` still overrides it.
+  std::size_t defaultJobs() const noexcept { return defaultJobs_; }
+
+  /// Default remote object-cache endpoint for manifests that set none.
+  const std::string& cacheRemote() const noexcept { return cacheRemote_; }
+
+private:
+  GlobalConfig() noexcept;
+
+  std::vector<std::pair<std::string, std::string>> gitRewrites_;
+  std::string registryUrl_;
+  std::size_t defaultJobs_ = 0;
+  std::string cacheRemote_;
+};
+
+} // namespace cabin
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <rs/result.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cabin {
+
+/// One request for `HttpClient`.  An empty `body` performs a GET;
+/// otherwise the body is POSTed with `contentType`.
+struct HttpRequest {
+  std::string url;
+  std::string body;
+  std::string contentType = "application/json";
+  /// A failed transfer yields an empty response instead of failing the
+  /// whole batch (for lookups where absence is an expected answer).
+  bool allowFailure = false;
+};
+
+/// Process-wide HTTP session.
+///
+/// A single curl multi handle owns the connection pool for the whole
+/// process: successive requests to the same host reuse the established
+/// connection and TLS session instead of paying a fresh handshake,
+/// every transfer asks for compressed responses, and requests running
+/// together multiplex over one HTTP/2 connection per host.  Search and
+/// the registry fetch paths share this client.
+class HttpClient {
+public:
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+  HttpClient(HttpClient&&) = delete;
+  HttpClient& operator=(HttpClient&&) = delete;
+
+  static HttpClient& instance() noexcept;
+
+  /// Performs every request concurrently over the shared session,
+  /// returning the response bodies in request order.
+  rs::Result<std::vector<std::string>>
+  performAll(std::span<const HttpRequest> requests) noexcept;
+
+  /// Performs one request over the shared session.
+  rs::Result<std::string> perform(const HttpRequest& req) noexcept;
+
+private:
+  HttpClient() noexcept;
+  ~HttpClient();
+
+  CURLM* multi = nullptr;
+};
+
+} // namespace cabin
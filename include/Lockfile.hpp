@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <rs/result.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Records the commit OID each git dependency resolved to, Cargo.lock
+/// style.  Once a dependency is locked, repeat resolves reuse the pinned
+/// revision without any network traffic; deleting `cabin.lock` re-resolves
+/// everything from scratch.
+class Lockfile {
+public:
+  static constexpr const char* FILE_NAME = "cabin.lock";
+
+  struct Entry {
+    std::string name;
+    std::string url;
+    std::optional<std::string> target;
+    std::string rev;
+  };
+
+  /// Loads the lockfile stored in `baseDir` (next to the root manifest).
+  /// A missing file yields an empty — but savable — lock.
+  static rs::Result<Lockfile> load(const fs::path& baseDir) noexcept;
+
+  /// Returns the locked revision for `(name, url, target)` if recorded.
+  std::optional<std::string>
+  lookup(const std::string& name, const std::string& url,
+         const std::optional<std::string>& target) const noexcept;
+
+  /// Records the revision a dependency resolved to, replacing any stale
+  /// entry for the same `(name, url, target)`.
+  void record(Entry entry) noexcept;
+
+  /// Writes the lock back to disk iff an entry changed since load().
+  rs::Result<void> save() const noexcept;
+
+private:
+  explicit Lockfile(fs::path path) : path(std::move(path)) {}
+
+  fs::path path;
+  std::vector<Entry> entries;
+  bool dirty = false;
+};
+
+} // namespace cabin
@@ -10,6 +10,7 @@
 #include <filesystem>
 #include <fmt/ostream.h>
 #include <fmt/ranges.h>
+#include <optional>
 #include <rs/result.hpp>
 #include <string>
 #include <string_view>
@@ -58,16 +59,24 @@ private:
 };
 
 struct Package {
+  enum class LibType : uint8_t { Static, Shared };
+
   const std::string name;
   const Edition edition;
   const Version version;
+  const LibType libType;
+  const std::size_t testThreads; // 0: use the global parallelism setting
 
   static rs::Result<Package> tryFromToml(const toml::value& val) noexcept;
 
 private:
-  Package(std::string name, Edition edition, Version version) noexcept
+  friend class Manifest; // snapshot deserialization
+
+  Package(std::string name, Edition edition, Version version, LibType libType,
+          std::size_t testThreads) noexcept
       : name(std::move(name)), edition(std::move(edition)),
-        version(std::move(version)) {}
+        version(std::move(version)), libType(libType),
+        testThreads(testThreads) {}
 };
 
 struct Profile {
@@ -75,27 +84,56 @@ struct Profile {
   const std::vector<std::string> ldflags;
   const bool lto;
   const bool debug;
+  const bool splitDebugInfo; // -gsplit-dwarf: debug info in .dwo side files
   const std::uint8_t optLevel;
+  const std::vector<std::string> pch; // headers to precompile
 
   Profile(std::vector<std::string> cxxflags, std::vector<std::string> ldflags,
-          const bool lto, const bool debug,
-          const std::uint8_t optLevel) noexcept
+          const bool lto, const bool debug, const bool splitDebugInfo,
+          const std::uint8_t optLevel,
+          std::vector<std::string> pch = {}) noexcept
       : cxxflags(std::move(cxxflags)), ldflags(std::move(ldflags)), lto(lto),
-        debug(debug), optLevel(optLevel) {}
+        debug(debug), splitDebugInfo(splitDebugInfo), optLevel(optLevel),
+        pch(std::move(pch)) {}
 
   bool operator==(const Profile& other) const {
     return cxxflags == other.cxxflags && ldflags == other.ldflags
            && lto == other.lto && debug == other.debug
-           && optLevel == other.optLevel;
+           && splitDebugInfo == other.splitDebugInfo
+           && optLevel == other.optLevel && pch == other.pch;
   }
 };
 
+/// A partial `[profile.<key>.package.<name>]` table: every set field
+/// replaces the named package's value for that profile, unset fields keep
+/// the package's own setting.  The workspace root uses these to tune one
+/// member (e.g. build dependencies optimized while our code stays -O0)
+/// without touching the member manifests.
+struct ProfileOverride {
+  std::optional<std::vector<std::string>> cxxflags;
+  std::optional<std::vector<std::string>> ldflags;
+  std::optional<bool> lto;
+  std::optional<bool> debug;
+  std::optional<bool> splitDebugInfo;
+  std::optional<std::uint8_t> optLevel;
+  std::optional<std::vector<std::string>> pch;
+
+  Profile applyTo(const Profile& base) const noexcept;
+
+  /// Collects every `[profile.<profileKey>.package.<name>]` table under
+  /// `val`, keyed by package name.  No such tables yield an empty map.
+  static rs::Result<std::unordered_map<std::string, ProfileOverride>>
+  mapFromToml(const toml::value& val, std::string_view profileKey) noexcept;
+};
+
 struct Cpplint {
   const std::vector<std::string> filters;
 
   static rs::Result<Cpplint> tryFromToml(const toml::value& val) noexcept;
 
 private:
+  friend class Manifest; // snapshot deserialization
+
   explicit Cpplint(std::vector<std::string> filters) noexcept
       : filters(std::move(filters)) {}
 };
@@ -106,9 +144,53 @@ struct Lint {
   static rs::Result<Lint> tryFromToml(const toml::value& val) noexcept;
 
 private:
+  friend class Manifest; // snapshot deserialization
+
   explicit Lint(Cpplint cpplint) noexcept : cpplint(std::move(cpplint)) {}
 };
 
+struct Build {
+  /// Command prefix for compile edges (e.g. `distcc`, `sccache`).  Empty
+  /// means compile locally without a wrapper.
+  const std::string wrapper;
+  /// Job count for remote builds; 0 derives one from local parallelism.
+  /// Only meaningful when `wrapper` is set.
+  const std::size_t remoteJobs;
+  /// Niceness applied to the cabin process (and thus every build child)
+  /// before building; 0 leaves the inherited priority alone.
+  const std::int64_t nice;
+  /// IO scheduling class for build children: `idle` or `best-effort`.
+  /// Empty leaves the inherited class alone.
+  const std::string ioClass;
+
+  static rs::Result<Build> tryFromToml(const toml::value& val) noexcept;
+
+private:
+  friend class Manifest; // snapshot deserialization
+
+  Build(std::string wrapper, const std::size_t remoteJobs,
+        const std::int64_t nice, std::string ioClass) noexcept
+      : wrapper(std::move(wrapper)), remoteJobs(remoteJobs), nice(nice),
+        ioClass(std::move(ioClass)) {}
+};
+
+struct Cache {
+  /// Base URL of a shared HTTP content-addressed object store.  Empty
+  /// means only the local object cache is used.
+  const std::string remote;
+  /// Whether locally compiled objects are uploaded to the remote store
+  /// for other machines to reuse.
+  const bool upload;
+
+  static rs::Result<Cache> tryFromToml(const toml::value& val) noexcept;
+
+private:
+  friend class Manifest; // snapshot deserialization
+
+  Cache(std::string remote, const bool upload) noexcept
+      : remote(std::move(remote)), upload(upload) {}
+};
+
 class Manifest {
 public:
   static constexpr const char* FILE_NAME = "cabin.toml";
@@ -119,6 +201,8 @@ public:
   const std::vector<Dependency> devDependencies;
   const std::unordered_map<BuildProfile, Profile> profiles;
   const Lint lint;
+  const Build build;
+  const Cache cache;
 
   static rs::Result<Manifest> tryParse(fs::path path = fs::current_path()
                                                        / FILE_NAME,
@@ -136,12 +220,44 @@ public:
 private:
   Manifest(fs::path path, Package package, std::vector<Dependency> dependencies,
            std::vector<Dependency> devDependencies,
-           std::unordered_map<BuildProfile, Profile> profiles,
-           Lint lint) noexcept
+           std::unordered_map<BuildProfile, Profile> profiles, Lint lint,
+           Build build, Cache cache) noexcept
       : path(std::move(path)), package(std::move(package)),
         dependencies(std::move(dependencies)),
         devDependencies(std::move(devDependencies)),
-        profiles(std::move(profiles)), lint(std::move(lint)) {}
+        profiles(std::move(profiles)), lint(std::move(lint)),
+        build(std::move(build)), cache(std::move(cache)) {}
+
+  // Snapshot cache of the validated manifest under `cabin-out/`, keyed by
+  // the manifest file's size, mtime, and content digest, so subsequent
+  // invocations skip the toml11 parse entirely.
+  static std::optional<Manifest>
+  loadSnapshot(const fs::path& snapshotFile, const fs::path& manifestPath,
+               std::uintmax_t size, std::int64_t mtime,
+               const std::string& digest) noexcept;
+  void saveSnapshot(const fs::path& snapshotFile, std::uintmax_t size,
+                    std::int64_t mtime,
+                    const std::string& digest) const noexcept;
+};
+
+/// The cheap subset of the manifest that light commands (`fmt`, `lint`,
+/// ...) need: `[package]` plus the lint table.  Skips dependency,
+/// profile, and build-table validation entirely, so such commands never
+/// pay for version-requirement parsing or path-dependency
+/// canonicalization.
+struct ManifestLite {
+  const fs::path path;
+  const Package package;
+  const Lint lint;
+
+  static rs::Result<ManifestLite>
+  tryParse(fs::path path = fs::current_path() / Manifest::FILE_NAME,
+           bool findParents = true) noexcept;
+
+private:
+  ManifestLite(fs::path path, Package package, Lint lint) noexcept
+      : path(std::move(path)), package(std::move(package)),
+        lint(std::move(lint)) {}
 };
 
 rs::Result<void> validatePackageName(std::string_view name) noexcept;
@@ -188,9 +304,12 @@ public:
   ldflags: {},
   lto: {},
   debug: {},
+  splitDebugInfo: {},
   optLevel: {},
+  pch: {},
 }})",
-                            p.cxxflags, p.ldflags, p.lto, p.debug, p.optLevel);
+                            p.cxxflags, p.ldflags, p.lto, p.debug,
+                            p.splitDebugInfo, p.optLevel, p.pch);
     }
   }
 };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <rs/result.hpp>
+#include <string>
+#include <string_view>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+#include <utility>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// Read-only memory mapping of one file, exposed as a string_view.  The
+/// kernel pages the content in on demand and shares it with the page
+/// cache, so mapping costs no copy at all; empty files map to an empty
+/// view.
+class MappedFile {
+public:
+  static rs::Result<MappedFile> open(const fs::path& path);
+
+  ~MappedFile();
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&&) = delete;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  std::string_view view() const { return { data_, size_ }; }
+
+private:
+  MappedFile() = default;
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+/// Process-wide LRU of file mappings, so the passes that each need a
+/// source file's bytes (the CABIN_TEST pre-scan, digesting, lint's
+/// content checks) share one mapping per file instead of re-reading it
+/// through buffered streams.  Entries are validated against (size,
+/// mtime), so an in-place rewrite — fmt -i re-digests files it just
+/// formatted — is observed instead of served stale.
+class MappedFileCache {
+public:
+  static MappedFileCache& instance() noexcept;
+
+  /// Returns the cached mapping for `path`, mapping it on a miss;
+  /// nullptr when the file cannot be mapped.  The returned pointer
+  /// keeps the mapping alive past eviction.
+  std::shared_ptr<const MappedFile> get(const fs::path& path);
+
+private:
+  MappedFileCache() = default;
+
+  // Mappings are address space, not memory: capacity bounds the number
+  // of live views, while the kernel keeps deciding what stays resident.
+  static constexpr std::size_t CAPACITY = 256;
+
+  struct Entry {
+    std::uintmax_t size = 0;
+    fs::file_time_type mtime;
+    std::shared_ptr<const MappedFile> mapping;
+    std::list<std::string>::iterator lruPos;
+  };
+
+  tbb::spin_mutex mtx;
+  std::list<std::string> lru; // most recently used first
+  std::unordered_map<std::string, Entry> entries;
+};
+
+} // namespace cabin
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+namespace cabin::profile {
+
+/// Whether hot-path profiling is active for this process, i.e. the
+/// CABIN_PROFILE environment variable is set and not "0".  Evaluated
+/// once and cached.
+bool isEnabled() noexcept;
+
+/// RAII timer aggregating the span of its own lifetime under `name`.
+/// Samples land in a per-thread buffer and are merged into a global
+/// summary table that is printed to stderr at process exit.  When
+/// profiling is off the constructor is a single cached branch, so spans
+/// can stay in hot paths permanently.
+///
+/// `name` must be a string literal (or otherwise outlive the process);
+/// only the pointer is stored.
+class Span {
+public:
+  explicit Span(const char* name) noexcept;
+  ~Span();
+
+  Span(const Span&) = delete;
+  Span(Span&&) = delete;
+  Span& operator=(const Span&) = delete;
+  Span& operator=(Span&&) = delete;
+
+private:
+  const char* name;
+  std::chrono::steady_clock::time_point start;
+  bool active;
+};
+
+} // namespace cabin::profile
@@ -4,17 +4,26 @@
 
 #include <cctype>
 #include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+#include <mutex>
 #include <optional>
 #include <rs/result.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <thread>
+#include <unistd.h>
+#include <unordered_map>
 #include <utility>
 
 namespace cabin {
 
+namespace fs = std::filesystem;
+
 std::string toMacroName(const std::string_view name) noexcept {
   std::string macroName;
   for (const unsigned char c : name) {
@@ -75,14 +84,60 @@ rs::Result<std::string> getCmdOutput(const Command& cmd,
           [stdErr = std::move(stdErr)] { return rs::anyhow(stdErr); });
 }
 
+static bool isExecutableFile(const std::string& path) noexcept {
+  std::error_code ec;
+  return fs::is_regular_file(path, ec) && ::access(path.c_str(), X_OK) == 0;
+}
+
+static bool searchPath(const std::string& cmd) noexcept {
+  if (cmd.find('/') != std::string::npos) {
+    return isExecutableFile(cmd);
+  }
+
+  const char* pathEnv = std::getenv("PATH");
+  if (pathEnv == nullptr) {
+    return false;
+  }
+
+  const std::string_view path = pathEnv;
+  std::size_t begin = 0;
+  while (begin <= path.size()) {
+    std::size_t end = path.find(':', begin);
+    if (end == std::string_view::npos) {
+      end = path.size();
+    }
+    const std::string_view dir = path.substr(begin, end - begin);
+    // An empty PATH entry means the current directory, per POSIX.
+    const std::string candidate =
+        fmt::format("{}/{}", dir.empty() ? "." : dir, cmd);
+    if (isExecutableFile(candidate)) {
+      return true;
+    }
+    begin = end + 1;
+  }
+  return false;
+}
+
 bool commandExists(const std::string_view cmd) noexcept {
-  return Command("which")
-      .addArg(cmd)
-      .setStdOutConfig(Command::IOConfig::Null)
-      .spawn()
-      .and_then(&Child::wait)
-      .map(&ExitStatus::success)
-      .unwrap_or(false);
+  // Probed tools repeat across a run (compiler siblings, formatters,
+  // linters), so memoize for the process lifetime.  Guarded by a mutex:
+  // probes also happen from parallel planning code.
+  static std::mutex mtx;
+  static std::unordered_map<std::string, bool> cache;
+
+  std::string name(cmd);
+  {
+    const std::scoped_lock lock(mtx);
+    if (const auto it = cache.find(name); it != cache.end()) {
+      return it->second;
+    }
+  }
+
+  const bool found = searchPath(name);
+
+  const std::scoped_lock lock(mtx);
+  cache.emplace(std::move(name), found);
+  return found;
 }
 
 } // namespace cabin
@@ -149,6 +204,12 @@ static void testLevDistance2() {
   static_assert(levDistance("aab", "aac") == 1UL);
   static_assert(levDistance("aaab", "aaac") == 1UL);
 
+  // Bounded search: exact when within maxDist, only `> maxDist`
+  // guaranteed otherwise.
+  static_assert(levDistance("ab", "ac", 1UL) == 1UL);
+  static_assert(levDistance("abc", "xyz", 1UL) > 1UL);
+  static_assert(levDistance("short", "a-much-longer-string", 3UL) > 3UL);
+
   rs::pass();
 }
 
@@ -190,12 +251,22 @@ static void testFindSimilarStr2() {
   rs::pass();
 }
 
+static void testCommandExists() {
+  rs::assertTrue(commandExists("sh"));
+  // Memoized path: the second query hits the cache.
+  rs::assertTrue(commandExists("sh"));
+  rs::assertFalse(commandExists("definitely-no-such-command-cabin"));
+
+  rs::pass();
+}
+
 int main() {
   testToLower();
   testLevDistance();
   testLevDistance2();
   testFindSimilarStr();
   testFindSimilarStr2();
+  testCommandExists();
 }
 
 #endif
@@ -0,0 +1,82 @@
+#include "Builder/BuildEvents.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <tbb/spin_mutex.h>
+
+namespace cabin {
+
+namespace {
+
+std::atomic<bool> streamEnabled{ false };
+
+// One line per event; the lock keeps parallel edges from interleaving
+// partial lines on stdout.
+void emitLine(const nlohmann::json& event) noexcept {
+  static tbb::spin_mutex mtx;
+  try {
+    const std::string line = event.dump();
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout); // consumers read events as they happen
+  } catch (...) {
+    // An unemittable event must not fail the build.
+  }
+}
+
+} // namespace
+
+void BuildEvents::enable() noexcept {
+  streamEnabled.store(true, std::memory_order_release);
+}
+
+bool BuildEvents::enabled() noexcept {
+  return streamEnabled.load(std::memory_order_acquire);
+}
+
+void BuildEvents::edgeStarted(const std::string_view rule,
+                              const std::string_view target) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  emitLine({ { "reason", "edge-started" },
+             { "rule", rule },
+             { "target", target } });
+}
+
+void BuildEvents::edgeFinished(const std::string_view rule,
+                               const std::string_view target,
+                               const std::int64_t durationMs,
+                               const bool success,
+                               const bool cached) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  emitLine({ { "reason", "edge-finished" },
+             { "rule", rule },
+             { "target", target },
+             { "duration_ms", durationMs },
+             { "success", success },
+             { "cached", cached } });
+}
+
+void BuildEvents::artifact(const fs::path& path) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  emitLine({ { "reason", "artifact" }, { "path", path.string() } });
+}
+
+void BuildEvents::buildFinished(const bool success) noexcept {
+  if (!enabled()) {
+    return;
+  }
+  emitLine({ { "reason", "build-finished" }, { "success", success } });
+}
+
+} // namespace cabin
@@ -1,13 +1,26 @@
 #include "Builder/BuildGraph.hpp"
 
 #include "Algos.hpp"
+#include "Builder/Executor.hpp"
+#include "Builder/HeaderGraph.hpp"
+#include "Builder/RemoteCache.hpp"
+#include "Builder/PlanCache.hpp"
+#include "Builder/StatJournal.hpp"
+#include "Builder/TemplateDedup.hpp"
 #include "Command.hpp"
 #include "Diag.hpp"
 #include "Git2.hpp"
+#include "GlobalConfig.hpp"
+#include "Jobserver.hpp"
+#include "MappedFile.hpp"
 #include "Parallelism.hpp"
+#include "Profile.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <fmt/core.h>
@@ -16,8 +29,10 @@
 #include <fstream>
 #include <iomanip>
 #include <map>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
+#include <span>
 #include <spdlog/spdlog.h>
 #include <sstream>
 #include <string>
@@ -26,7 +41,9 @@
 #include <tbb/blocked_range.h>
 #include <tbb/concurrent_vector.h>
 #include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
 #include <tbb/spin_mutex.h>
+#include <tbb/task_group.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -34,14 +51,52 @@
 
 namespace cabin {
 
-static std::string parentDirOrDot(const std::string& path) {
-  const fs::path parent = fs::path(path).parent_path();
-  if (parent.empty()) {
+// Plan targets are already generic-separator strings, so these helpers
+// slice them directly instead of round-tripping through fs::path (one
+// allocation per call in the hottest planner loops).
+static std::string parentDirOrDot(const std::string_view path) {
+  const std::size_t slash = path.find_last_of('/');
+  if (slash == std::string_view::npos) {
     return ".";
   }
-  return parent.generic_string();
+  if (slash == 0) {
+    return "/";
+  }
+  return std::string(path.substr(0, slash));
+}
+
+static std::string_view genericFileName(const std::string_view path) {
+  const std::size_t slash = path.find_last_of('/');
+  if (slash == std::string_view::npos) {
+    return path;
+  }
+  return path.substr(slash + 1);
+}
+
+// Match fs::path::stem(): a leading dot with no later dot is no
+// extension.
+static std::string_view genericStem(const std::string_view path) {
+  const std::string_view name = genericFileName(path);
+  const std::size_t dot = name.find_last_of('.');
+  if (dot == std::string_view::npos || dot == 0) {
+    return name;
+  }
+  return name.substr(0, dot);
+}
+
+static std::string_view genericExtension(const std::string_view path) {
+  const std::string_view name = genericFileName(path);
+  const std::size_t dot = name.find_last_of('.');
+  if (dot == std::string_view::npos || dot == 0) {
+    return {};
+  }
+  return name.substr(dot);
 }
 
+// Dependency attribution masks are one std::uint64_t per TU; a project
+// with more installed dependencies than bits links the full set.
+static constexpr std::size_t MAX_ATTRIBUTED_DEPS = 64;
+
 template <typename Range>
 static std::string joinFlags(const Range& range) {
   if (range.empty()) {
@@ -66,38 +121,111 @@ static std::string combineFlags(std::initializer_list<std::string_view> parts) {
 
 std::unordered_set<std::string> parseMMOutput(const std::string& mmOutput,
                                               std::string& target) {
-  std::istringstream iss(mmOutput);
-  std::getline(iss, target, ':');
+  // Single pass over the raw buffer: no stream, no per-token temporaries.
+  // Backslash-newline continuations are treated as whitespace in place,
+  // and `\ ` escapes (spaces inside paths) stay part of their token.
+  const std::string_view out = mmOutput;
+  const std::size_t colon = out.find(':');
+  target.assign(out.substr(0, colon == std::string_view::npos ? out.size()
+                                                              : colon));
+
+  const auto isSpace = [](const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  };
 
-  std::string dependency;
   std::unordered_set<std::string> deps;
-  bool isFirst = true;
-  while (std::getline(iss, dependency, ' ')) {
-    if (dependency.empty() || dependency.front() == '\\') {
-      continue;
+  std::size_t pos = colon == std::string_view::npos ? out.size() : colon + 1;
+  bool isFirst = true; // the first path is the source file itself
+  while (pos < out.size()) {
+    // Skip whitespace and line continuations.
+    while (pos < out.size()) {
+      const char c = out[pos];
+      if (isSpace(c)) {
+        ++pos;
+      } else if (c == '\\' && pos + 1 < out.size()
+                 && (out[pos + 1] == '\n' || out[pos + 1] == '\r')) {
+        pos += 2;
+      } else {
+        break;
+      }
     }
-    if (dependency.back() == '\n') {
-      dependency.pop_back();
+    if (pos >= out.size()) {
+      break;
     }
+
+    std::size_t end = pos;
+    bool escaped = false;
+    while (end < out.size()) {
+      const char c = out[end];
+      if (c == '\\' && end + 1 < out.size()) {
+        const char next = out[end + 1];
+        if (next == '\n' || next == '\r') {
+          break; // continuation ends the token
+        }
+        if (next == ' ') {
+          escaped = true;
+          end += 2;
+          continue;
+        }
+      }
+      if (isSpace(c)) {
+        break;
+      }
+      ++end;
+    }
+
+    const std::string_view token = out.substr(pos, end - pos);
+    pos = end;
     if (isFirst) {
       isFirst = false;
       continue;
     }
-    deps.insert(dependency);
+    if (!escaped) {
+      deps.emplace(token);
+      continue;
+    }
+    std::string unescaped;
+    unescaped.reserve(token.size());
+    for (std::size_t i = 0; i < token.size(); ++i) {
+      if (token[i] == '\\' && i + 1 < token.size() && token[i + 1] == ' ') {
+        continue;
+      }
+      unescaped.push_back(token[i]);
+    }
+    deps.insert(std::move(unescaped));
   }
   return deps;
 }
 
-std::vector<fs::path> listSourceFilePaths(const fs::path& dir) {
-  std::vector<fs::path> sourceFilePaths;
-  for (const auto& entry : fs::recursive_directory_iterator(dir)) {
-    if (!SOURCE_FILE_EXTS.contains(entry.path().extension().string())) {
-      continue;
+// Splits the output of a multi-input `-MM` invocation into one rule per
+// source.  A rule continues onto the next line while the current line ends
+// with a backslash.
+static std::vector<std::string> splitMMOutput(const std::string& mmOutput) {
+  std::vector<std::string> rules;
+  std::string current;
+  std::istringstream iss(mmOutput);
+  std::string line;
+  bool continued = false;
+  while (std::getline(iss, line)) {
+    if (!continued && !current.empty()) {
+      rules.push_back(std::move(current));
+      current.clear();
     }
-    sourceFilePaths.emplace_back(entry.path());
+    continued = !line.empty() && line.back() == '\\';
+    current += line;
+    current += '\n';
   }
-  std::ranges::sort(sourceFilePaths);
-  return sourceFilePaths;
+  if (!current.empty()) {
+    rules.push_back(std::move(current));
+  }
+  return rules;
+}
+
+std::vector<fs::path> listSourceFilePaths(const fs::path& dir) {
+  return walkDirParallel(
+      dir, { .includeEntry = [](const fs::directory_entry& entry) {
+        return SOURCE_FILE_EXTS.contains(entry.path().extension().string());
+      } });
 }
 
 BuildGraph::BuildGraph(BuildProfile buildProfileIn, std::string libNameIn,
@@ -106,27 +234,61 @@ BuildGraph::BuildGraph(BuildProfile buildProfileIn, std::string libNameIn,
       compiler(std::move(compilerIn)), buildProfile_(std::move(buildProfileIn)),
       libName(std::move(libNameIn)), ninjaPlan(outBasePath_) {}
 
-rs::Result<BuildGraph> BuildGraph::create(const Manifest& manifest,
-                                          const BuildProfile& buildProfile) {
+rs::Result<BuildGraph>
+BuildGraph::create(const Manifest& manifest, const BuildProfile& buildProfile,
+                   const std::optional<ProfileOverride>& profileOverride) {
+  const std::string_view libExt =
+      manifest.package.libType == Package::LibType::Shared ? "so" : "a";
   std::string libName;
   if (manifest.package.name.starts_with("lib")) {
-    libName = fmt::format("{}.a", manifest.package.name);
+    libName = fmt::format("{}.{}", manifest.package.name, libExt);
   } else {
-    libName = fmt::format("lib{}.a", manifest.package.name);
+    libName = fmt::format("lib{}.{}", manifest.package.name, libExt);
   }
 
-  Project project = rs_try(Project::init(buildProfile, manifest));
+  // Manifest-configured scheduling classes apply to everything this
+  // process spawns from here on: scans, compiles, and links alike.
+  lowerProcessPriority(static_cast<int>(manifest.build.nice),
+                       manifest.build.ioClass);
+
+  Project project =
+      rs_try(Project::init(buildProfile, manifest, profileOverride));
+  Compiler compiler = rs_try(Compiler::init());
+  compiler.addLinkFlags(project.compilerOpts, project.profile.lto);
   return rs::Ok(BuildGraph(buildProfile, std::move(libName), std::move(project),
-                           rs_try(Compiler::init())));
+                           std::move(compiler)));
+}
+
+std::vector<fs::path> BuildGraph::watchedPaths() const {
+  return {
+    project.rootPath / "src",     project.rootPath / "lib",
+    project.rootPath / "include", project.rootPath / "tests",
+    project.manifest.path,
+  };
+}
+
+bool BuildGraph::sourceTreeUnchanged() const {
+  const auto journal = StatJournal::load(outBasePath_);
+  return journal.has_value() && !journal->empty()
+         && journal->matchesCurrentTree();
 }
 
 bool BuildGraph::isUpToDate(const std::string_view fileName) const {
+  const profile::Span span("BuildGraph::isUpToDate");
   const fs::path filePath = outBasePath_ / fileName;
 
   if (!fs::exists(filePath)) {
     return false;
   }
 
+  // Prefer the stat journal written after the last plan: one stat per
+  // journaled path, bailing at the first mismatch, instead of walking and
+  // statting the whole tree.
+  if (const auto journal = StatJournal::load(outBasePath_);
+      journal.has_value() && !journal->empty()) {
+    return journal->matchesCurrentTree();
+  }
+
   const fs::file_time_type configTime = fs::last_write_time(filePath);
   const std::array<fs::path, 4> watchedDirs{
     project.rootPath / "src",
@@ -138,17 +300,23 @@ bool BuildGraph::isUpToDate(const std::string_view fileName) const {
     if (!fs::exists(dir)) {
       continue;
     }
-    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
-      if (fs::last_write_time(entry.path()) > configTime) {
-        return false;
-      }
+    const std::vector<fs::path> entries = walkDirParallel(dir);
+    if (std::ranges::any_of(entries, [configTime](const fs::path& path) {
+          return fs::last_write_time(path) > configTime;
+        })) {
+      return false;
     }
   }
   return fs::last_write_time(project.manifest.path) <= configTime;
 }
 
 std::string BuildGraph::mapHeaderToObj(const fs::path& headerPath) const {
-  const fs::path objBase = fs::relative(project.buildOutPath, outBasePath_);
+  // Constant for the graph's lifetime; computing it per header showed up
+  // as avoidable fs::relative churn in collectBinDepObjs.
+  if (!headerObjBase_.has_value()) {
+    headerObjBase_ = fs::relative(project.buildOutPath, outBasePath_);
+  }
+  const fs::path& objBase = *headerObjBase_;
 
   const auto makeObjPath = [&](const fs::path& relDir, const fs::path& prefix) {
     fs::path objPath = objBase;
@@ -200,38 +368,407 @@ std::string BuildGraph::mapHeaderToObj(const fs::path& headerPath) const {
 
 void BuildGraph::registerCompileUnit(
     const std::string& objTarget, const std::string& sourceFile,
-    const std::unordered_set<std::string>& dependencies, const bool isTest) {
+    const std::unordered_set<std::string>& dependencies, const bool isTest,
+    const std::string_view extraCompileFlags) {
   compileUnits[objTarget] = CompileUnit{ .source = sourceFile,
-                                         .dependencies = dependencies,
+                                         .dependencies =
+                                             internPaths(dependencies),
                                          .isTest = isTest };
 
+  // Per-TU dependency attribution for link-what-you-use: one bit per
+  // installed dependency, set when any scanned header lives under its
+  // include root.  More than 64 dependencies disables pruning outright.
+  if (!depLinkUses_.empty() && depLinkUses_.size() <= MAX_ATTRIBUTED_DEPS) {
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < depLinkUses_.size(); ++i) {
+      const bool consumed = std::ranges::any_of(
+          depLinkUses_[i].includeDirs, [&dependencies](const std::string& dir) {
+            return std::ranges::any_of(dependencies,
+                                       [&dir](const std::string& header) {
+                                         return header.starts_with(dir);
+                                       });
+          });
+      if (consumed) {
+        mask |= std::uint64_t{ 1 } << i;
+      }
+    }
+    tuDepLibMask_[objTarget] = mask;
+  }
+
   NinjaEdge edge;
   edge.outputs = { objTarget };
+  if (splitDwarf_) {
+    // -gsplit-dwarf writes the debug info next to the object; track it so
+    // a deleted .dwo recompiles and clean outputs stay accountable.
+    edge.implicitOutputs = {
+      fs::path(objTarget).replace_extension(".dwo").generic_string()
+    };
+  }
   edge.rule = "cxx_compile";
   edge.inputs = { sourceFile };
   edge.implicitInputs.assign(dependencies.begin(), dependencies.end());
   std::ranges::sort(edge.implicitInputs);
   edge.bindings.emplace_back("out_dir", parentDirOrDot(objTarget));
-  edge.bindings.emplace_back("extra_flags", isTest ? "-DCABIN_TEST" : "");
+  std::string extraFlags = isTest ? "-DCABIN_TEST" : "";
+  if (!extraCompileFlags.empty()) {
+    extraFlags = combineFlags({ extraFlags, extraCompileFlags });
+  }
+  if (!pchTarget.empty()) {
+    extraFlags = combineFlags(
+        { extraFlags, "-Winvalid-pch -include cabin-pch.hpp" });
+    edge.implicitInputs.push_back(pchTarget);
+  }
+  if (!dedupObject_.empty()) {
+    // Every TU externs the registered instantiations; only the dedup TU
+    // (whose edge is built in configure) compiles their definitions.
+    extraFlags =
+        combineFlags({ extraFlags, "-include cabin-dedup.hpp" });
+    edge.implicitInputs.push_back(TemplateDedup::HEADER_FILE);
+  }
+  // Without per-importer module scans every TU conservatively depends on
+  // every BMI; an interface change recompiles all potential importers.
+  edge.implicitInputs.insert(edge.implicitInputs.end(),
+                             modulePcmTargets_.begin(),
+                             modulePcmTargets_.end());
+  edge.bindings.emplace_back("extra_flags", std::move(extraFlags));
   ninjaPlan.addEdge(std::move(edge));
 }
 
-void BuildGraph::writeBuildFiles() const {
-  const NinjaToolchain toolchain{
+void BuildGraph::appendLibraryObjects(
+    std::vector<std::string>& linkInputs, const std::string_view underTestStem,
+    std::unordered_set<std::string>* linkSeen) const {
+  if (!hasLibraryTarget_) {
+    return;
+  }
+  // A shared library is the linkable artifact itself; only static
+  // archives can be bypassed in favor of their object list.
+  if (project.manifest.package.libType == Package::LibType::Shared) {
+    linkInputs.push_back(libName);
+    return;
+  }
+  for (const std::string& obj : libObjectList_) {
+    if (!underTestStem.empty() && fs::path(obj).stem() == underTestStem) {
+      continue;
+    }
+    if (linkSeen == nullptr || linkSeen->insert(obj).second) {
+      linkInputs.push_back(obj);
+    }
+  }
+}
+
+// Every link edge is born with the global $LIBS, so each test binary
+// re-resolves symbols against every dependency's libraries whether or
+// not its object closure touched them — and the dynamic loader repeats
+// the work at every test startup.  Using the per-TU masks recorded by
+// registerCompileUnit, edges whose complete input closure is attributed
+// get a per-edge LIBS binding holding only what some input consumed.
+// Anything unattributable keeps the full set: a dependency without its
+// own include root (headers in a default search path), or an input with
+// no scan record (module and dedup objects, unity groups).
+void BuildGraph::pruneLinkLibs() {
+  if (depLinkUses_.empty() || depLinkUses_.size() > MAX_ATTRIBUTED_DEPS) {
+    return;
+  }
+
+  // Libraries keep the global order; one is prunable only when every
+  // dependency contributing it can be attributed by include root.
+  std::unordered_map<std::string, std::uint64_t> libOwners;
+  std::unordered_set<std::string> alwaysKeep;
+  for (std::size_t i = 0; i < depLinkUses_.size(); ++i) {
+    const DepLinkUse& use = depLinkUses_[i];
+    for (const std::string& lib : use.libs) {
+      if (use.includeDirs.empty()) {
+        alwaysKeep.insert(lib);
+      } else {
+        libOwners[lib] |= std::uint64_t{ 1 } << i;
+      }
+    }
+  }
+  if (libOwners.empty()) {
+    return;
+  }
+
+  // The shared library input stands for its whole object list.
+  std::uint64_t libTargetMask = 0;
+  bool libTargetKnown = hasLibraryTarget_;
+  for (const std::string& obj : libObjectList_) {
+    const auto found = tuDepLibMask_.find(obj);
+    if (found == tuDepLibMask_.end()) {
+      libTargetKnown = false;
+      break;
+    }
+    libTargetMask |= found->second;
+  }
+
+  for (NinjaEdge& edge : ninjaPlan.mutableEdges()) {
+    if (edge.rule != "cxx_link_exe" && edge.rule != "cxx_link_shared") {
+      continue;
+    }
+    std::uint64_t mask = 0;
+    bool known = true;
+    for (const std::string& input : edge.inputs) {
+      if (const auto found = tuDepLibMask_.find(input);
+          found != tuDepLibMask_.end()) {
+        mask |= found->second;
+      } else if (input == libName && libTargetKnown) {
+        mask |= libTargetMask;
+      } else {
+        known = false;
+        break;
+      }
+    }
+    if (!known) {
+      continue;
+    }
+
+    std::vector<Lib> kept;
+    kept.reserve(project.compilerOpts.ldFlags.libs.size());
+    for (const Lib& lib : project.compilerOpts.ldFlags.libs) {
+      const auto owners = libOwners.find(lib.name);
+      if (owners == libOwners.end() || alwaysKeep.contains(lib.name)
+          || (owners->second & mask) != 0) {
+        kept.push_back(lib);
+      }
+    }
+    if (kept.size() == project.compilerOpts.ldFlags.libs.size()) {
+      continue; // nothing pruned; the global $LIBS already matches
+    }
+    edge.bindings.emplace_back("LIBS", joinFlags(kept));
+  }
+}
+
+// A compile edge listing its whole header closure repeats every common
+// header once per TU, so targets.ninja grows with (TUs x closure depth)
+// and ninja re-parses all of it on every run.  Instead the include DAG
+// is stored once: each header gets one shared phony alias node
+// (`H^hdr`, built from H plus the aliases of H's direct includes), and
+// a reduced compile edge names only the aliases of its own direct
+// includes.  Both ninja and the embedded executor relay the newest
+// transitive mtime through phony nodes, so rebuild behavior is
+// unchanged.  An edge is rewritten only when HeaderGraph proves the
+// alias walk reproduces the scanned `-MM` closure exactly; anything
+// else (unity groups, conditional includes, computed includes) keeps
+// its flat listing.
+void BuildGraph::reduceHeaderEdges() {
+  std::vector<fs::path> searchDirs;
+  searchDirs.reserve(project.compilerOpts.cFlags.includeDirs.size());
+  for (const IncludeDir& dir : project.compilerOpts.cFlags.includeDirs) {
+    searchDirs.push_back(dir.dir);
+  }
+  HeaderGraph graph(std::move(searchDirs), outBasePath_);
+
+  for (const auto& [objTarget, unit] : compileUnits) {
+    for (const std::uint32_t id : unit.dependencies) {
+      graph.addKnownHeader(pathTable.str(id));
+    }
+  }
+
+  const auto aliasName = [](const std::string& header) {
+    return header + "^hdr";
+  };
+
+  std::unordered_set<std::string> aliased;
+  std::vector<std::string> aliasWorklist;
+  const auto requestAlias = [&](const std::string& header) {
+    if (aliased.insert(header).second) {
+      aliasWorklist.push_back(header);
+    }
+  };
+
+  for (NinjaEdge& edge : ninjaPlan.mutableEdges()) {
+    if (edge.rule != "cxx_compile" || edge.inputs.size() != 1) {
+      continue;
+    }
+    const auto unit = compileUnits.find(edge.outputs.front());
+    if (unit == compileUnits.end()) {
+      continue;
+    }
+
+    std::unordered_set<std::string> scanned; // the raw `-MM` spellings
+    std::unordered_set<std::string> closure; // normalized
+    for (const std::uint32_t id : unit->second.dependencies) {
+      const std::string& path = pathTable.str(id);
+      scanned.insert(path);
+      closure.insert(graph.normalize(path));
+    }
+
+    const auto direct =
+        graph.reduce(graph.normalize(edge.inputs.front()), closure);
+    if (!direct.has_value()) {
+      continue;
+    }
+
+    // The scanned headers are replaced by their direct-include aliases;
+    // non-header extras (PCH, dedup header, module BMIs) stay put.
+    std::vector<std::string> reduced;
+    reduced.reserve(edge.implicitInputs.size());
+    for (std::string& input : edge.implicitInputs) {
+      if (!scanned.contains(input)) {
+        reduced.push_back(std::move(input));
+      }
+    }
+    for (const std::string& header : *direct) {
+      requestAlias(header);
+      reduced.push_back(aliasName(header));
+    }
+    std::ranges::sort(reduced);
+    edge.implicitInputs = std::move(reduced);
+  }
+
+  // Close the alias set over the DAG first, then emit sorted, so
+  // targets.ninja stays byte-stable across replans regardless of the
+  // unordered iteration above.
+  for (std::size_t i = 0; i < aliasWorklist.size(); ++i) {
+    const std::string header = aliasWorklist[i]; // the list grows below
+    for (const std::string& inc : graph.directIncludes(header)) {
+      requestAlias(inc);
+    }
+  }
+  std::ranges::sort(aliasWorklist);
+
+  for (const std::string& header : aliasWorklist) {
+    NinjaEdge alias;
+    alias.outputs = { aliasName(header) };
+    alias.rule = "phony";
+    alias.inputs = { header };
+    for (const std::string& inc : graph.directIncludes(header)) {
+      alias.inputs.push_back(aliasName(inc));
+    }
+    ninjaPlan.addEdge(std::move(alias));
+  }
+}
+
+rs::Result<void> BuildGraph::planModules(const fs::path& srcDir,
+                                         const fs::path& libDir) {
+  modulePcmTargets_.clear();
+  srcModuleObjects.clear();
+  libModuleObjects.clear();
+
+  struct ModuleUnit {
+    fs::path source;
+    ModuleDeps deps;
+    bool inLib = false;
+  };
+  std::vector<ModuleUnit> units;
+  const auto collect = [&](const fs::path& dir,
+                           const bool inLib) -> rs::Result<void> {
+    if (!fs::exists(dir)) {
+      return rs::Ok();
+    }
+    const std::vector<fs::path> moduleSources = walkDirParallel(
+        dir, { .includeEntry = [](const fs::directory_entry& entry) {
+          return MODULE_FILE_EXTS.contains(entry.path().extension().string());
+        } });
+    for (const fs::path& source : moduleSources) {
+      units.push_back(ModuleUnit{
+          source,
+          rs_try(compiler.scanModuleDeps(project.compilerOpts,
+                                         source.string())),
+          inLib });
+    }
+    return rs::Ok();
+  };
+  rs_try(collect(srcDir, /*inLib=*/false));
+  rs_try(collect(libDir, /*inLib=*/true));
+  if (units.empty()) {
+    return rs::Ok();
+  }
+
+  // BMIs all land in modules/ under the out dir, named after the logical
+  // module (partitions use `-`), which is exactly what
+  // -fprebuilt-module-path resolves against.
+  const auto pcmStem = [](const std::string& logicalName) {
+    std::string stem = logicalName;
+    std::ranges::replace(stem, ':', '-');
+    return stem;
+  };
+  std::unordered_map<std::string, std::string> pcmByName;
+  for (const ModuleUnit& unit : units) {
+    rs_ensure(!unit.deps.provides.empty(),
+              "module source `{}` does not export a module",
+              unit.source.string());
+    rs_ensure(
+        pcmByName
+            .emplace(unit.deps.provides,
+                     fmt::format("modules/{}.pcm", pcmStem(unit.deps.provides)))
+            .second,
+        "module `{}` is exported by multiple sources", unit.deps.provides);
+  }
+
+  for (ModuleUnit& unit : units) {
+    const std::string& pcmTarget = pcmByName.at(unit.deps.provides);
+
+    NinjaEdge bmiEdge;
+    bmiEdge.outputs = { pcmTarget };
+    bmiEdge.rule = "cxx_module_bmi";
+    bmiEdge.inputs = { unit.source.string() };
+    for (const std::string& import : unit.deps.imports) {
+      const auto it = pcmByName.find(import);
+      rs_ensure(it != pcmByName.end(),
+                "module `{}` imported by `{}` is not provided by this package",
+                import, unit.source.string());
+      bmiEdge.implicitInputs.push_back(it->second);
+    }
+    std::ranges::sort(bmiEdge.implicitInputs);
+    bmiEdge.bindings.emplace_back("out_dir", "modules");
+    bmiEdge.bindings.emplace_back("extra_flags", "");
+    ninjaPlan.addEdge(std::move(bmiEdge));
+
+    // The BMI also compiles to a regular object that joins the link.
+    fs::path objOutput = project.buildOutPath;
+    if (unit.inLib) {
+      objOutput /= "lib";
+    }
+    objOutput /= fmt::format("{}.o", pcmStem(unit.deps.provides));
+    const std::string objTarget =
+        fs::relative(objOutput, outBasePath_).generic_string();
+
+    NinjaEdge objEdge;
+    objEdge.outputs = { objTarget };
+    if (splitDwarf_) {
+      objEdge.implicitOutputs = {
+        fs::path(objTarget).replace_extension(".dwo").generic_string()
+      };
+    }
+    objEdge.rule = "cxx_compile";
+    objEdge.inputs = { pcmTarget };
+    objEdge.bindings.emplace_back("out_dir", parentDirOrDot(objTarget));
+    objEdge.bindings.emplace_back("extra_flags", "");
+    ninjaPlan.addEdge(std::move(objEdge));
+
+    (unit.inLib ? libModuleObjects : srcModuleObjects).insert(objTarget);
+    modulePcmTargets_.push_back(pcmTarget);
+  }
+  std::ranges::sort(modulePcmTargets_);
+
+  // Any TU may import these; the prebuilt lookup path plus the implicit
+  // BMI inputs registerCompileUnit adds give correct ordering without
+  // per-importer module scans.
+  cxxFlags = combineFlags({ cxxFlags, "-fprebuilt-module-path=modules" });
+  return rs::Ok();
+}
+
+NinjaToolchain BuildGraph::makeToolchain() const {
+  return NinjaToolchain{
     .cxx = compiler.cxx,
+    .cxxWrapper = project.manifest.build.wrapper,
     .cxxFlags = cxxFlags,
     .defines = defines,
     .includes = includes,
     .ldFlags = ldFlags,
     .libs = libs,
     .archiver = archiver,
+    .archiveFlags = archiveFlags,
   };
+}
 
-  ninjaPlan.writeFiles(toolchain);
+void BuildGraph::writeBuildFiles() const {
+  ninjaPlan.writeFiles(makeToolchain());
 }
 
 rs::Result<std::string> BuildGraph::runMM(const std::string& sourceFile,
                                           const bool isTest) const {
+  const profile::Span span("BuildGraph::runMM");
   Command command = compiler.makeMMCmd(project.compilerOpts, sourceFile);
   if (isTest) {
     command.addArg("-DCABIN_TEST");
@@ -240,15 +777,127 @@ rs::Result<std::string> BuildGraph::runMM(const std::string& sourceFile,
   return getCmdOutput(command);
 }
 
-rs::Result<bool>
-BuildGraph::containsTestCode(const std::string& sourceFile) const {
-  std::ifstream ifs(sourceFile);
-  std::string line;
-  while (std::getline(ifs, line)) {
-    if (!line.contains("CABIN_TEST")) {
-      continue;
+rs::Result<std::pair<std::string, std::unordered_set<std::string>>>
+BuildGraph::scanDeps(const fs::path& sourceFilePath, const bool isTest) {
+  const std::string sourceFile = sourceFilePath.string();
+  const std::string contentDigest = scanCache.fileDigest(sourceFilePath);
+  const std::string flagsDigest =
+      isTest ? scanFlagsDigest + "+test" : scanFlagsDigest;
+
+  if (auto cached = scanCache.lookup(sourceFile, contentDigest, flagsDigest);
+      cached.has_value()) {
+    spdlog::trace("scan cache hit: {}", sourceFile);
+    return rs::Ok(std::make_pair(std::move(cached->objTarget),
+                                 std::move(cached->dependencies)));
+  }
+
+  std::string objTarget;
+  std::unordered_set<std::string> dependencies =
+      parseMMOutput(rs_try(runMM(sourceFile, isTest)), objTarget);
+
+  ScanEntry entry;
+  entry.contentDigest = contentDigest;
+  entry.flagsDigest = flagsDigest;
+  entry.depsDigest = scanCache.depsDigest(dependencies);
+  entry.objTarget = objTarget;
+  entry.dependencies = dependencies;
+  scanCache.insert(sourceFile, std::move(entry));
+
+  return rs::Ok(std::make_pair(std::move(objTarget), std::move(dependencies)));
+}
+
+static bool isIdentChar(const char c) {
+  return (std::isalnum(static_cast<unsigned char>(c)) != 0) || c == '_';
+}
+
+// Cheap tokenizer gate for containsTestCode: true only if `CABIN_TEST`
+// appears as a whole token outside of comments.  Over-approximates (string
+// literals pass), never under-approximates; the preprocessor comparison
+// remains the authority.
+static bool mentionsCabinTest(const std::string& sourceFile) {
+  static constexpr std::string_view TOKEN = "CABIN_TEST";
+
+  // Scan the shared mapping instead of a buffered line-by-line read;
+  // other passes (digesting) reuse the same bytes.
+  const std::shared_ptr<const MappedFile> mapped =
+      MappedFileCache::instance().get(sourceFile);
+  if (!mapped) {
+    return false;
+  }
+  const std::string_view content = mapped->view();
+
+  bool inBlockComment = false;
+  std::size_t lineBegin = 0;
+  while (lineBegin <= content.size()) {
+    std::size_t lineEnd = content.find('\n', lineBegin);
+    if (lineEnd == std::string_view::npos) {
+      if (lineBegin == content.size()) {
+        break;
+      }
+      lineEnd = content.size();
+    }
+    const std::string_view line =
+        content.substr(lineBegin, lineEnd - lineBegin);
+    lineBegin = lineEnd + 1;
+
+    std::size_t pos = 0;
+    while (pos < line.size()) {
+      if (inBlockComment) {
+        const std::size_t end = line.find("*/", pos);
+        if (end == std::string_view::npos) {
+          pos = line.size();
+          break;
+        }
+        inBlockComment = false;
+        pos = end + 2;
+        continue;
+      }
+      const std::size_t lineComment = line.find("//", pos);
+      const std::size_t blockComment = line.find("/*", pos);
+      std::size_t codeEnd = line.size();
+      if (lineComment != std::string_view::npos
+          && lineComment < blockComment) {
+        codeEnd = lineComment;
+      } else if (blockComment != std::string_view::npos) {
+        codeEnd = blockComment;
+      }
+
+      std::size_t found = line.find(TOKEN, pos);
+      while (found != std::string_view::npos
+             && found + TOKEN.size() <= codeEnd) {
+        const bool boundedLeft = found == 0 || !isIdentChar(line[found - 1]);
+        const bool boundedRight = found + TOKEN.size() == line.size()
+                                  || !isIdentChar(line[found + TOKEN.size()]);
+        if (boundedLeft && boundedRight) {
+          return true;
+        }
+        found = line.find(TOKEN, found + 1);
+      }
+
+      if (codeEnd == line.size()) {
+        break;
+      }
+      if (codeEnd == lineComment) {
+        break;
+      }
+      inBlockComment = true;
+      pos = codeEnd + 2;
     }
+  }
+  return false;
+}
+
+rs::Result<bool> BuildGraph::containsTestCode(const std::string& sourceFile) {
+  const profile::Span span("BuildGraph::containsTestCode");
+  const std::string contentDigest = scanCache.fileDigest(sourceFile);
+  if (const auto cached = scanCache.lookupTestVerdict(sourceFile, contentDigest,
+                                                      scanFlagsDigest);
+      cached.has_value()) {
+    return rs::Ok(*cached);
+  }
 
+  bool containsTest = false;
+  if (mentionsCabinTest(sourceFile)) {
     Command command =
         compiler.makePreprocessCmd(project.compilerOpts, sourceFile);
     const std::string src = rs_try(getCmdOutput(command));
@@ -256,22 +905,20 @@ BuildGraph::containsTestCode(const std::string& sourceFile) const {
     command.addArg("-DCABIN_TEST");
     const std::string testSrc = rs_try(getCmdOutput(command));
 
-    const bool containsTest = src != testSrc;
+    containsTest = src != testSrc;
     if (containsTest) {
       spdlog::trace("Found test code: {}", sourceFile);
     }
-    return rs::Ok(containsTest);
   }
-  return rs::Ok(false);
+  scanCache.insertTestVerdict(sourceFile, contentDigest, scanFlagsDigest,
+                              containsTest);
+  return rs::Ok(containsTest);
 }
 
-rs::Result<void>
-BuildGraph::processSrc(const fs::path& sourceFilePath, const SourceRoot& root,
-                       std::unordered_set<std::string>& buildObjTargets,
-                       tbb::spin_mutex* mtx) {
-  std::string objTarget;
-  const std::unordered_set<std::string> objTargetDeps =
-      parseMMOutput(rs_try(runMM(sourceFilePath)), objTarget);
+rs::Result<BuildGraph::ScannedUnit>
+BuildGraph::scanSrc(const fs::path& sourceFilePath, const SourceRoot& root) {
+  auto [objTarget, objTargetDeps] =
+      rs_try(scanDeps(sourceFilePath, /*isTest=*/false));
 
   std::error_code ec;
   const fs::path targetBaseDir =
@@ -292,119 +939,285 @@ BuildGraph::processSrc(const fs::path& sourceFilePath, const SourceRoot& root,
   }
 
   const fs::path objOutput = buildTargetBaseDir / objTarget;
-  const std::string buildObjTarget =
-      fs::relative(objOutput, outBasePath_).generic_string();
+  return rs::Ok(ScannedUnit{
+      .objTarget = fs::relative(objOutput, outBasePath_).generic_string(),
+      .source = sourceFilePath.string(),
+      .dependencies = std::move(objTargetDeps),
+  });
+}
 
-  if (mtx) {
-    mtx->lock();
-  }
-  buildObjTargets.insert(buildObjTarget);
-  registerCompileUnit(buildObjTarget, sourceFilePath.string(), objTargetDeps,
+rs::Result<void>
+BuildGraph::processSrc(const fs::path& sourceFilePath, const SourceRoot& root,
+                       std::unordered_set<std::string>& buildObjTargets) {
+  const ScannedUnit unit = rs_try(scanSrc(sourceFilePath, root));
+  buildObjTargets.insert(unit.objTarget);
+  registerCompileUnit(unit.objTarget, unit.source, unit.dependencies,
                       /*isTest=*/false);
-  if (mtx) {
-    mtx->unlock();
-  }
   return rs::Ok();
 }
 
-rs::Result<std::unordered_set<std::string>>
-BuildGraph::processSources(const std::vector<fs::path>& sourceFilePaths,
-                           const SourceRoot& root) {
-  std::unordered_set<std::string> buildObjTargets;
+// Smallest slice worth its own `-MM` process; below this the fork/exec
+// costs more than the scan itself.
+static constexpr std::size_t MIN_SCAN_BATCH = 8;
+
+// One scan process per available worker, each fed an equal slice of the
+// misses.  A thousand-file scan then costs `-j` spawns total instead of
+// one per fixed-size chunk, which is what dominates planning on
+// high-spawn-cost systems; the floor above keeps small scans from
+// splitting into slices that are all startup.
+static std::size_t scanBatchSize(const std::size_t numMisses) {
+  const std::size_t maxWorkers =
+      (numMisses + MIN_SCAN_BATCH - 1) / MIN_SCAN_BATCH;
+  const std::size_t workers =
+      std::max<std::size_t>(1, std::min(getParallelism(), maxWorkers));
+  return (numMisses + workers - 1) / workers;
+}
+
+rs::Result<void>
+BuildGraph::prescanSources(const std::vector<fs::path>& sourceFilePaths,
+                           const bool isTest) {
+  const std::string flagsDigest =
+      isTest ? scanFlagsDigest + "+test" : scanFlagsDigest;
+
+  std::vector<std::string> misses;
+  for (const fs::path& sourceFilePath : sourceFilePaths) {
+    const std::string sourceFile = sourceFilePath.string();
+    if (!scanCache
+             .lookup(sourceFile, scanCache.fileDigest(sourceFilePath),
+                     flagsDigest)
+             .has_value()) {
+      misses.push_back(sourceFile);
+    }
+  }
+  if (misses.size() < 2) {
+    return rs::Ok();
+  }
+
+  const auto scanBatch =
+      [&](const std::span<const std::string> batch) -> rs::Result<void> {
+    Command command = compiler.makeMMCmd(project.compilerOpts, batch);
+    if (isTest) {
+      command.addArg("-DCABIN_TEST");
+    }
+    command.setWorkingDirectory(outBasePath_);
+
+    const std::string output = rs_try(getCmdOutput(command));
+    const std::vector<std::string> rules = splitMMOutput(output);
+    rs_ensure(rules.size() == batch.size(),
+              "batched scan produced {} rules for {} sources", rules.size(),
+              batch.size());
+
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      std::string objTarget;
+      std::unordered_set<std::string> dependencies =
+          parseMMOutput(rules[i], objTarget);
+
+      ScanEntry entry;
+      entry.contentDigest = scanCache.fileDigest(batch[i]);
+      entry.flagsDigest = flagsDigest;
+      entry.depsDigest = scanCache.depsDigest(dependencies);
+      entry.objTarget = std::move(objTarget);
+      entry.dependencies = std::move(dependencies);
+      scanCache.insert(batch[i], std::move(entry));
+    }
+    return rs::Ok();
+  };
+
+  const std::size_t batchSize = scanBatchSize(misses.size());
+  const std::size_t numBatches = (misses.size() + batchSize - 1) / batchSize;
+  spdlog::debug("batch-scanning {} sources in {} processes", misses.size(),
+                numBatches);
 
   if (isParallel()) {
-    tbb::concurrent_vector<std::string> results;
-    tbb::spin_mutex mtx;
+    tbb::concurrent_vector<std::string> errors;
+    // First failure cancels the remaining batches (unless keep-going):
+    // a typo in a common header fails every TU, and time-to-first-error
+    // beats a full scan of guaranteed failures.
+    std::atomic<bool> failed{ false };
+    tbb::task_group_context ctx;
     tbb::parallel_for(
-        tbb::blocked_range<std::size_t>(0, sourceFilePaths.size()),
+        tbb::blocked_range<std::size_t>(0, numBatches),
         [&](const tbb::blocked_range<std::size_t>& rng) {
           for (std::size_t i = rng.begin(); i != rng.end(); ++i) {
+            if (failed.load(std::memory_order_relaxed)) {
+              return;
+            }
+            const std::size_t offset = i * batchSize;
+            const std::size_t count =
+                std::min(batchSize, misses.size() - offset);
             std::ignore =
-                processSrc(sourceFilePaths[i], root, buildObjTargets, &mtx)
-                    .map_err([&results](const auto& err) {
-                      results.push_back(err->what());
+                scanBatch(std::span(misses).subspan(offset, count))
+                    .map_err([&](const auto& err) {
+                      errors.push_back(err->what());
+                      if (!keepGoing_) {
+                        failed.store(true, std::memory_order_relaxed);
+                        ctx.cancel_group_execution();
+                      }
                     });
           }
-        });
-    if (!results.empty()) {
-      rs_bail("{}", fmt::join(results, "\n"));
+        },
+        tbb::auto_partitioner(), ctx);
+    if (!errors.empty()) {
+      rs_bail("{}", fmt::join(errors, "\n"));
     }
   } else {
-    for (const fs::path& sourceFilePath : sourceFilePaths) {
-      rs_try(processSrc(sourceFilePath, root, buildObjTargets));
+    for (std::size_t offset = 0; offset < misses.size();
+         offset += batchSize) {
+      const std::size_t count = std::min(batchSize, misses.size() - offset);
+      rs_try(scanBatch(std::span(misses).subspan(offset, count)));
     }
   }
-  return rs::Ok(buildObjTargets);
+  return rs::Ok();
 }
 
-rs::Result<std::optional<BuildGraph::TestTarget>>
-BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
-                               tbb::spin_mutex* mtx) {
-  if (!rs_try(containsTestCode(sourceFilePath))) {
-    return rs::Ok(std::optional<TestTarget>());
+rs::Result<std::unordered_set<std::string>>
+BuildGraph::processSourcesUnity(const std::vector<fs::path>& sourceFilePaths,
+                                const SourceRoot& root) {
+  std::unordered_set<std::string> buildObjTargets;
+  if (sourceFilePaths.empty()) {
+    return rs::Ok(buildObjTargets);
   }
 
-  std::string objTarget;
-  const std::unordered_set<std::string> objTargetDeps =
-      parseMMOutput(rs_try(runMM(sourceFilePath, /*isTest=*/true)), objTarget);
+  rs_try(prescanSources(sourceFilePaths, /*isTest=*/false));
 
-  fs::path relBase = fs::path("unit");
+  const std::string rootTag = root.objectSubdir.empty()
+                                  ? std::string("src")
+                                  : root.objectSubdir.generic_string();
+  const fs::path unityDir = outBasePath_ / "unity";
+  fs::create_directories(unityDir);
 
-  const auto canonicalOrGeneric = [](const fs::path& path) {
-    std::error_code ec;
-    const fs::path canonical = fs::weakly_canonical(path, ec);
-    if (ec) {
-      return path.lexically_normal().generic_string();
-    }
-    return canonical.generic_string();
-  };
+  fs::path buildTargetBaseDir = project.buildOutPath;
+  if (!root.objectSubdir.empty()) {
+    buildTargetBaseDir /= root.objectSubdir;
+  }
 
-  const std::string canonicalSource = canonicalOrGeneric(sourceFilePath);
-  const std::string canonicalSrcRoot =
-      canonicalOrGeneric(project.rootPath / "src");
-  const std::string canonicalLibRoot =
-      canonicalOrGeneric(project.rootPath / "lib");
+  for (std::size_t offset = 0, group = 0; offset < sourceFilePaths.size();
+       offset += unityGroupSize, ++group) {
+    const std::size_t count =
+        std::min(unityGroupSize, sourceFilePaths.size() - offset);
+
+    // Union the members' header dependencies (from the same scan data the
+    // per-file mode uses) and record the members themselves, so editing any
+    // of them rebuilds the group.
+    std::unordered_set<std::string> groupDeps;
+    std::string contents = "// Generated by Cabin (unity build)\n";
+    for (std::size_t i = offset; i < offset + count; ++i) {
+      const fs::path& member = sourceFilePaths[i];
+      auto [objTarget, deps] = rs_try(scanDeps(member, /*isTest=*/false));
+      groupDeps.insert(deps.begin(), deps.end());
+      groupDeps.insert(member.string());
+      contents += fmt::format("#include \"{}\"\n", member.generic_string());
+    }
 
-  const auto setRelBaseFrom = [&](const std::string& baseCanonical,
-                                  std::string_view subdir) -> bool {
-    if (baseCanonical.empty()) {
-      return false;
+    const fs::path unitySource =
+        unityDir / fmt::format("{}-{}.cc", rootTag, group);
+    std::string existing;
+    {
+      std::ifstream ifs(unitySource);
+      std::ostringstream oss;
+      oss << ifs.rdbuf();
+      existing = oss.str();
     }
-    if (canonicalSource.size() <= baseCanonical.size()) {
-      return false;
+    if (existing != contents) {
+      std::ofstream ofs(unitySource);
+      ofs << contents;
     }
-    if (!canonicalSource.starts_with(baseCanonical)) {
-      return false;
+
+    const fs::path objOutput =
+        buildTargetBaseDir / fmt::format("unity-{}.o", group);
+    const std::string buildObjTarget =
+        fs::relative(objOutput, outBasePath_).generic_string();
+
+    buildObjTargets.insert(buildObjTarget);
+    registerCompileUnit(buildObjTarget, unitySource.string(), groupDeps,
+                        /*isTest=*/false);
+  }
+  return rs::Ok(buildObjTargets);
+}
+
+rs::Result<std::unordered_set<std::string>>
+BuildGraph::processSources(const std::vector<fs::path>& sourceFilePaths,
+                           const SourceRoot& root) {
+  if (unityGroupSize > 0) {
+    return processSourcesUnity(sourceFilePaths, root);
+  }
+
+  std::unordered_set<std::string> buildObjTargets;
+
+  // Fill the scan cache for all out-of-date sources first, batching many
+  // inputs into each preprocessor invocation; processSrc then resolves every
+  // dependency list from the cache.
+  rs_try(prescanSources(sourceFilePaths, /*isTest=*/false));
+
+  if (isParallel()) {
+    // Map: each worker scans its slice into a per-index slot, so no lock
+    // guards the hot loop.  Reduce: units are registered serially in
+    // source-path order, which makes plan ordering (and the rendered
+    // targets.ninja) independent of worker timing.
+    std::vector<std::optional<ScannedUnit>> scanned(sourceFilePaths.size());
+    tbb::concurrent_vector<std::string> errors;
+    std::atomic<bool> failed{ false };
+    tbb::task_group_context ctx;
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, sourceFilePaths.size()),
+        [&](const tbb::blocked_range<std::size_t>& rng) {
+          for (std::size_t i = rng.begin(); i != rng.end(); ++i) {
+            if (failed.load(std::memory_order_relaxed)) {
+              return;
+            }
+            auto result = scanSrc(sourceFilePaths[i], root);
+            if (result.is_err()) {
+              errors.push_back(result.unwrap_err()->what());
+              if (!keepGoing_) {
+                failed.store(true, std::memory_order_relaxed);
+                ctx.cancel_group_execution();
+              }
+            } else {
+              scanned[i] = result.unwrap();
+            }
+          }
+        },
+        tbb::auto_partitioner(), ctx);
+    if (!errors.empty()) {
+      rs_bail("{}", fmt::join(errors, "\n"));
     }
-    const char divider = canonicalSource[baseCanonical.size()];
-    if (divider != '/') {
-      return false;
+    std::ranges::sort(scanned, {}, [](const std::optional<ScannedUnit>& unit) {
+      return std::string_view(unit->source);
+    });
+    for (const std::optional<ScannedUnit>& unit : scanned) {
+      buildObjTargets.insert(unit->objTarget);
+      registerCompileUnit(unit->objTarget, unit->source, unit->dependencies,
+                          /*isTest=*/false);
     }
-    const std::string remainder =
-        canonicalSource.substr(baseCanonical.size() + 1);
-    if (remainder.empty()) {
-      return false;
+  } else {
+    for (const fs::path& sourceFilePath : sourceFilePaths) {
+      rs_try(processSrc(sourceFilePath, root, buildObjTargets));
     }
+  }
+  return rs::Ok(buildObjTargets);
+}
 
-    relBase /= fs::path(subdir);
-    const fs::path remainderPath(remainder);
-    const fs::path parent = remainderPath.parent_path();
+const SourceClassifier& BuildGraph::classifier() {
+  if (!sourceClassifier_.has_value()) {
+    sourceClassifier_.emplace(project.rootPath);
+  }
+  return *sourceClassifier_;
+}
+
+rs::Result<std::pair<fs::path, bool>>
+BuildGraph::unitTestRelBase(const fs::path& sourceFilePath) {
+  fs::path relBase = fs::path("unit");
+
+  const SourceClassifier::Classification cls =
+      classifier().classify(sourceFilePath);
+  const bool isSrcUnit = cls.root == SourceClassifier::Root::Src;
+  if (cls.root != SourceClassifier::Root::Other) {
+    relBase /= isSrcUnit ? "src" : "lib";
+    const fs::path parent = cls.relPath.parent_path();
     if (!parent.empty()) {
       relBase /= parent;
     }
-    return true;
-  };
-
-  bool handled = false;
-  bool isSrcUnit = false;
-  if (setRelBaseFrom(canonicalSrcRoot, "src")) {
-    handled = true;
-    isSrcUnit = true;
-  } else if (setRelBaseFrom(canonicalLibRoot, "lib")) {
-    handled = true;
-  }
-
-  if (!handled) {
+  } else {
     std::error_code relRootEc;
     const fs::path relRootParent =
         fs::relative(sourceFilePath.parent_path(), project.rootPath, relRootEc);
@@ -414,6 +1227,20 @@ BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
       relBase /= relRootParent;
     }
   }
+  return rs::Ok(std::pair<fs::path, bool>(std::move(relBase), isSrcUnit));
+}
+
+rs::Result<std::optional<BuildGraph::TestTarget>>
+BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
+                               tbb::spin_mutex* mtx) {
+  if (!rs_try(containsTestCode(sourceFilePath))) {
+    return rs::Ok(std::optional<TestTarget>());
+  }
+
+  auto [objTarget, objTargetDeps] =
+      rs_try(scanDeps(sourceFilePath, /*isTest=*/true));
+
+  const auto [relBase, isSrcUnit] = rs_try(unitTestRelBase(sourceFilePath));
 
   const fs::path testObjRel = relBase / objTarget;
   const std::string testObjTarget = testObjRel.generic_string();
@@ -440,8 +1267,8 @@ BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
 
   if (isSrcUnit) {
     std::unordered_set<std::string> deps;
-    collectBinDepObjs(deps, sourceFilePath.stem().string(), objTargetDeps,
-                      srcObjectTargets);
+    collectBinDepObjs(deps, sourceFilePath.stem().string(),
+                      internPaths(objTargetDeps), srcObjectTargets);
 
     std::vector<std::string> srcDeps(deps.begin(), deps.end());
     std::ranges::sort(srcDeps);
@@ -458,9 +1285,7 @@ BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
     }
   }
 
-  if (hasLibraryTarget_) {
-    linkInputs.push_back(libName);
-  }
+  appendLibraryObjects(linkInputs, underTest, &linkSeen);
 
   NinjaEdge linkEdge;
   linkEdge.outputs = { testBinary };
@@ -479,12 +1304,198 @@ BuildGraph::processUnittestSrc(const fs::path& sourceFilePath,
   return rs::Ok(std::optional<TestTarget>(std::move(testTarget)));
 }
 
+rs::Result<std::optional<BuildGraph::TestTarget>>
+BuildGraph::planCombinedUnitTests(
+    const std::vector<fs::path>& sourceFilePaths) {
+  struct UnitEntry {
+    std::string displayName; // root-relative source path
+    std::string symbol;      // the TU's renamed `main`
+  };
+  std::vector<UnitEntry> entries;
+  std::vector<std::string> linkInputs;
+  std::unordered_set<std::string> linkSeen;
+  std::unordered_set<std::string> testStems;
+  std::unordered_set<std::string> usedSymbols;
+  std::unordered_set<std::string> closure;
+
+  for (const fs::path& sourceFilePath : sourceFilePaths) {
+    if (!rs_try(containsTestCode(sourceFilePath.string()))) {
+      continue;
+    }
+    auto [objTarget, objTargetDeps] =
+        rs_try(scanDeps(sourceFilePath, /*isTest=*/true));
+    const auto [relBase, isSrcUnit] = rs_try(unitTestRelBase(sourceFilePath));
+    const std::string testObjTarget = (relBase / objTarget).generic_string();
+
+    const std::string displayName =
+        fs::relative(sourceFilePath, project.rootPath).generic_string();
+    std::string symbol = "cabin_unit_main_";
+    for (const char c : displayName) {
+      symbol += std::isalnum(static_cast<unsigned char>(c)) != 0 ? c : '_';
+    }
+    while (!usedSymbols.insert(symbol).second) {
+      symbol += '_'; // paths differing only in punctuation
+    }
+
+    // The rename keeps every test TU linkable into one image; the
+    // dispatcher below calls the renamed entry point after forking.
+    registerCompileUnit(testObjTarget, sourceFilePath.string(), objTargetDeps,
+                        /*isTest=*/true, fmt::format("-Dmain={}", symbol));
+
+    if (isSrcUnit) {
+      collectBinDepObjs(closure, sourceFilePath.stem().string(),
+                        internPaths(objTargetDeps), srcObjectTargets);
+    }
+    if (linkSeen.insert(testObjTarget).second) {
+      linkInputs.push_back(testObjTarget);
+    }
+    testStems.insert(sourceFilePath.stem().string());
+    entries.push_back(UnitEntry{ displayName, std::move(symbol) });
+  }
+
+  if (entries.empty()) {
+    return rs::Ok(std::optional<TestTarget>());
+  }
+
+  // A TU with tests joins the link as its test object (which contains
+  // the TU's production code too); any production object sharing the
+  // stem must stay out or every symbol in it would be defined twice.
+  const auto addProductionObj = [&](const std::string& obj) {
+    if (testStems.contains(fs::path(obj).stem().string())) {
+      return;
+    }
+    if (linkSeen.insert(obj).second) {
+      linkInputs.push_back(obj);
+    }
+  };
+
+  std::vector<std::string> sortedClosure(closure.begin(), closure.end());
+  std::ranges::sort(sortedClosure);
+  for (const std::string& obj : sortedClosure) {
+    addProductionObj(obj);
+  }
+  std::vector<std::string> support(libSupportObjects.begin(),
+                                   libSupportObjects.end());
+  std::ranges::sort(support);
+  for (const std::string& obj : support) {
+    addProductionObj(obj);
+  }
+  if (hasLibraryTarget_) {
+    if (project.manifest.package.libType == Package::LibType::Shared) {
+      linkInputs.push_back(libName);
+    } else {
+      for (const std::string& obj : libObjectList_) {
+        addProductionObj(obj);
+      }
+    }
+  }
+
+  // The generated dispatcher forks once per file and calls the renamed
+  // entry point in the child, so a crash or exit() in one test cannot
+  // take the rest down — per-file isolation from one preloaded image.
+  std::string runner =
+      "// Generated by Cabin\n"
+      "#include <cstdio>\n"
+      "#include <cstring>\n"
+      "#include <sys/types.h>\n"
+      "#include <sys/wait.h>\n"
+      "#include <unistd.h>\n\n";
+  for (const UnitEntry& entry : entries) {
+    runner += fmt::format("int {}(); // {}\n", entry.symbol,
+                          entry.displayName);
+  }
+  runner += "\nnamespace {\n"
+            "struct CabinUnitTest {\n"
+            "  const char* name;\n"
+            "  int (*entry)();\n"
+            "};\n"
+            "constexpr CabinUnitTest cabinUnitTests[] = {\n";
+  for (const UnitEntry& entry : entries) {
+    runner +=
+        fmt::format("  {{ \"{}\", {} }},\n", entry.displayName, entry.symbol);
+  }
+  runner += "};\n"
+            "} // namespace\n\n"
+            "int main(const int argc, char* const* argv) {\n"
+            "  int failures = 0;\n"
+            "  for (const CabinUnitTest& test : cabinUnitTests) {\n"
+            "    if (argc > 1) {\n"
+            "      bool wanted = false;\n"
+            "      for (int i = 1; i < argc; ++i) {\n"
+            "        if (std::strstr(test.name, argv[i]) != nullptr) {\n"
+            "          wanted = true;\n"
+            "          break;\n"
+            "        }\n"
+            "      }\n"
+            "      if (!wanted) {\n"
+            "        continue;\n"
+            "      }\n"
+            "    }\n"
+            "    const pid_t pid = fork();\n"
+            "    if (pid == 0) {\n"
+            "      _exit(test.entry());\n"
+            "    }\n"
+            "    int status = 0;\n"
+            "    if (pid < 0 || waitpid(pid, &status, 0) < 0) {\n"
+            "      std::fprintf(stderr, \"%s: failed to fork\\n\", test.name);\n"
+            "      ++failures;\n"
+            "      continue;\n"
+            "    }\n"
+            "    if (status != 0) {\n"
+            "      std::fprintf(stderr, \"%s: FAILED\\n\", test.name);\n"
+            "      ++failures;\n"
+            "    }\n"
+            "  }\n"
+            "  return failures == 0 ? 0 : 1;\n"
+            "}\n";
+
+  // Rewrite only on change so the dispatcher's compile edge stays clean
+  // across plans (same idiom as the generated PCH header).
+  const fs::path runnerPath = outBasePath_ / "cabin-unit-runner.cc";
+  std::string existing;
+  {
+    std::ifstream ifs(runnerPath);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    existing = oss.str();
+  }
+  if (existing != runner) {
+    std::ofstream ofs(runnerPath);
+    ofs << runner;
+  }
+
+  // A manual edge keeps the PCH and dedup forced includes off the
+  // dispatcher TU; it needs nothing from the project headers.
+  const std::string runnerObj = "unit/cabin-unit-runner.o";
+  NinjaEdge runnerEdge;
+  runnerEdge.outputs = { runnerObj };
+  runnerEdge.rule = "cxx_compile";
+  runnerEdge.inputs = { "cabin-unit-runner.cc" };
+  runnerEdge.bindings.emplace_back("out_dir", parentDirOrDot(runnerObj));
+  runnerEdge.bindings.emplace_back("extra_flags", "");
+  ninjaPlan.addEdge(std::move(runnerEdge));
+  linkInputs.insert(linkInputs.begin(), runnerObj);
+
+  const std::string runnerBinary = "unit/cabin-test-runner";
+  NinjaEdge linkEdge;
+  linkEdge.outputs = { runnerBinary };
+  linkEdge.rule = "cxx_link_exe";
+  linkEdge.inputs = std::move(linkInputs);
+  linkEdge.bindings.emplace_back("out_dir", parentDirOrDot(runnerBinary));
+  ninjaPlan.addEdge(std::move(linkEdge));
+
+  TestTarget testTarget;
+  testTarget.ninjaTarget = runnerBinary;
+  testTarget.sourcePath = fmt::format("(combined, {} files)", entries.size());
+  testTarget.kind = TestKind::Unit;
+  return rs::Ok(std::optional<TestTarget>(std::move(testTarget)));
+}
+
 rs::Result<std::optional<BuildGraph::TestTarget>>
 BuildGraph::processIntegrationTestSrc(const fs::path& sourceFilePath,
                                       tbb::spin_mutex* mtx) {
-  std::string objTarget;
-  const std::unordered_set<std::string> objTargetDeps =
-      parseMMOutput(rs_try(runMM(sourceFilePath, /*isTest=*/true)), objTarget);
+  auto [objTarget, objTargetDeps] =
+      rs_try(scanDeps(sourceFilePath, /*isTest=*/true));
 
   const fs::path targetBaseDir =
       fs::relative(sourceFilePath.parent_path(), project.rootPath / "tests");
@@ -514,9 +1525,7 @@ BuildGraph::processIntegrationTestSrc(const fs::path& sourceFilePath,
     }
   }
 
-  if (hasLibraryTarget_) {
-    linkInputs.push_back(libName);
-  }
+  appendLibraryObjects(linkInputs, underTest, &linkSeen);
 
   NinjaEdge linkEdge;
   linkEdge.outputs = { testBinary };
@@ -543,21 +1552,88 @@ BuildGraph::processIntegrationTestSrc(const fs::path& sourceFilePath,
   return rs::Ok(std::optional<TestTarget>(std::move(testTarget)));
 }
 
+// Each source under benches/ becomes a standalone binary linked against
+// the project's objects, like an integration test but compiled without
+// CABIN_TEST so it measures the production code paths.
+rs::Result<std::optional<BuildGraph::BenchTarget>>
+BuildGraph::processBenchSrc(const fs::path& sourceFilePath) {
+  auto [objTarget, objTargetDeps] =
+      rs_try(scanDeps(sourceFilePath, /*isTest=*/false));
+
+  const fs::path targetBaseDir =
+      fs::relative(sourceFilePath.parent_path(), project.rootPath / "benches");
+  fs::path benchTargetBaseDir = project.benchOutPath;
+  if (targetBaseDir != ".") {
+    benchTargetBaseDir /= targetBaseDir;
+  }
+
+  const fs::path benchObjOutput = benchTargetBaseDir / objTarget;
+  const std::string benchObjTarget =
+      fs::relative(benchObjOutput, outBasePath_).generic_string();
+  const fs::path benchBinaryPath = benchTargetBaseDir / sourceFilePath.stem();
+  const std::string benchBinary =
+      fs::relative(benchBinaryPath, outBasePath_).generic_string();
+
+  std::vector<std::string> linkInputs{ benchObjTarget };
+  std::unordered_set<std::string> linkSeen(linkInputs.begin(),
+                                           linkInputs.end());
+  for (const std::string& obj : libSupportObjects) {
+    if (linkSeen.insert(obj).second) {
+      linkInputs.push_back(obj);
+    }
+  }
+  appendLibraryObjects(linkInputs, "", &linkSeen);
+
+  NinjaEdge linkEdge;
+  linkEdge.outputs = { benchBinary };
+  linkEdge.rule = "cxx_link_exe";
+  linkEdge.inputs = std::move(linkInputs);
+  linkEdge.bindings.emplace_back("out_dir", parentDirOrDot(benchBinary));
+
+  registerCompileUnit(benchObjTarget, sourceFilePath.string(), objTargetDeps,
+                      /*isTest=*/false);
+  ninjaPlan.addEdge(std::move(linkEdge));
+
+  BenchTarget benchTarget;
+  benchTarget.ninjaTarget = benchBinary;
+  benchTarget.sourcePath =
+      fs::relative(sourceFilePath, project.rootPath).generic_string();
+
+  return rs::Ok(std::optional<BenchTarget>(std::move(benchTarget)));
+}
+
+std::vector<std::uint32_t>
+BuildGraph::internPaths(const std::unordered_set<std::string>& paths) {
+  std::vector<std::uint32_t> ids;
+  ids.reserve(paths.size());
+  for (const std::string& path : paths) {
+    ids.push_back(pathTable.intern(path));
+  }
+  std::ranges::sort(ids);
+  return ids;
+}
+
 void BuildGraph::collectBinDepObjs(
     std::unordered_set<std::string>& deps,
     const std::string_view sourceFileName,
-    const std::unordered_set<std::string>& objTargetDeps,
+    const std::vector<std::uint32_t>& objTargetDeps,
     const std::unordered_set<std::string>& buildObjTargets) const {
-  for (const std::string& dep : objTargetDeps) {
-    const fs::path headerPath = dep;
-    if (sourceFileName == headerPath.stem().string()) {
+  for (const std::uint32_t depId : objTargetDeps) {
+    const std::string& headerPath = pathTable.str(depId);
+    if (sourceFileName == genericStem(headerPath)) {
       continue;
     }
-    if (!HEADER_FILE_EXTS.contains(headerPath.extension().string())) {
+    if (!HEADER_FILE_EXTS.contains(std::string(genericExtension(headerPath)))) {
       continue;
     }
 
-    const std::string objTarget = mapHeaderToObj(headerPath);
+    // Headers recur across the whole recursion, so the mapping is
+    // memoized per interned id.
+    const auto [memoIt, inserted] = headerObjMemo_.try_emplace(depId);
+    if (inserted) {
+      memoIt->second = mapHeaderToObj(headerPath);
+    }
+    const std::string& objTarget = memoIt->second;
     if (!buildObjTargets.contains(objTarget)) {
       continue;
     }
@@ -574,12 +1650,58 @@ void BuildGraph::collectBinDepObjs(
   }
 }
 
+void BuildGraph::prediscoverSources() {
+  std::vector<std::string_view> dirs{ "src", "lib" };
+  if (buildProfile_ == BuildProfile::Test) {
+    dirs.push_back("tests");
+  }
+  if (benchesEnabled) {
+    dirs.push_back("benches");
+  }
+  for (const std::string_view dir : dirs) {
+    const fs::path path = project.rootPath / dir;
+    if (fs::exists(path)) {
+      sourceListings_.try_emplace(path.string(), listSourceFilePaths(path));
+    }
+  }
+}
+
+std::vector<fs::path> BuildGraph::sourceFilesUnder(const fs::path& dir) {
+  const auto found = sourceListings_.find(dir.string());
+  if (found != sourceListings_.end()) {
+    std::vector<fs::path> paths = std::move(found->second);
+    sourceListings_.erase(found);
+    return paths;
+  }
+  return listSourceFilePaths(dir);
+}
+
 rs::Result<void> BuildGraph::installDeps(const bool includeDevDeps,
                                          const bool suppressDepDiag) {
   const std::vector<CompilerOpts> depsCompOpts =
       rs_try(project.manifest.installDeps(includeDevDeps, buildProfile_,
                                           suppressDepDiag));
 
+  // Keep per-dependency attribution before the merge flattens it: the
+  // include roots say which TUs consume the dependency, the libraries
+  // say what an edge may drop when none do.
+  depLinkUses_.clear();
+  depLinkUses_.reserve(depsCompOpts.size());
+  for (const CompilerOpts& depOpts : depsCompOpts) {
+    DepLinkUse use;
+    for (const IncludeDir& dir : depOpts.cFlags.includeDirs) {
+      std::string prefix = dir.dir.lexically_normal().generic_string();
+      if (!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+      }
+      use.includeDirs.push_back(std::move(prefix));
+    }
+    for (const Lib& lib : depOpts.ldFlags.libs) {
+      use.libs.push_back(lib.name);
+    }
+    depLinkUses_.push_back(std::move(use));
+  }
+
   for (const CompilerOpts& depOpts : depsCompOpts) {
     project.compilerOpts.merge(depOpts);
   }
@@ -587,8 +1709,21 @@ rs::Result<void> BuildGraph::installDeps(const bool includeDevDeps,
 }
 
 void BuildGraph::enableCoverage() {
-  project.compilerOpts.cFlags.others.emplace_back("--coverage");
-  project.compilerOpts.ldFlags.others.emplace_back("--coverage");
+  if (compiler.isClang()) {
+    // Source-based coverage: tests emit mergeable .profraw files (one
+    // per process via LLVM_PROFILE_FILE) instead of gcov .gcda side
+    // files.  The flags flow into the object-cache key, so instrumented
+    // objects are cached separately and toggling coverage restores the
+    // other flavor from the cache rather than recompiling.
+    project.compilerOpts.cFlags.others.emplace_back(
+        "-fprofile-instr-generate");
+    project.compilerOpts.cFlags.others.emplace_back("-fcoverage-mapping");
+    project.compilerOpts.ldFlags.others.emplace_back(
+        "-fprofile-instr-generate");
+  } else {
+    project.compilerOpts.cFlags.others.emplace_back("--coverage");
+    project.compilerOpts.ldFlags.others.emplace_back("--coverage");
+  }
 }
 
 rs::Result<void> BuildGraph::configure() {
@@ -596,8 +1731,17 @@ rs::Result<void> BuildGraph::configure() {
   const bool hasSrcDir = fs::exists(srcDir);
   const fs::path libDir = project.rootPath / "lib";
 
-  const Profile& profile = project.manifest.profiles.at(buildProfile_);
+  const Profile& profile = project.profile;
+  splitDwarf_ = profile.splitDebugInfo;
   archiver = compiler.detectArchiver(profile.lto);
+  archiveFlags = Compiler::archiverSupportsThinArchives(archiver)
+                     ? "rcsT" // thin archives skip copying member contents
+                     : "rcs";
+
+  if (unityGroupSize > 0 && buildProfile_ == BuildProfile::Test) {
+    Diag::warn("unity build is ignored for the test profile");
+    unityGroupSize = 0;
+  }
 
   hasBinaryTarget_ = false;
   hasLibraryTarget_ = false;
@@ -628,10 +1772,51 @@ rs::Result<void> BuildGraph::configure() {
     fs::create_directories(outBasePath_);
   }
 
+  // clear() releases nothing from the monotonic arena; a reconfigure on
+  // the same graph just allocates fresh nodes from it, which is fine for
+  // the at-most-two plans a process performs.
   compileUnits.clear();
   ninjaPlan.reset();
   testTargets_.clear();
 
+  pchTarget.clear();
+  if (!profile.pch.empty()) {
+    // Aggregate the requested headers into one generated header and emit a
+    // precompile edge ordered before every cxx_compile edge (which depend on
+    // its output implicitly; see registerCompileUnit).
+    std::string contents = "// Generated by Cabin\n";
+    for (const std::string& header : profile.pch) {
+      if (header.starts_with('<') || header.starts_with('"')) {
+        contents += fmt::format("#include {}\n", header);
+      } else {
+        contents += fmt::format("#include <{}>\n", header);
+      }
+    }
+
+    const fs::path pchHeaderPath = outBasePath_ / "cabin-pch.hpp";
+    std::string existing;
+    {
+      std::ifstream ifs(pchHeaderPath);
+      std::ostringstream oss;
+      oss << ifs.rdbuf();
+      existing = oss.str();
+    }
+    // Rewrite only on change so the precompile edge stays clean across
+    // plans.
+    if (existing != contents) {
+      std::ofstream ofs(pchHeaderPath);
+      ofs << contents;
+    }
+
+    pchTarget = "cabin-pch.hpp.gch";
+    NinjaEdge pchEdge;
+    pchEdge.outputs = { pchTarget };
+    pchEdge.rule = "cxx_pch";
+    pchEdge.inputs = { "cabin-pch.hpp" };
+    pchEdge.bindings.emplace_back("out_dir", ".");
+    ninjaPlan.addEdge(std::move(pchEdge));
+  }
+
   cxxFlags = joinFlags(project.compilerOpts.cFlags.others);
   defines = joinFlags(project.compilerOpts.cFlags.macros);
   includes = joinFlags(project.compilerOpts.cFlags.includeDirs);
@@ -640,9 +1825,50 @@ rs::Result<void> BuildGraph::configure() {
   ldFlags = combineFlags({ ldOthers, libDirs });
   libs = joinFlags(project.compilerOpts.ldFlags.libs);
 
+  if (timeTrace_) {
+    cxxFlags = combineFlags({ cxxFlags, "-ftime-trace" });
+  }
+
+  dedupCalibration_ = false;
+  dedupObject_.clear();
+  if (templateDedup_) {
+    const auto registry = TemplateDedup::loadRegistry(outBasePath_);
+    if (!registry.has_value()) {
+      // Calibration pass: trace every TU so the heaviest duplicated
+      // instantiations can be harvested once the build finishes.
+      dedupCalibration_ = true;
+      if (!timeTrace_) {
+        cxxFlags = combineFlags({ cxxFlags, "-ftime-trace" });
+      }
+    } else if (registry->empty()) {
+      Diag::warn("the calibration build found no template instantiations "
+                 "duplicated across TUs; nothing to coordinate");
+    } else if (profile.pch.empty()) {
+      Diag::warn("`--dedup-templates` needs the profile's `pch` list to name "
+                 "the headers declaring the registered templates; skipping");
+    } else {
+      TemplateDedup::writeGeneratedFiles(outBasePath_, *registry, profile.pch);
+      dedupObject_ = "cabin-dedup.o";
+      NinjaEdge dedupEdge;
+      dedupEdge.outputs = { dedupObject_ };
+      dedupEdge.rule = "cxx_compile";
+      dedupEdge.inputs = { TemplateDedup::SOURCE_FILE };
+      dedupEdge.implicitInputs = { TemplateDedup::HEADER_FILE };
+      dedupEdge.bindings.emplace_back("out_dir", ".");
+      // The define turns the forced-include header into the one TU that
+      // provides the definitions every other TU now externs.
+      dedupEdge.bindings.emplace_back("extra_flags", "-DCABIN_DEDUP_DEFINE");
+      ninjaPlan.addEdge(std::move(dedupEdge));
+    }
+  }
+
+  rs_try(planModules(srcDir, libDir));
+  scanFlagsDigest = digestString(
+      fmt::format("{} {} {} {}", compiler.cxx, cxxFlags, defines, includes));
+
   std::vector<fs::path> sourceFilePaths;
   if (hasSrcDir) {
-    sourceFilePaths = listSourceFilePaths(srcDir);
+    sourceFilePaths = sourceFilesUnder(srcDir);
     for (const fs::path& sourceFilePath : sourceFilePaths) {
       if (sourceFilePath != mainSource && isMainSource(sourceFilePath)) {
         Diag::warn(
@@ -657,7 +1883,7 @@ rs::Result<void> BuildGraph::configure() {
 
   std::vector<fs::path> publicSourceFilePaths;
   if (fs::exists(libDir)) {
-    publicSourceFilePaths = listSourceFilePaths(libDir);
+    publicSourceFilePaths = sourceFilesUnder(libDir);
   }
   hasLibraryTarget_ = !publicSourceFilePaths.empty();
 
@@ -679,6 +1905,20 @@ rs::Result<void> BuildGraph::configure() {
   std::unordered_set<std::string> buildObjTargets = srcObjTargets;
   buildObjTargets.insert(libObjTargets.begin(), libObjTargets.end());
 
+  // The archive's exact inputs, reused by executable links that bypass
+  // the archive (see appendLibraryObjects).
+  libObjectList_.clear();
+  if (hasLibraryTarget_) {
+    libObjectList_.reserve(libObjTargets.size() + libModuleObjects.size() + 1);
+    libObjectList_.assign(libObjTargets.begin(), libObjTargets.end());
+    libObjectList_.insert(libObjectList_.end(), libModuleObjects.begin(),
+                          libModuleObjects.end());
+    if (!dedupObject_.empty()) {
+      libObjectList_.push_back(dedupObject_);
+    }
+    std::ranges::sort(libObjectList_);
+  }
+
   libSupportObjects.clear();
   for (const std::string& libObj : libObjTargets) {
     const auto it = compileUnits.find(libObj);
@@ -692,7 +1932,30 @@ rs::Result<void> BuildGraph::configure() {
     return !srcObjectTargets.contains(obj);
   });
 
-  if (hasBinaryTarget_) {
+  if (hasBinaryTarget_ && unityGroupSize > 0) {
+    // Unity groups do not map back to per-source objects; the binary links
+    // every src group (main's group included) plus the library if present.
+    std::vector<std::string> inputs(srcObjTargets.begin(), srcObjTargets.end());
+    inputs.insert(inputs.end(), srcModuleObjects.begin(),
+                  srcModuleObjects.end());
+    std::ranges::sort(inputs);
+    if (hasLibraryTarget_) {
+      appendLibraryObjects(inputs, "", nullptr);
+    } else if (!dedupObject_.empty()) {
+      // Without a library target the shared instantiations must join
+      // the binary link directly.
+      inputs.push_back(dedupObject_);
+    }
+
+    NinjaEdge linkEdge;
+    linkEdge.outputs = { project.manifest.package.name };
+    linkEdge.rule = "cxx_link_exe";
+    linkEdge.inputs = std::move(inputs);
+    linkEdge.bindings.emplace_back(
+        "out_dir", parentDirOrDot(project.manifest.package.name));
+    ninjaPlan.addEdge(std::move(linkEdge));
+    ninjaPlan.addDefaultTarget(project.manifest.package.name);
+  } else if (hasBinaryTarget_) {
     const fs::path mainObjPath = project.buildOutPath / "main.o";
     const std::string mainObj =
         fs::relative(mainObjPath, outBasePath_).generic_string();
@@ -702,6 +1965,9 @@ rs::Result<void> BuildGraph::configure() {
     std::unordered_set<std::string> deps = { mainObj };
     collectBinDepObjs(deps, "", compileUnits.at(mainObj).dependencies,
                       buildObjTargets);
+    // Module objects cannot be reached through header closures; they
+    // always join the binary link.
+    deps.insert(srcModuleObjects.begin(), srcModuleObjects.end());
 
     std::vector<std::string> inputs;
     if (hasLibraryTarget_) {
@@ -718,9 +1984,12 @@ rs::Result<void> BuildGraph::configure() {
 
       inputs.push_back(mainObj);
       inputs.insert(inputs.end(), srcInputs.begin(), srcInputs.end());
-      inputs.push_back(libName);
+      appendLibraryObjects(inputs, "", nullptr);
     } else {
       inputs.assign(deps.begin(), deps.end());
+      if (!dedupObject_.empty()) {
+        inputs.push_back(dedupObject_);
+      }
       std::ranges::sort(inputs);
     }
 
@@ -735,19 +2004,16 @@ rs::Result<void> BuildGraph::configure() {
   }
 
   if (hasLibraryTarget_) {
-    std::vector<std::string> libraryInputs;
-    libraryInputs.reserve(libObjTargets.size());
-    for (const std::string& obj : libObjTargets) {
-      libraryInputs.push_back(obj);
-    }
-
+    std::vector<std::string> libraryInputs = libObjectList_;
     rs_ensure(!libraryInputs.empty(),
               "internal error: expected objects for library target");
-    std::ranges::sort(libraryInputs);
 
     NinjaEdge archiveEdge;
     archiveEdge.outputs = { libName };
-    archiveEdge.rule = "cxx_link_static_lib";
+    archiveEdge.rule =
+        project.manifest.package.libType == Package::LibType::Shared
+            ? "cxx_link_shared"
+            : "cxx_link_static_lib";
     archiveEdge.inputs = std::move(libraryInputs);
     archiveEdge.bindings.emplace_back("out_dir", parentDirOrDot(libName));
     ninjaPlan.addEdge(std::move(archiveEdge));
@@ -755,26 +2021,52 @@ rs::Result<void> BuildGraph::configure() {
   }
 
   if (buildProfile_ == BuildProfile::Test) {
+    // Warm the test-verdict cache in parallel; the sequential discovery
+    // below then reads every verdict from the cache.  Errors are ignored
+    // here on purpose — the discovery pass re-evaluates and reports them.
+    std::vector<fs::path> testCandidates = sourceFilePaths;
+    testCandidates.insert(testCandidates.end(), publicSourceFilePaths.begin(),
+                          publicSourceFilePaths.end());
+    if (isParallel() && testCandidates.size() > 1) {
+      tbb::parallel_for(
+          tbb::blocked_range<std::size_t>(0, testCandidates.size()),
+          [&](const tbb::blocked_range<std::size_t>& rng) {
+            for (std::size_t i = rng.begin(); i != rng.end(); ++i) {
+              std::ignore = containsTestCode(testCandidates[i].string());
+            }
+          });
+    }
+
     std::vector<TestTarget> discoveredTests;
     discoveredTests.reserve(sourceFilePaths.size());
-    for (const fs::path& sourceFilePath : sourceFilePaths) {
-      if (auto maybeTarget = rs_try(processUnittestSrc(sourceFilePath));
+    if (combinedTests_) {
+      std::vector<fs::path> unitSources = sourceFilePaths;
+      unitSources.insert(unitSources.end(), publicSourceFilePaths.begin(),
+                         publicSourceFilePaths.end());
+      if (auto maybeTarget = rs_try(planCombinedUnitTests(unitSources));
           maybeTarget.has_value()) {
         discoveredTests.push_back(std::move(maybeTarget.value()));
       }
-    }
+    } else {
+      for (const fs::path& sourceFilePath : sourceFilePaths) {
+        if (auto maybeTarget = rs_try(processUnittestSrc(sourceFilePath));
+            maybeTarget.has_value()) {
+          discoveredTests.push_back(std::move(maybeTarget.value()));
+        }
+      }
 
-    for (const fs::path& sourceFilePath : publicSourceFilePaths) {
-      if (auto maybeTarget = rs_try(processUnittestSrc(sourceFilePath));
-          maybeTarget.has_value()) {
-        discoveredTests.push_back(std::move(maybeTarget.value()));
+      for (const fs::path& sourceFilePath : publicSourceFilePaths) {
+        if (auto maybeTarget = rs_try(processUnittestSrc(sourceFilePath));
+            maybeTarget.has_value()) {
+          discoveredTests.push_back(std::move(maybeTarget.value()));
+        }
       }
     }
 
     const fs::path integrationTestDir = project.rootPath / "tests";
     if (fs::exists(integrationTestDir)) {
       const std::vector<fs::path> integrationSources =
-          listSourceFilePaths(integrationTestDir);
+          sourceFilesUnder(integrationTestDir);
       for (const fs::path& sourceFilePath : integrationSources) {
         if (auto maybeTarget =
                 rs_try(processIntegrationTestSrc(sourceFilePath));
@@ -801,6 +2093,26 @@ rs::Result<void> BuildGraph::configure() {
     ninjaPlan.setTestTargets({});
   }
 
+  benchTargets_.clear();
+  if (benchesEnabled) {
+    const fs::path benchDir = project.rootPath / "benches";
+    if (fs::exists(benchDir)) {
+      for (const fs::path& sourceFilePath : sourceFilesUnder(benchDir)) {
+        if (auto maybeTarget = rs_try(processBenchSrc(sourceFilePath));
+            maybeTarget.has_value()) {
+          benchTargets_.push_back(std::move(maybeTarget.value()));
+        }
+      }
+    }
+    std::ranges::sort(benchTargets_,
+                      [](const BenchTarget& lhs, const BenchTarget& rhs) {
+                        return lhs.ninjaTarget < rhs.ninjaTarget;
+                      });
+  }
+
+  pruneLinkLibs();
+  reduceHeaderEdges();
+
   return rs::Ok();
 }
 
@@ -833,7 +2145,10 @@ rs::Result<void> BuildGraph::generateCompdb() const {
   const auto uniqueResult = std::ranges::unique(buildDirs);
   buildDirs.erase(uniqueResult.begin(), uniqueResult.end());
 
-  std::map<std::pair<std::string, std::string>, nlohmann::json> entries;
+  // Each entry is serialized as soon as it is deduplicated instead of
+  // being collected into a second DOM: the combined array never exists
+  // as json nodes, only as the output text.
+  std::map<std::pair<std::string, std::string>, std::string> entries;
 
   for (const fs::path& buildDir : buildDirs) {
     if (!fs::exists(buildDir / "build.ninja")) {
@@ -860,23 +2175,124 @@ rs::Result<void> BuildGraph::generateCompdb() const {
       const auto file = entry.value("file", std::string_view{});
       if (!directory.empty() && !file.empty()) {
         entries[std::make_pair(std::string(directory), std::string(file))] =
-            entry;
+            entry.dump();
       }
     }
   }
 
-  nlohmann::json combined = nlohmann::json::array();
-  for (auto& [_, entry] : entries) {
-    combined.push_back(std::move(entry));
+  std::size_t contentSize = 4; // "[\n" + "]\n"
+  for (const auto& [_, entry] : entries) {
+    contentSize += entry.size() + 4; // "  " + ",\n"
+  }
+  std::string content;
+  content.reserve(contentSize);
+  content += "[\n";
+  bool first = true;
+  for (const auto& [_, entry] : entries) {
+    if (!first) {
+      content += ",\n";
+    }
+    first = false;
+    content += "  ";
+    content += entry;
+  }
+  content += "\n]\n";
+
+  // Tools watching compile_commands.json re-read it on mtime changes;
+  // leave an identical file untouched.
+  const fs::path compdbPath = cabinOutRoot / "compile_commands.json";
+  if (fs::exists(compdbPath)
+      && digestFile(compdbPath) == digestString(content)) {
+    return rs::Ok();
   }
 
   fs::create_directories(cabinOutRoot);
-  std::ofstream aggregateFile(cabinOutRoot / "compile_commands.json");
-  aggregateFile << combined.dump(2) << '\n';
+  std::ofstream aggregateFile(compdbPath);
+  aggregateFile << content;
 
   return rs::Ok();
 }
 
+bool BuildGraph::restoreFromPlanCache() {
+  auto snapshot = PlanCache::load(outBasePath_);
+  if (!snapshot.has_value()) {
+    return false;
+  }
+
+  // The stat journal only covers the source tree; also validate the flag
+  // set the current configuration would derive, so coverage, --unity, or
+  // changed env flags force a full replan.
+  const std::string ldOthers = joinFlags(project.compilerOpts.ldFlags.others);
+  const std::string libDirs = joinFlags(project.compilerOpts.ldFlags.libDirs);
+  // A module project appends the prebuilt-module lookup to cxxFlags after
+  // planning, so accept either form.
+  const std::string expectedCxxFlags =
+      joinFlags(project.compilerOpts.cFlags.others);
+  const std::string expectedModuleCxxFlags =
+      combineFlags({ expectedCxxFlags, "-fprebuilt-module-path=modules" });
+  if (snapshot->unityGroupSize != unityGroupSize
+      || snapshot->combinedTests != combinedTests_
+      || snapshot->toolchain.cxx != compiler.cxx
+      || snapshot->toolchain.cxxWrapper != project.manifest.build.wrapper
+      || (snapshot->toolchain.cxxFlags != expectedCxxFlags
+          && snapshot->toolchain.cxxFlags != expectedModuleCxxFlags)
+      || snapshot->toolchain.defines
+             != joinFlags(project.compilerOpts.cFlags.macros)
+      || snapshot->toolchain.includes
+             != joinFlags(project.compilerOpts.cFlags.includeDirs)
+      || snapshot->toolchain.ldFlags != combineFlags({ ldOthers, libDirs })
+      || snapshot->toolchain.libs
+             != joinFlags(project.compilerOpts.ldFlags.libs)) {
+    return false;
+  }
+
+  cxxFlags = snapshot->toolchain.cxxFlags;
+  defines = snapshot->toolchain.defines;
+  includes = snapshot->toolchain.includes;
+  ldFlags = snapshot->toolchain.ldFlags;
+  libs = snapshot->toolchain.libs;
+  archiver = snapshot->toolchain.archiver;
+  archiveFlags = snapshot->toolchain.archiveFlags;
+  hasBinaryTarget_ = snapshot->hasBinaryTarget;
+  hasLibraryTarget_ = snapshot->hasLibraryTarget;
+
+  testTargets_.clear();
+  testTargets_.reserve(snapshot->testTargets.size());
+  for (const PlanSnapshot::TestTarget& target : snapshot->testTargets) {
+    testTargets_.push_back(TestTarget{
+        .ninjaTarget = target.ninjaTarget,
+        .sourcePath = target.sourcePath,
+        .kind = static_cast<TestKind>(target.kind),
+    });
+  }
+
+  ninjaPlan.restore(std::move(snapshot->edges),
+                    std::move(snapshot->defaultTargets),
+                    std::move(snapshot->phonyTestTargets));
+  return true;
+}
+
+void BuildGraph::savePlanCache() const {
+  PlanSnapshot snapshot;
+  snapshot.toolchain = makeToolchain();
+  snapshot.hasBinaryTarget = hasBinaryTarget_;
+  snapshot.hasLibraryTarget = hasLibraryTarget_;
+  snapshot.combinedTests = combinedTests_;
+  snapshot.unityGroupSize = unityGroupSize;
+  snapshot.edges.assign(ninjaPlan.edges().begin(), ninjaPlan.edges().end());
+  snapshot.defaultTargets = ninjaPlan.defaultTargets();
+  snapshot.phonyTestTargets = ninjaPlan.testTargets();
+  snapshot.testTargets.reserve(testTargets_.size());
+  for (const TestTarget& target : testTargets_) {
+    snapshot.testTargets.push_back(PlanSnapshot::TestTarget{
+        .ninjaTarget = target.ninjaTarget,
+        .sourcePath = target.sourcePath,
+        .kind = static_cast<std::uint8_t>(target.kind),
+    });
+  }
+  PlanCache::save(outBasePath_, snapshot);
+}
+
 rs::Result<void> BuildGraph::plan(const bool logAnalysis) {
   if (logAnalysis) {
     Diag::info("Analyzing", "project dependencies...");
@@ -885,8 +2301,27 @@ rs::Result<void> BuildGraph::plan(const bool logAnalysis) {
   const bool buildProj = !isUpToDate("build.ninja");
   spdlog::debug("build.ninja is {}up to date", buildProj ? "NOT " : "");
 
+  // On an unchanged tree the serialized plan is authoritative: one mmap
+  // plus validation instead of re-deriving every edge (and respawning
+  // ninja for the compdb, which is also unchanged).  Bench planning adds
+  // edges the normal plan does not have, so it bypasses the cache in both
+  // directions rather than poisoning later builds with bench targets.
+  // Template dedup likewise alters edges (or flags, on a calibration
+  // pass), so it always derives the plan fresh.
+  if (!buildProj && !benchesEnabled && !templateDedup_ && !timeTrace_
+      && restoreFromPlanCache()) {
+    spdlog::debug("restored plan from {}", PlanCache::FILE_NAME);
+    return rs::Ok();
+  }
+
+  scanCache.load(outBasePath_);
   rs_try(configure());
-  if (buildProj) {
+  scanCache.save(outBasePath_);
+  StatJournal::record(watchedPaths()).save(outBasePath_);
+  if (!benchesEnabled && !templateDedup_ && !timeTrace_) {
+    savePlanCache();
+  }
+  if (buildProj || benchesEnabled || templateDedup_ || timeTrace_) {
     writeBuildFiles();
   }
   rs_try(generateCompdb());
@@ -903,14 +2338,43 @@ Command BuildGraph::ninjaCommand(const bool forDryRun) const {
     ninja.addArg("--verbose");
   }
 
-  const std::size_t numThreads = getParallelism();
+  // With a compile wrapper the bottleneck moves to the remote farm, so
+  // oversubscribe well past local core count; each extra job only costs an
+  // idle local process waiting on the network.
+  std::size_t numThreads = getParallelism();
+  if (!project.manifest.build.wrapper.empty()) {
+    numThreads = project.manifest.build.remoteJobs > 0
+                     ? project.manifest.build.remoteJobs
+                     : numThreads * 4;
+  }
   ninja.addArg(fmt::format("-j{}", numThreads));
 
+  // Advertise our budget through the jobserver fifo so nested make or
+  // cabin invocations spawned by build commands share it instead of
+  // multiplying it.
+  if (std::string makeflags =
+          Jobserver::instance().childMakeflags(numThreads);
+      !makeflags.empty()) {
+    ninja.setEnv("MAKEFLAGS", std::move(makeflags));
+  }
+
   return ninja;
 }
 
+bool BuildGraph::buildWithNinja() const {
+  // The embedded executor's wave width is bounded by local parallelism;
+  // ninja's -j can cheaply exceed core count, which is what a distributed
+  // compile wrapper needs.
+  return useNinjaFallback() || !project.manifest.build.wrapper.empty();
+}
+
 rs::Result<bool>
 BuildGraph::needsBuild(const std::vector<std::string>& targets) const {
+  if (!buildWithNinja()) {
+    const Executor executor(ninjaPlan.edges(), makeToolchain(), outBasePath_);
+    return executor.needsBuild(targets);
+  }
+
   Command dryRunCmd = ninjaCommand(true);
   dryRunCmd.addArg("-C").addArg(outBasePath_.string()).addArg("-n");
   for (const std::string& target : targets) {
@@ -923,21 +2387,45 @@ BuildGraph::needsBuild(const std::vector<std::string>& targets) const {
   return rs::Ok(!hasNoWork || !dryRun.exitStatus.success());
 }
 
+rs::Result<std::vector<std::string>>
+BuildGraph::affectedTargets(const std::vector<std::string>& targets) const {
+  // The ninja fallback has no per-target dirtiness query; treating every
+  // target as affected just restores the old build-everything behavior.
+  if (buildWithNinja()) {
+    return rs::Ok(targets);
+  }
+  const Executor executor(ninjaPlan.edges(), makeToolchain(), outBasePath_);
+  return executor.affected(targets);
+}
+
 rs::Result<ExitStatus>
 BuildGraph::buildTargets(const std::vector<std::string>& targets,
                          const std::string_view displayName) const {
-  Command buildCmd = ninjaCommand(false);
-  buildCmd.addArg("-C").addArg(outBasePath_.string());
-  for (const std::string& target : targets) {
-    buildCmd.addArg(target);
-  }
-
   if (rs_try(needsBuild(targets))) {
     Diag::info("Compiling", "{} v{} ({})", displayName,
                project.manifest.package.version.toString(),
                project.manifest.path.parent_path().string());
   }
 
+  // Prefer the embedded executor: it consumes the in-memory plan directly
+  // instead of paying the serialize/reparse round trip through ninja.
+  if (!buildWithNinja()) {
+    // The manifest's `[cache] remote` wins; the global config supplies a
+    // machine-wide default endpoint for projects that set none.
+    const std::string& remote =
+        project.manifest.cache.remote.empty()
+            ? GlobalConfig::instance().cacheRemote()
+            : project.manifest.cache.remote;
+    RemoteCache::instance().configure(remote, project.manifest.cache.upload);
+    const Executor executor(ninjaPlan.edges(), makeToolchain(), outBasePath_);
+    return executor.build(targets);
+  }
+
+  Command buildCmd = ninjaCommand(false);
+  buildCmd.addArg("-C").addArg(outBasePath_.string());
+  for (const std::string& target : targets) {
+    buildCmd.addArg(target);
+  }
   return execCmd(buildCmd);
 }
 
@@ -1,17 +1,28 @@
 #include "Builder/Compiler.hpp"
 
 #include "Algos.hpp"
+#include "Builder/ToolchainCache.hpp"
 #include "Command.hpp"
+#include "Parallelism.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cctype>
+#include <charconv>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <optional>
 #include <rs/result.hpp>
+#include <span>
+#include <spdlog/spdlog.h>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -111,6 +122,10 @@ static std::optional<std::string> resolveGccAr(const fs::path& cxxPath) {
 
 enum class CompilerFlavor : std::uint8_t { Clang, Gcc, Other };
 
+// Name-based fallback for compilers that cannot be executed (cross
+// toolchains staged but not runnable, broken installs).  `c++` and other
+// neutral names come out as Other here; the macro probe below resolves
+// them correctly when the binary runs.
 static CompilerFlavor detectCompilerFlavor(const fs::path& cxxPath) {
   const std::string name = cxxPath.filename().string();
   if (name.contains("clang")) {
@@ -122,6 +137,120 @@ static CompilerFlavor detectCompilerFlavor(const fs::path& cxxPath) {
   return CompilerFlavor::Other;
 }
 
+/// Identity read off the compiler's predefined-macro dump: what the
+/// binary actually is (not what its name suggests), its version, and the
+/// language standard its default mode selects.
+struct CompilerId {
+  CompilerFlavor flavor = CompilerFlavor::Other;
+  unsigned major = 0;
+  unsigned minor = 0;
+  unsigned defaultCplusplus = 0; // __cplusplus under the default -std
+};
+
+// One `-E -dM` run over an empty translation unit yields every
+// predefined macro; identity, version, and default standard all come out
+// of that single fork/exec, and the dump persists in the toolchain cache
+// keyed by the binary, so warm runs spawn nothing.
+static std::optional<std::string> dumpPredefinedMacros(const std::string& cxx) {
+  return ToolchainCache::instance().probe(
+      cxx, "macros", [&cxx]() -> std::optional<std::string> {
+        auto output = getCmdOutput(Command(cxx)
+                                       .addArg("-E")
+                                       .addArg("-dM")
+                                       .addArg("-x")
+                                       .addArg("c++")
+                                       .addArg("/dev/null"));
+        if (output.is_ok()) {
+          return output.unwrap();
+        }
+        return std::nullopt;
+      });
+}
+
+static unsigned parseMacroValue(const std::string_view value) {
+  // Values like `201703L` stop parsing at the suffix, which is what we
+  // want.
+  unsigned result = 0;
+  std::from_chars(value.data(), value.data() + value.size(), result);
+  return result;
+}
+
+// Single allocation-free pass over the dump lines, picking out the
+// handful of identity macros.  Clang defines the __GNUC__ family too, so
+// __clang__ wins when both appear.
+static CompilerId parseMacroDump(std::string_view dump) {
+  bool isClang = false;
+  unsigned clangMajor = 0;
+  unsigned clangMinor = 0;
+  unsigned gccMajor = 0;
+  unsigned gccMinor = 0;
+  CompilerId id;
+
+  while (!dump.empty()) {
+    const std::size_t eol = dump.find('\n');
+    std::string_view line = dump.substr(0, eol);
+    dump.remove_prefix(eol == std::string_view::npos ? dump.size() : eol + 1);
+
+    constexpr std::string_view definePrefix = "#define ";
+    if (!line.starts_with(definePrefix)) {
+      continue;
+    }
+    line.remove_prefix(definePrefix.size());
+    const std::size_t space = line.find(' ');
+    const std::string_view name = line.substr(0, space);
+    const std::string_view value =
+        space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+
+    if (name == "__clang__") {
+      isClang = true;
+    } else if (name == "__clang_major__") {
+      clangMajor = parseMacroValue(value);
+    } else if (name == "__clang_minor__") {
+      clangMinor = parseMacroValue(value);
+    } else if (name == "__GNUC__") {
+      gccMajor = parseMacroValue(value);
+    } else if (name == "__GNUC_MINOR__") {
+      gccMinor = parseMacroValue(value);
+    } else if (name == "__cplusplus") {
+      id.defaultCplusplus = parseMacroValue(value);
+    }
+  }
+
+  if (isClang) {
+    id.flavor = CompilerFlavor::Clang;
+    id.major = clangMajor;
+    id.minor = clangMinor;
+  } else if (gccMajor != 0) {
+    id.flavor = CompilerFlavor::Gcc;
+    id.major = gccMajor;
+    id.minor = gccMinor;
+  }
+  return id;
+}
+
+static const CompilerId& compilerIdFor(const std::string& cxx) {
+  static std::unordered_map<std::string, CompilerId> memo;
+  static std::mutex mutex;
+  const std::scoped_lock lock(mutex);
+  if (const auto found = memo.find(cxx); found != memo.end()) {
+    return found->second;
+  }
+
+  CompilerId id;
+  if (const auto dump = dumpPredefinedMacros(cxx); dump.has_value()) {
+    id = parseMacroDump(*dump);
+    spdlog::debug("compiler `{}`: {} {}.{}, default __cplusplus={}", cxx,
+                  id.flavor == CompilerFlavor::Clang  ? "clang"
+                  : id.flavor == CompilerFlavor::Gcc ? "gcc"
+                                                     : "unknown",
+                  id.major, id.minor, id.defaultCplusplus);
+  }
+  if (id.flavor == CompilerFlavor::Other) {
+    id.flavor = detectCompilerFlavor(fs::path(cxx));
+  }
+  return memo.emplace(cxx, id).first->second;
+}
+
 static std::optional<std::string> envArchiverOverride() {
   if (auto ar = getEnvVar("CABIN_AR"); ar.has_value()) {
     return ar;
@@ -191,11 +320,27 @@ CFlags::parsePkgConfig(const std::string_view pkgConfigVer) noexcept {
       std::move(macros), std::move(includeDirs), std::move(others)));
 }
 
+// Appends the elements of `src` whose rendered form is not already present,
+// preserving order.  Dependencies repeat the same -D/-I/-L flags; merging
+// one copy keeps command lines and the planner's flag strings short.
+template <typename Flags>
+static void appendUniqueFlags(Flags& dst, const Flags& src) noexcept {
+  std::unordered_set<std::string> seen;
+  seen.reserve(dst.size() + src.size());
+  for (const auto& flag : dst) {
+    seen.insert(fmt::format("{}", flag));
+  }
+  for (const auto& flag : src) {
+    if (seen.insert(fmt::format("{}", flag)).second) {
+      dst.push_back(flag);
+    }
+  }
+}
+
 void CFlags::merge(const CFlags& other) noexcept {
-  macros.insert(macros.end(), other.macros.begin(), other.macros.end());
-  includeDirs.insert(includeDirs.end(), other.includeDirs.begin(),
-                     other.includeDirs.end());
-  others.insert(others.end(), other.others.begin(), other.others.end());
+  appendUniqueFlags(macros, other.macros);
+  appendUniqueFlags(includeDirs, other.includeDirs);
+  appendUniqueFlags(others, other.others);
 }
 
 rs::Result<LdFlags>
@@ -255,8 +400,8 @@ LdFlags::LdFlags(std::vector<LibDir> libDirs, std::vector<Lib> libs,
 }
 
 void LdFlags::merge(const LdFlags& other) noexcept {
-  libDirs.insert(libDirs.end(), other.libDirs.begin(), other.libDirs.end());
-  others.insert(others.end(), other.others.begin(), other.others.end());
+  appendUniqueFlags(libDirs, other.libDirs);
+  appendUniqueFlags(others, other.others);
 
   // Remove duplicates of libs & other.libs.
   std::unordered_set<std::string> libSet;
@@ -276,9 +421,28 @@ rs::Result<CompilerOpts>
 CompilerOpts::parsePkgConfig(const VersionReq& pkgVerReq,
                              const std::string_view pkgName) noexcept {
   const std::string pkgConfigVer = pkgVerReq.toPkgConfigString(pkgName);
+
+  // The same system package recurs across the transitive dependency
+  // closure and across workspace members built in one process; each
+  // occurrence used to spawn pkg-config twice.  Interrogate it once per
+  // (package, version-req) and replay the parsed flags afterwards.
+  static std::unordered_map<std::string, CompilerOpts> memo;
+  static std::mutex mutex;
+  {
+    const std::scoped_lock lock(mutex);
+    if (const auto found = memo.find(pkgConfigVer); found != memo.end()) {
+      return rs::Ok(found->second);
+    }
+  }
+
   CFlags cFlags = rs_try(CFlags::parsePkgConfig(pkgConfigVer));
   LdFlags ldFlags = rs_try(LdFlags::parsePkgConfig(pkgConfigVer));
-  return rs::Ok(CompilerOpts(std::move(cFlags), std::move(ldFlags)));
+  CompilerOpts opts(std::move(cFlags), std::move(ldFlags));
+  {
+    const std::scoped_lock lock(mutex);
+    memo.try_emplace(pkgConfigVer, opts);
+  }
+  return rs::Ok(opts);
 }
 
 void CompilerOpts::merge(const CompilerOpts& other) noexcept {
@@ -329,6 +493,17 @@ Command Compiler::makeMMCmd(const CompilerOpts& opts,
       .addArg(sourceFile);
 }
 
+Command Compiler::makeMMCmd(
+    const CompilerOpts& opts,
+    const std::span<const std::string> sourceFiles) const {
+  return Command(cxx)
+      .addArgs(opts.cFlags.others)
+      .addArgs(opts.cFlags.macros)
+      .addArgs(opts.cFlags.includeDirs)
+      .addArg("-MM")
+      .addArgs(sourceFiles);
+}
+
 Command Compiler::makePreprocessCmd(const CompilerOpts& opts,
                                     const std::string& sourceFile) const {
   return Command(cxx)
@@ -348,7 +523,7 @@ std::string Compiler::detectArchiver(const bool useLTO) const {
   }
 
   const fs::path cxxPath(cxx);
-  switch (detectCompilerFlavor(cxxPath)) {
+  switch (compilerIdFor(cxx).flavor) {
   case CompilerFlavor::Clang:
     if (auto llvmAr = resolveLlvmAr(cxxPath); llvmAr.has_value()) {
       return llvmAr.value();
@@ -366,6 +541,162 @@ std::string Compiler::detectArchiver(const bool useLTO) const {
   return "ar";
 }
 
+bool Compiler::isClang() const {
+  return compilerIdFor(cxx).flavor == CompilerFlavor::Clang;
+}
+
+std::optional<std::string> Compiler::detectFasterLinker() const {
+  if (auto linker = getEnvVar("CABIN_LINKER"); linker.has_value()) {
+    return linker;
+  }
+
+  // Probe the ld.* names the driver resolves for -fuse-ld=, fastest first.
+  static constexpr std::array<std::pair<std::string_view, std::string_view>, 3>
+      candidates{ { { "mold", "mold" },
+                    { "ld.lld", "lld" },
+                    { "ld.gold", "gold" } } };
+  for (const auto& [binary, name] : candidates) {
+    if (commandExists(binary)) {
+      return std::string(name);
+    }
+  }
+  return std::nullopt;
+}
+
+void Compiler::addLinkFlags(CompilerOpts& opts, const bool useLTO) const {
+  const bool hasUserLinker = std::ranges::any_of(
+      opts.ldFlags.others,
+      [](const std::string& flag) { return flag.starts_with("-fuse-ld="); });
+  if (!hasUserLinker) {
+    if (auto linker = detectFasterLinker(); linker.has_value()) {
+      opts.ldFlags.others.push_back(fmt::format("-fuse-ld={}", *linker));
+    }
+  }
+
+  // GCC runs its LTO backend serially unless told otherwise; the later
+  // -flto=N overrides the plain -flto already on the link line.  Clang's
+  // full LTO has no equivalent knob (parallelism needs ThinLTO bitcode).
+  if (useLTO && compilerIdFor(cxx).flavor == CompilerFlavor::Gcc) {
+    opts.ldFlags.others.push_back(fmt::format("-flto={}", getParallelism()));
+  }
+}
+
+static std::optional<ModuleDeps> parseP1689(const std::string& output) {
+  nlohmann::json json;
+  try {
+    json = nlohmann::json::parse(output);
+  } catch (const nlohmann::json::parse_error&) {
+    return std::nullopt;
+  }
+  if (!json.contains("rules") || !json["rules"].is_array()
+      || json["rules"].empty()) {
+    return std::nullopt;
+  }
+
+  const nlohmann::json& rule = json["rules"].front();
+  ModuleDeps deps;
+  if (rule.contains("provides") && !rule["provides"].empty()) {
+    deps.provides = rule["provides"].front().value("logical-name", "");
+  }
+  if (rule.contains("requires")) {
+    for (const auto& required : rule["requires"]) {
+      std::string name = required.value("logical-name", "");
+      if (!name.empty()) {
+        deps.imports.push_back(std::move(name));
+      }
+    }
+  }
+  return deps;
+}
+
+// Lexical fallback when clang-scan-deps is unavailable: reads the module
+// and import declarations off line starts.  Header units and commented-out
+// declarations are the known blind spots.
+static ModuleDeps scanModuleDeclarations(const std::string& sourceFile) {
+  ModuleDeps deps;
+  std::string owningModule;
+
+  std::ifstream file(sourceFile);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream iss(line);
+    std::string token;
+    iss >> token;
+    bool exported = false;
+    if (token == "export") {
+      exported = true;
+      iss >> token;
+    }
+
+    std::string name;
+    if (token == "module" || token == "import") {
+      iss >> name;
+      while (!name.empty() && name.back() == ';') {
+        name.pop_back();
+      }
+    }
+
+    if (token == "module") {
+      // `module;` (global fragment) and `module :private;` carry no name.
+      if (name.empty() || name == ":private") {
+        continue;
+      }
+      owningModule = name.substr(0, name.find(':'));
+      if (exported) {
+        deps.provides = name;
+      }
+    } else if (token == "import") {
+      if (name.empty() || name.front() == '<' || name.front() == '"') {
+        continue; // header unit
+      }
+      if (name.front() == ':') {
+        name = owningModule + name; // partition import
+      }
+      deps.imports.push_back(std::move(name));
+    }
+  }
+  return deps;
+}
+
+rs::Result<ModuleDeps>
+Compiler::scanModuleDeps(const CompilerOpts& opts,
+                         const std::string& sourceFile) const {
+  if (commandExists("clang-scan-deps")) {
+    const Command scanCmd = Command("clang-scan-deps")
+                                .addArg("-format=p1689")
+                                .addArg("--")
+                                .addArg(cxx)
+                                .addArgs(opts.cFlags.others)
+                                .addArgs(opts.cFlags.macros)
+                                .addArgs(opts.cFlags.includeDirs)
+                                .addArg("-c")
+                                .addArg(sourceFile)
+                                .addArg("-o")
+                                .addArg("/dev/null");
+    if (auto output = getCmdOutput(scanCmd); output.is_ok()) {
+      if (auto deps = parseP1689(output.unwrap()); deps.has_value()) {
+        return rs::Ok(std::move(*deps));
+      }
+    }
+  }
+  return rs::Ok(scanModuleDeclarations(sourceFile));
+}
+
+bool Compiler::archiverSupportsThinArchives(const std::string& archiver) {
+  // Thin archives (the `T` modifier) are a GNU/LLVM extension; BSD ar
+  // rejects it.  The probe persists across runs keyed by the binary.
+  const std::optional<std::string> output = ToolchainCache::instance().probe(
+      archiver, "version", [&archiver]() -> std::optional<std::string> {
+        auto version = getCmdOutput(Command(archiver).addArg("--version"));
+        if (version.is_ok()) {
+          return version.unwrap();
+        }
+        return std::nullopt;
+      });
+  return output.has_value()
+         && (output->contains("GNU ar") || output->contains("LLVM"));
+}
+
 } // namespace cabin
 
 #ifdef CABIN_TEST
@@ -1,19 +1,22 @@
 #include "Builder/DepGraph.hpp"
 
 #include "Manifest.hpp"
+#include "Profile.hpp"
 
 namespace cabin {
 
 rs::Result<void> DepGraph::resolve() {
+  const profile::Span span("DepGraph::resolve");
   rootManifest.emplace(
       rs_try(Manifest::tryParse(rootPath / Manifest::FILE_NAME)));
   return rs::Ok();
 }
 
-rs::Result<BuildGraph>
-DepGraph::computeBuildGraph(const BuildProfile& buildProfile) const {
+rs::Result<BuildGraph> DepGraph::computeBuildGraph(
+    const BuildProfile& buildProfile,
+    const std::optional<ProfileOverride>& profileOverride) const {
   rs_ensure(rootManifest.has_value(), "dependency graph not resolved");
-  return BuildGraph::create(*rootManifest, buildProfile);
+  return BuildGraph::create(*rootManifest, buildProfile, profileOverride);
 }
 
 } // namespace cabin
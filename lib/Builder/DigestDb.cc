@@ -0,0 +1,68 @@
+#include "Builder/DigestDb.hpp"
+
+#include "CacheFile.hpp"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+namespace cabin {
+
+void DigestDb::load(const fs::path& outBasePath) {
+  std::ifstream ifs(outBasePath / FILE_NAME);
+  if (!ifs) {
+    return;
+  }
+
+  nlohmann::json json;
+  try {
+    json = nlohmann::json::parse(ifs);
+  } catch (const nlohmann::json::parse_error& e) {
+    spdlog::debug("discarding corrupt digest db: {}", e.what());
+    return;
+  }
+  if (!json.is_object() || !json.contains("entries")) {
+    return;
+  }
+
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  entries.clear();
+  for (const auto& [output, digest] : json["entries"].items()) {
+    if (digest.is_string()) {
+      entries.emplace(output, digest.get<std::string>());
+    }
+  }
+}
+
+void DigestDb::save(const fs::path& outBasePath) const {
+  nlohmann::json jsonEntries = nlohmann::json::object();
+  {
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    for (const auto& [output, digest] : entries) {
+      jsonEntries[output] = digest;
+    }
+  }
+
+  nlohmann::json json;
+  json["version"] = 1;
+  json["entries"] = std::move(jsonEntries);
+
+  writeFileAtomic(outBasePath / FILE_NAME, json.dump() + '\n');
+}
+
+std::optional<std::string> DigestDb::lookup(const std::string& output) const {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  const auto it = entries.find(output);
+  if (it == entries.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void DigestDb::update(const std::string& output, std::string digest) {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  entries[output] = std::move(digest);
+}
+
+} // namespace cabin
@@ -0,0 +1,997 @@
+#include "Builder/Executor.hpp"
+
+#include "Algos.hpp"
+#include "Builder/BuildEvents.hpp"
+#include "Builder/RemoteCache.hpp"
+#include "Builder/ScanCache.hpp"
+#include "Builder/Timings.hpp"
+#include "Builder/ToolchainCache.hpp"
+#include "Diag.hpp"
+#include "Parallelism.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <string>
+#include <tbb/spin_mutex.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+
+namespace cabin {
+
+bool useNinjaFallback() noexcept {
+  const char* env = std::getenv("CABIN_BUILD_WITH_NINJA");
+  return env != nullptr && *env != '\0' && std::string_view(env) != "0";
+}
+
+template <typename Range>
+static std::string joinWithSpace(const Range& range) {
+  if (range.empty()) {
+    return "";
+  }
+  return fmt::format("{}", fmt::join(range, " "));
+}
+
+static std::string_view bindingValue(const NinjaEdge& edge,
+                                     const std::string_view key) {
+  for (const auto& [k, v] : edge.bindings) {
+    if (k == key) {
+      return v;
+    }
+  }
+  return "";
+}
+
+// Edge bindings shadow the toolchain-wide value, matching ninja's
+// variable scoping; an absent binding (unlike an empty one) falls back.
+static std::string_view bindingOr(const NinjaEdge& edge,
+                                  const std::string_view key,
+                                  const std::string_view fallback) {
+  for (const auto& [k, v] : edge.bindings) {
+    if (k == key) {
+      return v;
+    }
+  }
+  return fallback;
+}
+
+namespace {
+
+// Weight assumed for edges with no recorded peak RSS: high enough that a
+// wave of unknown template-heavy TUs cannot blow past the budget.
+constexpr std::int64_t DEFAULT_EDGE_RSS_KB = 2LL * 1024 * 1024; // 2 GiB
+
+// Process-wide memory gate for build jobs.  Each edge leases its
+// predicted peak RSS before spawning and returns it afterwards; a job is
+// admitted only while the aggregate fits the budget, except that one job
+// always runs so the build cannot stall.  The budget defaults to 90% of
+// physical RAM and can be pinned with CABIN_MEMORY_BUDGET (bytes, or
+// with a K/M/G suffix).
+class MemoryBudget {
+public:
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+  MemoryBudget(MemoryBudget&&) noexcept = delete;
+  MemoryBudget& operator=(MemoryBudget&&) noexcept = delete;
+  ~MemoryBudget() noexcept = default;
+
+  static MemoryBudget& instance() noexcept {
+    static MemoryBudget instance;
+    return instance;
+  }
+
+  void acquire(const std::int64_t kb) noexcept {
+    while (true) {
+      {
+        const tbb::spin_mutex::scoped_lock lock(mtx_);
+        if (runningJobs_ == 0 || usedKb_ + kb <= budgetKb_) {
+          usedKb_ += kb;
+          ++runningJobs_;
+          return;
+        }
+      }
+      spdlog::trace("memory budget full, delaying job ({} KiB predicted)",
+                    kb);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  void release(const std::int64_t kb) noexcept {
+    const tbb::spin_mutex::scoped_lock lock(mtx_);
+    usedKb_ -= kb;
+    --runningJobs_;
+  }
+
+private:
+  MemoryBudget() noexcept : budgetKb_(detectBudgetKb()) {}
+
+  static std::int64_t detectBudgetKb() noexcept {
+    if (const char* env = std::getenv("CABIN_MEMORY_BUDGET")) {
+      const std::string_view value(env);
+      std::int64_t number = 0;
+      const auto [ptr, ec] =
+          std::from_chars(value.begin(), value.end(), number);
+      if (ec == std::errc() && number > 0) {
+        const std::string_view suffix(ptr, value.end());
+        if (suffix == "G" || suffix == "g") {
+          return number * 1024 * 1024;
+        }
+        if (suffix == "M" || suffix == "m") {
+          return number * 1024;
+        }
+        if (suffix == "K" || suffix == "k") {
+          return number;
+        }
+        if (suffix.empty()) {
+          return number / 1024; // plain bytes
+        }
+      }
+      Diag::warn("ignoring invalid CABIN_MEMORY_BUDGET `{}`", value);
+    }
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && pageSize > 0) {
+      // 90% of physical RAM; the rest is headroom for cabin itself, the
+      // page cache, and whatever else the machine runs.
+      return static_cast<std::int64_t>(pages) * (pageSize / 1024) / 10 * 9;
+    }
+    return 8LL * 1024 * 1024; // 8 GiB when the probe fails
+  }
+
+  tbb::spin_mutex mtx_;
+  std::int64_t budgetKb_;
+  std::int64_t usedKb_ = 0;
+  std::size_t runningJobs_ = 0;
+};
+
+// Returns the lease on destruction so early returns cannot leak budget.
+struct MemoryLease {
+  std::int64_t kb;
+
+  explicit MemoryLease(const std::int64_t kb) noexcept : kb(kb) {
+    MemoryBudget::instance().acquire(kb);
+  }
+  MemoryLease(const MemoryLease&) = delete;
+  MemoryLease& operator=(const MemoryLease&) = delete;
+  MemoryLease(MemoryLease&&) noexcept = delete;
+  MemoryLease& operator=(MemoryLease&&) noexcept = delete;
+  ~MemoryLease() noexcept { MemoryBudget::instance().release(kb); }
+};
+
+} // namespace
+
+static std::string_view edgeDescription(const NinjaEdge& edge) {
+  if (edge.rule == "cxx_compile") {
+    return "Building CXX object";
+  }
+  if (edge.rule == "cxx_module_bmi") {
+    return "Precompiling CXX module";
+  }
+  if (edge.rule == "cxx_pch") {
+    return "Precompiling header";
+  }
+  if (edge.rule == "cxx_link_exe") {
+    return "Linking CXX executable";
+  }
+  if (edge.rule == "cxx_link_static_lib") {
+    return "Linking CXX static library";
+  }
+  if (edge.rule == "cxx_link_shared") {
+    return "Linking CXX shared library";
+  }
+  return "Building";
+}
+
+Executor::Executor(const std::span<const NinjaEdge> edges,
+                   NinjaToolchain toolchain, fs::path workDir)
+    : edges_(edges), toolchain_(std::move(toolchain)),
+      workDir_(std::move(workDir)) {
+  for (std::size_t i = 0; i < edges_.size(); ++i) {
+    for (const std::string& output : edges_[i].outputs) {
+      producers_.emplace(output, i);
+    }
+    for (const std::string& output : edges_[i].implicitOutputs) {
+      producers_.emplace(output, i);
+    }
+  }
+  digestDb_.load(workDir_);
+
+  if (objectCache_.enabled()) {
+    // Distinguishes cached objects produced by different compiler
+    // releases behind the same $CXX name.  The probe result persists
+    // across runs keyed by the binary's stat, so it usually costs no
+    // fork at all.
+    const std::optional<std::string> version =
+        ToolchainCache::instance().probe(
+            toolchain_.cxx, "version", [this]() -> std::optional<std::string> {
+              auto output =
+                  getCmdOutput(Command(toolchain_.cxx).addArg("--version"));
+              if (output.is_ok()) {
+                return output.unwrap();
+              }
+              return std::nullopt;
+            });
+    if (version.has_value()) {
+      compilerVersionDigest_ = digestString(version.value());
+    }
+  }
+}
+
+std::vector<std::string>
+Executor::expandInputs(const std::vector<std::string>& inputs) const {
+  const auto isAlias = [this](const std::string& input) {
+    const auto it = producers_.find(input);
+    return it != producers_.end() && edges_[it->second].rule == "phony";
+  };
+  // Fast path: plans without reduced header edges pass through untouched.
+  if (std::ranges::none_of(inputs, isAlias)) {
+    return inputs;
+  }
+
+  std::vector<std::string> files;
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> stack(inputs.rbegin(), inputs.rend());
+  while (!stack.empty()) {
+    std::string current = std::move(stack.back());
+    stack.pop_back();
+    if (!seen.insert(current).second) {
+      continue;
+    }
+    if (isAlias(current)) {
+      const NinjaEdge& alias = edges_[producers_.at(current)];
+      stack.insert(stack.end(), alias.inputs.rbegin(), alias.inputs.rend());
+      continue;
+    }
+    files.push_back(std::move(current));
+  }
+  return files;
+}
+
+std::string Executor::objectCacheKey(const NinjaEdge& edge) const {
+  std::string material =
+      fmt::format("{} {} {} {} {} {}", compilerVersionDigest_, toolchain_.cxx,
+                  toolchain_.defines, toolchain_.includes, toolchain_.cxxFlags,
+                  bindingValue(edge, "extra_flags"));
+  const auto appendInputs = [&](const std::vector<std::string>& inputs) {
+    for (const std::string& input : inputs) {
+      material += digestFile(workDir_ / input);
+    }
+  };
+  appendInputs(edge.inputs);
+  appendInputs(expandInputs(edge.implicitInputs));
+  return digestString(material);
+}
+
+std::string Executor::edgeDigest(const NinjaEdge& edge) const {
+  std::string material = renderCommand(edge, toolchain_);
+  const auto appendInputs = [&](const std::vector<std::string>& inputs) {
+    for (const std::string& input : inputs) {
+      material += input;
+      material += digestFile(workDir_ / input);
+    }
+  };
+  appendInputs(edge.inputs);
+  appendInputs(expandInputs(edge.implicitInputs));
+  return digestString(material);
+}
+
+std::string Executor::sourceDigest(const NinjaEdge& edge) const {
+  std::string material = renderCommand(edge, toolchain_);
+  for (const std::string& input : edge.inputs) {
+    material += input;
+    material += digestFile(workDir_ / input);
+  }
+  return digestString(material);
+}
+
+std::optional<std::string>
+Executor::preprocessedDigest(const NinjaEdge& edge) const {
+  // `-P` drops the linemarkers, so comment edits and code guarded by
+  // unused macros leave the output byte-identical.  The wrapper is
+  // skipped: preprocessing is cheap and stays local.
+  const std::string commandLine = fmt::format(
+      "{} {} {} {} {} -E -P {}", toolchain_.cxx, toolchain_.defines,
+      toolchain_.includes, toolchain_.cxxFlags,
+      bindingValue(edge, "extra_flags"), joinWithSpace(edge.inputs));
+
+  Command command("/bin/sh");
+  command.addArg("-c").addArg(commandLine);
+  command.setWorkingDirectory(workDir_);
+  auto output = command.output();
+  if (output.is_err() || !output.unwrap().exitStatus.success()) {
+    return std::nullopt;
+  }
+  return digestString(output.unwrap().stdOut);
+}
+
+// Keep these templates in sync with NinjaPlan::writeRulesNinja so the
+// embedded executor and the ninja fallback run identical commands.
+std::string Executor::renderCommand(const NinjaEdge& edge,
+                                    const NinjaToolchain& toolchain) {
+  const std::string in = joinWithSpace(edge.inputs);
+  const std::string out = joinWithSpace(edge.outputs);
+  // Compile edges run through the configured wrapper; link edges are local.
+  const std::string wrappedCxx =
+      toolchain.cxxWrapper.empty()
+          ? toolchain.cxx
+          : fmt::format("{} {}", toolchain.cxxWrapper, toolchain.cxx);
+
+  if (edge.rule == "cxx_compile") {
+    return fmt::format("{} {} {} {} {} -c {} -o {}", wrappedCxx,
+                       toolchain.defines, toolchain.includes,
+                       toolchain.cxxFlags, bindingValue(edge, "extra_flags"),
+                       in, out);
+  }
+  if (edge.rule == "cxx_module_bmi") {
+    return fmt::format("{} {} {} {} {} -x c++-module --precompile {} -o {}",
+                       wrappedCxx, toolchain.defines, toolchain.includes,
+                       toolchain.cxxFlags, bindingValue(edge, "extra_flags"),
+                       in, out);
+  }
+  if (edge.rule == "cxx_pch") {
+    return fmt::format("{} {} {} {} -x c++-header -c {} -o {}", wrappedCxx,
+                       toolchain.defines, toolchain.includes,
+                       toolchain.cxxFlags, in, out);
+  }
+  if (edge.rule == "cxx_link_exe") {
+    return fmt::format("{} {} {} {} -o {}", toolchain.cxx, in,
+                       toolchain.ldFlags,
+                       bindingOr(edge, "LIBS", toolchain.libs), out);
+  }
+  if (edge.rule == "cxx_link_static_lib") {
+    return fmt::format("rm -f {0} && {1} {2} {0} {3}", out, toolchain.archiver,
+                       toolchain.archiveFlags, in);
+  }
+  if (edge.rule == "cxx_link_shared") {
+    return fmt::format("{} -shared {} {} {} -o {}", toolchain.cxx, in,
+                       toolchain.ldFlags,
+                       bindingOr(edge, "LIBS", toolchain.libs), out);
+  }
+  return "";
+}
+
+// Advises the kernel to start paging in every listed file.  The advice
+// is asynchronous — each call queues readahead and returns — so the
+// whole pass is a burst of opens that overlaps the first compile wave
+// instead of each compiler faulting its source and headers in serially
+// from a cold page cache.
+static void prefetchFiles(const std::vector<fs::path> paths) { // NOLINT(performance-unnecessary-value-param)
+  for (const fs::path& path : paths) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+#ifdef POSIX_FADV_WILLNEED
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    ::close(fd);
+  }
+}
+
+static std::optional<fs::file_time_type> mtimeOf(const fs::path& path) {
+  std::error_code ec;
+  const fs::file_time_type time = fs::last_write_time(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return time;
+}
+
+std::string Executor::renderArchiveCommand(const NinjaEdge& edge) const {
+  if (edge.rule != "cxx_link_static_lib" || edge.outputs.size() != 1) {
+    return "";
+  }
+  const std::string& archive = edge.outputs.front();
+  const auto archiveTime = mtimeOf(workDir_ / archive);
+  if (!archiveTime.has_value()) {
+    return "";
+  }
+  // Incremental replacement is only sound when the member list is unchanged;
+  // `ar r` cannot drop members that left the edge.  The member list recorded
+  // alongside the content digest guards against that.
+  const auto recordedMembers = digestDb_.lookup(archive + "#members");
+  if (!recordedMembers.has_value()
+      || *recordedMembers != digestString(joinWithSpace(edge.inputs))) {
+    return "";
+  }
+
+  std::vector<std::string> changed;
+  for (const std::string& input : edge.inputs) {
+    const auto inputTime = mtimeOf(workDir_ / input);
+    if (!inputTime.has_value()) {
+      return "";
+    }
+    if (*inputTime > *archiveTime) {
+      changed.push_back(input);
+    }
+  }
+  if (changed.empty() || changed.size() == edge.inputs.size()) {
+    return "";
+  }
+  return fmt::format("{} {} {} {}", toolchain_.archiver,
+                     toolchain_.archiveFlags, archive,
+                     joinWithSpace(changed));
+}
+
+rs::Result<std::vector<std::size_t>>
+Executor::schedule(const std::vector<std::string>& targets) const {
+  // Collect the edges reachable from the requested targets, dependencies
+  // first (DFS postorder).
+  std::vector<std::size_t> topoOrder;
+  std::vector<std::uint8_t> visited(edges_.size(), 0); // 0/1/2: new/open/done
+
+  const auto visit = [&](const auto& self, const std::size_t idx) -> void {
+    if (visited[idx] != 0) {
+      return;
+    }
+    visited[idx] = 1;
+    const NinjaEdge& edge = edges_[idx];
+    const auto visitInputs = [&](const std::vector<std::string>& inputs) {
+      for (const std::string& input : inputs) {
+        const auto it = producers_.find(input);
+        if (it != producers_.end()) {
+          self(self, it->second);
+        }
+      }
+    };
+    visitInputs(edge.inputs);
+    visitInputs(edge.implicitInputs);
+    visitInputs(edge.orderOnlyInputs);
+    visited[idx] = 2;
+    topoOrder.push_back(idx);
+  };
+
+  for (const std::string& target : targets) {
+    const auto it = producers_.find(target);
+    rs_ensure(it != producers_.end(), "unknown build target `{}`", target);
+    visit(visit, it->second);
+  }
+
+  // Walk in topological order and mark edges whose outputs are missing,
+  // older than an input, or fed by another dirty edge.
+  std::vector<std::uint8_t> dirty(edges_.size(), 0);
+  std::vector<std::size_t> scheduled;
+
+  // Effective mtimes of phony outputs (the header-alias nodes from the
+  // include-graph reduction): a phony edge runs nothing, its output
+  // relays the newest transitive input — ninja's phony semantics — and
+  // a missing input poisons the alias so consumers rebuild.
+  std::unordered_map<std::string, std::optional<fs::file_time_type>>
+      phonyTimes;
+  const auto inputTime =
+      [&](const std::string& input) -> std::optional<fs::file_time_type> {
+    if (const auto phony = phonyTimes.find(input);
+        phony != phonyTimes.end()) {
+      return phony->second;
+    }
+    return mtimeOf(workDir_ / input);
+  };
+
+  for (const std::size_t idx : topoOrder) {
+    const NinjaEdge& edge = edges_[idx];
+    if (edge.rule == "phony") {
+      std::optional<fs::file_time_type> newest = fs::file_time_type::min();
+      const auto relayInputs = [&](const std::vector<std::string>& inputs) {
+        for (const std::string& input : inputs) {
+          const auto time = inputTime(input);
+          if (!time.has_value()) {
+            newest.reset();
+            return;
+          }
+          if (newest.has_value() && *time > *newest) {
+            newest = *time;
+          }
+        }
+      };
+      relayInputs(edge.inputs);
+      if (newest.has_value()) {
+        relayInputs(edge.implicitInputs);
+      }
+      for (const std::string& output : edge.outputs) {
+        phonyTimes[output] = newest;
+      }
+      continue;
+    }
+    rs_ensure(!renderCommand(edge, toolchain_).empty(),
+              "unknown build rule `{}`", edge.rule);
+
+    std::optional<fs::file_time_type> oldestOutput;
+    bool outputMissing = false;
+    const auto checkOutputs = [&](const std::vector<std::string>& outputs) {
+      for (const std::string& output : outputs) {
+        const auto time = mtimeOf(workDir_ / output);
+        if (!time.has_value()) {
+          outputMissing = true;
+          return;
+        }
+        if (!oldestOutput.has_value() || *time < *oldestOutput) {
+          oldestOutput = time;
+        }
+      }
+    };
+    checkOutputs(edge.outputs);
+    if (!outputMissing) {
+      checkOutputs(edge.implicitOutputs);
+    }
+    if (outputMissing) {
+      oldestOutput.reset();
+    }
+
+    bool isDirty = !oldestOutput.has_value();
+    const auto checkInputs = [&](const std::vector<std::string>& inputs,
+                                 const bool affectsFreshness) {
+      for (const std::string& input : inputs) {
+        const auto it = producers_.find(input);
+        if (it != producers_.end() && dirty[it->second] != 0) {
+          isDirty = true;
+          return;
+        }
+        if (!affectsFreshness) {
+          continue;
+        }
+        const auto time = inputTime(input);
+        if (!time.has_value() || (oldestOutput.has_value()
+                                  && *time > *oldestOutput)) {
+          isDirty = true;
+          return;
+        }
+      }
+    };
+    if (!isDirty) {
+      checkInputs(edge.inputs, true);
+    }
+    if (!isDirty) {
+      checkInputs(edge.implicitInputs, true);
+    }
+    if (!isDirty) {
+      checkInputs(edge.orderOnlyInputs, false);
+    }
+
+    if (isDirty) {
+      dirty[idx] = 1;
+      scheduled.push_back(idx);
+    }
+  }
+  return rs::Ok(scheduled);
+}
+
+rs::Result<bool>
+Executor::needsBuild(const std::vector<std::string>& targets) const {
+  return rs::Ok(!rs_try(schedule(targets)).empty());
+}
+
+rs::Result<std::vector<std::string>>
+Executor::affected(const std::vector<std::string>& targets) const {
+  const std::vector<std::size_t> scheduled = rs_try(schedule(targets));
+  const std::unordered_set<std::size_t> dirty(scheduled.begin(),
+                                              scheduled.end());
+
+  std::vector<std::string> result;
+  if (dirty.empty()) {
+    return rs::Ok(std::move(result));
+  }
+
+  // One DFS per target over the producer graph; a target is affected as
+  // soon as its closure touches a dirty edge.
+  for (const std::string& target : targets) {
+    std::vector<std::uint8_t> visited(edges_.size(), 0);
+    const auto reachesDirty = [&](const auto& self,
+                                  const std::size_t idx) -> bool {
+      if (visited[idx] != 0) {
+        return false;
+      }
+      visited[idx] = 1;
+      if (dirty.contains(idx)) {
+        return true;
+      }
+      const NinjaEdge& edge = edges_[idx];
+      const auto inputsReach = [&](const std::vector<std::string>& inputs) {
+        for (const std::string& input : inputs) {
+          const auto it = producers_.find(input);
+          if (it != producers_.end() && self(self, it->second)) {
+            return true;
+          }
+        }
+        return false;
+      };
+      return inputsReach(edge.inputs) || inputsReach(edge.implicitInputs)
+             || inputsReach(edge.orderOnlyInputs);
+    };
+
+    const auto it = producers_.find(target);
+    rs_ensure(it != producers_.end(), "unknown build target `{}`", target);
+    if (reachesDirty(reachesDirty, it->second)) {
+      result.push_back(target);
+    }
+  }
+  return rs::Ok(std::move(result));
+}
+
+// Side outputs (e.g. split-DWARF .dwo files) are not stored in the
+// object cache, so such edges always compile.
+bool Executor::isCacheableCompile(const NinjaEdge& edge) const {
+  return edge.rule == "cxx_compile" && edge.outputs.size() == 1
+         && edge.implicitOutputs.empty() && objectCache_.enabled()
+         && !compilerVersionDigest_.empty();
+}
+
+rs::Result<ExitStatus> Executor::runEdge(const NinjaEdge& edge) const {
+  const std::string_view eventTarget =
+      edge.outputs.empty() ? std::string_view(edge.rule)
+                           : std::string_view(edge.outputs.front());
+  BuildEvents::edgeStarted(edge.rule, eventTarget);
+  const auto edgeStart = std::chrono::steady_clock::now();
+  const auto elapsedMs = [&edgeStart]() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - edgeStart)
+        .count();
+  };
+
+  const Timings::Span timingSpan(
+      edge.rule, edge.outputs.empty() ? edge.rule : edge.outputs.front());
+
+  // Early cutoff: if every output exists and the recorded digest of
+  // (command line + input contents) is unchanged, the mtime-based schedule
+  // was a false positive (e.g. a fresh checkout) and the edge can be
+  // skipped.
+  const auto existsHere = [this](const std::string& output) {
+    return fs::exists(workDir_ / output);
+  };
+  const bool outputsExist =
+      std::ranges::all_of(edge.outputs, existsHere)
+      && std::ranges::all_of(edge.implicitOutputs, existsHere);
+  const std::string digest = edgeDigest(edge);
+  const std::string outKey = joinWithSpace(edge.outputs);
+  const std::string diagKey = outKey + "#diag";
+  if (outputsExist) {
+    const auto recorded = digestDb_.lookup(outKey);
+    if (recorded.has_value() && *recorded == digest) {
+      spdlog::debug("up-to-date content, skipping {}", outKey);
+      // Replay the warnings the last compile of this edge produced;
+      // skipping the edge must not hide them until the next clean build.
+      if (const auto diag = digestDb_.lookup(diagKey);
+          diag.has_value() && !diag->empty()) {
+        DiagSink::writeLine(*diag);
+      }
+      BuildEvents::edgeFinished(edge.rule, eventTarget, elapsedMs(),
+                                /*success=*/true, /*cached=*/true);
+      return rs::Ok(ExitStatus());
+    }
+  }
+
+  // Impact analysis: when only headers moved (the explicit inputs still
+  // digest the same as the last successful compile), re-preprocess the TU
+  // and compare against the recorded preprocessed digest.  A match means
+  // the change cannot affect the object -- comment edits or additions
+  // behind unused macros in a widely-included header then skip the whole
+  // fan-out for the cost of one `-E` per candidate.  (The old object's
+  // debug line info may go stale across such a skip; a clean build
+  // refreshes it.)
+  std::string freshPpDigest;
+  if (edge.rule == "cxx_compile" && outputsExist) {
+    const auto recordedSrc = digestDb_.lookup(outKey + "#src");
+    if (recordedSrc.has_value() && *recordedSrc == sourceDigest(edge)) {
+      if (const auto ppDigest = preprocessedDigest(edge)) {
+        const auto recordedPp = digestDb_.lookup(outKey + "#pp");
+        if (recordedPp.has_value() && !recordedPp->empty()
+            && *recordedPp == *ppDigest) {
+          spdlog::debug("header change has no impact, skipping {}", outKey);
+          digestDb_.update(outKey, digest);
+          if (const auto diag = digestDb_.lookup(diagKey);
+              diag.has_value() && !diag->empty()) {
+            DiagSink::writeLine(*diag);
+          }
+          BuildEvents::edgeFinished(edge.rule, eventTarget, elapsedMs(),
+                                    /*success=*/true, /*cached=*/true);
+          return rs::Ok(ExitStatus());
+        }
+        // The preprocessed text really changed; remember its digest so
+        // the compile below records an up-to-date baseline for free.
+        freshPpDigest = *ppDigest;
+      }
+    }
+  }
+
+  for (const std::string& output : edge.outputs) {
+    const fs::path parent = (workDir_ / output).parent_path();
+    if (!parent.empty()) {
+      fs::create_directories(parent);
+    }
+  }
+
+  const bool cacheableCompile = isCacheableCompile(edge);
+  std::string cacheKey;
+  if (cacheableCompile) {
+    cacheKey = objectCacheKey(edge);
+    if (objectCache_.fetch(cacheKey, workDir_ / edge.outputs.front())) {
+      digestDb_.update(outKey, digest);
+      // Diagnostics travel with the cached object; adopt them locally so
+      // future early-cutoff skips replay them too.
+      const std::string diag = objectCache_.fetchDiag(cacheKey).value_or("");
+      if (!diag.empty()) {
+        DiagSink::writeLine(diag);
+      }
+      digestDb_.update(diagKey, diag);
+      // The fetched object may predate the recorded preprocessed
+      // baseline; drop it so the impact check cannot skip against the
+      // wrong compile.
+      digestDb_.update(outKey + "#pp", "");
+      BuildEvents::edgeFinished(edge.rule, eventTarget, elapsedMs(),
+                                /*success=*/true, /*cached=*/true);
+      return rs::Ok(ExitStatus());
+    }
+  }
+
+  // Replace only the changed members of an existing archive instead of
+  // rewriting it from scratch.
+  std::string commandLine = renderArchiveCommand(edge);
+  if (commandLine.empty()) {
+    commandLine = renderCommand(edge, toolchain_);
+  }
+  if (isVerbose()) {
+    fmt::print(stderr, "{}\n", commandLine);
+  }
+  spdlog::debug("{} {}", edgeDescription(edge), joinWithSpace(edge.outputs));
+
+  Command command("/bin/sh");
+  command.addArg("-c").addArg(commandLine);
+  command.setWorkingDirectory(workDir_);
+
+  // Admit the job against the memory budget using its last recorded peak
+  // RSS; admitting by prediction keeps a -j32 wave of 2-3 GiB compiles
+  // from outrunning RAM and meeting the OOM killer.
+  std::int64_t predictedKb = DEFAULT_EDGE_RSS_KB;
+  if (const auto rss = digestDb_.lookup(outKey + "#rss"); rss.has_value()) {
+    std::int64_t recorded = 0;
+    const auto [ptr, ec] =
+        std::from_chars(rss->data(), rss->data() + rss->size(), recorded);
+    if (ec == std::errc() && recorded > 0) {
+      predictedKb = recorded;
+    }
+  }
+  const MemoryLease lease(predictedKb);
+
+  ExitStatus status;
+  if (edge.rule == "cxx_compile") {
+    // Capture the compiler's stderr instead of inheriting it, so warnings
+    // from this compile can be replayed whenever the edge is skipped.
+    const CommandOutput out = rs_try(command.output());
+    status = out.exitStatus;
+    if (!out.stdOut.empty()) {
+      std::fwrite(out.stdOut.data(), 1, out.stdOut.size(), stdout);
+    }
+    std::string diag = out.stdErr;
+    if (!diag.empty()) {
+      if (diag.back() != '\n') {
+        diag += '\n';
+      }
+      DiagSink::writeLine(diag);
+    }
+    if (status.success()) {
+      digestDb_.update(diagKey, diag); // empty clears stale diagnostics
+      if (out.peakRssKb > 0) {
+        digestDb_.update(outKey + "#rss", std::to_string(out.peakRssKb));
+      }
+      if (cacheableCompile) {
+        objectCache_.storeDiag(cacheKey, diag);
+      }
+    }
+  } else {
+    status = rs_try(execCmd(command));
+  }
+  if (status.success()) {
+    digestDb_.update(outKey, digest);
+    if (edge.rule == "cxx_compile") {
+      digestDb_.update(outKey + "#src", sourceDigest(edge));
+      // Empty unless the impact check just measured it; a cleared
+      // baseline only costs one extra recompile on the next
+      // header-only change, never a wrong skip.
+      digestDb_.update(outKey + "#pp", freshPpDigest);
+    }
+    if (edge.rule == "cxx_link_static_lib" && edge.outputs.size() == 1) {
+      digestDb_.update(edge.outputs.front() + "#members",
+                       digestString(joinWithSpace(edge.inputs)));
+    }
+    if (cacheableCompile) {
+      objectCache_.store(cacheKey, workDir_ / edge.outputs.front());
+      RemoteCache::instance().enqueueUpload(cacheKey,
+                                            workDir_ / edge.outputs.front());
+    }
+    if (edge.rule.starts_with("cxx_link_")) {
+      for (const std::string& output : edge.outputs) {
+        BuildEvents::artifact(workDir_ / output);
+      }
+    }
+  }
+  BuildEvents::edgeFinished(edge.rule, eventTarget, elapsedMs(),
+                            status.success(), /*cached=*/false);
+  return rs::Ok(status);
+}
+
+rs::Result<ExitStatus>
+Executor::build(const std::vector<std::string>& targets) const {
+  const std::vector<std::size_t> scheduled = rs_try(schedule(targets));
+  if (scheduled.empty()) {
+    return rs::Ok(ExitStatus());
+  }
+
+  // Pull remote cache hits for every scheduled compile up front in one
+  // multiplexed batch; they land in the local object cache, so the edge
+  // loop below never waits on the network.
+  if (RemoteCache::instance().enabled()) {
+    std::vector<std::string> missingKeys;
+    for (const std::size_t idx : scheduled) {
+      if (!isCacheableCompile(edges_[idx])) {
+        continue;
+      }
+      std::string key = objectCacheKey(edges_[idx]);
+      if (!objectCache_.contains(key)) {
+        missingKeys.push_back(std::move(key));
+      }
+    }
+    RemoteCache::instance().prefetch(missingKeys, objectCache_);
+  }
+
+  // Page-cache warmup: the plan knows the exact set of sources and
+  // headers the scheduled compiles will read, so hand it to the kernel
+  // now and let readahead run concurrently with the first wave.  Inputs
+  // produced by other edges (objects, BMIs, the PCH) do not exist yet
+  // and are skipped.
+  std::unordered_set<std::string> prefetchSet;
+  for (const std::size_t idx : scheduled) {
+    const NinjaEdge& edge = edges_[idx];
+    if (edge.rule != "cxx_compile" && edge.rule != "cxx_module_bmi"
+        && edge.rule != "cxx_pch") {
+      continue;
+    }
+    const auto collect = [&](const std::vector<std::string>& inputs) {
+      for (const std::string& input : inputs) {
+        if (!producers_.contains(input)) {
+          prefetchSet.insert(input);
+        }
+      }
+    };
+    collect(edge.inputs);
+    collect(expandInputs(edge.implicitInputs));
+  }
+  struct Prefetcher { // joins on scope exit; the advice pass is cheap
+    std::thread thread;
+    ~Prefetcher() {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+    Prefetcher() = default;
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+    Prefetcher(Prefetcher&&) noexcept = delete;
+    Prefetcher& operator=(Prefetcher&&) noexcept = delete;
+  } prefetcher;
+  if (!prefetchSet.empty()) {
+    std::vector<fs::path> paths;
+    paths.reserve(prefetchSet.size());
+    for (const std::string& input : prefetchSet) {
+      paths.push_back(workDir_ / input);
+    }
+    spdlog::debug("prefetching {} input files", paths.size());
+    prefetcher.thread = std::thread(prefetchFiles, std::move(paths));
+  }
+
+  const std::unordered_set<std::size_t> scheduledSet(scheduled.begin(),
+                                                     scheduled.end());
+
+  // Remaining scheduled producers each edge still waits on.
+  std::unordered_map<std::size_t, std::size_t> waiting;
+  std::unordered_map<std::size_t, std::vector<std::size_t>> dependents;
+  for (const std::size_t idx : scheduled) {
+    std::size_t count = 0;
+    const auto countInputs = [&](const std::vector<std::string>& inputs) {
+      for (const std::string& input : inputs) {
+        const auto it = producers_.find(input);
+        if (it != producers_.end() && scheduledSet.contains(it->second)) {
+          ++count;
+          dependents[it->second].push_back(idx);
+        }
+      }
+    };
+    const NinjaEdge& edge = edges_[idx];
+    countInputs(edge.inputs);
+    countInputs(edge.implicitInputs);
+    countInputs(edge.orderOnlyInputs);
+    waiting.emplace(idx, count);
+  }
+
+  std::vector<std::size_t> wave;
+  for (const std::size_t idx : scheduled) {
+    if (waiting.at(idx) == 0) {
+      wave.push_back(idx);
+    }
+  }
+
+  Progress progress(scheduled.size());
+  const auto reportDone = [&](const NinjaEdge& edge) {
+    progress.completed(edge.outputs.empty() ? std::string_view(edge.rule)
+                                            : edge.outputs.front());
+  };
+
+  ExitStatus failure(EXIT_SUCCESS);
+  while (!wave.empty()) {
+    tbb::concurrent_vector<std::string> errors;
+    tbb::spin_mutex statusMtx;
+
+    if (isParallel() && wave.size() > 1) {
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, wave.size()),
+                        [&](const tbb::blocked_range<std::size_t>& rng) {
+                          for (std::size_t i = rng.begin(); i != rng.end();
+                               ++i) {
+                            auto result = runEdge(edges_[wave[i]]);
+                            if (result.is_err()) {
+                              errors.push_back(result.unwrap_err()->what());
+                              continue;
+                            }
+                            const ExitStatus status = result.unwrap();
+                            if (!status.success()) {
+                              const tbb::spin_mutex::scoped_lock lock(
+                                  statusMtx);
+                              failure = status;
+                            } else {
+                              reportDone(edges_[wave[i]]);
+                            }
+                          }
+                        });
+    } else {
+      for (const std::size_t idx : wave) {
+        const ExitStatus status = rs_try(runEdge(edges_[idx]));
+        if (!status.success()) {
+          failure = status;
+          break;
+        }
+        reportDone(edges_[idx]);
+      }
+    }
+    if (!errors.empty()) {
+      rs_bail("{}", fmt::join(errors, "\n"));
+    }
+    if (!failure.success()) {
+      digestDb_.save(workDir_);
+      BuildEvents::buildFinished(/*success=*/false);
+      return rs::Ok(failure);
+    }
+
+    std::vector<std::size_t> nextWave;
+    for (const std::size_t idx : wave) {
+      const auto it = dependents.find(idx);
+      if (it == dependents.end()) {
+        continue;
+      }
+      for (const std::size_t dependent : it->second) {
+        if (--waiting.at(dependent) == 0) {
+          nextWave.push_back(dependent);
+        }
+      }
+    }
+    std::ranges::sort(nextWave);
+    wave = std::move(nextWave);
+  }
+
+  digestDb_.save(workDir_);
+  BuildEvents::buildFinished(/*success=*/true);
+  return rs::Ok(ExitStatus());
+}
+
+} // namespace cabin
@@ -0,0 +1,132 @@
+#include "Builder/FreshToken.hpp"
+
+#include "Builder/ScanCache.hpp"
+#include "Builder/StatJournal.hpp"
+#include "CacheFile.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <system_error>
+
+namespace cabin {
+
+static std::string statOf(const fs::path& path) {
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(path, ec);
+  if (ec) {
+    return "missing";
+  }
+  const auto mtime = fs::last_write_time(path, ec);
+  if (ec) {
+    return "missing";
+  }
+  return fmt::format("{}:{}", size, mtime.time_since_epoch().count());
+}
+
+// The token's validity digest.  The stat of the compiler binary catches
+// toolchain upgrades behind an unchanged path; the stat of the journal
+// file pins the token to the exact plan it was written against, so any
+// later replan (by `run`, `test`, or a failed build) kills it without
+// coordination.  $CXX is folded in because it can redirect compiler
+// selection before any manifest is parsed.
+static std::string computeHash(const fs::path& manifestPath,
+                               const fs::path& outBasePath,
+                               const std::string& cxx) {
+  const char* cxxEnv = std::getenv("CXX");
+  return digestString(fmt::format(
+      "{}\x1f{}\x1f{}\x1f{}\x1f{}", digestFile(manifestPath), cxx,
+      cxx.find('/') != std::string::npos ? statOf(cxx) : std::string(),
+      statOf(outBasePath / StatJournal::FILE_NAME),
+      cxxEnv != nullptr ? cxxEnv : ""));
+}
+
+// Shared validation: parses the token, rechecks its digest, and replays
+// the stat journal.  The caller decides what the token's scope is good
+// for.
+static std::optional<nlohmann::json>
+loadValidToken(const fs::path& manifestPath, const fs::path& outBasePath) {
+  const fs::path tokenPath = outBasePath / FreshToken::FILE_NAME;
+  std::error_code ec;
+  if (!fs::exists(tokenPath, ec) || !fs::exists(manifestPath, ec)) {
+    return std::nullopt;
+  }
+
+  nlohmann::json token;
+  std::string cxx;
+  std::string hash;
+  try {
+    std::ifstream ifs(tokenPath);
+    token = nlohmann::json::parse(ifs);
+    if (!token.is_object() || token.value("version", 0) != 2) {
+      return std::nullopt;
+    }
+    cxx = token.at("cxx");
+    hash = token.at("hash");
+  } catch (const std::exception& e) {
+    spdlog::debug("discarding fresh token: {}", e.what());
+    return std::nullopt;
+  }
+
+  if (computeHash(manifestPath, outBasePath, cxx) != hash) {
+    return std::nullopt;
+  }
+
+  // The digest covers the journal file; the journal covers the tree.
+  const std::optional<StatJournal> journal = StatJournal::load(outBasePath);
+  if (!journal.has_value() || journal->empty()
+      || !journal->matchesCurrentTree()) {
+    return std::nullopt;
+  }
+  return token;
+}
+
+bool FreshToken::isFresh(const fs::path& manifestPath,
+                         const fs::path& outBasePath) {
+  const std::optional<nlohmann::json> token =
+      loadValidToken(manifestPath, outBasePath);
+  return token.has_value() && token->value("scope", "") == "all";
+}
+
+std::optional<fs::path> FreshToken::freshBinary(const fs::path& manifestPath,
+                                                const fs::path& outBasePath) {
+  const std::optional<nlohmann::json> token =
+      loadValidToken(manifestPath, outBasePath);
+  if (!token.has_value()) {
+    return std::nullopt;
+  }
+  const std::string bin = token->value("bin", "");
+  if (bin.empty()) {
+    return std::nullopt;
+  }
+  fs::path binPath = outBasePath / bin;
+  std::error_code ec;
+  if (!fs::is_regular_file(binPath, ec)) {
+    return std::nullopt;
+  }
+  return binPath;
+}
+
+void FreshToken::write(const fs::path& manifestPath,
+                       const fs::path& outBasePath, const std::string& cxx,
+                       const Scope scope, const std::string& binaryName) {
+  nlohmann::json token;
+  token["version"] = 2;
+  token["cxx"] = cxx;
+  token["hash"] = computeHash(manifestPath, outBasePath, cxx);
+  token["scope"] = scope == Scope::All ? "all" : "bin";
+  token["bin"] = binaryName;
+  writeFileAtomic(outBasePath / FILE_NAME, token.dump());
+}
+
+void FreshToken::invalidate(const fs::path& outBasePath) {
+  std::error_code ec;
+  fs::remove(outBasePath / FILE_NAME, ec);
+}
+
+} // namespace cabin
@@ -0,0 +1,217 @@
+#include "Builder/HeaderGraph.hpp"
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cabin {
+
+HeaderGraph::HeaderGraph(std::vector<fs::path> searchDirs, fs::path baseDir)
+    : searchDirs_(std::move(searchDirs)), baseDir_(std::move(baseDir)) {}
+
+std::string HeaderGraph::normalize(const std::string_view path) const {
+  fs::path p(path);
+  if (p.is_relative()) {
+    p = baseDir_ / p;
+  }
+  return p.lexically_normal().generic_string();
+}
+
+void HeaderGraph::addKnownHeader(const std::string_view path) {
+  universe_.insert(normalize(path));
+}
+
+// The directive name if `line` is an include directive, empty otherwise;
+// `quoted` reports the `"..."` form (which also searches the includer's
+// directory).
+static std::string_view includeName(std::string_view line, bool& quoted) {
+  const auto skipSpace = [&line] {
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+      line.remove_prefix(1);
+    }
+  };
+  skipSpace();
+  if (line.empty() || line.front() != '#') {
+    return {};
+  }
+  line.remove_prefix(1);
+  skipSpace();
+  if (!line.starts_with("include")) {
+    return {};
+  }
+  line.remove_prefix(std::string_view("include").size());
+  skipSpace();
+  if (line.empty()) {
+    return {};
+  }
+  const char open = line.front();
+  const char close = open == '"' ? '"' : '>';
+  if (open != '"' && open != '<') {
+    return {}; // computed include; divergence is caught by reduce()
+  }
+  line.remove_prefix(1);
+  const std::size_t end = line.find(close);
+  if (end == std::string_view::npos) {
+    return {};
+  }
+  quoted = open == '"';
+  return line.substr(0, end);
+}
+
+const std::vector<std::string>&
+HeaderGraph::directIncludes(const std::string& path) {
+  if (const auto found = parsed_.find(path); found != parsed_.end()) {
+    return found->second;
+  }
+
+  std::vector<std::string> includes;
+  const std::shared_ptr<const MappedFile> mapped =
+      MappedFileCache::instance().get(path);
+  if (mapped) {
+    const std::string_view content = mapped->view();
+    const fs::path includerDir = fs::path(path).parent_path();
+
+    const auto resolve = [&](const std::string_view name, const bool quoted) {
+      const auto tryDir = [&](const fs::path& dir) {
+        std::string candidate = normalize((dir / name).native());
+        if (!universe_.contains(candidate)) {
+          return false;
+        }
+        if (std::ranges::find(includes, candidate) == includes.end()) {
+          includes.push_back(std::move(candidate));
+        }
+        return true;
+      };
+      if (quoted && tryDir(includerDir)) {
+        return;
+      }
+      for (const fs::path& dir : searchDirs_) {
+        if (tryDir(dir)) {
+          return;
+        }
+      }
+      // Unresolved: assumed external.  A wrong assumption only makes the
+      // walked closure diverge from the scanned one, disabling reduction
+      // for the affected TUs.
+    };
+
+    std::size_t lineBegin = 0;
+    while (lineBegin < content.size()) {
+      std::size_t lineEnd = content.find('\n', lineBegin);
+      if (lineEnd == std::string_view::npos) {
+        lineEnd = content.size();
+      }
+      const std::string_view line =
+          content.substr(lineBegin, lineEnd - lineBegin);
+      lineBegin = lineEnd + 1;
+
+      bool quoted = false;
+      if (const std::string_view name = includeName(line, quoted);
+          !name.empty()) {
+        resolve(name, quoted);
+      }
+    }
+  }
+  return parsed_.emplace(path, std::move(includes)).first->second;
+}
+
+std::optional<std::vector<std::string>>
+HeaderGraph::reduce(const std::string& sourceFile,
+                    const std::unordered_set<std::string>& closure) {
+  const std::vector<std::string> direct = directIncludes(sourceFile);
+
+  std::unordered_set<std::string> reached;
+  std::vector<std::string> stack(direct.begin(), direct.end());
+  while (!stack.empty()) {
+    const std::string current = std::move(stack.back());
+    stack.pop_back();
+    if (!closure.contains(current)) {
+      return std::nullopt; // reached outside the scanned closure
+    }
+    if (!reached.insert(current).second) {
+      continue;
+    }
+    for (const std::string& inc : directIncludes(current)) {
+      stack.push_back(inc);
+    }
+  }
+  if (reached.size() != closure.size()) {
+    return std::nullopt; // part of the scanned closure was never reached
+  }
+  return direct;
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <fstream>
+#  include <rs/tests.hpp>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static void writeTestFile(const fs::path& path,
+                          const std::string_view content) {
+  std::ofstream(path) << content;
+}
+
+static void testReduceExactClosure() {
+  const fs::path dir = fs::temp_directory_path() / "cabin-header-graph-test";
+  fs::create_directories(dir / "include");
+  writeTestFile(dir / "include" / "b.hpp", "#pragma once\n#include <vector>\n");
+  writeTestFile(dir / "include" / "a.hpp", "#pragma once\n#include \"b.hpp\"\n");
+  writeTestFile(dir / "main.cc", "#include \"include/a.hpp\"\nint main() {}\n");
+
+  HeaderGraph graph({ dir / "include" }, dir);
+  const std::string a = graph.normalize((dir / "include" / "a.hpp").native());
+  const std::string b = graph.normalize((dir / "include" / "b.hpp").native());
+  graph.addKnownHeader(a);
+  graph.addKnownHeader(b);
+
+  // The walk reproduces the scanned closure exactly, so the TU reduces
+  // to its one direct include; <vector> resolves nowhere and is ignored.
+  const auto direct = graph.reduce((dir / "main.cc").string(), { a, b });
+  rs::assertTrue(direct.has_value());
+  rs::assertEq(direct->size(), static_cast<std::size_t>(1));
+  rs::assertEq(direct->front(), a);
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+static void testReduceDivergence() {
+  const fs::path dir =
+      fs::temp_directory_path() / "cabin-header-graph-diverge";
+  fs::create_directories(dir / "include");
+  writeTestFile(dir / "include" / "b.hpp", "#pragma once\n");
+  writeTestFile(dir / "include" / "a.hpp", "#pragma once\n#include \"b.hpp\"\n");
+  writeTestFile(dir / "main.cc", "#include \"include/a.hpp\"\nint main() {}\n");
+
+  HeaderGraph graph({ dir / "include" }, dir);
+  const std::string a = graph.normalize((dir / "include" / "a.hpp").native());
+  const std::string b = graph.normalize((dir / "include" / "b.hpp").native());
+  graph.addKnownHeader(a);
+  graph.addKnownHeader(b);
+
+  const std::string source = (dir / "main.cc").string();
+  // Walk escapes the scanned closure (a header guarded out for this TU).
+  rs::assertFalse(graph.reduce(source, { a }).has_value());
+  // Walk misses part of the scanned closure (a computed include).
+  rs::assertFalse(
+      graph.reduce(source, { a, b, "/elsewhere/c.hpp" }).has_value());
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+int main() {
+  testReduceExactClosure();
+  testReduceDivergence();
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include "Builder/NinjaPlan.hpp"
 
+#include "Builder/ScanCache.hpp"
+
+#include <cstddef>
+#include <filesystem>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include <fstream>
@@ -9,12 +13,18 @@
 
 namespace cabin {
 
+namespace fs = std::filesystem;
+
 template <typename Range>
-static std::string joinWithSpace(const Range& range) {
-  if (range.empty()) {
-    return "";
+static void appendJoined(std::string& out, const Range& range) {
+  bool first = true;
+  for (const auto& item : range) {
+    if (!first) {
+      out += ' ';
+    }
+    first = false;
+    out += item;
   }
-  return fmt::format("{}", fmt::join(range, " "));
 }
 
 NinjaPlan::NinjaPlan(std::filesystem::path outBasePath)
@@ -36,84 +46,168 @@ void NinjaPlan::setTestTargets(std::vector<std::string> testTargets) {
   testTargets_ = std::move(testTargets);
 }
 
+void NinjaPlan::restore(std::vector<NinjaEdge> edges,
+                        std::vector<std::string> defaultTargets,
+                        std::vector<std::string> testTargets) {
+  edges_ = std::move(edges);
+  defaultTargets_ = std::move(defaultTargets);
+  testTargets_ = std::move(testTargets);
+}
+
 void NinjaPlan::writeFiles(const NinjaToolchain& toolchain) const {
-  writeBuildNinja();
-  writeConfigNinja(toolchain);
-  writeRulesNinja();
-  writeTargetsNinja();
+  writeIfChanged("build.ninja", renderBuildNinja());
+  writeIfChanged("config.ninja", renderConfigNinja(toolchain));
+  writeIfChanged("rules.ninja", renderRulesNinja());
+  writeIfChanged("targets.ninja", renderTargetsNinja());
 }
 
-void NinjaPlan::writeBuildNinja() const {
-  std::ofstream buildFile(outBasePath_ / "build.ninja");
-  buildFile << "# Generated by Cabin\n";
-  buildFile << "ninja_required_version = 1.11\n\n";
-  buildFile << "include config.ninja\n";
-  buildFile << "include rules.ninja\n";
-  buildFile << "include targets.ninja\n\n";
-  if (!defaultTargets_.empty()) {
-    buildFile << "default " << joinWithSpace(defaultTargets_) << '\n';
+void NinjaPlan::writeIfChanged(const std::string_view fileName,
+                               const std::string& content) const {
+  const fs::path path = outBasePath_ / fileName;
+  // An untouched mtime means ninja can trust its previous stat of the
+  // file; rewriting identical content would make it re-read everything.
+  if (fs::exists(path) && digestFile(path) == digestString(content)) {
+    return;
   }
+  std::ofstream file(path, std::ios::trunc);
+  file << content;
 }
 
-void NinjaPlan::writeConfigNinja(const NinjaToolchain& toolchain) const {
-  std::ofstream cfg(outBasePath_ / "config.ninja");
-  cfg << "# Build variables\n";
-  cfg << "CXX = " << toolchain.cxx << '\n';
-  cfg << "CXXFLAGS = " << toolchain.cxxFlags << '\n';
-  cfg << "DEFINES = " << toolchain.defines << '\n';
-  cfg << "INCLUDES = " << toolchain.includes << '\n';
-  cfg << "LDFLAGS = " << toolchain.ldFlags << '\n';
-  cfg << "LIBS = " << toolchain.libs << '\n';
-  cfg << "AR = " << toolchain.archiver << '\n';
+std::string NinjaPlan::renderBuildNinja() const {
+  std::string out = "# Generated by Cabin\n"
+                    "ninja_required_version = 1.11\n\n"
+                    "include config.ninja\n"
+                    "include rules.ninja\n"
+                    "include targets.ninja\n\n";
+  if (!defaultTargets_.empty()) {
+    out += "default ";
+    appendJoined(out, defaultTargets_);
+    out += '\n';
+  }
+  return out;
 }
 
-void NinjaPlan::writeRulesNinja() const {
-  std::ofstream rules(outBasePath_ / "rules.ninja");
-
-  rules << "rule cxx_compile\n";
-  rules << "  command = $CXX $DEFINES $INCLUDES $CXXFLAGS $extra_flags -c $in "
-           "-o $out\n";
-  rules << "  description = Building CXX object $out\n\n";
-
-  rules << "rule cxx_link_exe\n";
-  rules << "  command = $CXX $in $LDFLAGS $LIBS -o $out\n";
-  rules << "  description = Linking CXX executable $out\n\n";
+std::string NinjaPlan::renderConfigNinja(
+    const NinjaToolchain& toolchain) const {
+  return fmt::format("# Build variables\n"
+                     "CXX = {}\n"
+                     "WRAPPER = {}\n"
+                     "CXXFLAGS = {}\n"
+                     "DEFINES = {}\n"
+                     "INCLUDES = {}\n"
+                     "LDFLAGS = {}\n"
+                     "LIBS = {}\n"
+                     "AR = {}\n"
+                     "ARFLAGS = {}\n",
+                     toolchain.cxx, toolchain.cxxWrapper, toolchain.cxxFlags,
+                     toolchain.defines, toolchain.includes, toolchain.ldFlags,
+                     toolchain.libs, toolchain.archiver,
+                     toolchain.archiveFlags);
+}
 
-  rules << "rule cxx_link_static_lib\n";
-  rules << "  command = rm -f $out && $AR rcs $out $in\n";
-  rules << "  description = Linking CXX static library $out\n\n";
+std::string NinjaPlan::renderRulesNinja() const {
+  // $WRAPPER is usually empty; when [build] wrapper is set it prefixes the
+  // compile edges (link edges always run locally).
+  return "rule cxx_compile\n"
+         "  command = $WRAPPER $CXX $DEFINES $INCLUDES $CXXFLAGS "
+         "$extra_flags -c $in -o $out\n"
+         "  description = Building CXX object $out\n\n"
+
+         "rule cxx_module_bmi\n"
+         "  command = $WRAPPER $CXX $DEFINES $INCLUDES $CXXFLAGS "
+         "$extra_flags -x c++-module --precompile $in -o $out\n"
+         "  description = Precompiling CXX module $out\n\n"
+
+         "rule cxx_pch\n"
+         "  command = $WRAPPER $CXX $DEFINES $INCLUDES $CXXFLAGS -x "
+         "c++-header -c $in -o $out\n"
+         "  description = Precompiling header $out\n\n"
+
+         "rule cxx_link_exe\n"
+         "  command = $CXX $in $LDFLAGS $LIBS -o $out\n"
+         "  description = Linking CXX executable $out\n\n"
+
+         "rule cxx_link_static_lib\n"
+         "  command = rm -f $out && $AR $ARFLAGS $out $in\n"
+         "  description = Linking CXX static library $out\n\n"
+
+         "rule cxx_link_shared\n"
+         "  command = $CXX -shared $in $LDFLAGS $LIBS -o $out\n"
+         "  description = Linking CXX shared library $out\n\n";
 }
 
-void NinjaPlan::writeTargetsNinja() const {
-  std::ofstream targetsFile(outBasePath_ / "targets.ninja");
+std::string NinjaPlan::renderTargetsNinja() const {
+  // Predict the output size from the edge strings so the append loop
+  // never reallocates; the per-edge slack covers separators.
+  std::size_t estimate = 64;
+  for (const NinjaEdge& edge : edges_) {
+    std::size_t edgeSize = 16 + edge.rule.size();
+    for (const auto& strs :
+         { &edge.outputs, &edge.implicitOutputs, &edge.inputs,
+           &edge.implicitInputs, &edge.orderOnlyInputs }) {
+      for (const std::string& str : *strs) {
+        edgeSize += str.size() + 1;
+      }
+      edgeSize += 3;
+    }
+    for (const auto& [key, value] : edge.bindings) {
+      edgeSize += key.size() + value.size() + 6;
+    }
+    estimate += edgeSize;
+  }
+  for (const std::string& target : defaultTargets_) {
+    estimate += target.size() + 1;
+  }
+  for (const std::string& target : testTargets_) {
+    estimate += target.size() + 1;
+  }
+
+  std::string out;
+  out.reserve(estimate);
 
   for (const NinjaEdge& edge : edges_) {
-    targetsFile << "build " << joinWithSpace(edge.outputs);
-    targetsFile << ": " << edge.rule;
+    out += "build ";
+    appendJoined(out, edge.outputs);
+    if (!edge.implicitOutputs.empty()) {
+      out += " | ";
+      appendJoined(out, edge.implicitOutputs);
+    }
+    out += ": ";
+    out += edge.rule;
     if (!edge.inputs.empty()) {
-      targetsFile << ' ' << joinWithSpace(edge.inputs);
+      out += ' ';
+      appendJoined(out, edge.inputs);
     }
     if (!edge.implicitInputs.empty()) {
-      targetsFile << " | " << joinWithSpace(edge.implicitInputs);
+      out += " | ";
+      appendJoined(out, edge.implicitInputs);
     }
     if (!edge.orderOnlyInputs.empty()) {
-      targetsFile << " || " << joinWithSpace(edge.orderOnlyInputs);
+      out += " || ";
+      appendJoined(out, edge.orderOnlyInputs);
     }
-    targetsFile << '\n';
+    out += '\n';
     for (const auto& [key, value] : edge.bindings) {
-      targetsFile << "  " << key << " = " << value << '\n';
+      out += "  ";
+      out += key;
+      out += " = ";
+      out += value;
+      out += '\n';
     }
-    targetsFile << '\n';
+    out += '\n';
   }
 
   if (!defaultTargets_.empty()) {
-    targetsFile << "build all: phony " << joinWithSpace(defaultTargets_) << '\n'
-                << '\n';
+    out += "build all: phony ";
+    appendJoined(out, defaultTargets_);
+    out += "\n\n";
   }
   if (!testTargets_.empty()) {
-    targetsFile << "build tests: phony " << joinWithSpace(testTargets_) << '\n'
-                << '\n';
+    out += "build tests: phony ";
+    appendJoined(out, testTargets_);
+    out += "\n\n";
   }
+  return out;
 }
 
 } // namespace cabin
@@ -0,0 +1,176 @@
+#include "Builder/ObjectCache.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace cabin {
+
+static bool cacheDisabledByEnv() {
+  const char* env = std::getenv("CABIN_OBJECT_CACHE");
+  return env != nullptr && std::string_view(env) == "0";
+}
+
+fs::path ObjectCache::defaultRoot() {
+  if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+      xdgCacheHome != nullptr && *xdgCacheHome != '\0') {
+    return fs::path(xdgCacheHome) / "cabin" / "objects";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && *home != '\0') {
+    return fs::path(home) / ".cache" / "cabin" / "objects";
+  }
+  return {};
+}
+
+ObjectCache::ObjectCache() : ObjectCache(defaultRoot()) {}
+
+ObjectCache::ObjectCache(fs::path root) : root_(std::move(root)) {
+  enabled_ = !root_.empty() && !cacheDisabledByEnv();
+}
+
+fs::path ObjectCache::objectPath(const std::string& key) const {
+  // Shard by the first two digest characters to keep directories small.
+  return root_ / key.substr(0, 2) / (key.substr(2) + ".o");
+}
+
+static bool linkOrCopy(const fs::path& from, const fs::path& to) {
+  std::error_code ec;
+  fs::create_hard_link(from, to, ec);
+  if (!ec) {
+    return true;
+  }
+  fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+  return !ec;
+}
+
+bool ObjectCache::contains(const std::string& key) const {
+  if (!enabled_) {
+    return false;
+  }
+  std::error_code ec;
+  return fs::exists(objectPath(key), ec) && !ec;
+}
+
+bool ObjectCache::fetch(const std::string& key, const fs::path& dst) const {
+  if (!enabled_) {
+    return false;
+  }
+  const fs::path cached = objectPath(key);
+  std::error_code ec;
+  if (!fs::exists(cached, ec) || ec) {
+    return false;
+  }
+
+  fs::create_directories(dst.parent_path(), ec);
+  fs::remove(dst, ec);
+  if (!linkOrCopy(cached, dst)) {
+    spdlog::debug("object cache: failed to materialize {}", dst.string());
+    return false;
+  }
+  spdlog::trace("object cache hit: {}", dst.string());
+  return true;
+}
+
+void ObjectCache::store(const std::string& key, const fs::path& src) const {
+  if (!enabled_) {
+    return;
+  }
+  const fs::path cached = objectPath(key);
+  std::error_code ec;
+  if (fs::exists(cached, ec)) {
+    return;
+  }
+  fs::create_directories(cached.parent_path(), ec);
+  if (ec) {
+    return;
+  }
+  // Publish atomically so a concurrent cabin never sees a partial object.
+  const fs::path tmp = cached.string() + ".tmp";
+  fs::remove(tmp, ec);
+  if (!linkOrCopy(src, tmp)) {
+    spdlog::debug("object cache: failed to publish {}", src.string());
+    return;
+  }
+  fs::rename(tmp, cached, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+  }
+}
+
+void ObjectCache::storeBuffer(const std::string& key,
+                              const std::string_view bytes) const {
+  if (!enabled_) {
+    return;
+  }
+  const fs::path cached = objectPath(key);
+  std::error_code ec;
+  if (fs::exists(cached, ec)) {
+    return;
+  }
+  fs::create_directories(cached.parent_path(), ec);
+  if (ec) {
+    return;
+  }
+  const fs::path tmp = cached.string() + ".tmp";
+  {
+    std::ofstream ofs(tmp, std::ios::binary);
+    if (!ofs) {
+      return;
+    }
+    ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  }
+  fs::rename(tmp, cached, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+  }
+}
+
+std::optional<std::string>
+ObjectCache::fetchDiag(const std::string& key) const {
+  if (!enabled_) {
+    return std::nullopt;
+  }
+  std::ifstream ifs(objectPath(key).string() + ".diag", std::ios::binary);
+  if (!ifs) {
+    return std::nullopt;
+  }
+  return std::string(std::istreambuf_iterator<char>(ifs),
+                     std::istreambuf_iterator<char>());
+}
+
+void ObjectCache::storeDiag(const std::string& key,
+                            const std::string& diag) const {
+  if (!enabled_ || diag.empty()) {
+    return;
+  }
+  const fs::path cached = objectPath(key).string() + ".diag";
+  std::error_code ec;
+  if (fs::exists(cached, ec)) {
+    return;
+  }
+  fs::create_directories(cached.parent_path(), ec);
+  if (ec) {
+    return;
+  }
+  // Same atomic-rename publish as the object itself.
+  const fs::path tmp = cached.string() + ".tmp";
+  {
+    std::ofstream ofs(tmp, std::ios::binary);
+    if (!ofs) {
+      return;
+    }
+    ofs << diag;
+  }
+  fs::rename(tmp, cached, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+  }
+}
+
+} // namespace cabin
@@ -0,0 +1,55 @@
+#include "Builder/PathTable.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace cabin {
+
+std::uint32_t PathTable::intern(const std::string_view path) {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  const auto it = ids.find(path);
+  if (it != ids.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<std::uint32_t>(strings.size());
+  strings.emplace_back(path);
+  ids.emplace(strings.back(), id);
+  return id;
+}
+
+const std::string& PathTable::str(const std::uint32_t id) const {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  return strings[id];
+}
+
+std::size_t PathTable::size() const {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  return strings.size();
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <rs/tests.hpp>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static void testInternDedupes() {
+  PathTable table;
+
+  const std::uint32_t first = table.intern("include/Foo.hpp");
+  const std::uint32_t second = table.intern("include/Bar.hpp");
+  rs::assertTrue(first != second);
+  rs::assertEq(table.intern("include/Foo.hpp"), first);
+  rs::assertEq(table.size(), static_cast<std::size_t>(2));
+
+  rs::assertEq(table.str(first), "include/Foo.hpp");
+  rs::assertEq(table.str(second), "include/Bar.hpp");
+
+  rs::pass();
+}
+
+int main() { testInternDedupes(); }
+
+#endif
@@ -0,0 +1,358 @@
+#include "Builder/PlanCache.hpp"
+
+#include "CacheFile.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+static constexpr std::uint32_t PLAN_MAGIC = 0x4C'50'42'43; // "CBPL"
+static constexpr std::uint32_t PLAN_VERSION = 4; // 4: combined test runner
+
+namespace {
+
+/// Bounds-checked cursor over the mapped file.  Every reader returns false
+/// on a truncated or out-of-range record, which makes the whole load fail
+/// soft (and the planner re-derive the plan).
+class Reader {
+public:
+  Reader(const char* data, const std::size_t size)
+      : data_(data), size_(size) {}
+
+  bool readU32(std::uint32_t& value) {
+    if (size_ - pos_ < sizeof(value)) {
+      return false;
+    }
+    std::memcpy(&value, data_ + pos_, sizeof(value));
+    pos_ += sizeof(value);
+    return true;
+  }
+
+  bool readU8(std::uint8_t& value) {
+    if (size_ - pos_ < sizeof(value)) {
+      return false;
+    }
+    value = static_cast<std::uint8_t>(data_[pos_]);
+    pos_ += sizeof(value);
+    return true;
+  }
+
+  bool readString(std::string& value) {
+    std::uint32_t len = 0;
+    if (!readU32(len) || size_ - pos_ < len) {
+      return false;
+    }
+    value.assign(data_ + pos_, len);
+    pos_ += len;
+    return true;
+  }
+
+private:
+  const char* data_;
+  std::size_t size_;
+  std::size_t pos_ = 0;
+};
+
+class Writer {
+public:
+  std::uint32_t intern(const std::string& str) {
+    const auto [it, inserted] =
+        stringIds_.try_emplace(str, static_cast<std::uint32_t>(strings_.size()));
+    if (inserted) {
+      strings_.push_back(str);
+    }
+    return it->second;
+  }
+
+  void putU32(const std::uint32_t value) {
+    body_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void putU8(const std::uint8_t value) {
+    body_.push_back(static_cast<char>(value));
+  }
+
+  void putRef(const std::string& str) { putU32(intern(str)); }
+
+  void putRefs(const std::vector<std::string>& strs) {
+    putU32(static_cast<std::uint32_t>(strs.size()));
+    for (const std::string& str : strs) {
+      putRef(str);
+    }
+  }
+
+  void writeTo(std::ostream& out) const {
+    const auto putU32To = [&out](const std::uint32_t value) {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    putU32To(PLAN_MAGIC);
+    putU32To(PLAN_VERSION);
+    putU32To(static_cast<std::uint32_t>(strings_.size()));
+    for (const std::string& str : strings_) {
+      putU32To(static_cast<std::uint32_t>(str.size()));
+      out.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+    out.write(body_.data(), static_cast<std::streamsize>(body_.size()));
+  }
+
+private:
+  std::unordered_map<std::string, std::uint32_t> stringIds_;
+  std::vector<std::string> strings_;
+  std::string body_;
+};
+
+} // namespace
+
+std::optional<PlanSnapshot> PlanCache::load(const fs::path& outBasePath) {
+  const fs::path path = outBasePath / FILE_NAME;
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) { // NOLINT(performance-no-int-to-ptr)
+    return std::nullopt;
+  }
+
+  std::optional<PlanSnapshot> result;
+  {
+    Reader reader(static_cast<const char*>(mapped), size);
+    result = [&reader]() -> std::optional<PlanSnapshot> {
+      std::uint32_t magic = 0;
+      std::uint32_t version = 0;
+      if (!reader.readU32(magic) || magic != PLAN_MAGIC
+          || !reader.readU32(version) || version != PLAN_VERSION) {
+        return std::nullopt;
+      }
+
+      std::uint32_t stringCount = 0;
+      if (!reader.readU32(stringCount)) {
+        return std::nullopt;
+      }
+      std::vector<std::string> strings(stringCount);
+      for (std::string& str : strings) {
+        if (!reader.readString(str)) {
+          return std::nullopt;
+        }
+      }
+
+      const auto readRef = [&](std::string& value) {
+        std::uint32_t idx = 0;
+        if (!reader.readU32(idx) || idx >= strings.size()) {
+          return false;
+        }
+        value = strings[idx];
+        return true;
+      };
+      const auto readRefs = [&](std::vector<std::string>& values) {
+        std::uint32_t count = 0;
+        if (!reader.readU32(count)) {
+          return false;
+        }
+        values.resize(count);
+        for (std::string& value : values) {
+          if (!readRef(value)) {
+            return false;
+          }
+        }
+        return true;
+      };
+
+      PlanSnapshot snapshot;
+      NinjaToolchain& tc = snapshot.toolchain;
+      for (std::string* field :
+           { &tc.cxx, &tc.cxxWrapper, &tc.cxxFlags, &tc.defines, &tc.includes,
+             &tc.ldFlags, &tc.libs, &tc.archiver, &tc.archiveFlags }) {
+        if (!readRef(*field)) {
+          return std::nullopt;
+        }
+      }
+
+      std::uint8_t hasBinary = 0;
+      std::uint8_t hasLibrary = 0;
+      std::uint8_t combinedTests = 0;
+      std::uint32_t unityGroupSize = 0;
+      if (!reader.readU8(hasBinary) || !reader.readU8(hasLibrary)
+          || !reader.readU8(combinedTests)
+          || !reader.readU32(unityGroupSize)) {
+        return std::nullopt;
+      }
+      snapshot.hasBinaryTarget = hasBinary != 0;
+      snapshot.hasLibraryTarget = hasLibrary != 0;
+      snapshot.combinedTests = combinedTests != 0;
+      snapshot.unityGroupSize = unityGroupSize;
+
+      std::uint32_t edgeCount = 0;
+      if (!reader.readU32(edgeCount)) {
+        return std::nullopt;
+      }
+      snapshot.edges.resize(edgeCount);
+      for (NinjaEdge& edge : snapshot.edges) {
+        if (!readRef(edge.rule) || !readRefs(edge.outputs)
+            || !readRefs(edge.implicitOutputs) || !readRefs(edge.inputs)
+            || !readRefs(edge.implicitInputs)
+            || !readRefs(edge.orderOnlyInputs)) {
+          return std::nullopt;
+        }
+        std::uint32_t bindingCount = 0;
+        if (!reader.readU32(bindingCount)) {
+          return std::nullopt;
+        }
+        edge.bindings.resize(bindingCount);
+        for (auto& [key, value] : edge.bindings) {
+          if (!readRef(key) || !readRef(value)) {
+            return std::nullopt;
+          }
+        }
+      }
+
+      if (!readRefs(snapshot.defaultTargets)
+          || !readRefs(snapshot.phonyTestTargets)) {
+        return std::nullopt;
+      }
+
+      std::uint32_t testCount = 0;
+      if (!reader.readU32(testCount)) {
+        return std::nullopt;
+      }
+      snapshot.testTargets.resize(testCount);
+      for (PlanSnapshot::TestTarget& target : snapshot.testTargets) {
+        if (!readRef(target.ninjaTarget) || !readRef(target.sourcePath)
+            || !reader.readU8(target.kind)) {
+          return std::nullopt;
+        }
+      }
+      return snapshot;
+    }();
+  }
+
+  ::munmap(mapped, size);
+  return result;
+}
+
+void PlanCache::save(const fs::path& outBasePath,
+                     const PlanSnapshot& snapshot) {
+  Writer writer;
+
+  const NinjaToolchain& tc = snapshot.toolchain;
+  for (const std::string* field :
+       { &tc.cxx, &tc.cxxWrapper, &tc.cxxFlags, &tc.defines, &tc.includes,
+         &tc.ldFlags, &tc.libs, &tc.archiver, &tc.archiveFlags }) {
+    writer.putRef(*field);
+  }
+
+  writer.putU8(snapshot.hasBinaryTarget ? 1 : 0);
+  writer.putU8(snapshot.hasLibraryTarget ? 1 : 0);
+  writer.putU8(snapshot.combinedTests ? 1 : 0);
+  writer.putU32(static_cast<std::uint32_t>(snapshot.unityGroupSize));
+
+  writer.putU32(static_cast<std::uint32_t>(snapshot.edges.size()));
+  for (const NinjaEdge& edge : snapshot.edges) {
+    writer.putRef(edge.rule);
+    writer.putRefs(edge.outputs);
+    writer.putRefs(edge.implicitOutputs);
+    writer.putRefs(edge.inputs);
+    writer.putRefs(edge.implicitInputs);
+    writer.putRefs(edge.orderOnlyInputs);
+    writer.putU32(static_cast<std::uint32_t>(edge.bindings.size()));
+    for (const auto& [key, value] : edge.bindings) {
+      writer.putRef(key);
+      writer.putRef(value);
+    }
+  }
+
+  writer.putRefs(snapshot.defaultTargets);
+  writer.putRefs(snapshot.phonyTestTargets);
+
+  writer.putU32(static_cast<std::uint32_t>(snapshot.testTargets.size()));
+  for (const PlanSnapshot::TestTarget& target : snapshot.testTargets) {
+    writer.putRef(target.ninjaTarget);
+    writer.putRef(target.sourcePath);
+    writer.putU8(target.kind);
+  }
+
+  std::ostringstream out;
+  writer.writeTo(out);
+  writeFileAtomic(outBasePath / FILE_NAME, out.str());
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <rs/tests.hpp>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static void testRoundTrip() {
+  const fs::path dir = fs::temp_directory_path() / "cabin-plan-cache-test";
+  fs::create_directories(dir);
+
+  PlanSnapshot snapshot;
+  snapshot.toolchain.cxx = "clang++";
+  snapshot.toolchain.cxxFlags = "-O2";
+  snapshot.hasBinaryTarget = true;
+  snapshot.unityGroupSize = 8;
+  NinjaEdge edge;
+  edge.outputs = { "main.o" };
+  edge.rule = "cxx_compile";
+  edge.inputs = { "../../src/main.cc" };
+  edge.bindings.emplace_back("out_dir", ".");
+  snapshot.edges.push_back(std::move(edge));
+  snapshot.defaultTargets = { "test-pkg" };
+  snapshot.testTargets.push_back(
+      PlanSnapshot::TestTarget{ "unit/foo", "src/foo.cc", 0 });
+
+  PlanCache::save(dir, snapshot);
+  const auto loaded = PlanCache::load(dir);
+  rs::assertTrue(loaded.has_value());
+  rs::assertEq(loaded->toolchain.cxx, "clang++");
+  rs::assertEq(loaded->toolchain.cxxFlags, "-O2");
+  rs::assertTrue(loaded->hasBinaryTarget);
+  rs::assertEq(loaded->unityGroupSize, static_cast<std::size_t>(8));
+  rs::assertEq(loaded->edges.size(), static_cast<std::size_t>(1));
+  rs::assertEq(loaded->edges.front().rule, "cxx_compile");
+  rs::assertEq(loaded->edges.front().bindings.front().second, ".");
+  rs::assertEq(loaded->defaultTargets.front(), "test-pkg");
+  rs::assertEq(loaded->testTargets.front().ninjaTarget, "unit/foo");
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+static void testRejectsCorruptFile() {
+  const fs::path dir = fs::temp_directory_path() / "cabin-plan-cache-corrupt";
+  fs::create_directories(dir);
+  std::ofstream(dir / PlanCache::FILE_NAME) << "not a plan";
+
+  rs::assertFalse(PlanCache::load(dir).has_value());
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+int main() {
+  testRoundTrip();
+  testRejectsCorruptFile();
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "Builder/RemoteCache.hpp"
+
+#include "HttpClient.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <curl/curl.h>
+#include <fstream>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <tbb/concurrent_queue.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+namespace {
+
+struct UploadJob {
+  std::string url;
+  fs::path src;
+  bool stop = false; // uploader-shutdown sentinel
+};
+
+// Set once the uploader joins during static destruction; late enqueues
+// are dropped rather than pushed to a dead queue.
+std::atomic<bool> uploaderStopped{ false };
+
+std::size_t discardResponse(const void* /*contents*/, const std::size_t size,
+                            const std::size_t nmemb, void* /*userdata*/) {
+  return size * nmemb;
+}
+
+// One background thread drains the queue over its own curl easy handle —
+// never the shared HttpClient multi handle, which the main thread may be
+// using concurrently — so uploads overlap with compilation and never
+// block an edge.  The destructor pushes the stop sentinel behind all
+// pending jobs, so every queued upload is attempted before process exit.
+class Uploader {
+public:
+  static Uploader& instance() {
+    static Uploader uploader;
+    return uploader;
+  }
+
+  void push(UploadJob job) { queue.push(std::move(job)); }
+
+  ~Uploader() {
+    queue.push(UploadJob{ .stop = true });
+    thread.join();
+    uploaderStopped.store(true, std::memory_order_release);
+    curl_global_cleanup();
+  }
+
+  Uploader(const Uploader&) = delete;
+  Uploader& operator=(const Uploader&) = delete;
+  Uploader(Uploader&&) = delete;
+  Uploader& operator=(Uploader&&) = delete;
+
+private:
+  Uploader() {
+    // Refcounted; paired with the cleanup in the destructor.  Done on the
+    // constructing thread because curl_global_init is not thread-safe.
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    thread = std::thread([this]() { run(); });
+  }
+
+  void run() {
+    CURL* easy = curl_easy_init();
+    curl_slist* headers =
+        curl_slist_append(nullptr, "Content-Type: application/octet-stream");
+    for (;;) {
+      UploadJob job;
+      queue.pop(job); // blocks until a job arrives
+      if (job.stop) {
+        break;
+      }
+      if (easy == nullptr) {
+        continue;
+      }
+
+      std::ifstream ifs(job.src, std::ios::binary);
+      if (!ifs) {
+        spdlog::debug("remote cache: cannot read {}", job.src.string());
+        continue;
+      }
+      const std::string body(std::istreambuf_iterator<char>(ifs),
+                             std::istreambuf_iterator<char>());
+
+      // The handle is reused across jobs so the connection stays open.
+      curl_easy_setopt(easy, CURLOPT_URL, job.url.c_str());
+      curl_easy_setopt(easy, CURLOPT_POST, 1L);
+      curl_easy_setopt(easy, CURLOPT_POSTFIELDS, body.c_str());
+      curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(body.size()));
+      curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+      curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+      curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discardResponse);
+      if (const CURLcode code = curl_easy_perform(easy); code != CURLE_OK) {
+        spdlog::debug("remote cache: upload of {} failed: {}", job.url,
+                      curl_easy_strerror(code));
+      }
+    }
+    if (headers != nullptr) {
+      curl_slist_free_all(headers);
+    }
+    if (easy != nullptr) {
+      curl_easy_cleanup(easy);
+    }
+  }
+
+  tbb::concurrent_bounded_queue<UploadJob> queue;
+  std::thread thread;
+};
+
+std::string objectUrl(const std::string& baseUrl, const std::string& key) {
+  if (!baseUrl.empty() && baseUrl.back() == '/') {
+    return baseUrl + key;
+  }
+  return baseUrl + '/' + key;
+}
+
+} // namespace
+
+RemoteCache& RemoteCache::instance() noexcept {
+  static RemoteCache cache;
+  return cache;
+}
+
+void RemoteCache::configure(std::string baseUrl, const bool upload) noexcept {
+  baseUrl_ = std::move(baseUrl);
+  upload_ = upload;
+}
+
+bool RemoteCache::enabled() const noexcept { return !baseUrl_.empty(); }
+
+void RemoteCache::prefetch(const std::span<const std::string> keys,
+                           const ObjectCache& localCache) const noexcept {
+  if (!enabled() || keys.empty()) {
+    return;
+  }
+  try {
+    std::vector<HttpRequest> requests;
+    requests.reserve(keys.size());
+    for (const std::string& key : keys) {
+      requests.push_back(HttpRequest{ .url = objectUrl(baseUrl_, key),
+                                      .allowFailure = true });
+    }
+
+    auto responses = HttpClient::instance().performAll(requests);
+    if (responses.is_err()) {
+      spdlog::debug("remote cache: prefetch failed: {}",
+                    responses.unwrap_err()->what());
+      return;
+    }
+
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      const std::string& body = responses.unwrap()[i];
+      if (body.empty()) {
+        continue;
+      }
+      localCache.storeBuffer(keys[i], body);
+      ++hits;
+    }
+    spdlog::debug("remote cache: {}/{} objects downloaded", hits,
+                  keys.size());
+  } catch (...) {
+    // Best-effort: a failed prefetch just means local compiles.
+  }
+}
+
+void RemoteCache::enqueueUpload(std::string key, fs::path src) noexcept {
+  if (!enabled() || !upload_
+      || uploaderStopped.load(std::memory_order_acquire)) {
+    return;
+  }
+  try {
+    Uploader::instance().push(UploadJob{ .url = objectUrl(baseUrl_, key),
+                                         .src = std::move(src) });
+  } catch (...) {
+    // Losing an opportunistic upload is fine.
+  }
+}
+
+} // namespace cabin
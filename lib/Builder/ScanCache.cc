@@ -0,0 +1,259 @@
+#include "Builder/ScanCache.hpp"
+
+#include "CacheFile.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+// 64-bit FNV-1a.  We only need a fast, stable fingerprint to detect change,
+// not a cryptographic hash.
+static constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static constexpr std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static std::uint64_t fnv1a(const std::string_view data,
+                           std::uint64_t state = FNV_OFFSET_BASIS) noexcept {
+  for (const char c : data) {
+    state ^= static_cast<unsigned char>(c);
+    state *= FNV_PRIME;
+  }
+  return state;
+}
+
+std::string digestString(const std::string_view data) noexcept {
+  return fmt::format("{:016x}", fnv1a(data));
+}
+
+std::string digestFile(const fs::path& path) {
+  // The shared mapping means a file digested here and scanned elsewhere
+  // in the same run is read from disk once.
+  const std::shared_ptr<const MappedFile> mapped =
+      MappedFileCache::instance().get(path);
+  if (!mapped) {
+    return "";
+  }
+  return digestString(mapped->view());
+}
+
+void ScanCache::load(const fs::path& outBasePath) {
+  const fs::path cachePath = outBasePath / FILE_NAME;
+  std::ifstream ifs(cachePath);
+  if (!ifs) {
+    return;
+  }
+
+  nlohmann::json json;
+  try {
+    json = nlohmann::json::parse(ifs);
+  } catch (const nlohmann::json::parse_error& e) {
+    spdlog::debug("discarding corrupt scan cache {}: {}", cachePath.string(),
+                  e.what());
+    return;
+  }
+  if (!json.is_object() || !json.contains("entries")) {
+    return;
+  }
+
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  entries.clear();
+  for (const auto& [source, value] : json["entries"].items()) {
+    if (!value.is_object()) {
+      continue;
+    }
+    ScanEntry entry;
+    entry.contentDigest = value.value("content", "");
+    entry.flagsDigest = value.value("flags", "");
+    entry.depsDigest = value.value("deps_digest", "");
+    entry.objTarget = value.value("obj", "");
+    for (const auto& dep : value.value("deps", nlohmann::json::array())) {
+      if (dep.is_string()) {
+        entry.dependencies.insert(dep.get<std::string>());
+      }
+    }
+    entries.emplace(source, std::move(entry));
+  }
+  testVerdicts.clear();
+  if (json.contains("test_verdicts")) {
+    for (const auto& [source, value] : json["test_verdicts"].items()) {
+      if (!value.is_object()) {
+        continue;
+      }
+      TestVerdict verdict;
+      verdict.contentDigest = value.value("content", "");
+      verdict.flagsDigest = value.value("flags", "");
+      verdict.verdict = value.value("verdict", false);
+      testVerdicts.emplace(source, std::move(verdict));
+    }
+  }
+  spdlog::debug("loaded {} scan cache entries from {}", entries.size(),
+                cachePath.string());
+}
+
+void ScanCache::save(const fs::path& outBasePath) const {
+  nlohmann::json jsonEntries = nlohmann::json::object();
+  {
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    for (const auto& [source, entry] : entries) {
+      std::vector<std::string> deps(entry.dependencies.begin(),
+                                    entry.dependencies.end());
+      std::ranges::sort(deps);
+      jsonEntries[source] = {
+        { "content", entry.contentDigest },
+        { "flags", entry.flagsDigest },
+        { "deps_digest", entry.depsDigest },
+        { "obj", entry.objTarget },
+        { "deps", deps },
+      };
+    }
+  }
+
+  nlohmann::json jsonVerdicts = nlohmann::json::object();
+  {
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    for (const auto& [source, verdict] : testVerdicts) {
+      jsonVerdicts[source] = {
+        { "content", verdict.contentDigest },
+        { "flags", verdict.flagsDigest },
+        { "verdict", verdict.verdict },
+      };
+    }
+  }
+
+  nlohmann::json json;
+  json["version"] = 1;
+  json["entries"] = std::move(jsonEntries);
+  json["test_verdicts"] = std::move(jsonVerdicts);
+
+  writeFileAtomic(outBasePath / FILE_NAME, json.dump() + '\n');
+}
+
+std::optional<ScanEntry> ScanCache::lookup(const std::string& sourceFile,
+                                           const std::string& contentDigest,
+                                           const std::string& flagsDigest) {
+  ScanEntry entry;
+  {
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    const auto it = entries.find(sourceFile);
+    if (it == entries.end()) {
+      return std::nullopt;
+    }
+    entry = it->second;
+  }
+
+  if (entry.contentDigest != contentDigest
+      || entry.flagsDigest != flagsDigest) {
+    return std::nullopt;
+  }
+  // A header edit can change the dependency closure itself, so the entry is
+  // only trusted while every recorded dependency is byte-identical.
+  if (entry.depsDigest != depsDigest(entry.dependencies)) {
+    return std::nullopt;
+  }
+  return entry;
+}
+
+void ScanCache::insert(const std::string& sourceFile, ScanEntry entry) {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  entries[sourceFile] = std::move(entry);
+}
+
+std::optional<bool>
+ScanCache::lookupTestVerdict(const std::string& sourceFile,
+                             const std::string& contentDigest,
+                             const std::string& flagsDigest) const {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  const auto it = testVerdicts.find(sourceFile);
+  if (it == testVerdicts.end() || it->second.contentDigest != contentDigest
+      || it->second.flagsDigest != flagsDigest) {
+    return std::nullopt;
+  }
+  return it->second.verdict;
+}
+
+void ScanCache::insertTestVerdict(const std::string& sourceFile,
+                                  const std::string& contentDigest,
+                                  const std::string& flagsDigest,
+                                  const bool verdict) {
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  testVerdicts[sourceFile] =
+      TestVerdict{ contentDigest, flagsDigest, verdict };
+}
+
+std::string ScanCache::fileDigest(const fs::path& path) {
+  const std::string key = path.generic_string();
+  {
+    const tbb::spin_mutex::scoped_lock lock(digestMtx);
+    const auto it = digestMemo.find(key);
+    if (it != digestMemo.end()) {
+      return it->second;
+    }
+  }
+
+  std::string digest = digestFile(path);
+  const tbb::spin_mutex::scoped_lock lock(digestMtx);
+  return digestMemo.emplace(key, std::move(digest)).first->second;
+}
+
+std::string
+ScanCache::depsDigest(const std::unordered_set<std::string>& dependencies) {
+  std::vector<std::string> deps(dependencies.begin(), dependencies.end());
+  std::ranges::sort(deps);
+
+  std::uint64_t state = FNV_OFFSET_BASIS;
+  for (const std::string& dep : deps) {
+    state = fnv1a(dep, state);
+    state = fnv1a(fileDigest(dep), state);
+  }
+  return fmt::format("{:016x}", state);
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <rs/tests.hpp>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static void testDigestString() {
+  rs::assertEq(digestString("").size(), static_cast<std::size_t>(16));
+  rs::assertEq(digestString("abc"), digestString("abc"));
+  rs::assertTrue(digestString("abc") != digestString("abd"));
+
+  rs::pass();
+}
+
+static void testLookupRejectsStaleDigests() {
+  ScanCache cache;
+
+  ScanEntry entry;
+  entry.contentDigest = "c";
+  entry.flagsDigest = "f";
+  entry.depsDigest = cache.depsDigest({});
+  entry.objTarget = "foo.o";
+  cache.insert("foo.cc", entry);
+
+  rs::assertTrue(cache.lookup("foo.cc", "c", "f").has_value());
+  rs::assertFalse(cache.lookup("foo.cc", "changed", "f").has_value());
+  rs::assertFalse(cache.lookup("foo.cc", "c", "changed").has_value());
+  rs::assertFalse(cache.lookup("bar.cc", "c", "f").has_value());
+
+  rs::pass();
+}
+
+int main() {
+  testDigestString();
+  testLookupRejectsStaleDigests();
+}
+
+#endif
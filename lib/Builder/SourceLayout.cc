@@ -0,0 +1,125 @@
+#include "Builder/SourceLayout.hpp"
+
+#include "Parallelism.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <vector>
+
+namespace cabin {
+
+std::vector<fs::path> walkDirParallel(const fs::path& dir,
+                                      const WalkOptions& options) {
+  const auto enterDir = [&](const fs::path& path) {
+    return !options.enterDir || options.enterDir(path);
+  };
+  const auto includeEntry = [&](const fs::directory_entry& entry) {
+    return !options.includeEntry || options.includeEntry(entry);
+  };
+
+  // Split the top level sequentially; each subdirectory becomes one walk
+  // task below.
+  std::vector<fs::path> results;
+  std::vector<fs::path> subdirs;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    if (entry.is_directory()) {
+      if (enterDir(entry.path())) {
+        if (includeEntry(entry)) {
+          results.push_back(entry.path());
+        }
+        subdirs.push_back(entry.path());
+      }
+      continue;
+    }
+    if (includeEntry(entry)) {
+      results.push_back(entry.path());
+    }
+  }
+
+  const auto walkSubdir = [&](const fs::path& subdir, auto&& sink) {
+    for (auto entry = fs::recursive_directory_iterator(subdir);
+         entry != fs::recursive_directory_iterator(); ++entry) {
+      if (entry->is_directory() && !enterDir(entry->path())) {
+        entry.disable_recursion_pending();
+        continue;
+      }
+      if (includeEntry(*entry)) {
+        sink(entry->path());
+      }
+    }
+  };
+
+  if (isParallel() && subdirs.size() > 1) {
+    tbb::concurrent_vector<fs::path> found;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, subdirs.size()),
+                      [&](const tbb::blocked_range<std::size_t>& rng) {
+                        for (std::size_t i = rng.begin(); i != rng.end(); ++i) {
+                          walkSubdir(subdirs[i], [&found](const fs::path& p) {
+                            found.push_back(p);
+                          });
+                        }
+                      });
+    results.insert(results.end(), found.begin(), found.end());
+  } else {
+    for (const fs::path& subdir : subdirs) {
+      walkSubdir(subdir,
+                 [&results](const fs::path& p) { results.push_back(p); });
+    }
+  }
+
+  std::ranges::sort(results);
+  return results;
+}
+
+static std::string canonicalOrGeneric(const fs::path& path) {
+  std::error_code ec;
+  const fs::path canonical = fs::weakly_canonical(path, ec);
+  if (ec) {
+    return path.lexically_normal().generic_string();
+  }
+  return canonical.generic_string();
+}
+
+SourceClassifier::SourceClassifier(const fs::path& projectRoot) {
+  const auto rootOrEmpty = [&](const char* name) {
+    const fs::path root = projectRoot / name;
+    std::error_code ec;
+    if (!fs::exists(root, ec) || ec) {
+      return std::string();
+    }
+    return canonicalOrGeneric(root);
+  };
+  srcRoot_ = rootOrEmpty("src");
+  libRoot_ = rootOrEmpty("lib");
+}
+
+SourceClassifier::Classification
+SourceClassifier::classify(const fs::path& source) const {
+  const std::string canonicalSource = canonicalOrGeneric(source);
+
+  const auto under = [&](const std::string& root) -> std::string_view {
+    if (root.empty() || canonicalSource.size() <= root.size()
+        || !canonicalSource.starts_with(root)
+        || canonicalSource[root.size()] != '/') {
+      return {};
+    }
+    return std::string_view(canonicalSource).substr(root.size() + 1);
+  };
+
+  if (const std::string_view rel = under(srcRoot_); !rel.empty()) {
+    return Classification{ .root = Root::Src, .relPath = fs::path(rel) };
+  }
+  if (const std::string_view rel = under(libRoot_); !rel.empty()) {
+    return Classification{ .root = Root::Lib, .relPath = fs::path(rel) };
+  }
+  return Classification{};
+}
+
+} // namespace cabin
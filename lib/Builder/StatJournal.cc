@@ -0,0 +1,133 @@
+#include "Builder/StatJournal.hpp"
+
+#include "CacheFile.hpp"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <system_error>
+#include <utility>
+
+namespace cabin {
+
+static std::int64_t mtimeOf(const fs::path& path) {
+  std::error_code ec;
+  const fs::file_time_type time = fs::last_write_time(path, ec);
+  if (ec) {
+    return -1;
+  }
+  return time.time_since_epoch().count();
+}
+
+StatJournal StatJournal::record(const std::span<const fs::path> watchedPaths) {
+  StatJournal journal;
+
+  const auto recordOne = [&journal](const fs::path& path) {
+    Entry entry;
+    std::error_code ec;
+    const fs::file_status status = fs::status(path, ec);
+    if (!ec && fs::exists(status)) {
+      entry.mtime = mtimeOf(path);
+      entry.isDir = fs::is_directory(status);
+      if (!entry.isDir) {
+        entry.size = fs::file_size(path, ec);
+      }
+    }
+    journal.entries.emplace(path.generic_string(), entry);
+  };
+
+  for (const fs::path& watched : watchedPaths) {
+    recordOne(watched);
+    std::error_code ec;
+    if (!fs::is_directory(watched, ec)) {
+      continue;
+    }
+    for (const auto& dirEntry : fs::recursive_directory_iterator(watched)) {
+      recordOne(dirEntry.path());
+    }
+  }
+  return journal;
+}
+
+std::optional<StatJournal> StatJournal::load(const fs::path& outBasePath) {
+  std::ifstream ifs(outBasePath / FILE_NAME);
+  if (!ifs) {
+    return std::nullopt;
+  }
+
+  nlohmann::json json;
+  try {
+    json = nlohmann::json::parse(ifs);
+  } catch (const nlohmann::json::parse_error& e) {
+    spdlog::debug("discarding corrupt stat journal: {}", e.what());
+    return std::nullopt;
+  }
+  if (!json.is_object() || !json.contains("entries")) {
+    return std::nullopt;
+  }
+
+  StatJournal journal;
+  for (const auto& [path, value] : json["entries"].items()) {
+    if (!value.is_object()) {
+      continue;
+    }
+    Entry entry;
+    entry.mtime = value.value("mtime", static_cast<std::int64_t>(-1));
+    entry.size = value.value("size", static_cast<std::uint64_t>(0));
+    entry.isDir = value.value("dir", false);
+    journal.entries.emplace(path, entry);
+  }
+  return journal;
+}
+
+void StatJournal::save(const fs::path& outBasePath) const {
+  nlohmann::json jsonEntries = nlohmann::json::object();
+  for (const auto& [path, entry] : entries) {
+    jsonEntries[path] = {
+      { "mtime", entry.mtime },
+      { "size", entry.size },
+      { "dir", entry.isDir },
+    };
+  }
+
+  nlohmann::json json;
+  json["version"] = 1;
+  json["entries"] = std::move(jsonEntries);
+
+  writeFileAtomic(outBasePath / FILE_NAME, json.dump() + '\n');
+}
+
+bool StatJournal::matchesCurrentTree() const {
+  for (const auto& [path, entry] : entries) {
+    std::error_code ec;
+    const fs::file_status status = fs::status(path, ec);
+    const bool exists = !ec && fs::exists(status);
+
+    if (entry.mtime == -1) {
+      if (exists) {
+        spdlog::trace("stat journal: {} appeared", path);
+        return false;
+      }
+      continue;
+    }
+    if (!exists) {
+      spdlog::trace("stat journal: {} disappeared", path);
+      return false;
+    }
+    if (fs::is_directory(status) != entry.isDir) {
+      return false;
+    }
+    if (mtimeOf(path) != entry.mtime) {
+      spdlog::trace("stat journal: {} mtime changed", path);
+      return false;
+    }
+    // A directory's mtime is unchanged, so its entry list is unchanged; its
+    // contents are each journaled and checked on their own.
+    if (!entry.isDir && fs::file_size(path, ec) != entry.size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace cabin
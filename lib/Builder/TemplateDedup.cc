@@ -0,0 +1,167 @@
+#include "Builder/TemplateDedup.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace cabin {
+
+// Registry entries must round-trip through `extern template class N;`.
+// Function instantiations would need a full signature and lambda or
+// anonymous-namespace types cannot be named at all, so only plain
+// class template-ids qualify.
+static bool isDeclarable(const std::string_view name) {
+  return !name.empty() && name.find('<') != std::string_view::npos
+         && name.back() == '>' && name.find('(') == std::string_view::npos
+         && name.find('{') == std::string_view::npos;
+}
+
+std::optional<std::vector<std::string>>
+TemplateDedup::loadRegistry(const fs::path& outBasePath) {
+  const fs::path path = outBasePath / REGISTRY_FILE;
+  if (!fs::exists(path)) {
+    return std::nullopt;
+  }
+  try {
+    std::ifstream ifs(path);
+    const nlohmann::json registry = nlohmann::json::parse(ifs);
+    if (!registry.is_object() || registry.value("version", 0) != 1) {
+      return std::nullopt;
+    }
+    return registry.at("names").get<std::vector<std::string>>();
+  } catch (const std::exception& e) {
+    spdlog::debug("discarding template-dedup registry: {}", e.what());
+    return std::nullopt;
+  }
+}
+
+std::size_t TemplateDedup::harvestTimeTraces(const fs::path& outBasePath) {
+  struct Stats {
+    std::uint64_t totalUs = 0;
+    std::unordered_set<std::string> files;
+  };
+  std::unordered_map<std::string, Stats> instantiations;
+
+  // Clang writes each TU's trace next to its object, as `<obj>.json`
+  // with the `.o` extension replaced.  Other JSON files under the out
+  // dir (caches, compile_commands) lack `traceEvents` and are skipped.
+  for (const auto& entry :
+       fs::recursive_directory_iterator(outBasePath)) {
+    if (!entry.is_regular_file() || entry.path().extension() != ".json") {
+      continue;
+    }
+    nlohmann::json trace;
+    try {
+      std::ifstream ifs(entry.path());
+      trace = nlohmann::json::parse(ifs);
+    } catch (const std::exception&) {
+      continue;
+    }
+    if (!trace.is_object() || !trace.contains("traceEvents")) {
+      continue;
+    }
+    const std::string file = entry.path().generic_string();
+    for (const auto& event : trace["traceEvents"]) {
+      if (event.value("name", "") != "InstantiateClass"
+          || !event.contains("args")) {
+        continue;
+      }
+      const std::string detail = event["args"].value("detail", "");
+      if (!isDeclarable(detail)) {
+        continue;
+      }
+      Stats& stats = instantiations[detail];
+      stats.totalUs += event.value("dur", std::uint64_t{ 0 });
+      stats.files.insert(file);
+    }
+  }
+
+  // Only instantiations compiled into at least two TUs pay for a shared
+  // definition; rank those by total time and keep the heaviest few so
+  // the generated TU stays cheap to compile itself.
+  static constexpr std::size_t maxEntries = 32;
+  std::vector<std::pair<std::string, std::uint64_t>> ranked;
+  for (auto& [name, stats] : instantiations) {
+    if (stats.files.size() >= 2) {
+      ranked.emplace_back(name, stats.totalUs);
+    }
+  }
+  std::ranges::sort(ranked, [](const auto& lhs, const auto& rhs) {
+    return lhs.second != rhs.second ? lhs.second > rhs.second
+                                    : lhs.first < rhs.first;
+  });
+  if (ranked.size() > maxEntries) {
+    ranked.resize(maxEntries);
+  }
+
+  std::vector<std::string> names;
+  names.reserve(ranked.size());
+  for (auto& [name, totalUs] : ranked) {
+    names.push_back(std::move(name));
+  }
+
+  nlohmann::json registry;
+  registry["version"] = 1;
+  registry["names"] = names;
+  std::ofstream ofs(outBasePath / REGISTRY_FILE);
+  ofs << registry.dump();
+  return names.size();
+}
+
+static void writeIfChanged(const fs::path& path, const std::string& contents) {
+  std::string existing;
+  {
+    std::ifstream ifs(path);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    existing = oss.str();
+  }
+  if (existing != contents) {
+    std::ofstream ofs(path);
+    ofs << contents;
+  }
+}
+
+void TemplateDedup::writeGeneratedFiles(
+    const fs::path& outBasePath, const std::span<const std::string> names,
+    const std::span<const std::string> preamble) {
+  // The shared TU defines CABIN_DEDUP_DEFINE before including the
+  // header, turning every declaration into the one definition; all
+  // other TUs see the header through a forced include and get the
+  // `extern template` form that suppresses their own instantiation.
+  std::string header = "// Generated by Cabin\n#pragma once\n";
+  for (const std::string& include : preamble) {
+    if (include.starts_with('<') || include.starts_with('"')) {
+      header += fmt::format("#include {}\n", include);
+    } else {
+      header += fmt::format("#include <{}>\n", include);
+    }
+  }
+  header += "#if defined(CABIN_DEDUP_DEFINE)\n"
+            "#define CABIN_DEDUP_TEMPLATE template class\n"
+            "#else\n"
+            "#define CABIN_DEDUP_TEMPLATE extern template class\n"
+            "#endif\n";
+  for (const std::string& name : names) {
+    header += fmt::format("CABIN_DEDUP_TEMPLATE {};\n", name);
+  }
+  header += "#undef CABIN_DEDUP_TEMPLATE\n";
+  writeIfChanged(outBasePath / HEADER_FILE, header);
+
+  writeIfChanged(outBasePath / SOURCE_FILE,
+                 fmt::format("// Generated by Cabin\n"
+                             "#define CABIN_DEDUP_DEFINE 1\n"
+                             "#include \"{}\"\n",
+                             HEADER_FILE));
+}
+
+} // namespace cabin
@@ -0,0 +1,120 @@
+#include "Builder/TimeTraceReport.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+namespace {
+
+struct Aggregate {
+  std::uint64_t totalUs = 0;
+  std::uint64_t count = 0;
+};
+
+} // namespace
+
+static void printTopTable(const std::string_view heading,
+                          std::unordered_map<std::string, Aggregate>& rows) {
+  static constexpr std::size_t maxRows = 15;
+  std::vector<std::pair<std::string, Aggregate>> ranked(
+      std::move_iterator(rows.begin()), std::move_iterator(rows.end()));
+  std::ranges::sort(ranked, [](const auto& lhs, const auto& rhs) {
+    return lhs.second.totalUs != rhs.second.totalUs
+               ? lhs.second.totalUs > rhs.second.totalUs
+               : lhs.first < rhs.first;
+  });
+  if (ranked.size() > maxRows) {
+    ranked.resize(maxRows);
+  }
+
+  fmt::print("\n{}\n", heading);
+  fmt::print("{:>10}  {:>6}  {}\n", "total", "count", "name");
+  for (const auto& [name, agg] : ranked) {
+    fmt::print("{:>8.1f}ms  {:>6}  {}\n",
+               static_cast<double>(agg.totalUs) / 1000.0, agg.count, name);
+  }
+}
+
+std::size_t writeTimeTraceReport(const fs::path& outBasePath) {
+  // Cumulative parse time per header ("Source" events; nested includes
+  // are counted under every includer, which is exactly the "how much
+  // does this header cost wherever it appears" question).
+  std::unordered_map<std::string, Aggregate> headers;
+  std::unordered_map<std::string, Aggregate> instantiations;
+  nlohmann::json combinedEvents = nlohmann::json::array();
+
+  std::size_t numTraces = 0;
+  for (const auto& entry : fs::recursive_directory_iterator(outBasePath)) {
+    if (!entry.is_regular_file() || entry.path().extension() != ".json") {
+      continue;
+    }
+    nlohmann::json trace;
+    try {
+      std::ifstream ifs(entry.path());
+      trace = nlohmann::json::parse(ifs);
+    } catch (const std::exception&) {
+      continue;
+    }
+    if (!trace.is_object() || !trace.contains("traceEvents")) {
+      continue;
+    }
+    ++numTraces;
+
+    const std::string traceName =
+        fs::relative(entry.path(), outBasePath).generic_string();
+    for (auto& event : trace["traceEvents"]) {
+      const std::string name = event.value("name", "");
+      const std::uint64_t dur = event.value("dur", std::uint64_t{ 0 });
+      if (event.contains("args")) {
+        const std::string detail = event["args"].value("detail", "");
+        if (!detail.empty()) {
+          if (name == "Source") {
+            Aggregate& agg = headers[detail];
+            agg.totalUs += dur;
+            ++agg.count;
+          } else if (name == "InstantiateClass"
+                     || name == "InstantiateFunction") {
+            Aggregate& agg = instantiations[detail];
+            agg.totalUs += dur;
+            ++agg.count;
+          }
+        }
+      }
+      // One process lane per TU keeps the merged trace readable.
+      event["pid"] = numTraces;
+      combinedEvents.push_back(std::move(event));
+    }
+    combinedEvents.push_back({ { "name", "process_name" },
+                               { "ph", "M" },
+                               { "pid", numTraces },
+                               { "args", { { "name", traceName } } } });
+  }
+
+  if (numTraces == 0) {
+    return 0;
+  }
+
+  printTopTable("Top headers by cumulative parse time:", headers);
+  printTopTable("Top template instantiations:", instantiations);
+
+  nlohmann::json combined;
+  combined["traceEvents"] = std::move(combinedEvents);
+  std::ofstream ofs(outBasePath / "time-trace.json");
+  ofs << combined.dump();
+  return numTraces;
+}
+
+} // namespace cabin
@@ -0,0 +1,158 @@
+#include "Builder/Timings.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+Timings& Timings::instance() noexcept {
+  static Timings timings;
+  return timings;
+}
+
+void Timings::record(std::string category, std::string name,
+                     const Clock::time_point start,
+                     const Clock::time_point end) noexcept {
+  if (!enabled) {
+    return;
+  }
+  const auto toUs = [this](const Clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(tp - origin)
+        .count();
+  };
+  // Fold the opaque thread id into something small and stable enough for
+  // trace rows; collisions only merge rows, never lose events.
+  const std::size_t threadId =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) % 0xffffU;
+  events.push_back(Event{ .category = std::move(category),
+                          .name = std::move(name),
+                          .threadId = threadId,
+                          .startUs = toUs(start),
+                          .durationUs = toUs(end) - toUs(start) });
+}
+
+Timings::Span::Span(std::string category, std::string name) noexcept
+    : category(std::move(category)), name(std::move(name)),
+      active(Timings::instance().isEnabled()) {
+  if (active) {
+    start = Clock::now();
+  }
+}
+
+Timings::Span::~Span() {
+  if (active) {
+    Timings::instance().record(std::move(category), std::move(name), start,
+                               Clock::now());
+  }
+}
+
+// Escapes the characters JSON string literals cannot contain verbatim;
+// span names are file paths and rule names, so this covers everything we
+// ever emit.
+static std::string escapeJson(const std::string_view str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+static std::string escapeHtml(const std::string_view str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    switch (c) {
+    case '&':
+      escaped += "&amp;";
+      break;
+    case '<':
+      escaped += "&lt;";
+      break;
+    case '>':
+      escaped += "&gt;";
+      break;
+    default:
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+rs::Result<void> Timings::write(const fs::path& outDir) const noexcept {
+  if (!enabled || events.empty()) {
+    return rs::Ok();
+  }
+
+  std::vector<Event> sorted(events.begin(), events.end());
+  std::ranges::sort(sorted, [](const Event& lhs, const Event& rhs) {
+    return lhs.durationUs > rhs.durationUs;
+  });
+
+  try {
+    fs::create_directories(outDir);
+
+    // Chrome trace_event format: an array of complete ("ph": "X") events.
+    std::ofstream trace(outDir / "timings.json");
+    trace << "[\n";
+    bool first = true;
+    for (const Event& event : events) {
+      trace << fmt::format(
+          "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},"
+          "\"dur\":{},\"pid\":1,\"tid\":{}}}",
+          first ? "" : ",\n", escapeJson(event.name),
+          escapeJson(event.category), event.startUs, event.durationUs,
+          event.threadId);
+      first = false;
+    }
+    trace << "\n]\n";
+
+    std::int64_t totalUs = 0;
+    for (const Event& event : sorted) {
+      totalUs = std::max(totalUs, event.startUs + event.durationUs);
+    }
+
+    static constexpr std::size_t maxRows = 30;
+    std::ofstream html(outDir / "timings.html");
+    html << "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">"
+            "<title>cabin build timings</title>\n"
+            "<style>body{font-family:monospace}"
+            "table{border-collapse:collapse}"
+            "td,th{border:1px solid #ccc;padding:2px 8px;"
+            "text-align:left}</style></head><body>\n"
+            "<h1>cabin build timings</h1>\n";
+    html << fmt::format("<p>{} span(s), {:.2f}s wall time; full trace in "
+                        "<code>timings.json</code> (open in Perfetto or "
+                        "chrome://tracing).</p>\n",
+                        sorted.size(), static_cast<double>(totalUs) / 1e6);
+    html << "<table>\n<tr><th>duration</th><th>category</th>"
+            "<th>name</th></tr>\n";
+    for (std::size_t i = 0; i < std::min(sorted.size(), maxRows); ++i) {
+      const Event& event = sorted[i];
+      html << fmt::format("<tr><td>{:.3f}s</td><td>{}</td><td>{}</td></tr>\n",
+                          static_cast<double>(event.durationUs) / 1e6,
+                          escapeHtml(event.category), escapeHtml(event.name));
+    }
+    html << "</table>\n</body></html>\n";
+  } catch (const std::exception& e) {
+    rs_bail("failed to write timing reports: {}", e.what());
+  }
+  return rs::Ok();
+}
+
+} // namespace cabin
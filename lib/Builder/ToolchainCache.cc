@@ -0,0 +1,162 @@
+#include "Builder/ToolchainCache.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace cabin {
+
+static fs::path defaultCachePath() {
+  if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+      xdgCacheHome != nullptr && *xdgCacheHome != '\0') {
+    return fs::path(xdgCacheHome) / "cabin" / "toolchain.json";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && *home != '\0') {
+    return fs::path(home) / ".cache" / "cabin" / "toolchain.json";
+  }
+  return {};
+}
+
+// Resolves `tool` the way exec would: as-is when it contains a slash,
+// otherwise the first executable match on $PATH.
+static fs::path resolveTool(const std::string& tool) {
+  const auto isExecutable = [](const fs::path& path) {
+    std::error_code ec;
+    return fs::is_regular_file(path, ec) && ::access(path.c_str(), X_OK) == 0;
+  };
+
+  if (tool.find('/') != std::string::npos) {
+    return isExecutable(tool) ? fs::path(tool) : fs::path();
+  }
+
+  const char* pathEnv = std::getenv("PATH");
+  if (pathEnv == nullptr) {
+    return {};
+  }
+  const std::string_view path = pathEnv;
+  std::size_t begin = 0;
+  while (begin <= path.size()) {
+    std::size_t end = path.find(':', begin);
+    if (end == std::string_view::npos) {
+      end = path.size();
+    }
+    const std::string_view dir = path.substr(begin, end - begin);
+    const fs::path candidate =
+        fs::path(dir.empty() ? "." : std::string(dir)) / tool;
+    if (isExecutable(candidate)) {
+      return candidate;
+    }
+    begin = end + 1;
+  }
+  return {};
+}
+
+static std::string statKeyFor(const fs::path& bin) {
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(bin, ec);
+  if (ec) {
+    return {};
+  }
+  const auto mtime = fs::last_write_time(bin, ec);
+  if (ec) {
+    return {};
+  }
+  return fmt::format("{}:{}:{}", bin.generic_string(), size,
+                     mtime.time_since_epoch().count());
+}
+
+ToolchainCache& ToolchainCache::instance() noexcept {
+  static ToolchainCache cache;
+  return cache;
+}
+
+ToolchainCache::ToolchainCache() : path_(defaultCachePath()) {
+  if (path_.empty() || !fs::exists(path_)) {
+    return;
+  }
+
+  nlohmann::json json;
+  try {
+    std::ifstream ifs(path_);
+    json = nlohmann::json::parse(ifs);
+  } catch (const nlohmann::json::parse_error& e) {
+    spdlog::debug("discarding toolchain cache: {}", e.what());
+    return;
+  }
+  if (!json.is_object() || !json.contains("probes")) {
+    return;
+  }
+
+  for (const auto& [key, value] : json["probes"].items()) {
+    if (value.contains("stat") && value.contains("value")) {
+      entries_.emplace(key, Entry{ .stat = value["stat"],
+                                   .value = value["value"] });
+    }
+  }
+  spdlog::debug("loaded {} toolchain cache entries from {}", entries_.size(),
+                path_.string());
+}
+
+ToolchainCache::~ToolchainCache() {
+  if (!dirty_ || path_.empty()) {
+    return;
+  }
+
+  nlohmann::json probes = nlohmann::json::object();
+  for (const auto& [key, entry] : entries_) {
+    probes[key] = { { "stat", entry.stat }, { "value", entry.value } };
+  }
+  nlohmann::json json;
+  json["version"] = 1;
+  json["probes"] = std::move(probes);
+
+  std::error_code ec;
+  fs::create_directories(path_.parent_path(), ec);
+  std::ofstream ofs(path_, std::ios::trunc);
+  if (ofs.is_open()) {
+    ofs << json.dump();
+  }
+}
+
+std::optional<std::string>
+ToolchainCache::probe(const std::string& tool, const std::string& probeName,
+                      const std::function<std::optional<std::string>()>&
+                          compute) {
+  const fs::path bin = resolveTool(tool);
+  const std::string stat = bin.empty() ? std::string() : statKeyFor(bin);
+  if (stat.empty()) {
+    // Can't key the probe; fall through without caching.
+    return compute();
+  }
+
+  const std::string key = fmt::format("{}\x1f{}", tool, probeName);
+  {
+    const std::scoped_lock lock(mutex_);
+    if (const auto it = entries_.find(key);
+        it != entries_.end() && it->second.stat == stat) {
+      return it->second.value;
+    }
+  }
+
+  const std::optional<std::string> value = compute();
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+
+  const std::scoped_lock lock(mutex_);
+  entries_[key] = Entry{ .stat = stat, .value = value.value() };
+  dirty_ = true;
+  return value;
+}
+
+} // namespace cabin
@@ -0,0 +1,113 @@
+#include "CacheFile.hpp"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <ios>
+#include <string_view>
+#include <sys/file.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace cabin {
+
+FileLock::FileLock(const fs::path& path)
+    : fd_(::open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644)) { // NOLINT
+  if (fd_ >= 0) {
+    ::flock(fd_, LOCK_EX);
+  }
+}
+
+FileLock::~FileLock() {
+  if (fd_ >= 0) {
+    ::flock(fd_, LOCK_UN);
+    ::close(fd_);
+  }
+}
+
+bool writeFileAtomic(const fs::path& path,
+                     const std::string_view content) noexcept {
+  // The temp file lives next to the target so the rename cannot cross
+  // filesystems; the pid suffix keeps concurrent writers out of each
+  // other's staging file.
+  fs::path tmp = path;
+  tmp += fmt::format(".tmp.{}", ::getpid());
+  {
+    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+      return false;
+    }
+    ofs.write(content.data(),
+              static_cast<std::streamsize>(content.size()));
+    if (!ofs) {
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <cstddef>
+#  include <iterator>
+#  include <rs/tests.hpp>
+#  include <string>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static std::string slurp(const fs::path& path) {
+  std::ifstream ifs(path);
+  return { std::istreambuf_iterator<char>(ifs),
+           std::istreambuf_iterator<char>() };
+}
+
+static void testAtomicWriteReplacesWhole() {
+  const fs::path dir = fs::temp_directory_path() / "cabin-cache-file-test";
+  fs::create_directories(dir);
+  const fs::path target = dir / "cache.json";
+
+  rs::assertTrue(writeFileAtomic(target, "first epoch"));
+  rs::assertEq(slurp(target), "first epoch");
+  rs::assertTrue(writeFileAtomic(target, "second epoch"));
+  rs::assertEq(slurp(target), "second epoch");
+
+  // No staging file survives a successful publish.
+  std::size_t entries = 0;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    (void)entry;
+    ++entries;
+  }
+  rs::assertEq(entries, static_cast<std::size_t>(1));
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+static void testLockCreatesAndHolds() {
+  const fs::path dir = fs::temp_directory_path() / "cabin-cache-lock-test";
+  fs::create_directories(dir);
+
+  const FileLock lock(dir / "entry.lock");
+  rs::assertTrue(lock.held());
+  rs::assertTrue(fs::exists(dir / "entry.lock"));
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+int main() {
+  testAtomicWriteReplacesWhole();
+  testLockCreatesAndHolds();
+}
+
+#endif
@@ -1,22 +1,46 @@
 #include "Command.hpp"
 
+#include "Diag.hpp"
+#include "Profile.hpp"
+
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <fcntl.h>
 #include <fmt/format.h>
+#include <cstring>
+#include <poll.h>
 #include <rs/result.hpp>
+#include <spawn.h>
 #include <string>
-#include <sys/select.h>
+#include <string_view>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <utility>
 #include <vector>
 
+extern "C" char** environ; // NOLINT(readability-identifier-naming)
+
 namespace cabin {
 
-constexpr std::size_t BUFFER_SIZE = 128;
+// Pipes are drained in large chunks so preprocessor output measured in
+// hundreds of KB costs a handful of reads, not thousands.
+constexpr std::size_t BUFFER_SIZE = 64UL * 1024;
+
+// How much of a teed stream is retained for error context; everything is
+// still forwarded to the terminal as it arrives.
+constexpr std::size_t TEE_TAIL_BYTES = 64UL * 1024;
+
+// Tee shares all of Piped's pipe plumbing.
+static bool wantsPipe(const Command::IOConfig config) noexcept {
+  return config == Command::IOConfig::Piped
+         || config == Command::IOConfig::Tee;
+}
 
 bool ExitStatus::exitedNormally() const noexcept {
   return WIFEXITED(rawStatus);
@@ -71,102 +95,331 @@ rs::Result<ExitStatus> Child::wait() const noexcept {
   return rs::Ok(ExitStatus{ status });
 }
 
-rs::Result<CommandOutput> Child::waitWithOutput() const noexcept {
-  std::string stdOutOutput;
-  std::string stdErrOutput;
-
-  int maxfd = -1;
-  fd_set readfds;
-
-  // Determine the maximum file descriptor
-  maxfd = std::max(maxfd, stdOutFd);
-  maxfd = std::max(maxfd, stdErrFd);
-
-  bool stdOutEOF = (stdOutFd == -1);
-  bool stdErrEOF = (stdErrFd == -1);
-
-  while (!stdOutEOF || !stdErrEOF) {
-    FD_ZERO(&readfds);
-    if (!stdOutEOF) {
-      FD_SET(stdOutFd, &readfds);
+namespace {
+
+struct PipeState {
+  int fd = -1;
+  std::string* out = nullptr;
+  // Teed pipes forward every chunk here and keep only a bounded tail in
+  // `out`; -1 captures everything without forwarding.
+  int mirrorFd = -1;
+  // When the pipe reached EOF; approximates the owning child's exit time.
+  std::chrono::steady_clock::time_point closedAt;
+};
+
+} // namespace
+
+// Drains every pipe into its output string from one poll() loop, closing
+// each fd at EOF.  All fds are closed by the time this returns, even on
+// failure.
+static rs::Result<void> drainPipes(std::vector<PipeState>& pipes) noexcept {
+  const auto closeAll = [&pipes]() {
+    for (PipeState& pipe : pipes) {
+      if (pipe.fd != -1) {
+        close(pipe.fd);
+        pipe.fd = -1;
+      }
+    }
+  };
+
+  std::array<char, BUFFER_SIZE> buffer{};
+  std::vector<pollfd> pollFds;
+  std::vector<std::size_t> pollIdx; // pollFds[i] reads pipes[pollIdx[i]]
+  while (true) {
+    pollFds.clear();
+    pollIdx.clear();
+    for (std::size_t i = 0; i < pipes.size(); ++i) {
+      if (pipes[i].fd != -1) {
+        pollFds.push_back(
+            { .fd = pipes[i].fd, .events = POLLIN, .revents = 0 });
+        pollIdx.push_back(i);
+      }
     }
-    if (!stdErrEOF) {
-      FD_SET(stdErrFd, &readfds);
+    if (pollFds.empty()) {
+      return rs::Ok();
     }
 
-    const int ret = select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
-    if (ret == -1) {
-      if (stdOutFd != -1) {
-        close(stdOutFd);
-      }
-      if (stdErrFd != -1) {
-        close(stdErrFd);
+    if (poll(pollFds.data(), pollFds.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
       }
-      rs_bail("select() failed");
+      closeAll();
+      rs_bail("poll() failed");
     }
 
-    // Read from stdout if available
-    if (!stdOutEOF && FD_ISSET(stdOutFd, &readfds)) {
-      std::array<char, BUFFER_SIZE> buffer{};
-      const ssize_t count = read(stdOutFd, buffer.data(), buffer.size());
+    for (std::size_t i = 0; i < pollFds.size(); ++i) {
+      if ((pollFds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+        continue;
+      }
+      PipeState& pipe = pipes[pollIdx[i]];
+      const ssize_t count = read(pipe.fd, buffer.data(), buffer.size());
       if (count == -1) {
-        if (stdOutFd != -1) {
-          close(stdOutFd);
-        }
-        if (stdErrFd != -1) {
-          close(stdErrFd);
-        }
-        rs_bail("read() failed on stdout");
+        closeAll();
+        rs_bail("read() failed");
       } else if (count == 0) {
-        stdOutEOF = true;
-        close(stdOutFd);
+        close(pipe.fd);
+        pipe.fd = -1;
+        pipe.closedAt = std::chrono::steady_clock::now();
       } else {
-        stdOutOutput.append(buffer.data(), static_cast<std::size_t>(count));
-      }
-    }
-
-    // Read from stderr if available
-    if (!stdErrEOF && FD_ISSET(stdErrFd, &readfds)) {
-      std::array<char, BUFFER_SIZE> buffer{};
-      const ssize_t count = read(stdErrFd, buffer.data(), buffer.size());
-      if (count == -1) {
-        if (stdOutFd != -1) {
-          close(stdOutFd);
+        if (pipe.mirrorFd != -1) {
+          // Best effort: a closed terminal must not abort the drain, or
+          // the child would block on a full pipe forever.
+          std::size_t written = 0;
+          while (written < static_cast<std::size_t>(count)) {
+            const ssize_t n = write(pipe.mirrorFd, buffer.data() + written,
+                                    static_cast<std::size_t>(count) - written);
+            if (n == -1) {
+              if (errno == EINTR) {
+                continue;
+              }
+              break;
+            }
+            written += static_cast<std::size_t>(n);
+          }
         }
-        if (stdErrFd != -1) {
-          close(stdErrFd);
+        pipe.out->append(buffer.data(), static_cast<std::size_t>(count));
+        if (pipe.mirrorFd != -1 && pipe.out->size() > TEE_TAIL_BYTES) {
+          pipe.out->erase(0, pipe.out->size() - TEE_TAIL_BYTES);
         }
-        rs_bail("read() failed on stderr");
-      } else if (count == 0) {
-        stdErrEOF = true;
-        close(stdErrFd);
-      } else {
-        stdErrOutput.append(buffer.data(), static_cast<std::size_t>(count));
       }
     }
   }
+}
+
+// ru_maxrss is kilobytes on Linux but bytes on macOS.
+static std::int64_t maxRssKb(const rusage& usage) noexcept {
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+rs::Result<CommandOutput> Child::waitWithOutput() const noexcept {
+  std::string stdOutOutput;
+  std::string stdErrOutput;
+
+  std::vector<PipeState> pipes;
+  if (stdOutFd != -1) {
+    pipes.push_back(
+        { .fd = stdOutFd, .out = &stdOutOutput, .mirrorFd = stdOutMirrorFd });
+  }
+  if (stdErrFd != -1) {
+    pipes.push_back(
+        { .fd = stdErrFd, .out = &stdErrOutput, .mirrorFd = stdErrMirrorFd });
+  }
+  rs_try(drainPipes(pipes));
 
   int status{};
-  if (waitpid(pid, &status, 0) == -1) {
-    rs_bail("waitpid() failed");
+  rusage usage{};
+  if (wait4(pid, &status, 0, &usage) == -1) {
+    rs_bail("wait4() failed");
   }
   return rs::Ok(CommandOutput{ .exitStatus = ExitStatus{ status },
                                .stdOut = stdOutOutput,
-                               .stdErr = stdErrOutput });
+                               .stdErr = stdErrOutput,
+                               .peakRssKb = maxRssKb(usage) });
+}
+
+rs::Result<std::vector<CommandOutput>>
+waitAllWithOutput(const std::vector<Child>& children) noexcept {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::string> stdOuts(children.size());
+  std::vector<std::string> stdErrs(children.size());
+
+  // One poll() loop supervises every child's pipes, so dozens of
+  // in-flight commands drain concurrently instead of blocking one at a
+  // time.
+  std::vector<PipeState> pipes;
+  std::vector<std::vector<std::size_t>> childPipes(children.size());
+  for (std::size_t i = 0; i < children.size(); ++i) {
+    if (children[i].stdOutFd != -1) {
+      childPipes[i].push_back(pipes.size());
+      pipes.push_back({ .fd = children[i].stdOutFd,
+                        .out = &stdOuts[i],
+                        .mirrorFd = children[i].stdOutMirrorFd });
+    }
+    if (children[i].stdErrFd != -1) {
+      childPipes[i].push_back(pipes.size());
+      pipes.push_back({ .fd = children[i].stdErrFd,
+                        .out = &stdErrs[i],
+                        .mirrorFd = children[i].stdErrMirrorFd });
+    }
+  }
+  rs_try(drainPipes(pipes));
+
+  std::vector<CommandOutput> outputs;
+  outputs.reserve(children.size());
+  for (std::size_t i = 0; i < children.size(); ++i) {
+    int status{};
+    rusage usage{};
+    if (wait4(children[i].pid, &status, 0, &usage) == -1) {
+      rs_bail("wait4() failed");
+    }
+    // The last pipe's EOF approximates the child's exit time closely
+    // enough for scheduling decisions.
+    auto finished = start;
+    for (const std::size_t pipeIdx : childPipes[i]) {
+      finished = std::max(finished, pipes[pipeIdx].closedAt);
+    }
+    outputs.push_back(CommandOutput{
+        .exitStatus = ExitStatus{ status },
+        .stdOut = std::move(stdOuts[i]),
+        .stdErr = std::move(stdErrs[i]),
+        .durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          finished - start)
+                          .count(),
+        .peakRssKb = maxRssKb(usage),
+    });
+  }
+  return rs::Ok(std::move(outputs));
 }
 
+// posix_spawn_file_actions_addchdir_np landed in glibc 2.29 and
+// macOS 10.15; without it a working-directory change still needs fork().
+#if (defined(__GLIBC__) \
+     && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))) \
+    || defined(__APPLE__)
+#  define CABIN_SPAWN_HAS_CHDIR 1
+#else
+#  define CABIN_SPAWN_HAS_CHDIR 0
+#endif
+
 rs::Result<Child> Command::spawn() const noexcept {
+  // The child shares stderr; queued diagnostics must land before it
+  // starts writing, or its output could precede lines logged earlier.
+  DiagSink::flush();
+#if CABIN_SPAWN_HAS_CHDIR
+  return spawnPosix();
+#else
+  if (workingDirectory.empty()) {
+    return spawnPosix();
+  }
+  return spawnFork();
+#endif
+}
+
+rs::Result<Child> Command::spawnPosix() const noexcept {
+  std::array<int, 2> stdOutPipe{ { -1, -1 } };
+  std::array<int, 2> stdErrPipe{ { -1, -1 } };
+
+  if (wantsPipe(stdOutConfig)) {
+    if (pipe(stdOutPipe.data()) == -1) {
+      rs_bail("pipe() failed for stdout");
+    }
+  }
+  if (wantsPipe(stdErrConfig)) {
+    if (pipe(stdErrPipe.data()) == -1) {
+      rs_bail("pipe() failed for stderr");
+    }
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+
+  if (wantsPipe(stdOutConfig)) {
+    posix_spawn_file_actions_adddup2(&actions, stdOutPipe[1], STDOUT_FILENO);
+  } else if (stdOutConfig == IOConfig::Null) {
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+  }
+  if (wantsPipe(stdErrConfig)) {
+    posix_spawn_file_actions_adddup2(&actions, stdErrPipe[1], STDERR_FILENO);
+  } else if (stdErrConfig == IOConfig::Null) {
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+  }
+  // The child must not keep any pipe end open besides the dup2'd ones.
+  for (const int fd : { stdOutPipe[0], stdOutPipe[1], stdErrPipe[0],
+                        stdErrPipe[1] }) {
+    if (fd != -1) {
+      posix_spawn_file_actions_addclose(&actions, fd);
+    }
+  }
+
+#if CABIN_SPAWN_HAS_CHDIR
+  if (!workingDirectory.empty()) {
+    posix_spawn_file_actions_addchdir_np(&actions, workingDirectory.c_str());
+  }
+#endif
+
+  std::vector<char*> argv;
+  argv.reserve(arguments.size() + 2);
+  argv.push_back(const_cast<char*>(command.c_str())); // NOLINT
+  for (const std::string& arg : arguments) {
+    argv.push_back(const_cast<char*>(arg.c_str())); // NOLINT
+  }
+  argv.push_back(nullptr);
+
+  // Start from the inherited environment and replace overridden keys, to
+  // keep Command::setEnv's setenv(overwrite) semantics.
+  std::vector<std::string> envStorage;
+  std::vector<char*> envp;
+  char** envpPtr = environ;
+  if (!environment.empty()) {
+    const auto overridden = [this](const std::string_view entry) {
+      for (const auto& [key, value] : environment) {
+        if (entry.size() > key.size() && entry[key.size()] == '='
+            && entry.starts_with(key)) {
+          return true;
+        }
+      }
+      return false;
+    };
+    for (char** env = environ; *env != nullptr; ++env) {
+      if (!overridden(*env)) {
+        envp.push_back(*env);
+      }
+    }
+    envStorage.reserve(environment.size());
+    for (const auto& [key, value] : environment) {
+      envStorage.push_back(fmt::format("{}={}", key, value));
+      envp.push_back(envStorage.back().data());
+    }
+    envp.push_back(nullptr);
+    envpPtr = envp.data();
+  }
+
+  pid_t pid{};
+  const int rc = posix_spawnp(&pid, command.c_str(), &actions, nullptr,
+                              argv.data(), envpPtr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (wantsPipe(stdOutConfig)) {
+    close(stdOutPipe[1]); // Parent doesn't write to stdout pipe
+  }
+  if (wantsPipe(stdErrConfig)) {
+    close(stdErrPipe[1]); // Parent doesn't write to stderr pipe
+  }
+  if (rc != 0) {
+    if (stdOutPipe[0] != -1) {
+      close(stdOutPipe[0]);
+    }
+    if (stdErrPipe[0] != -1) {
+      close(stdErrPipe[0]);
+    }
+    rs_bail("posix_spawnp() failed for `{}`: {}", command, strerror(rc));
+  }
+
+  return rs::Ok(
+      Child{ pid, wantsPipe(stdOutConfig) ? stdOutPipe[0] : -1,
+             wantsPipe(stdErrConfig) ? stdErrPipe[0] : -1,
+             stdOutConfig == IOConfig::Tee ? STDOUT_FILENO : -1,
+             stdErrConfig == IOConfig::Tee ? STDERR_FILENO : -1 });
+}
+
+rs::Result<Child> Command::spawnFork() const noexcept {
   std::array<int, 2> stdOutPipe{};
   std::array<int, 2> stdErrPipe{};
 
   // Set up stdout pipe if needed
-  if (stdOutConfig == IOConfig::Piped) {
+  if (wantsPipe(stdOutConfig)) {
     if (pipe(stdOutPipe.data()) == -1) {
       rs_bail("pipe() failed for stdout");
     }
   }
   // Set up stderr pipe if needed
-  if (stdErrConfig == IOConfig::Piped) {
+  if (wantsPipe(stdErrConfig)) {
     if (pipe(stdErrPipe.data()) == -1) {
       rs_bail("pipe() failed for stderr");
     }
@@ -179,7 +432,7 @@ rs::Result<Child> Command::spawn() const noexcept {
     // Child process
 
     // Redirect stdout
-    if (stdOutConfig == IOConfig::Piped) {
+    if (wantsPipe(stdOutConfig)) {
       close(stdOutPipe[0]); // Child doesn't read from stdout pipe
       dup2(stdOutPipe[1], STDOUT_FILENO);
       close(stdOutPipe[1]);
@@ -191,7 +444,7 @@ rs::Result<Child> Command::spawn() const noexcept {
     }
 
     // Redirect stderr
-    if (stdErrConfig == IOConfig::Piped) {
+    if (wantsPipe(stdErrConfig)) {
       close(stdErrPipe[0]); // Child doesn't read from stderr pipe
       dup2(stdErrPipe[1], STDERR_FILENO);
       close(stdErrPipe[1]);
@@ -244,21 +497,24 @@ rs::Result<Child> Command::spawn() const noexcept {
     // Parent process
 
     // Close unused pipe ends
-    if (stdOutConfig == IOConfig::Piped) {
+    if (wantsPipe(stdOutConfig)) {
       close(stdOutPipe[1]); // Parent doesn't write to stdout pipe
     }
-    if (stdErrConfig == IOConfig::Piped) {
+    if (wantsPipe(stdErrConfig)) {
       close(stdErrPipe[1]); // Parent doesn't write to stderr pipe
     }
 
     // Return the Child object with appropriate file descriptors
     return rs::Ok(
-        Child{ pid, stdOutConfig == IOConfig::Piped ? stdOutPipe[0] : -1,
-               stdErrConfig == IOConfig::Piped ? stdErrPipe[0] : -1 });
+        Child{ pid, wantsPipe(stdOutConfig) ? stdOutPipe[0] : -1,
+               wantsPipe(stdErrConfig) ? stdErrPipe[0] : -1,
+               stdOutConfig == IOConfig::Tee ? STDOUT_FILENO : -1,
+               stdErrConfig == IOConfig::Tee ? STDERR_FILENO : -1 });
   }
 }
 
 rs::Result<CommandOutput> Command::output() const noexcept {
+  const profile::Span span("Command::output");
   Command cmd = *this;
   cmd.setStdOutConfig(IOConfig::Piped);
   cmd.setStdErrConfig(IOConfig::Piped);
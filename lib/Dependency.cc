@@ -1,13 +1,28 @@
 #include "Dependency.hpp"
 
 #include "Builder/Compiler.hpp"
+#include "Builder/ScanCache.hpp"
+#include "CacheFile.hpp"
+#include "Command.hpp"
 #include "Diag.hpp"
+#include "Download.hpp"
 #include "Git2.hpp"
+#include "GlobalConfig.hpp"
 
+#include <cstdint>
 #include <cstdlib>
+#include <exception>
 #include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 
 namespace cabin {
 
@@ -24,6 +39,150 @@ static fs::path getXdgCacheHome() noexcept {
 static const fs::path CACHE_DIR(getXdgCacheHome() / "cabin");
 static const fs::path GIT_DIR(CACHE_DIR / "git");
 static const fs::path GIT_SRC_DIR(GIT_DIR / "src");
+static const fs::path GIT_DB_DIR(GIT_DIR / "db");
+static const fs::path REGISTRY_DIR(CACHE_DIR / "registry");
+static const fs::path REGISTRY_DL_DIR(REGISTRY_DIR / "dl");
+static const fs::path REGISTRY_SRC_DIR(REGISTRY_DIR / "src");
+
+namespace {
+
+/// Exclusive advisory lock on `<dir>.lock`, serializing cabin processes
+/// that materialize the same cache directory.
+class DirLock : public FileLock {
+public:
+  explicit DirLock(const fs::path& dir) : FileLock(dir.string() + ".lock") {}
+};
+
+/// Remembers each dependency's validated install layout (the chosen
+/// include dir) so warm builds skip the exists/is_empty probes, which
+/// read the directory and are slow on network filesystems.  Entries are
+/// keyed by the mtimes of the install dir and its `include/` child: a
+/// fresh install, an upgrade, or a manual edit bumps one of them and
+/// invalidates the entry.  Lives next to the dependency caches in
+/// ~/.cache/cabin.
+class DepLayoutCache {
+public:
+  static DepLayoutCache& instance() noexcept {
+    static DepLayoutCache cache;
+    return cache;
+  }
+
+  std::optional<fs::path> lookup(const fs::path& installDir) {
+    const std::scoped_lock lock(mutex_);
+    const auto it = entries_.find(installDir.string());
+    if (it == entries_.end()) {
+      return std::nullopt;
+    }
+    const Entry& entry = it->second;
+    if (entry.dirMtime != mtimeOf(installDir) || entry.dirMtime == -1
+        || entry.includeMtime != mtimeOf(installDir / "include")) {
+      return std::nullopt;
+    }
+    return fs::path(entry.include);
+  }
+
+  void record(const fs::path& installDir, const fs::path& includeDir) {
+    const std::scoped_lock lock(mutex_);
+    entries_[installDir.string()] =
+        Entry{ .include = includeDir.string(),
+               .dirMtime = mtimeOf(installDir),
+               .includeMtime = mtimeOf(installDir / "include") };
+    dirty_ = true;
+  }
+
+  DepLayoutCache(const DepLayoutCache&) = delete;
+  DepLayoutCache(DepLayoutCache&&) = delete;
+  DepLayoutCache& operator=(const DepLayoutCache&) = delete;
+  DepLayoutCache& operator=(DepLayoutCache&&) = delete;
+
+private:
+  struct Entry {
+    std::string include;
+    std::int64_t dirMtime = -1;
+    std::int64_t includeMtime = -1;
+  };
+
+  static std::int64_t mtimeOf(const fs::path& path) {
+    std::error_code ec;
+    const auto mtime = fs::last_write_time(path, ec);
+    return ec ? -1 : mtime.time_since_epoch().count();
+  }
+
+  DepLayoutCache() : path_(CACHE_DIR / "dep-layout.json") {
+    try {
+      std::ifstream ifs(path_);
+      if (!ifs) {
+        return;
+      }
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (!loaded.is_object() || loaded.value("version", 0) != 1) {
+        return;
+      }
+      for (const auto& [dir, entry] : loaded.at("deps").items()) {
+        entries_[dir] =
+            Entry{ .include = entry.value("include", ""),
+                   .dirMtime = entry.value("dirMtime", std::int64_t{ -1 }),
+                   .includeMtime =
+                       entry.value("includeMtime", std::int64_t{ -1 }) };
+      }
+    } catch (const std::exception& e) {
+      spdlog::debug("discarding dep-layout cache: {}", e.what());
+      entries_.clear();
+    }
+  }
+
+  ~DepLayoutCache() {
+    if (!dirty_) {
+      return;
+    }
+    try {
+      nlohmann::json deps = nlohmann::json::object();
+      for (const auto& [dir, entry] : entries_) {
+        deps[dir] = { { "include", entry.include },
+                      { "dirMtime", entry.dirMtime },
+                      { "includeMtime", entry.includeMtime } };
+      }
+      nlohmann::json json;
+      json["version"] = 1;
+      json["deps"] = std::move(deps);
+      fs::create_directories(path_.parent_path());
+      std::ofstream ofs(path_);
+      ofs << json.dump();
+    } catch (const std::exception& e) {
+      spdlog::debug("failed to save dep-layout cache: {}", e.what());
+    }
+  }
+
+  fs::path path_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  bool dirty_ = false;
+};
+
+} // namespace
+
+// Header-only dependencies compile with `include/` when it has content,
+// the checkout root otherwise.
+static CompilerOpts headerOnlyOpts(const fs::path& include) {
+  return CompilerOpts(CFlags({}, { IncludeDir{ include } }, {}),
+                      // Header-only: nothing to link.  Checkouts with a
+                      // cabin.toml are built by the dep installer instead
+                      // of going through this path.
+                      LdFlags());
+}
+
+static fs::path resolveIncludeDir(const fs::path& installDir) {
+  const fs::path includeDir = installDir / "include";
+  fs::path include;
+  if (fs::exists(includeDir) && fs::is_directory(includeDir)
+      && !fs::is_empty(includeDir)) {
+    include = includeDir;
+  } else {
+    include = installDir;
+  }
+  DepLayoutCache::instance().record(installDir, include);
+  return include;
+}
 
 fs::path GitDependency::installDir() const {
   fs::path dir = GIT_SRC_DIR / name;
@@ -33,63 +192,209 @@ fs::path GitDependency::installDir() const {
   return dir;
 }
 
-rs::Result<CompilerOpts> GitDependency::install() const {
-  const fs::path targetDir = installDir();
+// One bare mirror per URL (the digest disambiguates forks sharing a name);
+// every pinned checkout of that URL hardlinks this mirror's object database.
+fs::path GitDependency::mirrorDir() const {
+  return GIT_DB_DIR / fmt::format("{}-{}", name, digestString(url).substr(0, 8));
+}
 
+// Makes sure the mirror exists and can resolve `target` (when pinned),
+// fetching new objects into the existing mirror instead of re-cloning.
+rs::Result<void> GitDependency::updateMirror(const fs::path& mirrorPath) const {
+  fs::create_directories(GIT_DB_DIR);
+  const DirLock lock(mirrorPath);
+  rs_ensure(lock.held(), "failed to lock {}", mirrorPath.string());
+
+  git2::Repository mirror;
+  if (!fs::exists(mirrorPath) || fs::is_empty(mirrorPath)) {
+    // History is irrelevant until a pin needs it; start with the tips
+    // only.  The fetch URL goes through the global config's rewrite
+    // rules, so a corporate mirror can serve the clone while the mirror
+    // directory stays keyed by the logical URL.
+    mirror.cloneBare(GlobalConfig::instance().rewriteGitUrl(url),
+                     mirrorPath.string(), /*depth=*/1);
+  } else {
+    mirror.openBare(mirrorPath.string());
+  }
+
+  if (target.has_value()) {
+    try {
+      mirror.revparseSingle(target.value());
+    } catch (const git2::Exception&) {
+      // A rev bump or a pin older than the shallow boundary: pull the
+      // missing objects into the mirror and deepen it as needed.
+      spdlog::debug("{} not found in mirror of {}, fetching origin",
+                    target.value(), name);
+      mirror.fetchOrigin(/*depth=*/-1);
+      mirror.revparseSingle(target.value()); // throws if still unknown
+    }
+  }
+  return rs::Ok();
+}
+
+rs::Result<void> GitDependency::fetch() const {
+  const fs::path targetDir = installDir();
   if (fs::exists(targetDir) && !fs::is_empty(targetDir)) {
     spdlog::debug("{} is already installed", name);
-  } else {
+    return rs::Ok();
+  }
+
+  Diag::info("Downloading", "{} {}", name,
+             target.has_value() ? target.value() : url);
+  const fs::path mirrorPath = mirrorDir();
+  rs_try(updateMirror(mirrorPath));
+
+  fs::create_directories(GIT_SRC_DIR);
+  const DirLock lock(targetDir);
+  rs_ensure(lock.held(), "failed to lock {}", targetDir.string());
+
+  // Another cabin process may have finished the checkout while we waited.
+  if (fs::exists(targetDir) && !fs::is_empty(targetDir)) {
+    spdlog::debug("{} was installed while waiting for the lock", name);
+    return rs::Ok();
+  }
+
+  // The checkout hardlinks the mirror's object database, so materializing
+  // another pin of the same URL costs no network and near-zero disk.
+  git2::Repository repo;
+  repo.cloneLocal(mirrorPath.string(), targetDir.string());
+  if (target.has_value()) {
+    const git2::Object obj = repo.revparseSingle(target.value());
+    repo.setHeadDetached(obj.id());
+    repo.checkoutHead(true);
+  }
+
+  Diag::info("Downloaded", "{} {}", name,
+             target.has_value() ? target.value() : url);
+  return rs::Ok();
+}
+
+rs::Result<std::string> GitDependency::resolvedOid() const {
+  try {
     git2::Repository repo;
-    repo.clone(url, targetDir.string());
-
-    if (target.has_value()) {
-      // Checkout to target.
-      const std::string target = this->target.value();
-      const git2::Object obj = repo.revparseSingle(target);
-      repo.setHeadDetached(obj.id());
-      repo.checkoutHead(true);
+    repo.open(installDir().string());
+    return rs::Ok(repo.revparseSingle("HEAD").id().toString());
+  } catch (const git2::Exception& e) {
+    rs_bail("failed to resolve HEAD of {}: {}", name, e.what());
+  }
+}
+
+rs::Result<CompilerOpts> GitDependency::install() const {
+  const fs::path targetDir = installDir();
+  // A validated layout implies the checkout exists; skip fetch's own
+  // directory probes on the warm path.
+  if (const auto include = DepLayoutCache::instance().lookup(targetDir)) {
+    spdlog::debug("{} layout cached", name);
+    return rs::Ok(headerOnlyOpts(*include));
+  }
+  rs_try(fetch());
+  return rs::Ok(headerOnlyOpts(resolveIncludeDir(targetDir)));
+}
+
+fs::path TarballDependency::installDir() const {
+  // The digest disambiguates different archives published under one name.
+  return REGISTRY_SRC_DIR
+         / fmt::format("{}-{}", name, digestString(url).substr(0, 8));
+}
+
+static fs::path archivePathFor(const std::string& name,
+                               const std::string& url) {
+  return REGISTRY_DL_DIR
+         / fmt::format("{}-{}.tar.gz", name, digestString(url).substr(0, 8));
+}
+
+static rs::Result<void> extractArchive(const fs::path& archive,
+                                       const fs::path& destDir) {
+  const DirLock lock(destDir);
+  rs_ensure(lock.held(), "failed to lock {}", destDir.string());
+  if (fs::exists(destDir) && !fs::is_empty(destDir)) {
+    return rs::Ok();
+  }
+
+  fs::create_directories(destDir);
+  // Registry archives wrap their contents in one top-level directory.
+  const CommandOutput out = rs_try(Command("tar")
+                                       .addArg("-xf")
+                                       .addArg(archive.string())
+                                       .addArg("-C")
+                                       .addArg(destDir.string())
+                                       .addArg("--strip-components=1")
+                                       .setStdOutConfig(Command::IOConfig::Null)
+                                       .setStdErrConfig(
+                                           Command::IOConfig::Piped)
+                                       .output());
+  if (!out.exitStatus.success()) {
+    fs::remove_all(destDir);
+    rs_bail("failed to extract {}: {}", archive.string(), out.stdErr);
+  }
+  return rs::Ok();
+}
+
+rs::Result<void> TarballDependency::fetch() const { return fetchAll({ *this }); }
+
+rs::Result<void>
+TarballDependency::fetchAll(const std::vector<TarballDependency>& deps) {
+  std::vector<const TarballDependency*> toExtract;
+  std::vector<DownloadRequest> requests;
+  for (const TarballDependency& dep : deps) {
+    const fs::path dir = dep.installDir();
+    if (fs::exists(dir) && !fs::is_empty(dir)) {
+      spdlog::debug("{} is already installed", dep.name);
+      continue;
     }
+    toExtract.push_back(&dep);
 
-    Diag::info("Downloaded", "{} {}", name,
-               target.has_value() ? target.value() : url);
+    fs::path archive = archivePathFor(dep.name, dep.url);
+    if (fs::exists(archive)) {
+      if (!dep.digest.has_value() || digestFile(archive) == dep.digest) {
+        continue; // cached archive is usable as-is
+      }
+      fs::remove(archive);
+    }
+    Diag::info("Downloading", "{} {}", dep.name, dep.url);
+    requests.push_back({ .url = dep.url,
+                         .dest = std::move(archive),
+                         .expectedDigest = dep.digest.value_or("") });
+  }
+  if (toExtract.empty()) {
+    return rs::Ok();
   }
 
-  const fs::path includeDir = targetDir / "include";
-  fs::path include;
+  fs::create_directories(REGISTRY_DL_DIR);
+  rs_try(downloadAll(std::move(requests)));
 
-  if (fs::exists(includeDir) && fs::is_directory(includeDir)
-      && !fs::is_empty(includeDir)) {
-    include = includeDir;
-  } else {
-    include = targetDir;
+  fs::create_directories(REGISTRY_SRC_DIR);
+  for (const TarballDependency* dep : toExtract) {
+    rs_try(extractArchive(archivePathFor(dep->name, dep->url),
+                          dep->installDir()));
+    Diag::info("Downloaded", "{} {}", dep->name, dep->url);
   }
+  return rs::Ok();
+}
 
-  return rs::Ok(CompilerOpts(CFlags({}, { IncludeDir{ include } }, {}),
-                             // Currently, no libs are supported.
-                             LdFlags()));
+rs::Result<CompilerOpts> TarballDependency::install() const {
+  const fs::path targetDir = installDir();
+  if (const auto include = DepLayoutCache::instance().lookup(targetDir)) {
+    spdlog::debug("{} layout cached", name);
+    return rs::Ok(headerOnlyOpts(*include));
+  }
+  rs_try(fetch());
+  return rs::Ok(headerOnlyOpts(resolveIncludeDir(targetDir)));
 }
 
 rs::Result<CompilerOpts> PathDependency::install() const {
   const fs::path installDir = fs::weakly_canonical(path);
+  if (const auto include = DepLayoutCache::instance().lookup(installDir)) {
+    spdlog::debug("{} layout cached", name);
+    return rs::Ok(headerOnlyOpts(*include));
+  }
   if (fs::exists(installDir) && !fs::is_empty(installDir)) {
     spdlog::debug("{} is already installed", name);
   } else {
     rs_bail("{} can't be accessible as directory", installDir.string());
   }
 
-  const fs::path includeDir = installDir / "include";
-  fs::path include;
-
-  if (fs::exists(includeDir) && fs::is_directory(includeDir)
-      && !fs::is_empty(includeDir)) {
-    include = includeDir;
-  } else {
-    include = installDir;
-  }
-
-  return rs::Ok(CompilerOpts(CFlags({}, { IncludeDir{ include } }, {}),
-                             // Currently, no libs are supported.
-                             LdFlags()));
+  return rs::Ok(headerOnlyOpts(resolveIncludeDir(installDir)));
 }
 
 rs::Result<CompilerOpts> SystemDependency::install() const {
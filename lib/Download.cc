@@ -0,0 +1,147 @@
+#include "Download.hpp"
+
+#include "Builder/ScanCache.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <curl/curl.h>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace cabin {
+
+namespace {
+
+struct Transfer {
+  const DownloadRequest* req = nullptr;
+  fs::path partPath;
+  std::FILE* file = nullptr;
+};
+
+} // namespace
+
+static std::size_t writeToFile(const void* contents, const std::size_t size,
+                               const std::size_t nmemb, std::FILE* file) {
+  return std::fwrite(contents, size, nmemb, file) * size;
+}
+
+rs::Result<void> downloadAll(std::vector<DownloadRequest> requests) noexcept {
+  if (requests.empty()) {
+    return rs::Ok();
+  }
+
+  CURLM* multi = curl_multi_init();
+  rs_ensure(multi != nullptr, "curl_multi_init() failed");
+  // Prefer one connection per host with multiplexed HTTP/2 streams.
+  curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+  std::vector<Transfer> transfers(requests.size());
+  std::vector<CURL*> handles(requests.size(), nullptr);
+  std::vector<std::string> errors;
+
+  for (std::size_t i = 0; i < requests.size(); ++i) {
+    Transfer& transfer = transfers[i];
+    transfer.req = &requests[i];
+    transfer.partPath = requests[i].dest.string() + ".part";
+
+    curl_off_t resumeFrom = 0;
+    if (std::error_code ec; fs::exists(transfer.partPath, ec) && !ec) {
+      resumeFrom = static_cast<curl_off_t>(fs::file_size(transfer.partPath));
+    }
+    transfer.file =
+        std::fopen(transfer.partPath.c_str(), resumeFrom > 0 ? "ab" : "wb");
+    if (transfer.file == nullptr) {
+      errors.push_back(
+          fmt::format("failed to open {}", transfer.partPath.string()));
+      continue;
+    }
+
+    CURL* easy = curl_easy_init();
+    if (easy == nullptr) {
+      errors.emplace_back("curl_easy_init() failed");
+      std::fclose(transfer.file);
+      transfer.file = nullptr;
+      continue;
+    }
+    curl_easy_setopt(easy, CURLOPT_URL, transfer.req->url.c_str());
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeToFile);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.file);
+    // Wait for an existing connection instead of opening a new one, so
+    // sibling transfers share one multiplexed connection.
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    if (resumeFrom > 0) {
+      curl_easy_setopt(easy, CURLOPT_RESUME_FROM_LARGE, resumeFrom);
+    }
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+    curl_multi_add_handle(multi, easy);
+    handles[i] = easy;
+  }
+
+  int running = 0;
+  do {
+    CURLMcode mc = curl_multi_perform(multi, &running);
+    if (mc == CURLM_OK && running > 0) {
+      mc = curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+    if (mc != CURLM_OK) {
+      errors.emplace_back(curl_multi_strerror(mc));
+      break;
+    }
+
+    int msgsLeft = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &msgsLeft)) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+      Transfer* transfer = nullptr;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+      std::fclose(transfer->file);
+      transfer->file = nullptr;
+
+      if (msg->data.result != CURLE_OK) {
+        // Keep the .part file so a later invocation can resume it.
+        errors.push_back(fmt::format("failed to download {}: {}",
+                                     transfer->req->url,
+                                     curl_easy_strerror(msg->data.result)));
+      } else if (!transfer->req->expectedDigest.empty()
+                 && digestFile(transfer->partPath)
+                        != transfer->req->expectedDigest) {
+        fs::remove(transfer->partPath);
+        errors.push_back(
+            fmt::format("digest mismatch for {}", transfer->req->url));
+      } else {
+        fs::rename(transfer->partPath, transfer->req->dest);
+      }
+
+      for (CURL*& handle : handles) {
+        if (handle == msg->easy_handle) {
+          handle = nullptr;
+          break;
+        }
+      }
+      curl_multi_remove_handle(multi, msg->easy_handle);
+      curl_easy_cleanup(msg->easy_handle);
+    }
+  } while (running > 0);
+
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    if (handles[i] != nullptr) {
+      curl_multi_remove_handle(multi, handles[i]);
+      curl_easy_cleanup(handles[i]);
+    }
+    if (transfers[i].file != nullptr) {
+      std::fclose(transfers[i].file);
+    }
+  }
+  curl_multi_cleanup(multi);
+
+  rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+  return rs::Ok();
+}
+
+} // namespace cabin
@@ -0,0 +1,169 @@
+#include "FileWatcher.hpp"
+
+#include <rs/result.hpp>
+#include <utility>
+
+#ifdef __linux__
+#  include <array>
+#  include <cerrno>
+#  include <cstddef>
+#  include <cstdint>
+#  include <cstring>
+#  include <poll.h>
+#  include <sys/inotify.h>
+#  include <tuple>
+#  include <unistd.h>
+#else
+#  include <chrono>
+#  include <thread>
+#endif
+
+namespace cabin {
+
+FileWatcher::FileWatcher(std::vector<fs::path> roots)
+    : roots_(std::move(roots)) {}
+
+#ifdef __linux__
+
+// IN_CLOSE_WRITE (instead of IN_MODIFY) fires once per save rather than
+// once per write() call; the move events cover editors that write a temp
+// file and rename it over the original.
+static constexpr std::uint32_t WATCH_MASK =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+    | IN_ATTRIB;
+
+rs::Result<FileWatcher> FileWatcher::create(std::vector<fs::path> roots) {
+  FileWatcher watcher(std::move(roots));
+  watcher.inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  rs_ensure(watcher.inotifyFd_ != -1, "inotify_init1() failed: {}",
+            strerror(errno));
+  for (const fs::path& root : watcher.roots_) {
+    if (fs::is_directory(root)) {
+      rs_try(watcher.watchTree(root));
+    } else if (fs::exists(root)) {
+      rs_try(watcher.watchPath(root));
+    } else {
+      // Watch the parent so the root's later creation is reported; the
+      // extra events for unrelated siblings cost one spurious wakeup at
+      // worst.
+      rs_try(watcher.watchPath(root.parent_path()));
+    }
+  }
+  return rs::Ok(std::move(watcher));
+}
+
+FileWatcher::~FileWatcher() {
+  if (inotifyFd_ != -1) {
+    close(inotifyFd_); // releases every watch descriptor with it
+  }
+}
+
+FileWatcher::FileWatcher(FileWatcher&& other) noexcept
+    : roots_(std::move(other.roots_)),
+      inotifyFd_(std::exchange(other.inotifyFd_, -1)),
+      watchDirs_(std::move(other.watchDirs_)) {}
+
+rs::Result<void> FileWatcher::watchPath(const fs::path& path) {
+  const int wd = inotify_add_watch(inotifyFd_, path.c_str(), WATCH_MASK);
+  rs_ensure(wd != -1, "inotify_add_watch() failed for `{}`: {}", path,
+            strerror(errno));
+  if (fs::is_directory(path)) {
+    watchDirs_[wd] = path.string();
+  }
+  return rs::Ok();
+}
+
+rs::Result<void> FileWatcher::watchTree(const fs::path& root) {
+  rs_try(watchPath(root));
+  for (auto itr = fs::recursive_directory_iterator(root);
+       itr != fs::recursive_directory_iterator(); ++itr) {
+    if (itr->is_directory()) {
+      rs_try(watchPath(itr->path()));
+    }
+  }
+  return rs::Ok();
+}
+
+bool FileWatcher::drainEvents() {
+  bool sawEvent = false;
+  // Sized for a burst of events; inotify_event names are NUL-padded.
+  alignas(inotify_event) std::array<char, 4096> buffer{};
+  while (true) {
+    const ssize_t len = read(inotifyFd_, buffer.data(), buffer.size());
+    if (len <= 0) {
+      return sawEvent;
+    }
+    sawEvent = true;
+    std::size_t offset = 0;
+    while (offset < static_cast<std::size_t>(len)) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      const auto* event =
+          reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+      if ((event->mask & IN_ISDIR) != 0
+          && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+        // A directory appeared under a watched one; cover it (and
+        // anything already created inside it) before events are missed.
+        if (const auto dir = watchDirs_.find(event->wd);
+            dir != watchDirs_.end()) {
+          std::ignore = watchTree(fs::path(dir->second) / event->name);
+        }
+      }
+      offset += sizeof(inotify_event) + event->len;
+    }
+  }
+}
+
+rs::Result<void>
+FileWatcher::waitForChange(const std::chrono::milliseconds debounce) {
+  pollfd pfd{ .fd = inotifyFd_, .events = POLLIN, .revents = 0 };
+  while (poll(&pfd, 1, -1) == -1) {
+    rs_ensure(errno == EINTR, "poll() failed: {}", strerror(errno));
+  }
+  // Keep draining until the tree has been quiet for the debounce window.
+  while (true) {
+    drainEvents();
+    const int ready = poll(&pfd, 1, static_cast<int>(debounce.count()));
+    if (ready == 0) {
+      return rs::Ok();
+    }
+    rs_ensure(ready != -1 || errno == EINTR, "poll() failed: {}",
+              strerror(errno));
+  }
+}
+
+void FileWatcher::drainPendingEvents() { drainEvents(); }
+
+#else
+
+rs::Result<FileWatcher> FileWatcher::create(std::vector<fs::path> roots) {
+  FileWatcher watcher(std::move(roots));
+  watcher.journal_ = StatJournal::record(watcher.roots_);
+  return rs::Ok(std::move(watcher));
+}
+
+FileWatcher::~FileWatcher() = default;
+
+FileWatcher::FileWatcher(FileWatcher&& other) noexcept = default;
+
+rs::Result<void>
+FileWatcher::waitForChange(const std::chrono::milliseconds debounce) {
+  constexpr std::chrono::milliseconds pollInterval(200);
+  while (journal_.matchesCurrentTree()) {
+    std::this_thread::sleep_for(pollInterval);
+  }
+  // Keep re-snapshotting until the tree has been quiet for the debounce
+  // window.
+  do {
+    journal_ = StatJournal::record(roots_);
+    std::this_thread::sleep_for(debounce);
+  } while (!journal_.matchesCurrentTree());
+  return rs::Ok();
+}
+
+void FileWatcher::drainPendingEvents() {
+  journal_ = StatJournal::record(roots_);
+}
+
+#endif
+
+} // namespace cabin
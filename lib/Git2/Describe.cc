@@ -88,4 +88,15 @@ std::string Describe::format(const DescribeFormatOptions& opts) const {
   return { ret.ptr, ret.size };
 }
 
+std::string Describe::firstTag(const Repository& repo) {
+  DescribeOptions opts;
+  opts.describeTags()
+      .maxCandidatesTags(1)
+      .onlyFollowFirstParent(true)
+      .showCommitOidAsFallback(true);
+  Describe describe;
+  describe.workdir(repo, opts);
+  return describe.format(DescribeFormatOptions());
+}
+
 } // namespace git2
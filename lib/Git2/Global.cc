@@ -2,11 +2,57 @@
 
 #include "Git2/Exception.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <git2/common.h>
 #include <git2/global.h>
+#include <tuple>
+#include <unistd.h>
 
 namespace git2 {
 
-GlobalState::GlobalState() { git2Throw(git_libgit2_init()); }
+// libgit2's defaults (96 MiB object cache, 256 MiB of mapped pack
+// windows) are sized for small repositories; revparse and checkout
+// against a multi-gigabyte dependency pack spend their time evicting
+// cache entries and remapping windows.  Scale the limits to physical
+// memory once per process; failures are ignored since the defaults
+// still work, just slower.
+static void tuneOdbLimits() noexcept {
+  static const bool tuned = []() noexcept {
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0) {
+      return false;
+    }
+    const std::uint64_t physBytes = static_cast<std::uint64_t>(pages)
+                                    * static_cast<std::uint64_t>(pageSize);
+
+    constexpr std::uint64_t MIB = 1024 * 1024;
+    const std::uint64_t cacheMax =
+        std::clamp(physBytes / 16, 64 * MIB, 1024 * MIB);
+    const std::uint64_t mappedLimit =
+        std::clamp(physBytes / 8, 256 * MIB, 4096 * MIB);
+
+    std::ignore = git_libgit2_opts(GIT_OPT_SET_CACHE_MAX_SIZE,
+                                   static_cast<ssize_t>(cacheMax));
+    std::ignore = git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT,
+                                   static_cast<size_t>(mappedLimit));
+    // One window large enough that a big pack's hot region stays
+    // mapped instead of cycling through many small windows.
+    std::ignore = git_libgit2_opts(GIT_OPT_SET_MWINDOW_SIZE,
+                                   static_cast<size_t>(64 * MIB));
+    std::ignore = git_libgit2_opts(GIT_OPT_SET_PACK_MAX_OBJECTS,
+                                   static_cast<size_t>(1) << 24);
+    return true;
+  }();
+  (void)tuned;
+}
+
+GlobalState::GlobalState() {
+  git2Throw(git_libgit2_init());
+  tuneOdbLimits();
+}
 GlobalState::~GlobalState() { git2Throw(git_libgit2_shutdown()); }
 
 } // namespace git2
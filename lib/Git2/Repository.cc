@@ -10,8 +10,10 @@
 #include <git2/object.h>
 #include <git2/oid.h>
 #include <git2/refs.h>
+#include <git2/remote.h>
 #include <git2/repository.h>
 #include <git2/revparse.h>
+#include <git2/version.h>
 #include <string>
 
 namespace git2 {
@@ -48,6 +50,75 @@ Repository& Repository::clone(const std::string& url, const std::string& path,
   return *this;
 }
 
+// Shallow fetches landed in libgit2 1.7.
+#if LIBGIT2_VER_MAJOR > 1 \
+    || (LIBGIT2_VER_MAJOR == 1 && LIBGIT2_VER_MINOR >= 7)
+#  define CABIN_GIT2_HAS_FETCH_DEPTH 1
+#else
+#  define CABIN_GIT2_HAS_FETCH_DEPTH 0
+#endif
+
+Repository& Repository::cloneShallow(const std::string& url,
+                                     const std::string& path,
+                                     const int depth) {
+#if CABIN_GIT2_HAS_FETCH_DEPTH
+  git_clone_options opts;
+  git2Throw(git_clone_options_init(&opts, GIT_CLONE_OPTIONS_VERSION));
+  opts.fetch_opts.depth = depth;
+  return clone(url, path, &opts);
+#else
+  (void)depth;
+  return clone(url, path);
+#endif
+}
+
+Repository& Repository::cloneBare(const std::string& url,
+                                  const std::string& path, const int depth) {
+  git_clone_options opts;
+  git2Throw(git_clone_options_init(&opts, GIT_CLONE_OPTIONS_VERSION));
+  opts.bare = 1;
+#if CABIN_GIT2_HAS_FETCH_DEPTH
+  if (depth > 0) {
+    opts.fetch_opts.depth = depth;
+  }
+#else
+  (void)depth;
+#endif
+  return clone(url, path, &opts);
+}
+
+Repository& Repository::cloneLocal(const std::string& srcPath,
+                                   const std::string& dstPath) {
+  git_clone_options opts;
+  git2Throw(git_clone_options_init(&opts, GIT_CLONE_OPTIONS_VERSION));
+  opts.local = GIT_CLONE_LOCAL;
+  return clone(srcPath, dstPath, &opts);
+}
+
+Repository& Repository::fetchOrigin(const int depth) {
+  git_remote* remote = nullptr;
+  git2Throw(git_remote_lookup(&remote, this->raw, "origin"));
+
+  git_fetch_options opts;
+  if (const int rc = git_fetch_options_init(&opts, GIT_FETCH_OPTIONS_VERSION);
+      rc != 0) {
+    git_remote_free(remote);
+    git2Throw(rc);
+  }
+#if CABIN_GIT2_HAS_FETCH_DEPTH
+  if (depth != 0) {
+    opts.depth = depth; // negative means GIT_FETCH_DEPTH_UNSHALLOW
+  }
+#else
+  (void)depth;
+#endif
+
+  const int rc = git_remote_fetch(remote, nullptr, &opts, "fetch");
+  git_remote_free(remote);
+  git2Throw(rc);
+  return *this;
+}
+
 Object Repository::revparseSingle(const std::string& spec) const {
   git_object* obj = nullptr;
   git2Throw(git_revparse_single(&obj, this->raw, spec.c_str()));
@@ -4,8 +4,13 @@
 #include "Git2/Oid.hpp"
 #include "Git2/Repository.hpp"
 
+#include <cstddef>
+#include <git2/errors.h>
+#include <git2/oid.h>
 #include <git2/revwalk.h>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace git2 {
 
@@ -74,4 +79,30 @@ Revwalk& Revwalk::hideRef(const std::string& reference) {
   return *this;
 }
 
+std::optional<Oid> Revwalk::next() {
+  git_oid oid;
+  const int rc = git_revwalk_next(&oid, this->raw);
+  if (rc == GIT_ITEROVER) {
+    return std::nullopt;
+  }
+  git2Throw(rc);
+  return Oid(oid);
+}
+
+std::size_t Revwalk::nextMany(std::vector<Oid>& out, const std::size_t max) {
+  out.reserve(out.size() + max);
+  std::size_t count = 0;
+  while (count < max) {
+    git_oid oid;
+    const int rc = git_revwalk_next(&oid, this->raw);
+    if (rc == GIT_ITEROVER) {
+      break;
+    }
+    git2Throw(rc);
+    out.emplace_back(oid);
+    ++count;
+  }
+  return count;
+}
+
 } // end namespace git2
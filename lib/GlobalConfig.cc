@@ -0,0 +1,249 @@
+#include "GlobalConfig.hpp"
+
+#include "CacheFile.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <system_error>
+#include <toml.hpp>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+static fs::path configPath() {
+  if (const char* xdgConfigHome = std::getenv("XDG_CONFIG_HOME");
+      xdgConfigHome != nullptr && *xdgConfigHome != '\0') {
+    return fs::path(xdgConfigHome) / "cabin" / "config.toml";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && *home != '\0') {
+    return fs::path(home) / ".config" / "cabin" / "config.toml";
+  }
+  return {};
+}
+
+static fs::path snapshotPath() {
+  if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+      xdgCacheHome != nullptr && *xdgCacheHome != '\0') {
+    return fs::path(xdgCacheHome) / "cabin" / "config-cache.json";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && *home != '\0') {
+    return fs::path(home) / ".cache" / "cabin" / "config-cache.json";
+  }
+  return {};
+}
+
+namespace {
+
+struct ConfigData {
+  std::vector<std::pair<std::string, std::string>> gitRewrites;
+  std::string registryUrl;
+  std::size_t defaultJobs = 0;
+  std::string cacheRemote;
+};
+
+} // namespace
+
+// Longer prefixes win so a rewrite for one organization can shadow a
+// blanket host rewrite.
+static void sortRewrites(ConfigData& data) {
+  std::ranges::stable_sort(data.gitRewrites,
+                           [](const auto& lhs, const auto& rhs) {
+                             return lhs.first.size() > rhs.first.size();
+                           });
+}
+
+static std::optional<ConfigData> loadSnapshot(const fs::path& path,
+                                              const std::uintmax_t size,
+                                              const std::int64_t mtime) {
+  const auto mapped = MappedFile::open(path);
+  if (mapped.is_err()) {
+    return std::nullopt;
+  }
+  try {
+    const nlohmann::json snap = nlohmann::json::parse(mapped.unwrap().view());
+    if (!snap.is_object() || snap.value("version", 0) != 1
+        || snap.value("size", std::uintmax_t{ 0 }) != size
+        || snap.value("mtime", std::int64_t{ 0 }) != mtime) {
+      return std::nullopt;
+    }
+    ConfigData data;
+    for (const nlohmann::json& rewrite : snap.at("git-rewrites")) {
+      data.gitRewrites.emplace_back(rewrite.at(0).get<std::string>(),
+                                    rewrite.at(1).get<std::string>());
+    }
+    data.registryUrl = snap.at("registry-url").get<std::string>();
+    data.defaultJobs = snap.at("jobs").get<std::size_t>();
+    data.cacheRemote = snap.at("cache-remote").get<std::string>();
+    return data;
+  } catch (const std::exception& e) {
+    spdlog::debug("discarding global config snapshot: {}", e.what());
+    return std::nullopt;
+  }
+}
+
+static void saveSnapshot(const fs::path& path, const std::uintmax_t size,
+                         const std::int64_t mtime, const ConfigData& data) {
+  try {
+    nlohmann::json snap;
+    snap["version"] = 1;
+    snap["size"] = size;
+    snap["mtime"] = mtime;
+    snap["git-rewrites"] = nlohmann::json::array();
+    for (const auto& [from, to] : data.gitRewrites) {
+      snap["git-rewrites"].push_back({ from, to });
+    }
+    snap["registry-url"] = data.registryUrl;
+    snap["jobs"] = data.defaultJobs;
+    snap["cache-remote"] = data.cacheRemote;
+
+    fs::create_directories(path.parent_path());
+    writeFileAtomic(path, snap.dump());
+  } catch (const std::exception& e) {
+    spdlog::debug("failed to save global config snapshot: {}", e.what());
+  }
+}
+
+static ConfigData parseConfig(const toml::value& val) {
+  ConfigData data;
+  if (val.contains("git") && val.at("git").contains("rewrite")) {
+    for (const auto& entry : val.at("git").at("rewrite").as_table()) {
+      data.gitRewrites.emplace_back(entry.first,
+                                    entry.second.as_string());
+    }
+  }
+  data.registryUrl =
+      toml::find_or<std::string>(val, "registry", "url", "");
+  data.defaultJobs = toml::find_or<std::size_t>(val, "build", "jobs", 0);
+  data.cacheRemote = toml::find_or<std::string>(val, "cache", "remote", "");
+  sortRewrites(data);
+  return data;
+}
+
+static ConfigData loadConfig() {
+  const fs::path path = configPath();
+  if (path.empty()) {
+    return {};
+  }
+
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(path, ec);
+  if (ec) {
+    return {}; // no config file: all defaults
+  }
+  const std::int64_t mtime =
+      fs::last_write_time(path, ec).time_since_epoch().count();
+  if (ec) {
+    return {};
+  }
+
+  const fs::path snapFile = snapshotPath();
+  if (!snapFile.empty()) {
+    if (std::optional<ConfigData> snapshot =
+            loadSnapshot(snapFile, size, mtime)) {
+      return std::move(*snapshot);
+    }
+  }
+
+  ConfigData data;
+  try {
+    data = parseConfig(toml::parse(path));
+  } catch (const std::exception& e) {
+    spdlog::warn("ignoring invalid {}: {}", path.string(), e.what());
+    return {};
+  }
+  if (!snapFile.empty()) {
+    saveSnapshot(snapFile, size, mtime, data);
+  }
+  return data;
+}
+
+GlobalConfig::GlobalConfig() noexcept {
+  try {
+    ConfigData data = loadConfig();
+    gitRewrites_ = std::move(data.gitRewrites);
+    registryUrl_ = std::move(data.registryUrl);
+    defaultJobs_ = data.defaultJobs;
+    cacheRemote_ = std::move(data.cacheRemote);
+  } catch (const std::exception& e) {
+    spdlog::debug("global config unavailable: {}", e.what());
+  }
+}
+
+const GlobalConfig& GlobalConfig::instance() noexcept {
+  static const GlobalConfig instance;
+  return instance;
+}
+
+std::string GlobalConfig::rewriteGitUrl(const std::string_view url) const
+    noexcept {
+  for (const auto& [from, to] : gitRewrites_) {
+    if (url.starts_with(from)) {
+      return to + std::string(url.substr(from.size()));
+    }
+  }
+  return std::string(url);
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <rs/tests.hpp>
+
+namespace cabin {
+
+static void testRewriteLongestPrefixWins() {
+  ConfigData data;
+  data.gitRewrites.emplace_back("https://github.com/",
+                                "https://mirror.corp/github/");
+  data.gitRewrites.emplace_back("https://github.com/acme/",
+                                "ssh://git.corp/acme/");
+  sortRewrites(data);
+
+  rs::assertEq(data.gitRewrites.front().first, "https://github.com/acme/");
+  rs::pass();
+}
+
+static void testParseConfig() {
+  const toml::value val = R"(
+    [registry]
+    url = "https://registry.corp/v1/graphql"
+
+    [git.rewrite]
+    "https://github.com/" = "https://mirror.corp/github/"
+
+    [build]
+    jobs = 8
+
+    [cache]
+    remote = "https://cache.corp"
+  )"_toml;
+
+  const ConfigData data = parseConfig(val);
+  rs::assertEq(data.registryUrl, "https://registry.corp/v1/graphql");
+  rs::assertEq(data.defaultJobs, 8UL);
+  rs::assertEq(data.cacheRemote, "https://cache.corp");
+  rs::assertEq(data.gitRewrites.size(), 1UL);
+  rs::assertEq(data.gitRewrites.front().second,
+               "https://mirror.corp/github/");
+  rs::pass();
+}
+
+} // namespace cabin
+
+int main() {
+  cabin::testRewriteLongestPrefixWins();
+  cabin::testParseConfig();
+}
+
+#endif
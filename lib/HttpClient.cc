@@ -0,0 +1,148 @@
+#include "HttpClient.hpp"
+
+#include <cstddef>
+#include <curl/curl.h>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+HttpClient& HttpClient::instance() noexcept {
+  // Function-local static: the connection pool outlives every caller and
+  // is torn down at process exit.
+  static HttpClient client;
+  return client;
+}
+
+HttpClient::HttpClient() noexcept {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  multi = curl_multi_init();
+  if (multi != nullptr) {
+    // Prefer one connection per host with multiplexed HTTP/2 streams.
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  }
+}
+
+HttpClient::~HttpClient() {
+  if (multi != nullptr) {
+    curl_multi_cleanup(multi);
+  }
+  curl_global_cleanup();
+}
+
+static std::size_t writeToString(const void* contents, const std::size_t size,
+                                 const std::size_t nmemb, std::string* out) {
+  out->append(static_cast<const char*>(contents), size * nmemb);
+  return size * nmemb;
+}
+
+rs::Result<std::vector<std::string>>
+HttpClient::performAll(const std::span<const HttpRequest> requests) noexcept {
+  rs_ensure(multi != nullptr, "curl_multi_init() failed");
+  std::vector<std::string> responses(requests.size());
+  if (requests.empty()) {
+    return rs::Ok(std::move(responses));
+  }
+
+  std::vector<CURL*> handles(requests.size(), nullptr);
+  std::vector<curl_slist*> headers(requests.size(), nullptr);
+  std::vector<std::string> errors;
+
+  for (std::size_t i = 0; i < requests.size(); ++i) {
+    const HttpRequest& req = requests[i];
+    CURL* easy = curl_easy_init();
+    if (easy == nullptr) {
+      errors.emplace_back("curl_easy_init() failed");
+      continue;
+    }
+    curl_easy_setopt(easy, CURLOPT_URL, req.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeToString);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &responses[i]);
+    // "" advertises every encoding curl was built with (gzip, br, zstd,
+    // ...) and decodes transparently.
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    // Wait for an existing connection instead of opening a new one, so
+    // sibling requests share one multiplexed connection.
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    if (!req.body.empty()) {
+      curl_easy_setopt(easy, CURLOPT_POST, 1L);
+      curl_easy_setopt(easy, CURLOPT_POSTFIELDS, req.body.c_str());
+      curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(req.body.size()));
+      headers[i] = curl_slist_append(
+          nullptr, fmt::format("Content-Type: {}", req.contentType).c_str());
+      curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers[i]);
+    }
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &requests[i]);
+    curl_multi_add_handle(multi, easy);
+    handles[i] = easy;
+  }
+
+  int running = 0;
+  do {
+    CURLMcode mc = curl_multi_perform(multi, &running);
+    if (mc == CURLM_OK && running > 0) {
+      mc = curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+    if (mc != CURLM_OK) {
+      errors.emplace_back(curl_multi_strerror(mc));
+      break;
+    }
+
+    int msgsLeft = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &msgsLeft)) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
+      if (msg->data.result != CURLE_OK) {
+        const HttpRequest* req = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &req);
+        if (req->allowFailure) {
+          responses[static_cast<std::size_t>(req - requests.data())].clear();
+        } else {
+          errors.push_back(fmt::format("failed to fetch {}: {}", req->url,
+                                       curl_easy_strerror(msg->data.result)));
+        }
+      }
+
+      for (CURL*& handle : handles) {
+        if (handle == msg->easy_handle) {
+          handle = nullptr;
+          break;
+        }
+      }
+      // Removing the handle returns its connection to the multi's pool;
+      // cleaning it up does not close the connection.
+      curl_multi_remove_handle(multi, msg->easy_handle);
+      curl_easy_cleanup(msg->easy_handle);
+    }
+  } while (running > 0);
+
+  for (CURL* handle : handles) {
+    if (handle != nullptr) {
+      curl_multi_remove_handle(multi, handle);
+      curl_easy_cleanup(handle);
+    }
+  }
+  for (curl_slist* header : headers) {
+    if (header != nullptr) {
+      curl_slist_free_all(header);
+    }
+  }
+
+  rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+  return rs::Ok(std::move(responses));
+}
+
+rs::Result<std::string> HttpClient::perform(const HttpRequest& req) noexcept {
+  auto responses = rs_try(performAll({ &req, 1 }));
+  return rs::Ok(std::move(responses.front()));
+}
+
+} // namespace cabin
@@ -0,0 +1,156 @@
+#include "Lockfile.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+#include <toml.hpp>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+rs::Result<Lockfile> Lockfile::load(const fs::path& baseDir) noexcept {
+  Lockfile lockfile(baseDir / FILE_NAME);
+  if (!fs::exists(lockfile.path)) {
+    return rs::Ok(std::move(lockfile));
+  }
+
+  try {
+    const toml::value val = toml::parse(lockfile.path);
+    for (const toml::value& pkg : toml::find_or<std::vector<toml::value>>(
+             val, "package", std::vector<toml::value>{})) {
+      Entry entry;
+      entry.name = toml::find<std::string>(pkg, "name");
+      entry.url = toml::find<std::string>(pkg, "url");
+      if (pkg.contains("target")) {
+        entry.target = toml::find<std::string>(pkg, "target");
+      }
+      entry.rev = toml::find<std::string>(pkg, "rev");
+      lockfile.entries.emplace_back(std::move(entry));
+    }
+  } catch (const std::exception& e) {
+    rs_bail("failed to parse {}: {}", lockfile.path.string(), e.what());
+  }
+  return rs::Ok(std::move(lockfile));
+}
+
+std::optional<std::string>
+Lockfile::lookup(const std::string& name, const std::string& url,
+                 const std::optional<std::string>& target) const noexcept {
+  // Linear scan: projects have a handful of dependencies, not thousands.
+  for (const Entry& entry : entries) {
+    if (entry.name == name && entry.url == url && entry.target == target) {
+      return entry.rev;
+    }
+  }
+  return std::nullopt;
+}
+
+void Lockfile::record(Entry entry) noexcept {
+  const auto it = std::ranges::find_if(entries, [&entry](const Entry& e) {
+    return e.name == entry.name && e.url == entry.url
+           && e.target == entry.target;
+  });
+  if (it != entries.end()) {
+    if (it->rev == entry.rev) {
+      return;
+    }
+    *it = std::move(entry);
+  } else {
+    entries.emplace_back(std::move(entry));
+  }
+  dirty = true;
+}
+
+rs::Result<void> Lockfile::save() const noexcept {
+  if (!dirty) {
+    return rs::Ok();
+  }
+
+  // Sort for a deterministic file so the lock diffs cleanly in VCS.
+  std::vector<Entry> sorted = entries;
+  std::ranges::sort(sorted, {}, &Entry::name);
+
+  std::string out = "# This file is automatically generated by cabin.\n"
+                    "version = 1\n";
+  for (const Entry& entry : sorted) {
+    out += fmt::format("\n[[package]]\nname = \"{}\"\nurl = \"{}\"\n",
+                       entry.name, entry.url);
+    if (entry.target.has_value()) {
+      out += fmt::format("target = \"{}\"\n", entry.target.value());
+    }
+    out += fmt::format("rev = \"{}\"\n", entry.rev);
+  }
+
+  std::ofstream ofs(path, std::ios::trunc);
+  rs_ensure(ofs.is_open(), "failed to open {}", path.string());
+  ofs << out;
+  return rs::Ok();
+}
+
+} // namespace cabin
+
+#ifdef CABIN_TEST
+
+#  include <rs/tests.hpp>
+#  include <unistd.h>
+
+using namespace cabin; // NOLINT(build/namespaces,google-build-using-namespace)
+
+static void testRecordAndLookup() {
+  Lockfile lockfile =
+      Lockfile::load(fs::temp_directory_path() / "cabin-lock-none").unwrap();
+
+  rs::assertFalse(lockfile.lookup("dep", "url", std::nullopt).has_value());
+
+  lockfile.record({ .name = "dep",
+                    .url = "url",
+                    .target = std::nullopt,
+                    .rev = "aaaa" });
+  rs::assertEq(lockfile.lookup("dep", "url", std::nullopt).value(), "aaaa");
+  // A different target is a different lock entry.
+  rs::assertFalse(lockfile.lookup("dep", "url", "v1").has_value());
+
+  // Re-recording replaces the stale entry instead of duplicating it.
+  lockfile.record({ .name = "dep",
+                    .url = "url",
+                    .target = std::nullopt,
+                    .rev = "bbbb" });
+  rs::assertEq(lockfile.lookup("dep", "url", std::nullopt).value(), "bbbb");
+
+  rs::pass();
+}
+
+static void testSaveLoadRoundtrip() {
+  const fs::path dir =
+      fs::temp_directory_path() / fmt::format("cabin-lock-{}", ::getpid());
+  fs::create_directories(dir);
+
+  Lockfile lockfile = Lockfile::load(dir).unwrap();
+  lockfile.record(
+      { .name = "foo", .url = "https://x/foo.git", .target = "v1", .rev = "a" });
+  lockfile.record({ .name = "bar",
+                    .url = "https://x/bar.git",
+                    .target = std::nullopt,
+                    .rev = "b" });
+  lockfile.save().unwrap();
+
+  const Lockfile reloaded = Lockfile::load(dir).unwrap();
+  rs::assertEq(reloaded.lookup("foo", "https://x/foo.git", "v1").value(), "a");
+  rs::assertEq(
+      reloaded.lookup("bar", "https://x/bar.git", std::nullopt).value(), "b");
+  rs::assertFalse(reloaded.lookup("foo", "https://x/foo.git", std::nullopt)
+                      .has_value());
+
+  fs::remove_all(dir);
+  rs::pass();
+}
+
+int main() {
+  testRecordAndLookup();
+  testSaveLoadRoundtrip();
+}
+
+#endif
@@ -1,18 +1,30 @@
 #include "Manifest.hpp"
 
+#include "Algos.hpp"
 #include "Builder/BuildProfile.hpp"
 #include "Builder/Builder.hpp"
 #include "Builder/Compiler.hpp"
+#include "Builder/ScanCache.hpp"
+#include "CacheFile.hpp"
 #include "Diag.hpp"
+#include "Lockfile.hpp"
+#include "Parallelism.hpp"
+#include "Profile.hpp"
 #include "Semver.hpp"
 #include "TermColor.hpp"
 #include "VersionReq.hpp"
 
+#include <array>
 #include <cctype>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <optional>
 #include <ranges>
 #include <rs/result.hpp>
@@ -20,10 +32,14 @@
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
 #include <toml.hpp>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace toml {
@@ -76,7 +92,7 @@ struct Overloaded : Ts... {
 template <typename... Ts>
 Overloaded(Ts...) -> Overloaded<Ts...>;
 
-enum class DepKind : std::uint8_t { Git, Path, System };
+enum class DepKind : std::uint8_t { Git, Tarball, Path, System };
 
 struct DepKey {
   DepKind kind;
@@ -108,32 +124,22 @@ static rs::Result<void>
 installDependencies(const Manifest& manifest, const BuildProfile& buildProfile,
                     bool includeDevDeps, bool suppressDepDiag,
                     std::unordered_map<std::string, DepKey>& seenDeps,
-                    std::unordered_set<fs::path>& visited,
+                    std::unordered_set<fs::path>& visited, Lockfile& lockfile,
                     std::vector<CompilerOpts>& installed);
 
-static rs::Result<void>
-installPathDependency(const Manifest& manifest, const PathDependency& pathDep,
-                      const BuildProfile& buildProfile, bool includeDevDeps,
-                      bool suppressDepDiag,
-                      std::unordered_map<std::string, DepKey>& seenDeps,
-                      std::unordered_set<fs::path>& visited,
-                      std::vector<CompilerOpts>& installed) {
-  const fs::path basePath = manifest.path.parent_path();
-  const fs::path depRoot = canonicalizePathDep(basePath, pathDep.path);
-
-  rs_ensure(fs::exists(depRoot) && fs::is_directory(depRoot),
-            "{} can't be accessible as directory", depRoot.string());
-  if (!visited.insert(depRoot).second) {
-    return rs::Ok();
-  }
-
-  CompilerOpts pathOpts;
-  const fs::path depManifestPath = depRoot / Manifest::FILE_NAME;
-  rs_ensure(fs::exists(depManifestPath), "missing `{}` in path dependency {}",
-            Manifest::FILE_NAME, depRoot.string());
-  const Manifest depManifest =
-      rs_try(Manifest::tryParse(depManifestPath, false));
-
+// Builds the cabin package rooted at `depRoot` through its own Builder and
+// returns CompilerOpts exposing its include directory, its static library
+// (when it has one), and its transitive dependencies.  Both path and git
+// dependencies funnel through here; for git dependencies `depRoot` lives in
+// the shared cache, so the package is built once per machine, not once per
+// consumer.
+static rs::Result<CompilerOpts>
+buildDepPackageUncached(const fs::path& depRoot, const Manifest& depManifest,
+                        const BuildProfile& buildProfile,
+                        const bool includeDevDeps, const bool suppressDepDiag,
+                        std::unordered_map<std::string, DepKey>& seenDeps,
+                        std::unordered_set<fs::path>& visited,
+                        Lockfile& lockfile) {
   if (!suppressDepDiag) {
     Diag::info("Building", "{} ({})", depManifest.package.name,
                depRoot.string());
@@ -152,14 +158,16 @@ installPathDependency(const Manifest& manifest, const PathDependency& pathDep,
   const fs::path depOutDir = depGraph.outBasePath();
   const fs::path libPath = depOutDir / depGraph.libraryName();
 
-  pathOpts.cFlags.includeDirs.emplace_back(resolveIncludeDir(depRoot),
-                                           /*isSystem=*/false);
+  CompilerOpts depOpts;
+  depOpts.cFlags.includeDirs.emplace_back(resolveIncludeDir(depRoot),
+                                          /*isSystem=*/false);
 
   std::vector<CompilerOpts> nestedDeps;
   rs_try(installDependencies(depManifest, buildProfile, includeDevDeps,
-                             suppressDepDiag, seenDeps, visited, nestedDeps));
+                             suppressDepDiag, seenDeps, visited, lockfile,
+                             nestedDeps));
   for (const CompilerOpts& opts : nestedDeps) {
-    pathOpts.merge(opts);
+    depOpts.merge(opts);
   }
 
   const bool libBuilt = fs::exists(libPath);
@@ -169,18 +177,100 @@ installPathDependency(const Manifest& manifest, const PathDependency& pathDep,
   }
 
   if (libBuilt) {
-    pathOpts.ldFlags.libDirs.emplace(pathOpts.ldFlags.libDirs.begin(),
-                                     libPath.parent_path());
+    depOpts.ldFlags.libDirs.emplace(depOpts.ldFlags.libDirs.begin(),
+                                    libPath.parent_path());
 
     std::string libName = libPath.stem().string();
     if (libName.starts_with("lib")) {
       libName.erase(0, 3);
     }
-    pathOpts.ldFlags.libs.emplace(pathOpts.ldFlags.libs.begin(),
-                                  std::move(libName));
+    depOpts.ldFlags.libs.emplace(depOpts.ldFlags.libs.begin(),
+                                 std::move(libName));
   }
 
-  installed.emplace_back(std::move(pathOpts));
+  return rs::Ok(std::move(depOpts));
+}
+
+// Invocation-wide dedup in front of buildDepPackageUncached: several
+// consumers in one process (workspace members, possibly building in
+// parallel waves) often share the same path or git dependency.  The
+// first consumer builds it while later ones block on the entry and then
+// reuse its CompilerOpts — without this, each consumer re-plans the dep
+// and two parallel members could race inside its out directory.
+static rs::Result<CompilerOpts>
+buildDepPackage(const fs::path& depRoot, const Manifest& depManifest,
+                const BuildProfile& buildProfile, const bool includeDevDeps,
+                const bool suppressDepDiag,
+                std::unordered_map<std::string, DepKey>& seenDeps,
+                std::unordered_set<fs::path>& visited, Lockfile& lockfile) {
+  struct Entry {
+    std::mutex mutex;
+    std::optional<CompilerOpts> opts;
+    std::string error;
+    bool done = false;
+  };
+  static std::mutex registryMutex;
+  static std::unordered_map<std::string, std::shared_ptr<Entry>> registry;
+
+  const std::string key =
+      fmt::format("{}\x1f{}", depRoot.generic_string(), buildProfile);
+  std::shared_ptr<Entry> entry;
+  {
+    const std::scoped_lock lock(registryMutex);
+    std::shared_ptr<Entry>& slot = registry[key];
+    if (!slot) {
+      slot = std::make_shared<Entry>();
+    }
+    entry = slot;
+  }
+
+  const std::scoped_lock lock(entry->mutex);
+  if (entry->done) {
+    if (entry->opts.has_value()) {
+      spdlog::debug("{} already built this invocation", depRoot.string());
+      return rs::Ok(*entry->opts);
+    }
+    rs_bail("{}", entry->error);
+  }
+
+  auto result =
+      buildDepPackageUncached(depRoot, depManifest, buildProfile,
+                              includeDevDeps, suppressDepDiag, seenDeps,
+                              visited, lockfile);
+  entry->done = true;
+  if (result.is_err()) {
+    entry->error = result.unwrap_err()->what();
+    rs_bail("{}", entry->error);
+  }
+  entry->opts = result.unwrap();
+  return rs::Ok(*entry->opts);
+}
+
+static rs::Result<void>
+installPathDependency(const Manifest& manifest, const PathDependency& pathDep,
+                      const BuildProfile& buildProfile, bool includeDevDeps,
+                      bool suppressDepDiag,
+                      std::unordered_map<std::string, DepKey>& seenDeps,
+                      std::unordered_set<fs::path>& visited, Lockfile& lockfile,
+                      std::vector<CompilerOpts>& installed) {
+  const fs::path basePath = manifest.path.parent_path();
+  const fs::path depRoot = canonicalizePathDep(basePath, pathDep.path);
+
+  rs_ensure(fs::exists(depRoot) && fs::is_directory(depRoot),
+            "{} can't be accessible as directory", depRoot.string());
+  if (!visited.insert(depRoot).second) {
+    return rs::Ok();
+  }
+
+  const fs::path depManifestPath = depRoot / Manifest::FILE_NAME;
+  rs_ensure(fs::exists(depManifestPath), "missing `{}` in path dependency {}",
+            Manifest::FILE_NAME, depRoot.string());
+  const Manifest depManifest =
+      rs_try(Manifest::tryParse(depManifestPath, false));
+
+  installed.emplace_back(rs_try(
+      buildDepPackage(depRoot, depManifest, buildProfile, includeDevDeps,
+                      suppressDepDiag, seenDeps, visited, lockfile)));
   return rs::Ok();
 }
 
@@ -196,6 +286,9 @@ static DepKey makeDepKey(const Manifest& manifest, const Dependency& dep) {
             }
             return DepKey{ .kind = DepKind::Git, .detail = std::move(detail) };
           },
+          [&](const TarballDependency& tarDep) -> DepKey {
+            return DepKey{ .kind = DepKind::Tarball, .detail = tarDep.url };
+          },
           [&](const SystemDependency& sysDep) -> DepKey {
             return DepKey{ .kind = DepKind::System,
                            .detail = sysDep.versionReq.toString() };
@@ -215,6 +308,9 @@ static const std::string& depName(const Dependency& dep) {
           [](const GitDependency& gitDep) -> const std::string& {
             return gitDep.name;
           },
+          [](const TarballDependency& tarDep) -> const std::string& {
+            return tarDep.name;
+          },
           [](const SystemDependency& sysDep) -> const std::string& {
             return sysDep.name;
           },
@@ -240,35 +336,78 @@ rememberDep(const Manifest& manifest, const Dependency& dep,
   rs_bail("dependency `{}` conflicts across manifests", name);
 }
 
+// A locked git dependency is re-targeted at its recorded OID, so its
+// freshness check is a directory-existence test and branch heads never
+// move underneath us.
+static GitDependency applyLock(const Lockfile& lockfile,
+                               const GitDependency& gitDep) {
+  std::optional<std::string> rev =
+      lockfile.lookup(gitDep.name, gitDep.url, gitDep.target);
+  if (!rev.has_value()) {
+    return gitDep;
+  }
+  return GitDependency(gitDep.name, gitDep.url, std::move(rev));
+}
+
 static rs::Result<void>
 installDependencies(const Manifest& manifest, const BuildProfile& buildProfile,
                     const bool includeDevDeps, const bool suppressDepDiag,
                     std::unordered_map<std::string, DepKey>& seenDeps,
-                    std::unordered_set<fs::path>& visited,
+                    std::unordered_set<fs::path>& visited, Lockfile& lockfile,
                     std::vector<CompilerOpts>& installed) {
   const auto installOne = [&](const Dependency& dep) -> rs::Result<void> {
     rs_try(rememberDep(manifest, dep, seenDeps));
     return std::visit(
         Overloaded{
             [&](const GitDependency& gitDep) -> rs::Result<void> {
-              CompilerOpts depOpts = rs_try(gitDep.install());
+              const bool wasLocked =
+                  lockfile.lookup(gitDep.name, gitDep.url, gitDep.target)
+                      .has_value();
+              const GitDependency locked = applyLock(lockfile, gitDep);
+              rs_try(locked.fetch());
+              if (!wasLocked) {
+                lockfile.record({ .name = gitDep.name,
+                                  .url = gitDep.url,
+                                  .target = gitDep.target,
+                                  .rev = rs_try(locked.resolvedOid()) });
+              }
 
-              const fs::path depManifestPath =
-                  gitDep.installDir() / Manifest::FILE_NAME;
+              const fs::path depRoot = locked.installDir();
+              const fs::path depManifestPath = depRoot / Manifest::FILE_NAME;
               if (fs::exists(depManifestPath)) {
-                const Manifest depManifest =
-                    rs_try(Manifest::tryParse(depManifestPath, false));
+                // A git dependency that is itself a cabin package is built
+                // into the shared cache and linked like a path dependency.
+                if (visited.insert(depRoot).second) {
+                  const Manifest depManifest =
+                      rs_try(Manifest::tryParse(depManifestPath, false));
+                  installed.emplace_back(rs_try(buildDepPackage(
+                      depRoot, depManifest, buildProfile, includeDevDeps,
+                      suppressDepDiag, seenDeps, visited, lockfile)));
+                }
+                return rs::Ok();
+              }
 
-                std::vector<CompilerOpts> nestedDeps;
-                rs_try(installDependencies(depManifest, buildProfile,
-                                           includeDevDeps, suppressDepDiag,
-                                           seenDeps, visited, nestedDeps));
-                for (const CompilerOpts& opts : nestedDeps) {
-                  depOpts.merge(opts);
+              // Header-only dependency: just expose its include directory.
+              installed.emplace_back(rs_try(locked.install()));
+              return rs::Ok();
+            },
+            [&](const TarballDependency& tarDep) -> rs::Result<void> {
+              rs_try(tarDep.fetch());
+
+              const fs::path depRoot = tarDep.installDir();
+              const fs::path depManifestPath = depRoot / Manifest::FILE_NAME;
+              if (fs::exists(depManifestPath)) {
+                if (visited.insert(depRoot).second) {
+                  const Manifest depManifest =
+                      rs_try(Manifest::tryParse(depManifestPath, false));
+                  installed.emplace_back(rs_try(buildDepPackage(
+                      depRoot, depManifest, buildProfile, includeDevDeps,
+                      suppressDepDiag, seenDeps, visited, lockfile)));
                 }
+                return rs::Ok();
               }
 
-              installed.emplace_back(std::move(depOpts));
+              installed.emplace_back(rs_try(tarDep.install()));
               return rs::Ok();
             },
             [&](const SystemDependency& sysDep) -> rs::Result<void> {
@@ -278,16 +417,61 @@ installDependencies(const Manifest& manifest, const BuildProfile& buildProfile,
             [&](const PathDependency& pathDep) -> rs::Result<void> {
               return installPathDependency(manifest, pathDep, buildProfile,
                                            includeDevDeps, suppressDepDiag,
-                                           seenDeps, visited, installed);
+                                           seenDeps, visited, lockfile,
+                                           installed);
             },
         },
         dep);
   };
 
+  const bool installDevDeps =
+      includeDevDeps && manifest.path == Manifest::tryParse().unwrap().path;
+
+  // First-time setup is dominated by serial clone latency.  Fetch the
+  // missing git checkouts in parallel up front — they write distinct
+  // directories and hold per-directory locks — so the sequential install
+  // below runs over warm directories.
+  std::vector<GitDependency> toFetch;
+  std::vector<TarballDependency> tarballs;
+  const auto collectColdGitDeps = [&](const std::vector<Dependency>& deps) {
+    for (const Dependency& dep : deps) {
+      if (const auto* gitDep = std::get_if<GitDependency>(&dep)) {
+        GitDependency locked = applyLock(lockfile, *gitDep);
+        const fs::path dir = locked.installDir();
+        if (!fs::exists(dir) || fs::is_empty(dir)) {
+          toFetch.push_back(std::move(locked));
+        }
+      } else if (const auto* tarDep = std::get_if<TarballDependency>(&dep)) {
+        tarballs.push_back(*tarDep);
+      }
+    }
+  };
+  collectColdGitDeps(manifest.dependencies);
+  if (installDevDeps) {
+    collectColdGitDeps(manifest.devDependencies);
+  }
+  // Tarballs download over one multiplexed HTTP session; fetchAll skips
+  // the warm ones itself.
+  rs_try(TarballDependency::fetchAll(tarballs));
+  if (toFetch.size() > 1 && isParallel()) {
+    tbb::concurrent_vector<std::string> errors;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, toFetch.size()),
+                      [&](const tbb::blocked_range<std::size_t>& rng) {
+                        for (std::size_t i = rng.begin(); i != rng.end();
+                             ++i) {
+                          auto result = toFetch[i].fetch();
+                          if (result.is_err()) {
+                            errors.push_back(result.unwrap_err()->what());
+                          }
+                        }
+                      });
+    rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+  }
+
   for (const auto& dep : manifest.dependencies) {
     rs_try(installOne(dep));
   }
-  if (includeDevDeps && manifest.path == Manifest::tryParse().unwrap().path) {
+  if (installDevDeps) {
     for (const auto& dep : manifest.devDependencies) {
       rs_try(installOne(dep));
     }
@@ -323,8 +507,24 @@ rs::Result<Package> Package::tryFromToml(const toml::value& val) noexcept {
       rs_try(toml::try_find<std::string>(val, "package", "edition"))));
   auto version = rs_try(Version::parse(
       rs_try(toml::try_find<std::string>(val, "package", "version"))));
-  return rs::Ok(
-      Package(std::move(name), std::move(edition), std::move(version)));
+
+  const auto libTypeStr =
+      toml::find_or<std::string>(val, "package", "lib-type", "static");
+  LibType libType = LibType::Static;
+  if (libTypeStr == "shared") {
+    libType = LibType::Shared;
+  } else {
+    rs_ensure(libTypeStr == "static",
+              "lib-type must be either `static` or `shared`");
+  }
+
+  // Tests that need isolation (shared ports, fixtures on disk, ...) can
+  // pin the number of concurrently running test processes.
+  const auto testThreads =
+      toml::find_or<std::size_t>(val, "package", "test-threads", 0);
+
+  return rs::Ok(Package(std::move(name), std::move(edition), std::move(version),
+                        libType, testThreads));
 }
 
 static rs::Result<std::uint8_t>
@@ -373,14 +573,18 @@ struct BaseProfile {
   const std::vector<std::string> ldflags;
   const bool lto;
   const mitama::maybe<bool> debug;
+  const bool splitDebugInfo;
   const mitama::maybe<std::uint8_t> optLevel;
+  const std::vector<std::string> pch;
 
   BaseProfile(std::vector<std::string> cxxflags,
               std::vector<std::string> ldflags, const bool lto,
-              const mitama::maybe<bool> debug,
-              const mitama::maybe<std::uint8_t> optLevel) noexcept
+              const mitama::maybe<bool> debug, const bool splitDebugInfo,
+              const mitama::maybe<std::uint8_t> optLevel,
+              std::vector<std::string> pch) noexcept
       : cxxflags(std::move(cxxflags)), ldflags(std::move(ldflags)), lto(lto),
-        debug(debug), optLevel(optLevel) {}
+        debug(debug), splitDebugInfo(splitDebugInfo), optLevel(optLevel),
+        pch(std::move(pch)) {}
 };
 
 static rs::Result<BaseProfile>
@@ -394,11 +598,15 @@ parseBaseProfile(const toml::value& val) noexcept {
   const bool lto = toml::try_find<bool>(val, "profile", "lto").unwrap_or(false);
   const mitama::maybe debug =
       toml::try_find<bool>(val, "profile", "debug").ok();
+  const bool splitDebugInfo =
+      toml::try_find<bool>(val, "profile", "split-debuginfo").unwrap_or(false);
   const mitama::maybe optLevel =
       toml::try_find<std::uint8_t>(val, "profile", "opt-level").ok();
+  auto pch =
+      toml::find_or_default<std::vector<std::string>>(val, "profile", "pch");
 
   return rs::Ok(BaseProfile(std::move(cxxflags), std::move(ldflags), lto, debug,
-                            optLevel));
+                            splitDebugInfo, optLevel, std::move(pch)));
 }
 
 static rs::Result<Profile>
@@ -416,11 +624,15 @@ parseDevProfile(const toml::value& val,
       toml::find_or<bool>(val, "profile", key, "lto", baseProfile.lto);
   const auto debug = toml::find_or<bool>(val, "profile", key, "debug",
                                          baseProfile.debug.unwrap_or(true));
+  const auto splitDebugInfo = toml::find_or<bool>(
+      val, "profile", key, "split-debuginfo", baseProfile.splitDebugInfo);
   const auto optLevel = rs_try(validateOptLevel(toml::find_or<std::uint8_t>(
       val, "profile", key, "opt-level", baseProfile.optLevel.unwrap_or(0))));
+  auto pch = toml::find_or<std::vector<std::string>>(val, "profile", key, "pch",
+                                                     baseProfile.pch);
 
-  return rs::Ok(
-      Profile(std::move(cxxflags), std::move(ldflags), lto, debug, optLevel));
+  return rs::Ok(Profile(std::move(cxxflags), std::move(ldflags), lto, debug,
+                        splitDebugInfo, optLevel, std::move(pch)));
 }
 
 static rs::Result<Profile>
@@ -438,11 +650,15 @@ parseReleaseProfile(const toml::value& val,
       toml::find_or<bool>(val, "profile", key, "lto", baseProfile.lto);
   const auto debug = toml::find_or<bool>(val, "profile", key, "debug",
                                          baseProfile.debug.unwrap_or(false));
+  const auto splitDebugInfo = toml::find_or<bool>(
+      val, "profile", key, "split-debuginfo", baseProfile.splitDebugInfo);
   const auto optLevel = rs_try(validateOptLevel(toml::find_or<std::uint8_t>(
       val, "profile", key, "opt-level", baseProfile.optLevel.unwrap_or(3))));
+  auto pch = toml::find_or<std::vector<std::string>>(val, "profile", key, "pch",
+                                                     baseProfile.pch);
 
-  return rs::Ok(
-      Profile(std::move(cxxflags), std::move(ldflags), lto, debug, optLevel));
+  return rs::Ok(Profile(std::move(cxxflags), std::move(ldflags), lto, debug,
+                        splitDebugInfo, optLevel, std::move(pch)));
 }
 
 enum class InheritMode : uint8_t {
@@ -502,11 +718,15 @@ parseTestProfile(const toml::value& val, const Profile& devProfile) noexcept {
       toml::find_or<bool>(val, "profile", key, "lto", devProfile.lto);
   const auto debug =
       toml::find_or<bool>(val, "profile", key, "debug", devProfile.debug);
+  const auto splitDebugInfo = toml::find_or<bool>(
+      val, "profile", key, "split-debuginfo", devProfile.splitDebugInfo);
   const auto optLevel = rs_try(validateOptLevel(toml::find_or<std::uint8_t>(
       val, "profile", key, "opt-level", devProfile.optLevel)));
+  auto pch = toml::find_or<std::vector<std::string>>(val, "profile", key, "pch",
+                                                     devProfile.pch);
 
-  return rs::Ok(
-      Profile(std::move(cxxflags), std::move(ldflags), lto, debug, optLevel));
+  return rs::Ok(Profile(std::move(cxxflags), std::move(ldflags), lto, debug,
+                        splitDebugInfo, optLevel, std::move(pch)));
 }
 
 static rs::Result<std::unordered_map<BuildProfile, Profile>>
@@ -522,6 +742,64 @@ parseProfiles(const toml::value& val) noexcept {
   return rs::Ok(profiles);
 }
 
+Profile ProfileOverride::applyTo(const Profile& base) const noexcept {
+  return Profile(cxxflags.value_or(base.cxxflags),
+                 ldflags.value_or(base.ldflags), lto.value_or(base.lto),
+                 debug.value_or(base.debug),
+                 splitDebugInfo.value_or(base.splitDebugInfo),
+                 optLevel.value_or(base.optLevel), pch.value_or(base.pch));
+}
+
+rs::Result<std::unordered_map<std::string, ProfileOverride>>
+ProfileOverride::mapFromToml(const toml::value& val,
+                             const std::string_view profileKey) noexcept {
+  const auto tables = toml::try_find<toml::table>(
+      val, "profile", std::string(profileKey), "package");
+  if (tables.is_err()) {
+    return rs::Ok(std::unordered_map<std::string, ProfileOverride>{});
+  }
+
+  std::unordered_map<std::string, ProfileOverride> overrides;
+  for (const auto& [name, entry] : tables.unwrap()) {
+    rs_ensure(entry.is_table(),
+              "[profile.{}.package.{}] must be a table", profileKey, name);
+    try {
+      ProfileOverride ov;
+      if (entry.contains("cxxflags")) {
+        ov.cxxflags = rs_try(validateFlags(
+            "cxxflags", toml::find<std::vector<std::string>>(entry,
+                                                             "cxxflags")));
+      }
+      if (entry.contains("ldflags")) {
+        ov.ldflags = rs_try(validateFlags(
+            "ldflags", toml::find<std::vector<std::string>>(entry,
+                                                            "ldflags")));
+      }
+      if (entry.contains("lto")) {
+        ov.lto = toml::find<bool>(entry, "lto");
+      }
+      if (entry.contains("debug")) {
+        ov.debug = toml::find<bool>(entry, "debug");
+      }
+      if (entry.contains("split-debuginfo")) {
+        ov.splitDebugInfo = toml::find<bool>(entry, "split-debuginfo");
+      }
+      if (entry.contains("opt-level")) {
+        ov.optLevel = rs_try(
+            validateOptLevel(toml::find<std::uint8_t>(entry, "opt-level")));
+      }
+      if (entry.contains("pch")) {
+        ov.pch = toml::find<std::vector<std::string>>(entry, "pch");
+      }
+      overrides.emplace(name, std::move(ov));
+    } catch (const std::exception& e) {
+      rs_bail("invalid [profile.{}.package.{}]: {}", profileKey, name,
+              e.what());
+    }
+  }
+  return rs::Ok(overrides);
+}
+
 rs::Result<Cpplint> Cpplint::tryFromToml(const toml::value& val) noexcept {
   auto filters = toml::find_or_default<std::vector<std::string>>(
       val, "lint", "cpplint", "filters");
@@ -533,6 +811,32 @@ rs::Result<Lint> Lint::tryFromToml(const toml::value& val) noexcept {
   return rs::Ok(Lint(std::move(cpplint)));
 }
 
+rs::Result<Build> Build::tryFromToml(const toml::value& val) noexcept {
+  auto wrapper = toml::find_or<std::string>(val, "build", "wrapper", "");
+  const auto remoteJobs =
+      toml::find_or<std::size_t>(val, "build", "remote-jobs", 0);
+  rs_ensure(remoteJobs == 0 || !wrapper.empty(),
+            "remote-jobs requires `wrapper` to be set");
+  const auto nice = toml::find_or<std::int64_t>(val, "build", "nice", 0);
+  rs_ensure(nice >= 0 && nice <= 19,
+            "build.nice must be between 0 and 19, got {}", nice);
+  auto ioClass = toml::find_or<std::string>(val, "build", "io-class", "");
+  rs_ensure(ioClass.empty() || ioClass == "idle" || ioClass == "best-effort",
+            "build.io-class must be `idle` or `best-effort`, got `{}`",
+            ioClass);
+  return rs::Ok(Build(std::move(wrapper), remoteJobs, nice,
+                      std::move(ioClass)));
+}
+
+rs::Result<Cache> Cache::tryFromToml(const toml::value& val) noexcept {
+  auto remote = toml::find_or<std::string>(val, "cache", "remote", "");
+  const auto upload = toml::find_or<bool>(val, "cache", "upload", true);
+  rs_ensure(remote.empty() || remote.starts_with("http://")
+                || remote.starts_with("https://"),
+            "cache.remote must be an http(s) URL");
+  return rs::Ok(Cache(std::move(remote), upload));
+}
+
 static rs::Result<void> validateDepName(const std::string_view name) noexcept {
   rs_ensure(!name.empty(), "dependency name must not be empty");
   rs_ensure(std::isalnum(name.front()),
@@ -610,6 +914,21 @@ static rs::Result<GitDependency> parseGitDep(const std::string& name,
   return rs::Ok(GitDependency(name, gitUrlStr, std::move(target)));
 }
 
+static rs::Result<TarballDependency>
+parseTarballDep(const std::string& name, const toml::table& info) noexcept {
+  rs_try(validateDepName(name));
+  const auto& url = info.at("tarball");
+  rs_ensure(url.is_string(), "tarball dependency must be a string");
+
+  std::optional<std::string> digest = std::nullopt;
+  if (info.contains("digest")) {
+    const auto& value = info.at("digest");
+    rs_ensure(value.is_string(), "tarball digest must be a string");
+    digest = value.as_string();
+  }
+  return rs::Ok(TarballDependency(name, url.as_string(), std::move(digest)));
+}
+
 static rs::Result<PathDependency>
 parsePathDep(const std::string& name, const toml::table& info) noexcept {
   rs_try(validateDepName(name));
@@ -643,6 +962,9 @@ parseDependencies(const toml::value& val, const char* key) noexcept {
       if (info.contains("git")) {
         deps.emplace_back(rs_try(parseGitDep(dep.first, info)));
         continue;
+      } else if (info.contains("tarball")) {
+        deps.emplace_back(rs_try(parseTarballDep(dep.first, info)));
+        continue;
       } else if (info.contains("system") && info.at("system").as_boolean()) {
         deps.emplace_back(rs_try(parseSystemDep(dep.first, info)));
         continue;
@@ -652,19 +974,278 @@ parseDependencies(const toml::value& val, const char* key) noexcept {
       }
     }
 
-    rs_bail("Only Git dependency, path dependency, and system dependency are "
+    rs_bail("Only Git, tarball, path, and system dependencies are "
             "supported for now: {}",
             dep.first);
   }
   return rs::Ok(deps);
 }
 
+// A JSON snapshot of the fully validated manifest, stored next to the
+// other caches under `cabin-out/` and keyed by the manifest file's size,
+// mtime, and content digest.  toml11's DOM allocates heavily and every
+// subcommand re-parses cabin.toml, so the warm path is one small file
+// read plus field-by-field reconstruction.
+static constexpr const char* MANIFEST_SNAPSHOT_FILE = "manifest-cache.json";
+
+static nlohmann::json depToJson(const Dependency& dep) {
+  return std::visit(
+      Overloaded{
+          [](const GitDependency& gitDep) -> nlohmann::json {
+            nlohmann::json json{ { "kind", "git" },
+                                 { "name", gitDep.name },
+                                 { "url", gitDep.url } };
+            if (gitDep.target.has_value()) {
+              json["target"] = gitDep.target.value();
+            }
+            return json;
+          },
+          [](const TarballDependency& tarDep) -> nlohmann::json {
+            nlohmann::json json{ { "kind", "tarball" },
+                                 { "name", tarDep.name },
+                                 { "url", tarDep.url } };
+            if (tarDep.digest.has_value()) {
+              json["digest"] = tarDep.digest.value();
+            }
+            return json;
+          },
+          [](const SystemDependency& sysDep) -> nlohmann::json {
+            return { { "kind", "system" },
+                     { "name", sysDep.name },
+                     { "version", sysDep.versionReq.toString() } };
+          },
+          [](const PathDependency& pathDep) -> nlohmann::json {
+            return { { "kind", "path" },
+                     { "name", pathDep.name },
+                     { "path", pathDep.path } };
+          },
+      },
+      dep);
+}
+
+static rs::Result<Dependency> depFromJson(const nlohmann::json& json) {
+  const std::string kind = json.at("kind").get<std::string>();
+  std::string name = json.at("name").get<std::string>();
+  if (kind == "git") {
+    std::optional<std::string> target = std::nullopt;
+    if (json.contains("target")) {
+      target = json.at("target").get<std::string>();
+    }
+    return rs::Ok(Dependency(GitDependency(
+        std::move(name), json.at("url").get<std::string>(),
+        std::move(target))));
+  } else if (kind == "tarball") {
+    std::optional<std::string> digest = std::nullopt;
+    if (json.contains("digest")) {
+      digest = json.at("digest").get<std::string>();
+    }
+    return rs::Ok(Dependency(TarballDependency(
+        std::move(name), json.at("url").get<std::string>(),
+        std::move(digest))));
+  } else if (kind == "system") {
+    return rs::Ok(Dependency(SystemDependency(
+        std::move(name),
+        rs_try(VersionReq::parse(json.at("version").get<std::string>())))));
+  } else if (kind == "path") {
+    return rs::Ok(Dependency(
+        PathDependency(std::move(name), json.at("path").get<std::string>())));
+  }
+  rs_bail("unknown dependency kind in manifest snapshot: {}", kind);
+}
+
+static nlohmann::json profileToJson(const Profile& profile) {
+  return { { "cxxflags", profile.cxxflags },
+           { "ldflags", profile.ldflags },
+           { "lto", profile.lto },
+           { "debug", profile.debug },
+           { "split-debuginfo", profile.splitDebugInfo },
+           { "opt-level", profile.optLevel },
+           { "pch", profile.pch } };
+}
+
+static Profile profileFromJson(const nlohmann::json& json) {
+  return Profile(json.at("cxxflags").get<std::vector<std::string>>(),
+                 json.at("ldflags").get<std::vector<std::string>>(),
+                 json.at("lto").get<bool>(), json.at("debug").get<bool>(),
+                 json.at("split-debuginfo").get<bool>(),
+                 json.at("opt-level").get<std::uint8_t>(),
+                 json.at("pch").get<std::vector<std::string>>());
+}
+
+std::optional<Manifest>
+Manifest::loadSnapshot(const fs::path& snapshotFile,
+                       const fs::path& manifestPath, const std::uintmax_t size,
+                       const std::int64_t mtime,
+                       const std::string& digest) noexcept {
+  try {
+    std::ifstream ifs(snapshotFile);
+    if (!ifs) {
+      return std::nullopt;
+    }
+    const nlohmann::json snapshot = nlohmann::json::parse(ifs);
+    if (snapshot.value("version", 0) != 1
+        || snapshot.value("size", std::uintmax_t{ 0 }) != size
+        || snapshot.value("mtime", std::int64_t{ 0 }) != mtime
+        || snapshot.value("digest", std::string{}) != digest) {
+      spdlog::debug("discarding stale manifest snapshot: {}",
+                    snapshotFile.string());
+      return std::nullopt;
+    }
+
+    const nlohmann::json& pkg = snapshot.at("package");
+    auto edition =
+        Edition::tryFromString(pkg.at("edition").get<std::string>());
+    auto version = Version::parse(pkg.at("version").get<std::string>());
+    if (edition.is_err() || version.is_err()) {
+      return std::nullopt;
+    }
+    Package package(pkg.at("name").get<std::string>(), edition.unwrap(),
+                    version.unwrap(),
+                    pkg.at("lib-type").get<std::string>() == "shared"
+                        ? Package::LibType::Shared
+                        : Package::LibType::Static,
+                    pkg.at("test-threads").get<std::size_t>());
+
+    std::vector<Dependency> dependencies;
+    for (const nlohmann::json& depJson : snapshot.at("dependencies")) {
+      auto dep = depFromJson(depJson);
+      if (dep.is_err()) {
+        return std::nullopt;
+      }
+      dependencies.emplace_back(dep.unwrap());
+    }
+    std::vector<Dependency> devDependencies;
+    for (const nlohmann::json& depJson : snapshot.at("dev-dependencies")) {
+      auto dep = depFromJson(depJson);
+      if (dep.is_err()) {
+        return std::nullopt;
+      }
+      devDependencies.emplace_back(dep.unwrap());
+    }
+
+    // The profile map always holds exactly these three entries; custom
+    // profiles are spelled through them at parse time.
+    const nlohmann::json& profs = snapshot.at("profiles");
+    std::unordered_map<BuildProfile, Profile> profiles;
+    profiles.emplace(BuildProfile::Dev, profileFromJson(profs.at("dev")));
+    profiles.emplace(BuildProfile::Release,
+                     profileFromJson(profs.at("release")));
+    profiles.emplace(BuildProfile::Test, profileFromJson(profs.at("test")));
+
+    Lint lint(Cpplint(snapshot.at("lint")
+                          .at("cpplint-filters")
+                          .get<std::vector<std::string>>()));
+    Build build(snapshot.at("build").at("wrapper").get<std::string>(),
+                snapshot.at("build").at("remote-jobs").get<std::size_t>(),
+                snapshot.at("build").at("nice").get<std::int64_t>(),
+                snapshot.at("build").at("io-class").get<std::string>());
+    Cache cache(snapshot.at("cache").at("remote").get<std::string>(),
+                snapshot.at("cache").at("upload").get<bool>());
+
+    return Manifest(manifestPath, std::move(package), std::move(dependencies),
+                    std::move(devDependencies), std::move(profiles),
+                    std::move(lint), std::move(build), std::move(cache));
+  } catch (const std::exception& e) {
+    spdlog::debug("discarding manifest snapshot ({}): {}",
+                  snapshotFile.string(), e.what());
+    return std::nullopt;
+  }
+}
+
+void Manifest::saveSnapshot(const fs::path& snapshotFile,
+                            const std::uintmax_t size,
+                            const std::int64_t mtime,
+                            const std::string& digest) const noexcept {
+  try {
+    nlohmann::json deps = nlohmann::json::array();
+    for (const Dependency& dep : dependencies) {
+      deps.push_back(depToJson(dep));
+    }
+    nlohmann::json devDeps = nlohmann::json::array();
+    for (const Dependency& dep : devDependencies) {
+      devDeps.push_back(depToJson(dep));
+    }
+
+    const nlohmann::json snapshot = {
+      { "version", 1 },
+      { "size", size },
+      { "mtime", mtime },
+      { "digest", digest },
+      { "package",
+        { { "name", package.name },
+          { "edition", package.edition.str },
+          { "version", package.version.toString() },
+          { "lib-type",
+            package.libType == Package::LibType::Shared ? "shared"
+                                                        : "static" },
+          { "test-threads", package.testThreads } } },
+      { "dependencies", deps },
+      { "dev-dependencies", devDeps },
+      { "profiles",
+        { { "dev", profileToJson(profiles.at(BuildProfile::Dev)) },
+          { "release", profileToJson(profiles.at(BuildProfile::Release)) },
+          { "test", profileToJson(profiles.at(BuildProfile::Test)) } } },
+      { "lint", { { "cpplint-filters", lint.cpplint.filters } } },
+      { "build",
+        { { "wrapper", build.wrapper },
+          { "remote-jobs", build.remoteJobs },
+          { "nice", build.nice },
+          { "io-class", build.ioClass } } },
+      { "cache",
+        { { "remote", cache.remote }, { "upload", cache.upload } } },
+    };
+
+    fs::create_directories(snapshotFile.parent_path());
+    writeFileAtomic(snapshotFile, snapshot.dump());
+  } catch (const std::exception& e) {
+    spdlog::debug("failed to save manifest snapshot: {}", e.what());
+  }
+}
+
 rs::Result<Manifest> Manifest::tryParse(fs::path path,
                                         const bool findParents) noexcept {
+  const profile::Span span("Manifest::tryParse");
   if (findParents) {
     path = rs_try(findPath(path.parent_path()));
   }
-  return tryFromToml(toml::parse(path), path);
+
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(path, ec);
+  fs::file_time_type mtime{};
+  if (!ec) {
+    mtime = fs::last_write_time(path, ec);
+  }
+  if (ec) {
+    // Let the TOML parser produce the error for an unreadable manifest.
+    return tryFromToml(toml::parse(path), path);
+  }
+
+  const std::int64_t mtimeTicks = mtime.time_since_epoch().count();
+  const fs::path snapshotFile =
+      path.parent_path() / "cabin-out" / MANIFEST_SNAPSHOT_FILE;
+  const std::string digest = digestFile(path);
+  if (std::optional<Manifest> cached =
+          loadSnapshot(snapshotFile, path, size, mtimeTicks, digest)) {
+    return rs::Ok(std::move(*cached));
+  }
+
+  Manifest manifest = rs_try(tryFromToml(toml::parse(path), path));
+  manifest.saveSnapshot(snapshotFile, size, mtimeTicks, digest);
+  return rs::Ok(std::move(manifest));
+}
+
+rs::Result<ManifestLite> ManifestLite::tryParse(fs::path path,
+                                                const bool findParents) noexcept {
+  const profile::Span span("ManifestLite::tryParse");
+  if (findParents) {
+    path = rs_try(Manifest::findPath(path.parent_path()));
+  }
+
+  const toml::value data = toml::parse(path);
+  auto package = rs_try(Package::tryFromToml(data));
+  auto lint = rs_try(Lint::tryFromToml(data));
+  return rs::Ok(
+      ManifestLite(std::move(path), std::move(package), std::move(lint)));
 }
 
 rs::Result<Manifest> Manifest::tryFromToml(const toml::value& data,
@@ -677,10 +1258,13 @@ rs::Result<Manifest> Manifest::tryFromToml(const toml::value& data,
   std::unordered_map<BuildProfile, Profile> profiles =
       rs_try(parseProfiles(data));
   auto lint = rs_try(Lint::tryFromToml(data));
+  auto build = rs_try(Build::tryFromToml(data));
+  auto cache = rs_try(Cache::tryFromToml(data));
 
   return rs::Ok(Manifest(std::move(path), std::move(package),
                          std::move(dependencies), std::move(devDependencies),
-                         std::move(profiles), std::move(lint)));
+                         std::move(profiles), std::move(lint),
+                         std::move(build), std::move(cache)));
 }
 
 rs::Result<fs::path> Manifest::findPath(fs::path candidateDir) noexcept {
@@ -712,8 +1296,12 @@ Manifest::installDeps(const bool includeDevDeps,
   std::unordered_map<std::string, DepKey> seenDeps;
   std::unordered_set<fs::path> visited;
   std::vector<CompilerOpts> installed;
+  // One lock at the root manifest covers the whole transitive closure.
+  Lockfile lockfile = rs_try(Lockfile::load(path.parent_path()));
   rs_try(installDependencies(*this, buildProfile, includeDevDeps,
-                             suppressDepDiag, seenDeps, visited, installed));
+                             suppressDepDiag, seenDeps, visited, lockfile,
+                             installed));
+  rs_try(lockfile.save());
   return rs::Ok(installed);
 }
 
@@ -734,9 +1322,9 @@ rs::Result<void> validatePackageName(const std::string_view name) noexcept {
   rs_ensure(std::isalnum(name[name.size() - 1]),
             "package name must end with a letter or digit");
 
-  static const std::unordered_set<std::string_view> keywords = {
+  static constexpr StaticStringSet keywords{ std::to_array<std::string_view>({
 #include "Keywords.def"
-  };
+  }) };
   rs_ensure(!keywords.contains(name), "package name must not be a C++ keyword");
 
   return rs::Ok();
@@ -972,15 +1560,43 @@ invalid
 ^^^^^^^ expected number)");
   }
 
+  // lib-type
+  {
+    const toml::value val = R"(
+      [package]
+      name = "test-pkg"
+      edition = "20"
+      version = "1.2.3"
+      lib-type = "shared"
+    )"_toml;
+
+    rs::assertTrue(Package::tryFromToml(val).unwrap().libType
+                   == Package::LibType::Shared);
+  }
+  {
+    const toml::value val = R"(
+      [package]
+      name = "test-pkg"
+      edition = "20"
+      version = "1.2.3"
+      lib-type = "dynamic"
+    )"_toml;
+
+    rs::assertEq(Package::tryFromToml(val).unwrap_err()->what(),
+                 "lib-type must be either `static` or `shared`");
+  }
+
   rs::pass();
 }
 
 static void testParseProfiles() {
   const Profile devProfileDefault(
       /*cxxflags=*/{}, /*ldflags=*/{}, /*lto=*/false, /*debug=*/true,
+      /*splitDebugInfo=*/false,
       /*optLevel=*/0);
   const Profile relProfileDefault(
       /*cxxflags=*/{}, /*ldflags=*/{}, /*lto=*/false, /*debug=*/false,
+      /*splitDebugInfo=*/false,
       /*optLevel=*/3);
 
   {
@@ -1014,6 +1630,7 @@ static void testParseProfiles() {
     const Profile expected(
         /*cxxflags=*/{ "-fno-rtti" }, /*ldflags=*/{ "-lm" }, /*lto=*/true,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/2);
 
     const auto profiles = parseProfiles(baseOnly).unwrap();
@@ -1055,15 +1672,18 @@ static void testParseProfiles() {
     const Profile devExpected(
         /*cxxflags=*/{}, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/1);
     const Profile relExpected(
         /*cxxflags=*/{}, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/false,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/2 // here, the default is 3
     );
     const Profile testExpected(
         /*cxxflags=*/{}, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/3);
 
     const auto profiles = parseProfiles(overwrite).unwrap();
@@ -1084,10 +1704,12 @@ static void testParseProfiles() {
     const Profile devExpected(
         /*cxxflags=*/{ "-A" }, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/0);
     const Profile testExpected(
         /*cxxflags=*/{ "-A", "-B" }, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/0);
 
     const auto profiles = parseProfiles(append).unwrap();
@@ -1109,10 +1731,12 @@ static void testParseProfiles() {
     const Profile devExpected(
         /*cxxflags=*/{ "-A" }, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/0);
     const Profile testExpected(
         /*cxxflags=*/{ "-B" }, /*ldflags=*/{}, /*lto=*/false,
         /*debug=*/true,
+        /*splitDebugInfo=*/false,
         /*optLevel=*/0);
 
     const auto profiles = parseProfiles(overwrite).unwrap();
@@ -1130,6 +1754,71 @@ static void testParseProfiles() {
     rs::assertEq(parseProfiles(incorrect).unwrap_err()->what(),
                  "invalid inherit-mode: `UNKNOWN`");
   }
+  {
+    const toml::value split = R"(
+      [profile]
+      split-debuginfo = true
+
+      [profile.release]
+      split-debuginfo = false
+    )"_toml;
+
+    const auto profiles = parseProfiles(split).unwrap();
+    rs::assertTrue(profiles.at(BuildProfile::Dev).splitDebugInfo);
+    rs::assertTrue(profiles.at(BuildProfile::Test).splitDebugInfo);
+    rs::assertFalse(profiles.at(BuildProfile::Release).splitDebugInfo);
+  }
+}
+
+static void testProfileOverrides() {
+  {
+    const toml::value empty = ""_toml;
+    rs::assertTrue(ProfileOverride::mapFromToml(empty, "dev").unwrap().empty());
+  }
+  {
+    const toml::value val = R"(
+      [profile.dev.package.mylib]
+      opt-level = 2
+      cxxflags = ["-fno-exceptions"]
+
+      [profile.release.package.mylib]
+      lto = true
+    )"_toml;
+
+    const auto devOverrides =
+        ProfileOverride::mapFromToml(val, "dev").unwrap();
+    rs::assertEq(devOverrides.size(), 1UL);
+    const ProfileOverride& ov = devOverrides.at("mylib");
+    rs::assertEq(ov.optLevel.value(), static_cast<std::uint8_t>(2));
+    rs::assertFalse(ov.lto.has_value());
+
+    // Unset fields keep the base profile's values.
+    const Profile base(
+        /*cxxflags=*/{ "-Wall" }, /*ldflags=*/{ "-lm" }, /*lto=*/false,
+        /*debug=*/true,
+        /*splitDebugInfo=*/false,
+        /*optLevel=*/0);
+    const Profile applied = ov.applyTo(base);
+    rs::assertEq(applied.optLevel, static_cast<std::uint8_t>(2));
+    rs::assertEq(fmt::format("{}", fmt::join(applied.cxxflags, ",")),
+                 "-fno-exceptions");
+    rs::assertEq(fmt::format("{}", fmt::join(applied.ldflags, ",")), "-lm");
+    rs::assertTrue(applied.debug);
+
+    const auto relOverrides =
+        ProfileOverride::mapFromToml(val, "release").unwrap();
+    rs::assertTrue(relOverrides.at("mylib").lto.value());
+    rs::assertTrue(
+        ProfileOverride::mapFromToml(val, "test").unwrap().empty());
+  }
+  {
+    const toml::value bad = R"(
+      [profile.dev.package.mylib]
+      opt-level = 9
+    )"_toml;
+    rs::assertEq(ProfileOverride::mapFromToml(bad, "dev").unwrap_err()->what(),
+                 "opt-level must be between 0 and 3");
+  }
 }
 
 static void testLintTryFromToml() {
@@ -1161,6 +1850,113 @@ static void testLintTryFromToml() {
   rs::pass();
 }
 
+static void testBuildTryFromToml() {
+  // Wrapper with an explicit remote job count
+  {
+    const toml::value val = R"(
+      [build]
+      wrapper = "distcc"
+      remote-jobs = 64
+    )"_toml;
+
+    auto build = Build::tryFromToml(val).unwrap();
+    rs::assertEq(build.wrapper, "distcc");
+    rs::assertEq(build.remoteJobs, 64UL);
+  }
+
+  // Empty build config compiles locally
+  {
+    const toml::value val{};
+    auto build = Build::tryFromToml(val).unwrap();
+    rs::assertTrue(build.wrapper.empty());
+    rs::assertEq(build.remoteJobs, 0UL);
+  }
+
+  // remote-jobs is meaningless without a wrapper
+  {
+    const toml::value val = R"(
+      [build]
+      remote-jobs = 64
+    )"_toml;
+
+    rs::assertEq(Build::tryFromToml(val).unwrap_err()->what(),
+                 "remote-jobs requires `wrapper` to be set");
+  }
+
+  // Background-friendly scheduling classes
+  {
+    const toml::value val = R"(
+      [build]
+      nice = 10
+      io-class = "idle"
+    )"_toml;
+
+    auto build = Build::tryFromToml(val).unwrap();
+    rs::assertEq(build.nice, std::int64_t{ 10 });
+    rs::assertEq(build.ioClass, "idle");
+  }
+
+  // Only the two lowering classes are accepted
+  {
+    const toml::value val = R"(
+      [build]
+      io-class = "realtime"
+    )"_toml;
+
+    rs::assertEq(
+        Build::tryFromToml(val).unwrap_err()->what(),
+        "build.io-class must be `idle` or `best-effort`, got `realtime`");
+  }
+
+  rs::pass();
+}
+
+static void testCacheTryFromToml() {
+  // Remote store with uploads left at the default
+  {
+    const toml::value val = R"(
+      [cache]
+      remote = "https://cache.example.com/cas"
+    )"_toml;
+
+    auto cache = Cache::tryFromToml(val).unwrap();
+    rs::assertEq(cache.remote, "https://cache.example.com/cas");
+    rs::assertTrue(cache.upload);
+  }
+
+  // Download-only configuration
+  {
+    const toml::value val = R"(
+      [cache]
+      remote = "http://cache.internal:8080"
+      upload = false
+    )"_toml;
+
+    auto cache = Cache::tryFromToml(val).unwrap();
+    rs::assertFalse(cache.upload);
+  }
+
+  // Empty cache config stays local
+  {
+    const toml::value val{};
+    auto cache = Cache::tryFromToml(val).unwrap();
+    rs::assertTrue(cache.remote.empty());
+  }
+
+  // Only http(s) endpoints are accepted
+  {
+    const toml::value val = R"(
+      [cache]
+      remote = "ftp://cache.example.com"
+    )"_toml;
+
+    rs::assertEq(Cache::tryFromToml(val).unwrap_err()->what(),
+                 "cache.remote must be an http(s) URL");
+  }
+
+  rs::pass();
+}
+
 static void testValidateDepName() {
   rs::assertEq(validateDepName("").unwrap_err()->what(),
                "dependency name must not be empty");
@@ -1231,7 +2027,10 @@ int main() {
   testEditionComparison();
   testPackageTryFromToml();
   testParseProfiles();
+  testProfileOverrides();
   testLintTryFromToml();
+  testBuildTryFromToml();
+  testCacheTryFromToml();
   testValidateDepName();
   testValidateFlag();
 }
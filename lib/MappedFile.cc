@@ -0,0 +1,108 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <rs/result.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace cabin {
+
+rs::Result<MappedFile> MappedFile::open(const fs::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  rs_ensure(fd != -1, "open() failed for `{}`: {}", path, strerror(errno));
+
+  struct stat st{};
+  if (fstat(fd, &st) == -1) {
+    const int err = errno;
+    close(fd);
+    rs_bail("fstat() failed for `{}`: {}", path, strerror(err));
+  }
+
+  MappedFile file;
+  file.size_ = static_cast<std::size_t>(st.st_size);
+  if (file.size_ > 0) {
+    void* addr = mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) { // NOLINT(performance-no-int-to-ptr)
+      const int err = errno;
+      close(fd);
+      rs_bail("mmap() failed for `{}`: {}", path, strerror(err));
+    }
+    file.data_ = static_cast<const char*>(addr);
+  }
+  // The mapping stays valid without the descriptor.
+  close(fd);
+  return rs::Ok(std::move(file));
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFileCache& MappedFileCache::instance() noexcept {
+  static MappedFileCache cache;
+  return cache;
+}
+
+std::shared_ptr<const MappedFile> MappedFileCache::get(const fs::path& path) {
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(path, ec);
+  if (ec) {
+    return nullptr;
+  }
+  const fs::file_time_type mtime = fs::last_write_time(path, ec);
+  if (ec) {
+    return nullptr;
+  }
+
+  std::string key = path.string();
+  {
+    const tbb::spin_mutex::scoped_lock lock(mtx);
+    if (const auto found = entries.find(key); found != entries.end()) {
+      Entry& entry = found->second;
+      if (entry.size == size && entry.mtime == mtime) {
+        lru.splice(lru.begin(), lru, entry.lruPos);
+        return entry.mapping;
+      }
+      // Stale: the file was rewritten since it was mapped.
+      lru.erase(entry.lruPos);
+      entries.erase(found);
+    }
+  }
+
+  // Map outside the lock; concurrent misses on the same file waste one
+  // mapping at worst.
+  auto result = MappedFile::open(path);
+  if (result.is_err()) {
+    return nullptr;
+  }
+  auto mapping =
+      std::make_shared<const MappedFile>(std::move(result.unwrap()));
+
+  const tbb::spin_mutex::scoped_lock lock(mtx);
+  lru.push_front(key);
+  entries.insert_or_assign(
+      std::move(key), Entry{ .size = size,
+                             .mtime = mtime,
+                             .mapping = mapping,
+                             .lruPos = lru.begin() });
+  while (entries.size() > CAPACITY) {
+    entries.erase(lru.back());
+    lru.pop_back();
+  }
+  return mapping;
+}
+
+} // namespace cabin
@@ -0,0 +1,149 @@
+#include "Profile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace cabin::profile {
+
+bool isEnabled() noexcept {
+  static const bool enabled = [] {
+    const char* env = std::getenv("CABIN_PROFILE");
+    return env != nullptr && *env != '\0' && std::string_view(env) != "0";
+  }();
+  return enabled;
+}
+
+namespace {
+
+struct Sample {
+  const char* name;
+  std::int64_t durationNs;
+};
+
+struct Stats {
+  std::uint64_t calls = 0;
+  std::int64_t totalNs = 0;
+  std::int64_t maxNs = 0;
+};
+
+// Process-wide aggregation.  Threads only touch it when flushing their
+// local buffers, so the mutex is uncontended in steady state.
+class Registry {
+public:
+  static Registry& instance() noexcept {
+    static Registry registry;
+    return registry;
+  }
+
+  void merge(const std::vector<Sample>& samples) {
+    const std::scoped_lock lock(mutex);
+    for (const Sample& sample : samples) {
+      Stats& entry = stats[sample.name];
+      ++entry.calls;
+      entry.totalNs += sample.durationNs;
+      entry.maxNs = std::max(entry.maxNs, sample.durationNs);
+    }
+  }
+
+  Registry(const Registry&) = delete;
+  Registry(Registry&&) = delete;
+  Registry& operator=(const Registry&) = delete;
+  Registry& operator=(Registry&&) = delete;
+
+private:
+  Registry() = default;
+
+  // Thread-local buffers flush before static destructors run, so every
+  // sample has been merged by the time the table is printed.
+  ~Registry() {
+    if (stats.empty()) {
+      return;
+    }
+
+    std::vector<std::pair<std::string_view, Stats>> rows(stats.begin(),
+                                                         stats.end());
+    std::ranges::sort(rows, [](const auto& lhs, const auto& rhs) {
+      return lhs.second.totalNs > rhs.second.totalNs;
+    });
+
+    std::size_t nameWidth = 0;
+    for (const auto& [name, entry] : rows) {
+      nameWidth = std::max(nameWidth, name.size());
+    }
+
+    fmt::print(stderr, "\nCABIN_PROFILE summary:\n");
+    fmt::print(stderr, "  {:<{}}  {:>9}  {:>11}  {:>10}  {:>10}\n", "span",
+               nameWidth, "calls", "total(ms)", "mean(us)", "max(us)");
+    for (const auto& [name, entry] : rows) {
+      fmt::print(stderr, "  {:<{}}  {:>9}  {:>11.2f}  {:>10.1f}  {:>10.1f}\n",
+                 name, nameWidth, entry.calls,
+                 static_cast<double>(entry.totalNs) / 1e6,
+                 static_cast<double>(entry.totalNs)
+                     / static_cast<double>(entry.calls) / 1e3,
+                 static_cast<double>(entry.maxNs) / 1e3);
+    }
+  }
+
+  std::mutex mutex;
+  std::map<std::string_view, Stats> stats;
+};
+
+// Per-thread sample buffer: spans append without synchronization and the
+// buffer drains into the registry when it fills or the thread exits.
+class ThreadBuffer {
+public:
+  ThreadBuffer() = default;
+  ~ThreadBuffer() { flush(); }
+
+  void add(const char* name, const std::int64_t durationNs) {
+    samples.push_back(Sample{ .name = name, .durationNs = durationNs });
+    static constexpr std::size_t flushThreshold = 4096;
+    if (samples.size() >= flushThreshold) {
+      flush();
+    }
+  }
+
+  ThreadBuffer(const ThreadBuffer&) = delete;
+  ThreadBuffer(ThreadBuffer&&) = delete;
+  ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+  ThreadBuffer& operator=(ThreadBuffer&&) = delete;
+
+private:
+  void flush() {
+    if (!samples.empty()) {
+      Registry::instance().merge(samples);
+      samples.clear();
+    }
+  }
+
+  std::vector<Sample> samples;
+};
+
+thread_local ThreadBuffer threadBuffer; // NOLINT(cert-err58-cpp)
+
+} // namespace
+
+Span::Span(const char* name) noexcept : name(name), active(isEnabled()) {
+  if (active) {
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+Span::~Span() {
+  if (active) {
+    const auto durationNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+    threadBuffer.add(name, durationNs);
+  }
+}
+
+} // namespace cabin::profile
@@ -14,6 +14,7 @@
 #include <format>
 #include <ostream>
 #include <rs/result.hpp>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -76,9 +77,57 @@ struct Version {
   BuildMetadata build;
 
   static rs::Result<Version> parse(std::string_view str) noexcept;
+  /// Compile-time parse of a plain `X.Y.Z` literal, for internal
+  /// constant tables (minimum tool versions and the like); anything
+  /// else fails to compile.  User input goes through parse().
+  static consteval Version parseConst(std::string_view str);
+  /// Parses a contiguous batch of version strings (e.g. a registry
+  /// candidate list), failing on the first invalid entry.  Each entry
+  /// takes the allocation-light fast path when it has the common
+  /// `X.Y.Z(-pre)?(+build)?` shape.
+  static rs::Result<std::vector<Version>>
+  parseMany(std::span<const std::string_view> strs) noexcept;
   std::string toString() const noexcept;
   uint64_t toNum() const noexcept;
 };
+consteval Version Version::parseConst(const std::string_view str) {
+  // A throw renders the evaluation non-constant, so a malformed literal
+  // is reported at compile time.
+  constexpr auto isDigit = [](const char c) { return c >= '0' && c <= '9'; };
+  std::size_t pos = 0;
+  const auto parseNum = [&]() -> uint64_t {
+    if (pos >= str.size() || !isDigit(str[pos])) {
+      throw "expected digit in version literal";
+    }
+    if (str[pos] == '0' && pos + 1 < str.size() && isDigit(str[pos + 1])) {
+      throw "invalid leading zero in version literal";
+    }
+    uint64_t value = 0;
+    while (pos < str.size() && isDigit(str[pos])) {
+      value = (value * 10) + static_cast<uint64_t>(str[pos] - '0');
+      ++pos;
+    }
+    return value;
+  };
+  const auto parseDot = [&]() {
+    if (pos >= str.size() || str[pos] != '.') {
+      throw "expected `.` in version literal";
+    }
+    ++pos;
+  };
+
+  Version ver;
+  ver.major = parseNum();
+  parseDot();
+  ver.minor = parseNum();
+  parseDot();
+  ver.patch = parseNum();
+  if (pos != str.size()) {
+    throw "trailing characters in version literal";
+  }
+  return ver;
+}
+
 std::ostream& operator<<(std::ostream& os, const Version& ver) noexcept;
 bool operator==(const Version& lhs, const Version& rhs) noexcept;
 bool operator!=(const Version& lhs, const Version& rhs) noexcept;
@@ -16,6 +16,7 @@
 
 #include "Semver.hpp"
 
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <ostream>
@@ -85,17 +86,111 @@ struct Comparator {
   Comparator canonicalize() const noexcept;
 };
 
+struct CompiledVersionReq;
+
 struct VersionReq {
   Comparator left;
   std::optional<Comparator> right;
 
   static rs::Result<VersionReq> parse(std::string_view str) noexcept;
   static rs::Result<VersionReq> tryParse(std::string_view str) noexcept;
+  /// Compile-time parse of a requirement literal in the canonical
+  /// `[op] X[.Y[.Z]] [&& op X[.Y[.Z]]]` form without prerelease/build
+  /// parts, for internal constant tables; anything else fails to
+  /// compile.  User input goes through parse().
+  static consteval VersionReq parseConst(std::string_view str);
   bool satisfiedBy(const Version& ver) const noexcept;
+  /// Lowers the requirement into a flat bound-check program for repeated
+  /// evaluation against many candidate versions.
+  CompiledVersionReq compile() const noexcept;
   std::string toString() const noexcept;
   std::string toPkgConfigString(std::string_view name) const noexcept;
   VersionReq canonicalize() const noexcept;
   bool canSimplify() const noexcept;
 };
 
+// A `VersionReq` lowered for repeated `satisfiedBy` evaluation.  Regular
+// requirements (no prerelease bound in any comparator) become one
+// inclusive-lower/exclusive-upper triplet range checked with plain
+// integer compares, and prerelease candidates are rejected up front —
+// exactly what `VersionReq::satisfiedBy`'s compatibility gate does when
+// no comparator pins a prerelease.  Irregular requirements keep the
+// original comparator walk.
+struct CompiledVersionReq {
+  VersionReq req; // fallback for irregular requirements and diagnostics
+
+  bool regular{ false };
+  std::array<uint64_t, 3> lower{}; // inclusive {major, minor, patch}
+  std::optional<std::array<uint64_t, 3>> upper; // exclusive
+
+  bool matches(const Version& ver) const noexcept;
+  /// Evaluates every candidate, returning one bit per version (bit i set
+  /// iff `vers[i]` matches), packed LSB-first into 64-bit words.
+  std::vector<uint64_t> matchAll(std::span<const Version> vers) const noexcept;
+};
+
+consteval VersionReq VersionReq::parseConst(const std::string_view str) {
+  // A throw renders the evaluation non-constant, so a malformed literal
+  // is reported at compile time.
+  constexpr auto isDigit = [](const char c) { return c >= '0' && c <= '9'; };
+  std::size_t pos = 0;
+  const auto parseNum = [&]() -> uint64_t {
+    if (pos >= str.size() || !isDigit(str[pos])) {
+      throw "expected digit in version requirement literal";
+    }
+    if (str[pos] == '0' && pos + 1 < str.size() && isDigit(str[pos + 1])) {
+      throw "invalid leading zero in version requirement literal";
+    }
+    uint64_t value = 0;
+    while (pos < str.size() && isDigit(str[pos])) {
+      value = (value * 10) + static_cast<uint64_t>(str[pos] - '0');
+      ++pos;
+    }
+    return value;
+  };
+  const auto parseComparator = [&]() -> Comparator {
+    Comparator cmp;
+    if (str.substr(pos, 2) == ">=") {
+      cmp.op = Comparator::Gte;
+      pos += 2;
+    } else if (str.substr(pos, 2) == "<=") {
+      cmp.op = Comparator::Lte;
+      pos += 2;
+    } else if (str.substr(pos, 1) == ">") {
+      cmp.op = Comparator::Gt;
+      pos += 1;
+    } else if (str.substr(pos, 1) == "<") {
+      cmp.op = Comparator::Lt;
+      pos += 1;
+    } else if (str.substr(pos, 1) == "=") {
+      cmp.op = Comparator::Exact;
+      pos += 1;
+    }
+    cmp.major = parseNum();
+    if (pos < str.size() && str[pos] == '.') {
+      ++pos;
+      cmp.minor = parseNum();
+      if (pos < str.size() && str[pos] == '.') {
+        ++pos;
+        cmp.patch = parseNum();
+      }
+    }
+    return cmp;
+  };
+
+  VersionReq req;
+  req.left = parseComparator();
+  if (pos != str.size()) {
+    if (str.substr(pos, 4) != " && ") {
+      throw "trailing characters in version requirement literal";
+    }
+    pos += 4;
+    req.right = parseComparator();
+    if (pos != str.size()) {
+      throw "trailing characters in version requirement literal";
+    }
+  }
+  return req;
+}
+
 std::ostream& operator<<(std::ostream& os, const VersionReq& req);
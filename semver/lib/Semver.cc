@@ -1,13 +1,19 @@
 #include "Semver.hpp"
 
+#include <bit>
 #include <cctype>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <optional>
 #include <ostream>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 // NOLINTBEGIN(readability-identifier-naming,cppcoreguidelines-macro-usage)
@@ -42,13 +48,41 @@ std::ostream& operator<<(std::ostream& os, const VersionToken& tok) noexcept {
   return os;
 }
 
+// Stack-formatted token text, so comparisons and toString never go
+// through an ostringstream.  `buf` must outlive the returned view.
+static std::string_view tokenText(const VersionToken& tok,
+                                  char (&buf)[20]) noexcept {
+  switch (tok.kind) {
+  case VersionToken::Num: {
+    const auto [end, ec] =
+        std::to_chars(buf, buf + sizeof(buf), std::get<uint64_t>(tok.value));
+    static_cast<void>(ec); // 20 chars always fit a uint64_t
+    return { buf, static_cast<std::size_t>(end - buf) };
+  }
+  case VersionToken::Ident:
+    return std::get<std::string>(tok.value);
+  case VersionToken::Dot:
+    return ".";
+  case VersionToken::Hyphen:
+    return "-";
+  case VersionToken::Plus:
+    return "+";
+  case VersionToken::Eof:
+  case VersionToken::Unknown:
+    return {};
+  }
+  return {};
+}
+
 std::string VersionToken::toString() const noexcept {
-  std::ostringstream oss;
-  oss << *this;
-  return oss.str();
+  char buf[20]; // NOLINT(*-avoid-c-arrays)
+  return std::string(tokenText(*this, buf));
 }
 
-std::size_t VersionToken::size() const noexcept { return toString().size(); }
+std::size_t VersionToken::size() const noexcept {
+  char buf[20]; // NOLINT(*-avoid-c-arrays)
+  return tokenText(*this, buf).size();
+}
 
 bool operator==(const VersionToken& lhs, const VersionToken& rhs) noexcept {
   if (lhs.kind != rhs.kind) {
@@ -73,7 +107,12 @@ bool operator<(const VersionToken& lhs, const VersionToken& rhs) noexcept {
   if (lhs.kind == VersionToken::Num && rhs.kind == VersionToken::Num) {
     return std::get<uint64_t>(lhs.value) < std::get<uint64_t>(rhs.value);
   }
-  return lhs.toString() < rhs.toString();
+  // Mixed and identifier comparisons stay lexical (as before), but on
+  // stack-formatted views: requirement matching compares versions
+  // millions of times, and the old toString() pair allocated every call.
+  char lhsBuf[20]; // NOLINT(*-avoid-c-arrays)
+  char rhsBuf[20]; // NOLINT(*-avoid-c-arrays)
+  return tokenText(lhs, lhsBuf) < tokenText(rhs, rhsBuf);
 }
 bool operator>(const VersionToken& lhs, const VersionToken& rhs) {
   return rhs < lhs;
@@ -429,11 +468,199 @@ BuildMetadata::parse(const std::string_view str) noexcept {
   return parser.parseBuild();
 }
 
+// Fast path for the common `X.Y.Z(-pre)?(+build)?` shape.
+//
+// The lexer above materializes a VersionToken (often holding a heap
+// string) per token, which dominates when resolution code parses
+// thousands of candidate versions.  The fast path scans digit runs
+// eight bytes at a time (SWAR) and only allocates for pre-release/build
+// identifiers.  Anything irregular — leading zeros, overflow, unexpected
+// characters — yields nullopt so the full parser can produce its usual
+// diagnostics.
+
+// Length of the run of ASCII digits starting at `pos`.
+static std::size_t digitRunLen(const std::string_view str,
+                               const std::size_t pos) noexcept {
+  constexpr uint64_t ones = 0x0101010101010101ULL;
+  constexpr uint64_t highs = 0x8080808080808080ULL;
+
+  std::size_t i = pos;
+  while (i + sizeof(uint64_t) <= str.size()) {
+    uint64_t chunk = 0;
+    std::memcpy(&chunk, str.data() + i, sizeof(chunk));
+    // Set the high bit of every byte below '0' or above '9' (the
+    // hasless/hasmore idioms).  A cross-byte carry can only originate at
+    // a byte that is itself flagged, so the first flagged byte is exact.
+    const uint64_t below = (chunk - (ones * '0')) & ~chunk & highs;
+    const uint64_t above = ((chunk + (ones * (127 - '9'))) | chunk) & highs;
+    if ((below | above) != 0) {
+      return i - pos
+             + (static_cast<std::size_t>(std::countr_zero(below | above)) / 8);
+    }
+    i += sizeof(uint64_t);
+  }
+  while (i < str.size() && std::isdigit(str[i])) {
+    ++i;
+  }
+  return i - pos;
+}
+
+// Parses the digit run at `pos` as a semver num; nullopt on a leading
+// zero or overflow (the slow path reports those).
+static std::optional<uint64_t> fastParseNum(const std::string_view str,
+                                            std::size_t& pos) noexcept {
+  const std::size_t len = digitRunLen(str, pos);
+  if (len == 0 || (len > 1 && str[pos] == '0')) {
+    return std::nullopt;
+  }
+
+  uint64_t value = 0;
+  for (std::size_t i = pos; i < pos + len; ++i) {
+    const uint64_t digit = str[i] - '0';
+    constexpr uint64_t base = 10;
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+      return std::nullopt;
+    }
+    value = (value * base) + digit;
+  }
+  pos += len;
+  return value;
+}
+
+// Classifies one dot-separated pre-release component, mirroring
+// consumeNumOrIdent: all-digits parses as Num, anything else as Ident.
+static std::optional<VersionToken>
+fastPreToken(const std::string_view ident) noexcept {
+  if (ident.empty() || !std::isalnum(ident.front())) {
+    return std::nullopt;
+  }
+  bool allDigits = true;
+  for (const char c : ident) {
+    if (!std::isdigit(c)) {
+      allDigits = false;
+      if (!std::isalnum(c) && c != '-') {
+        return std::nullopt;
+      }
+    }
+  }
+  if (allDigits) {
+    std::size_t pos = 0;
+    const std::optional<uint64_t> num = fastParseNum(ident, pos);
+    if (!num.has_value() || pos != ident.size()) {
+      return std::nullopt;
+    }
+    return VersionToken(VersionToken::Num, num.value());
+  }
+  return VersionToken(VersionToken::Ident, std::string(ident));
+}
+
+// Build identifiers always stay identifiers, even when numeric.
+static std::optional<VersionToken>
+fastBuildToken(const std::string_view ident) noexcept {
+  if (ident.empty() || !std::isalnum(ident.front())) {
+    return std::nullopt;
+  }
+  for (const char c : ident) {
+    if (!std::isalnum(c) && c != '-') {
+      return std::nullopt;
+    }
+  }
+  return VersionToken(VersionToken::Ident, std::string(ident));
+}
+
+// Splits a `-pre`/`+build` section on dots and classifies each piece.
+static std::optional<std::vector<VersionToken>>
+fastParseIdents(const std::string_view section, const bool isPre) noexcept {
+  std::vector<VersionToken> idents;
+  std::size_t begin = 0;
+  while (true) {
+    const std::size_t dot = section.find('.', begin);
+    const std::string_view ident = section.substr(begin, dot - begin);
+    std::optional<VersionToken> tok =
+        isPre ? fastPreToken(ident) : fastBuildToken(ident);
+    if (!tok.has_value()) {
+      return std::nullopt;
+    }
+    idents.emplace_back(std::move(tok.value()));
+    if (dot == std::string_view::npos) {
+      return idents;
+    }
+    begin = dot + 1;
+  }
+}
+
+static std::optional<Version> fastParse(const std::string_view str) noexcept {
+  std::size_t pos = 0;
+  const std::optional<uint64_t> major = fastParseNum(str, pos);
+  if (!major.has_value() || pos >= str.size() || str[pos] != '.') {
+    return std::nullopt;
+  }
+  ++pos;
+  const std::optional<uint64_t> minor = fastParseNum(str, pos);
+  if (!minor.has_value() || pos >= str.size() || str[pos] != '.') {
+    return std::nullopt;
+  }
+  ++pos;
+  const std::optional<uint64_t> patch = fastParseNum(str, pos);
+  if (!patch.has_value()) {
+    return std::nullopt;
+  }
+
+  Version ver;
+  ver.major = major.value();
+  ver.minor = minor.value();
+  ver.patch = patch.value();
+  if (pos == str.size()) {
+    return ver;
+  }
+
+  std::string_view rest = str.substr(pos);
+  if (rest.front() == '-') {
+    rest.remove_prefix(1);
+    const std::size_t plus = rest.find('+');
+    std::optional<std::vector<VersionToken>> pre =
+        fastParseIdents(rest.substr(0, plus), /*isPre=*/true);
+    if (!pre.has_value()) {
+      return std::nullopt;
+    }
+    ver.pre = Prerelease{ std::move(pre.value()) };
+    if (plus == std::string_view::npos) {
+      return ver;
+    }
+    rest.remove_prefix(plus + 1);
+  } else if (rest.front() == '+') {
+    rest.remove_prefix(1);
+  } else {
+    return std::nullopt;
+  }
+
+  std::optional<std::vector<VersionToken>> build =
+      fastParseIdents(rest, /*isPre=*/false);
+  if (!build.has_value()) {
+    return std::nullopt;
+  }
+  ver.build = BuildMetadata{ std::move(build.value()) };
+  return ver;
+}
+
 rs::Result<Version> Version::parse(const std::string_view str) noexcept {
+  if (std::optional<Version> ver = fastParse(str)) {
+    return rs::Ok(std::move(ver.value()));
+  }
   VersionParser parser(str);
   return parser.parse();
 }
 
+rs::Result<std::vector<Version>>
+Version::parseMany(const std::span<const std::string_view> strs) noexcept {
+  std::vector<Version> vers;
+  vers.reserve(strs.size());
+  for (const std::string_view str : strs) {
+    vers.emplace_back(rs_try(parse(str)));
+  }
+  return rs::Ok(vers);
+}
+
 #ifdef CABIN_TEST
 
 #  include <rs/tests.hpp>
@@ -688,6 +915,41 @@ static void testSpecOrder() {
   rs::pass();
 }
 
+static void testParseConst() {
+  static_assert(Version::parseConst("1.2.3").major == 1);
+  static_assert(Version::parseConst("1.2.3").minor == 2);
+  static_assert(Version::parseConst("1.2.3").patch == 3);
+  static_assert(Version::parseConst("0.10.0").minor == 10);
+  static_assert(Version::parseConst("1.2.3").pre.ident.empty());
+  static_assert(Version::parseConst("1.2.3").build.ident.empty());
+
+  constexpr Version ver = Version::parseConst("12.0.1");
+  rs::assertEq(ver, Version::parse("12.0.1").unwrap());
+
+  rs::pass();
+}
+
+static void testParseMany() {
+  const std::vector<std::string_view> strs = {
+    "1.2.3",
+    "0.1.0",
+    "1.2.3-alpha1+build5",
+    "1.2.3-1.alpha1.9+build5.7.3aedf",
+    "18446744073709551615.0.0",
+  };
+  const std::vector<Version> vers = Version::parseMany(strs).unwrap();
+  rs::assertEq(vers.size(), strs.size());
+  for (std::size_t i = 0; i < strs.size(); ++i) {
+    rs::assertEq(vers[i], Version::parse(strs[i]).unwrap());
+    rs::assertEq(vers[i].toString(), std::string(strs[i]));
+  }
+
+  const std::vector<std::string_view> bad = { "1.2.3", "1.2" };
+  rs::assertTrue(Version::parseMany(bad).is_err());
+
+  rs::pass();
+}
+
 int main() {
   testParse();
   testEq();
@@ -698,6 +960,8 @@ int main() {
   testGt();
   testGe();
   testSpecOrder();
+  testParseConst();
+  testParseMany();
 }
 
 #endif
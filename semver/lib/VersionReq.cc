@@ -1,14 +1,20 @@
 #include "VersionReq.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cctype>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <optional>
 #include <ostream>
 #include <rs/result.hpp>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <variant>
+#include <vector>
 
 // NOLINTBEGIN(readability-identifier-naming,cppcoreguidelines-macro-usage)
 #define ComparatorBail(...) rs_bail("invalid comparator:\n" __VA_ARGS__)
@@ -584,6 +590,160 @@ bool VersionReq::satisfiedBy(const Version& ver) const noexcept {
   return false;
 }
 
+namespace {
+
+// One comparator lowered to an inclusive-lower/exclusive-upper triplet
+// range, valid only for candidates without prerelease tags.
+struct ComparatorBounds {
+  std::array<uint64_t, 3> lower{};
+  std::optional<std::array<uint64_t, 3>> upper;
+};
+
+} // namespace
+
+// Lowers `cmp` following the equivalences documented above Comparator.
+// Returns nullopt when the comparator cannot be lowered: it carries a
+// prerelease bound, or an exclusive upper bound would overflow.
+static std::optional<ComparatorBounds>
+lowerComparator(const Comparator& cmp) noexcept {
+  if (!cmp.pre.empty()) {
+    return std::nullopt;
+  }
+
+  constexpr uint64_t maxNum = std::numeric_limits<uint64_t>::max();
+  const uint64_t major = cmp.major;
+  const std::optional<uint64_t> minor = cmp.minor;
+  const std::optional<uint64_t> patch = cmp.patch;
+
+  ComparatorBounds bounds;
+  if (!cmp.op.has_value()) { // NoOp (caret, "compatible" updates)
+    bounds.lower = { major, minor.value_or(0), patch.value_or(0) };
+    if (!minor.has_value() || major > 0) {
+      if (major == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { major + 1, 0, 0 } };
+    } else if (minor.value() > 0) {
+      if (minor.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { 0, minor.value() + 1, 0 } };
+    } else if (patch.has_value()) {
+      if (patch.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { 0, 0, patch.value() + 1 } };
+    } else {
+      bounds.upper = { { 0, 1, 0 } };
+    }
+    return bounds;
+  }
+
+  switch (cmp.op.value()) {
+  case Comparator::Exact:
+  case Comparator::Lte:
+    if (cmp.op.value() == Comparator::Exact) {
+      bounds.lower = { major, minor.value_or(0), patch.value_or(0) };
+    }
+    if (patch.has_value()) {
+      if (patch.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { major, minor.value(), patch.value() + 1 } };
+    } else if (minor.has_value()) {
+      if (minor.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { major, minor.value() + 1, 0 } };
+    } else {
+      if (major == maxNum) {
+        return std::nullopt;
+      }
+      bounds.upper = { { major + 1, 0, 0 } };
+    }
+    return bounds;
+  case Comparator::Gt:
+    if (patch.has_value()) {
+      if (patch.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.lower = { major, minor.value(), patch.value() + 1 };
+    } else if (minor.has_value()) {
+      if (minor.value() == maxNum) {
+        return std::nullopt;
+      }
+      bounds.lower = { major, minor.value() + 1, 0 };
+    } else {
+      if (major == maxNum) {
+        return std::nullopt;
+      }
+      bounds.lower = { major + 1, 0, 0 };
+    }
+    return bounds;
+  case Comparator::Gte:
+    bounds.lower = { major, minor.value_or(0), patch.value_or(0) };
+    return bounds;
+  case Comparator::Lt:
+    bounds.upper = { { major, minor.value_or(0), patch.value_or(0) } };
+    return bounds;
+  }
+  std::unreachable();
+}
+
+CompiledVersionReq VersionReq::compile() const noexcept {
+  CompiledVersionReq compiled;
+  compiled.req = *this;
+
+  std::optional<ComparatorBounds> bounds = lowerComparator(left);
+  if (!bounds.has_value()) {
+    return compiled;
+  }
+  if (right.has_value()) {
+    const std::optional<ComparatorBounds> rightBounds =
+        lowerComparator(right.value());
+    if (!rightBounds.has_value()) {
+      return compiled;
+    }
+    bounds->lower = std::max(bounds->lower, rightBounds->lower);
+    if (rightBounds->upper.has_value()
+        && (!bounds->upper.has_value()
+            || rightBounds->upper.value() < bounds->upper.value())) {
+      bounds->upper = rightBounds->upper;
+    }
+  }
+
+  compiled.regular = true;
+  compiled.lower = bounds->lower;
+  compiled.upper = bounds->upper;
+  return compiled;
+}
+
+bool CompiledVersionReq::matches(const Version& ver) const noexcept {
+  if (!regular) {
+    return req.satisfiedBy(ver);
+  }
+  if (!ver.pre.empty()) {
+    // No comparator carries a prerelease bound, so satisfiedBy's
+    // compatibility gate rejects every prerelease candidate.
+    return false;
+  }
+  const std::array<uint64_t, 3> key{ ver.major, ver.minor, ver.patch };
+  return key >= lower && (!upper.has_value() || key < upper.value());
+}
+
+std::vector<uint64_t>
+CompiledVersionReq::matchAll(const std::span<const Version> vers)
+    const noexcept {
+  constexpr std::size_t wordBits = 64;
+  std::vector<uint64_t> bits((vers.size() + wordBits - 1) / wordBits, 0);
+  for (std::size_t i = 0; i < vers.size(); ++i) {
+    if (matches(vers[i])) {
+      bits[i / wordBits] |= uint64_t{ 1 } << (i % wordBits);
+    }
+  }
+  return bits;
+}
+
 // 1. NoOp: (= Caret (^), "compatible" updates)
 //   1.1. `A.B.C` (where A > 0) is equivalent to `>=A.B.C && <(A+1).0.0`
 //   1.2. `A.B` (where A > 0 & B > 0) is equivalent to `^A.B.0` (i.e., 1.1)
@@ -860,16 +1020,22 @@ using std::string_literals::operator""s;
 inline static void assertMatchAll(
     const VersionReq& req, const std::span<const std::string_view> versions,
     const std::source_location& loc = std::source_location::current()) {
+  const CompiledVersionReq compiled = req.compile();
   for (const std::string_view ver : versions) {
-    rs::assertTrue(req.satisfiedBy(Version::parse(ver).unwrap()), "", loc);
+    const Version version = Version::parse(ver).unwrap();
+    rs::assertTrue(req.satisfiedBy(version), "", loc);
+    rs::assertTrue(compiled.matches(version), "", loc);
   }
 }
 
 inline static void assertMatchNone(
     const VersionReq& req, const std::span<const std::string_view> versions,
     const std::source_location& loc = std::source_location::current()) {
+  const CompiledVersionReq compiled = req.compile();
   for (const std::string_view ver : versions) {
-    rs::assertFalse(req.satisfiedBy(Version::parse(ver).unwrap()), "", loc);
+    const Version version = Version::parse(ver).unwrap();
+    rs::assertFalse(req.satisfiedBy(version), "", loc);
+    rs::assertFalse(compiled.matches(version), "", loc);
   }
 }
 
@@ -1365,6 +1531,48 @@ static void testCanSimplify() {
   rs::pass();
 }
 
+static void testParseConstReq() {
+  static_assert(VersionReq::parseConst("1.2").left.major == 1);
+  static_assert(VersionReq::parseConst("1.2").left.minor.value() == 2);
+  static_assert(!VersionReq::parseConst("1.2").left.op.has_value());
+  static_assert(VersionReq::parseConst(">=1.2.3 && <2").left.op.value()
+                == Comparator::Gte);
+  static_assert(VersionReq::parseConst(">=1.2.3 && <2").right.has_value());
+
+  constexpr VersionReq req = VersionReq::parseConst(">=1.2.3 && <2");
+  rs::assertEq(req.toString(), ">=1.2.3 && <2");
+  rs::assertTrue(req.satisfiedBy(Version::parse("1.5.0").unwrap()));
+  rs::assertFalse(req.satisfiedBy(Version::parse("2.0.0").unwrap()));
+
+  rs::pass();
+}
+
+static void testMatchAll() {
+  const std::vector<Version> vers = {
+    Version::parse("0.9.9").unwrap(),    Version::parse("1.0.0").unwrap(),
+    Version::parse("1.2.3").unwrap(),    Version::parse("1.9.9").unwrap(),
+    Version::parse("2.0.0-pre").unwrap(), Version::parse("2.0.0").unwrap(),
+  };
+
+  const CompiledVersionReq req = VersionReq::parse(">=1.0.0 && <2").unwrap().compile();
+  rs::assertTrue(req.regular);
+  const std::vector<uint64_t> bits = req.matchAll(vers);
+  rs::assertEq(bits.size(), std::size_t{ 1 });
+  // 1.0.0, 1.2.3, and 1.9.9 match; 2.0.0-pre is rejected by the
+  // prerelease gate.
+  rs::assertEq(bits[0], uint64_t{ 0b001110 });
+
+  // A prerelease bound cannot be lowered; the compiled form falls back
+  // to the comparator walk.
+  const CompiledVersionReq preReq =
+      VersionReq::parse(">=2.0.0-alpha").unwrap().compile();
+  rs::assertFalse(preReq.regular);
+  const std::vector<uint64_t> preBits = preReq.matchAll(vers);
+  rs::assertEq(preBits[0], uint64_t{ 0b110000 });
+
+  rs::pass();
+}
+
 int main() {
   testBasic();
   testExact();
@@ -1389,6 +1597,8 @@ int main() {
   testToString();
   testToPkgConfigString();
   testCanSimplify();
+  testParseConstReq();
+  testMatchAll();
 }
 
 #endif
@@ -1,15 +1,31 @@
 #include "Builder/Builder.hpp"
 
 #include "Algos.hpp"
+#include "Builder/ScanCache.hpp"
+#include "Builder/TemplateDedup.hpp"
+#include "Builder/TimeTraceReport.hpp"
+#include "Builder/Timings.hpp"
 #include "Command.hpp"
 #include "Diag.hpp"
 #include "Parallelism.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <span>
+#include <spdlog/spdlog.h>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tbb/task_group.h>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -22,8 +38,12 @@ Builder::Builder(fs::path rootPath, BuildProfile buildProfile)
 rs::Result<void> Builder::schedule(const ScheduleOptions& options) {
   this->options = options;
 
-  rs_try(depGraph.resolve());
-  graphState.emplace(rs_try(depGraph.computeBuildGraph(buildProfile)));
+  {
+    const Timings::Span span("phase", "resolve");
+    rs_try(depGraph.resolve());
+    graphState.emplace(rs_try(
+        depGraph.computeBuildGraph(buildProfile, options.profileOverride)));
+  }
 
   const bool logAnalysis = !options.suppressAnalysisLog;
   if (logAnalysis) {
@@ -33,13 +53,49 @@ rs::Result<void> Builder::schedule(const ScheduleOptions& options) {
   if (options.enableCoverage) {
     graphState->enableCoverage();
   }
-  rs_try(
-      graphState->installDeps(options.includeDevDeps, options.suppressDepDiag));
-  rs_try(graphState->plan(false));
+  if (options.includeBenches) {
+    graphState->enableBenches();
+  }
+  if (options.unityGroupSize > 0) {
+    graphState->setUnityGroupSize(options.unityGroupSize);
+  }
+  graphState->setKeepGoing(options.keepGoing);
+  if (options.dedupTemplates) {
+    graphState->enableTemplateDedup();
+  }
+  if (options.timeTrace) {
+    graphState->enableTimeTrace();
+  }
+  if (options.combinedTests) {
+    graphState->enableCombinedTests();
+  }
+  {
+    const Timings::Span span("phase", "install-deps");
+    // Dependency installation is network-bound while the source-tree walk
+    // is disk-bound; overlap them.  Include scanning still runs inside
+    // plan(), after the dependency include dirs are known.
+    tbb::task_group discovery;
+    discovery.run([&] { graphState->prediscoverSources(); });
+    rs::Result<void> installed = graphState->installDeps(
+        options.includeDevDeps, options.suppressDepDiag);
+    discovery.wait();
+    rs_try(std::move(installed));
+  }
+  {
+    const Timings::Span span("phase", "plan");
+    rs_try(graphState->plan(false));
+  }
   outDir = graphState->outBasePath();
   return rs::Ok();
 }
 
+rs::Result<void> Builder::replan() {
+  rs_try(ensurePlanned());
+  // Re-plan against the already-resolved dependency graph; the scan cache
+  // keeps this cheap when few files changed.
+  return graphState->plan(false);
+}
+
 rs::Result<void> Builder::ensurePlanned() const {
   rs_ensure(graphState.has_value(), "builder.schedule() must be called first");
   return rs::Ok();
@@ -66,21 +122,174 @@ rs::Result<void> Builder::build() {
   const auto endBuild = std::chrono::steady_clock::now();
   const std::chrono::duration<double> buildElapsed = endBuild - startBuild;
 
-  const Profile& profile = mf.profiles.at(buildProfile);
+  const Profile& profile = graphState->profile();
   rs_ensure(status.success(), "build failed");
   if (!options.suppressFinishLog) {
     Diag::info("Finished", "`{}` profile [{}] target(s) in {:.2f}s",
                buildProfile, profile, buildElapsed.count());
   }
+  if (graphState->dedupCalibrationPending()) {
+    const std::size_t numShared = TemplateDedup::harvestTimeTraces(outDir);
+    Diag::info("Calibrated",
+               "{} duplicated template instantiation(s) recorded; the next "
+               "`--dedup-templates` build shares them",
+               numShared);
+  }
+  if (graphState->timeTracePending()) {
+    const std::size_t numTraces = writeTimeTraceReport(outDir);
+    Diag::info("Trace", "merged {} TU trace(s) into {}/time-trace.json",
+               numTraces, fs::relative(outDir, basePath).string());
+  }
   return rs::Ok();
 }
 
-rs::Result<void> Builder::test(std::optional<std::string> testName) {
+rs::Result<void> Builder::buildBinary() {
+  rs_try(ensurePlanned());
+  const Manifest& mf = graphState->manifest();
+  rs_ensure(graphState->hasBinaryTarget(), "no binary target to build");
+
+  const auto startBuild = std::chrono::steady_clock::now();
+
+  // One schedule for the binary target alone: the executor walks back to
+  // exactly the object closure the link needs (including the library
+  // archive when it is linked in), so compiles, the archive, and the
+  // final link overlap within the wave schedule instead of running as
+  // two sequential phases.
+  const ExitStatus status =
+      rs_try(graphState->buildTargets({ mf.package.name }, mf.package.name));
+
+  const auto endBuild = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> buildElapsed = endBuild - startBuild;
+
+  rs_ensure(status.success(), "build failed");
+  if (!options.suppressFinishLog) {
+    const Profile& profile = graphState->profile();
+    Diag::info("Finished", "`{}` profile [{}] target(s) in {:.2f}s",
+               buildProfile, profile, buildElapsed.count());
+  }
+  return rs::Ok();
+}
+
+static std::string profrawPatternFor(const fs::path& coverageDir,
+                                     std::string target) {
+  std::ranges::replace(target, '/', '-');
+  return (coverageDir / (target + "-%p.profraw")).string();
+}
+
+// Merges the per-test .profraw files under `coverageDir` into
+// coverage.profdata, sharding llvm-profdata across the job budget when
+// there are many profiles.
+static rs::Result<void> mergeCoverageProfiles(const fs::path& coverageDir) {
+  std::vector<std::string> profraws;
+  for (const auto& entry : fs::directory_iterator(coverageDir)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".profraw") {
+      profraws.push_back(entry.path().string());
+    }
+  }
+  if (profraws.empty()) {
+    // gcov-style instrumentation (GCC) leaves .gcda files next to the
+    // objects instead; nothing for llvm-profdata to do.
+    spdlog::debug("no .profraw files under {}", coverageDir.string());
+    return rs::Ok();
+  }
+  if (!commandExists("llvm-profdata")) {
+    Diag::warn("llvm-profdata not found; leaving raw profiles in {}",
+               coverageDir.string());
+    return rs::Ok();
+  }
+  std::ranges::sort(profraws);
+
+  const std::size_t numShards =
+      std::min(std::max<std::size_t>(getParallelism(), 1), profraws.size());
+  std::vector<std::string> shardOutputs;
+  if (numShards > 1) {
+    const std::size_t perShard = (profraws.size() + numShards - 1) / numShards;
+    std::vector<Child> children;
+    std::size_t shard = 0;
+    for (std::size_t base = 0; base < profraws.size();
+         base += perShard, ++shard) {
+      const std::size_t count = std::min(perShard, profraws.size() - base);
+      const std::string out =
+          (coverageDir / fmt::format("shard-{}.profdata", shard)).string();
+      Command merge("llvm-profdata");
+      merge.addArg("merge").addArg("-sparse");
+      for (std::size_t i = 0; i < count; ++i) {
+        merge.addArg(profraws[base + i]);
+      }
+      merge.addArg("-o").addArg(out);
+      merge.setStdOutConfig(Command::IOConfig::Piped);
+      merge.setStdErrConfig(Command::IOConfig::Piped);
+      children.push_back(rs_try(merge.spawn()));
+      shardOutputs.push_back(out);
+    }
+    const std::vector<CommandOutput> outputs =
+        rs_try(waitAllWithOutput(children));
+    for (const CommandOutput& output : outputs) {
+      rs_ensure(output.exitStatus.success(), "llvm-profdata {}: {}",
+                output.exitStatus, output.stdErr);
+    }
+  } else {
+    shardOutputs = profraws;
+  }
+
+  const fs::path merged = coverageDir / "coverage.profdata";
+  Command finalMerge("llvm-profdata");
+  finalMerge.addArg("merge").addArg("-sparse");
+  finalMerge.addArgs(std::span<const std::string>(shardOutputs));
+  finalMerge.addArg("-o").addArg(merged.string());
+  const ExitStatus mergeStatus = rs_try(execCmd(finalMerge));
+  rs_ensure(mergeStatus.success(), "llvm-profdata {}", mergeStatus);
+
+  if (numShards > 1) {
+    for (const std::string& out : shardOutputs) {
+      fs::remove(out);
+    }
+  }
+  Diag::info("Coverage", "merged profile at {}", merged.string());
+  return rs::Ok();
+}
+
+// Deterministic across machines, processes, and library versions
+// (std::hash is none of these), so every CI node derives the same test
+// partition independently.  FNV-1a.
+static std::uint64_t stableHash(const std::string_view str) noexcept {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+rs::Result<void> Builder::test(std::optional<std::string> testName,
+                               const bool noCache,
+                               const std::optional<TestShard> shard,
+                               const bool buildAll) {
   rs_try(ensurePlanned());
 
   const Manifest& mf = graphState->manifest();
   const std::vector<BuildGraph::TestTarget>& targets =
       graphState->testTargets();
+  if (targets.empty()) {
+    Diag::warn("No test targets found");
+    return rs::Ok();
+  }
+
+  // With --shard K/N only this node's bucket is built and run; the
+  // others' test objects and links never enter the schedule.
+  std::vector<const BuildGraph::TestTarget*> selected;
+  selected.reserve(targets.size());
+  for (const auto& target : targets) {
+    if (shard.has_value()
+        && stableHash(target.sourcePath) % shard->count != shard->index - 1) {
+      continue;
+    }
+    selected.push_back(&target);
+  }
+  if (selected.empty()) {
+    Diag::warn("no tests fall in shard {}/{}", shard->index, shard->count);
+    return rs::Ok();
+  }
 
   const auto buildStart = std::chrono::steady_clock::now();
   ExitStatus status(EXIT_SUCCESS);
@@ -92,23 +301,34 @@ rs::Result<void> Builder::test(std::optional<std::string> testName) {
     rs_ensure(status.success(), "build failed");
   }
 
-  if (!targets.empty()) {
+  {
     std::vector<std::string> names;
-    names.reserve(targets.size());
-    for (const auto& target : targets) {
-      names.push_back(target.ninjaTarget);
+    names.reserve(selected.size());
+    for (const BuildGraph::TestTarget* target : selected) {
+      names.push_back(target->ninjaTarget);
+    }
+    // Only relink the test binaries whose object closure is out of date;
+    // an edit to one lib file usually affects a handful of the test
+    // links.  Unaffected binaries keep their digest, so the pass cache
+    // still decides whether they run.  --all restores the full build.
+    std::vector<std::string> toBuild = names;
+    if (!buildAll) {
+      toBuild = rs_try(graphState->affectedTargets(names));
+      if (toBuild.size() < names.size()) {
+        spdlog::debug("{} of {} test binaries affected", toBuild.size(),
+                      names.size());
+      }
+    }
+    if (!toBuild.empty()) {
+      status = rs_try(graphState->buildTargets(
+          toBuild, fmt::format("{}(test)", mf.package.name)));
+      rs_ensure(status.success(), "build failed");
     }
-    status = rs_try(graphState->buildTargets(
-        names, fmt::format("{}(test)", mf.package.name)));
-    rs_ensure(status.success(), "build failed");
-  } else {
-    Diag::warn("No test targets found");
-    return rs::Ok();
   }
 
   const auto buildEnd = std::chrono::steady_clock::now();
   const std::chrono::duration<double> buildElapsed = buildEnd - buildStart;
-  const Profile& profile = mf.profiles.at(buildProfile);
+  const Profile& profile = graphState->profile();
   Diag::info("Finished", "`{}` profile [{}] target(s) in {:.2f}s", buildProfile,
              profile, buildElapsed.count());
 
@@ -129,35 +349,214 @@ rs::Result<void> Builder::test(std::optional<std::string> testName) {
     std::unreachable();
   };
 
-  for (const auto& testTarget : targets) {
+  std::vector<const BuildGraph::TestTarget*> toRun;
+  toRun.reserve(selected.size());
+  for (const BuildGraph::TestTarget* testTarget : selected) {
     if (testName.has_value()
-        && !testTarget.ninjaTarget.contains(testName.value())) {
+        && !testTarget->ninjaTarget.contains(testName.value())) {
       ++numFilteredOut;
       continue;
     }
+    toRun.push_back(testTarget);
+  }
+
+  // Pass results are cached keyed by the test executable's content hash:
+  // if neither the binary nor anything linked into it changed since the
+  // last pass, the run is skipped.  --no-cache forces every test.
+  const fs::path cachePath = outDir / "test-results.json";
+  nlohmann::json cachedPasses = nlohmann::json::object();
+  nlohmann::json cachedDurations = nlohmann::json::object();
+  if (fs::exists(cachePath)) {
+    try {
+      std::ifstream ifs(cachePath);
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (loaded.is_object() && loaded.contains("passed")) {
+        cachedPasses = loaded["passed"];
+      }
+      if (loaded.is_object() && loaded.contains("durations")) {
+        cachedDurations = loaded["durations"];
+      }
+    } catch (const nlohmann::json::parse_error& e) {
+      spdlog::debug("discarding test result cache: {}", e.what());
+    }
+  }
 
-    const fs::path absoluteBinary = outDir / testTarget.ninjaTarget;
-    const std::string testBinPath =
-        fs::relative(absoluteBinary, mf.path.parent_path()).string();
-    Diag::info("Running", "{} test {} ({})", labelFor(testTarget.kind),
-               testTarget.sourcePath, testBinPath);
+  // Coverage runs must execute every test (a cached pass produces no
+  // profile) and collect per-process .profraw files for merging.
+  const bool coverage = options.enableCoverage;
+  const fs::path coverageDir = outDir / "coverage";
+  if (coverage) {
+    fs::remove_all(coverageDir); // stale profiles would pollute the merge
+    fs::create_directories(coverageDir);
+  }
 
-    const ExitStatus curExitStatus =
-        rs_try(execCmd(Command(absoluteBinary.string())));
-    if (curExitStatus.success()) {
-      ++numPassed;
-    } else {
-      ++numFailed;
-      summaryStatus = curExitStatus;
+  std::size_t numCached = 0;
+  std::unordered_map<std::string, std::string> binDigests;
+  std::vector<const BuildGraph::TestTarget*> pending;
+  pending.reserve(toRun.size());
+  for (const BuildGraph::TestTarget* testTarget : toRun) {
+    const std::string digest = digestFile(outDir / testTarget->ninjaTarget);
+    binDigests.emplace(testTarget->ninjaTarget, digest);
+    if (!noCache && !coverage && cachedPasses.contains(testTarget->ninjaTarget)
+        && cachedPasses[testTarget->ninjaTarget] == digest) {
+      Diag::info("Cached", "{} test {} (pass)", labelFor(testTarget->kind),
+                 testTarget->sourcePath);
+      ++numCached;
+      continue;
+    }
+    pending.push_back(testTarget);
+  }
+
+  // `[package] test-threads` pins the process count for tests that need
+  // isolation; otherwise the -j/--jobs budget applies.
+  const std::size_t testThreads =
+      mf.package.testThreads > 0 ? mf.package.testThreads : getParallelism();
+
+  // Longest-first (LPT): starting the slowest tests first keeps the
+  // run's tail short -- a 90s test spawned last would bound the whole
+  // wall clock by itself.  Tests without a recorded duration sort first
+  // so they get measured before they can hide at the end of the run.
+  const auto recordedMs = [&](const BuildGraph::TestTarget* t) {
+    const auto it = cachedDurations.find(t->ninjaTarget);
+    if (it == cachedDurations.end() || !it->is_number_integer()) {
+      return std::numeric_limits<std::int64_t>::max();
+    }
+    return it->get<std::int64_t>();
+  };
+  std::ranges::stable_sort(pending, [&](const auto* a, const auto* b) {
+    return recordedMs(a) > recordedMs(b);
+  });
+
+  std::unordered_map<std::string, std::int64_t> measuredMs;
+
+  if (testThreads <= 1 || pending.size() <= 1) {
+    for (const BuildGraph::TestTarget* testTarget : pending) {
+      const fs::path absoluteBinary = outDir / testTarget->ninjaTarget;
+      const std::string testBinPath =
+          fs::relative(absoluteBinary, mf.path.parent_path()).string();
+      Diag::info("Running", "{} test {} ({})", labelFor(testTarget->kind),
+                 testTarget->sourcePath, testBinPath);
+
+      Command command(absoluteBinary.string());
+      if (coverage) {
+        command.setEnv("LLVM_PROFILE_FILE",
+                       profrawPatternFor(coverageDir, testTarget->ninjaTarget));
+      }
+      const auto testStart = std::chrono::steady_clock::now();
+      const ExitStatus curExitStatus = rs_try(execCmd(command));
+      measuredMs[testTarget->ninjaTarget] =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - testStart)
+              .count();
+      if (curExitStatus.success()) {
+        ++numPassed;
+        cachedPasses[testTarget->ninjaTarget] =
+            binDigests.at(testTarget->ninjaTarget);
+      } else {
+        ++numFailed;
+        cachedPasses.erase(testTarget->ninjaTarget);
+        summaryStatus = curExitStatus;
+      }
+    }
+  } else {
+    // Run up to `testThreads` test processes at a time with buffered
+    // output, reporting each wave in discovery order so the log stays
+    // deterministic regardless of completion order.
+    for (std::size_t base = 0; base < pending.size(); base += testThreads) {
+      const std::size_t count = std::min(testThreads, pending.size() - base);
+
+      std::vector<Child> children;
+      children.reserve(count);
+      for (std::size_t i = 0; i < count; ++i) {
+        const BuildGraph::TestTarget& testTarget = *pending[base + i];
+        const fs::path absoluteBinary = outDir / testTarget.ninjaTarget;
+        Diag::info("Running", "{} test {} ({})", labelFor(testTarget.kind),
+                   testTarget.sourcePath,
+                   fs::relative(absoluteBinary, mf.path.parent_path())
+                       .string());
+
+        Command command(absoluteBinary.string());
+        command.setStdOutConfig(Command::IOConfig::Piped);
+        command.setStdErrConfig(Command::IOConfig::Piped);
+        if (coverage) {
+          command.setEnv("LLVM_PROFILE_FILE",
+                         profrawPatternFor(coverageDir,
+                                           testTarget.ninjaTarget));
+        }
+        children.push_back(rs_try(command.spawn()));
+      }
+
+      const std::vector<CommandOutput> outputs =
+          rs_try(waitAllWithOutput(children));
+      for (std::size_t i = 0; i < count; ++i) {
+        const BuildGraph::TestTarget& testTarget = *pending[base + i];
+        const CommandOutput& output = outputs[i];
+        if (!output.stdOut.empty()) {
+          fmt::print("{}", output.stdOut);
+        }
+        if (!output.stdErr.empty()) {
+          fmt::print(stderr, "{}", output.stdErr);
+        }
+        measuredMs[testTarget.ninjaTarget] = output.durationMs;
+        if (output.exitStatus.success()) {
+          ++numPassed;
+          cachedPasses[testTarget.ninjaTarget] =
+              binDigests.at(testTarget.ninjaTarget);
+        } else {
+          ++numFailed;
+          cachedPasses.erase(testTarget.ninjaTarget);
+          summaryStatus = output.exitStatus;
+        }
+      }
     }
   }
 
   const auto runEnd = std::chrono::steady_clock::now();
   const std::chrono::duration<double> runElapsed = runEnd - runStart;
 
-  const std::string summary =
-      fmt::format("{} passed; {} failed; {} filtered out; finished in {:.2f}s",
-                  numPassed, numFailed, numFilteredOut, runElapsed.count());
+  if (coverage) {
+    rs_try(mergeCoverageProfiles(coverageDir));
+  }
+
+  for (const auto& [target, ms] : measuredMs) {
+    cachedDurations[target] = ms;
+  }
+
+  // One dominating test caps what parallelism can recover: if it alone
+  // takes longer than everything else combined, the wall clock is bound
+  // by it no matter the schedule.  Surface it as a splitting candidate.
+  if (testThreads > 1 && measuredMs.size() > 1) {
+    std::int64_t totalMs = 0;
+    std::int64_t maxMs = 0;
+    std::string_view slowest;
+    for (const auto& [target, ms] : measuredMs) {
+      totalMs += ms;
+      if (ms > maxMs) {
+        maxMs = ms;
+        slowest = target;
+      }
+    }
+    if (maxMs * 2 > totalMs) {
+      Diag::warn(
+          "test {} dominates the parallel run ({:.1f}s of {:.1f}s spent "
+          "testing); splitting it would shorten the tail",
+          slowest, static_cast<double>(maxMs) / 1000.0,
+          static_cast<double>(totalMs) / 1000.0);
+    }
+  }
+
+  {
+    nlohmann::json json;
+    json["version"] = 1;
+    json["passed"] = std::move(cachedPasses);
+    json["durations"] = std::move(cachedDurations);
+    std::ofstream ofs(cachePath);
+    ofs << json.dump();
+  }
+
+  const std::string summary = fmt::format(
+      "{} passed; {} cached; {} failed; {} filtered out; finished in {:.2f}s",
+      numPassed, numCached, numFailed, numFilteredOut, runElapsed.count());
   if (!summaryStatus.success()) {
     return rs::Err(rs::anyhow(summary));
   }
@@ -167,8 +566,170 @@ rs::Result<void> Builder::test(std::optional<std::string> testName) {
   return rs::Ok();
 }
 
+namespace {
+
+struct BenchStats {
+  double meanNs = 0.0;
+  double medianNs = 0.0;
+  double stddevNs = 0.0;
+};
+
+BenchStats computeStats(std::vector<double> samplesNs) {
+  BenchStats stats;
+  const double count = static_cast<double>(samplesNs.size());
+  for (const double sample : samplesNs) {
+    stats.meanNs += sample;
+  }
+  stats.meanNs /= count;
+
+  std::ranges::sort(samplesNs);
+  const std::size_t mid = samplesNs.size() / 2;
+  stats.medianNs = samplesNs.size() % 2 == 1
+                       ? samplesNs[mid]
+                       : (samplesNs[mid - 1] + samplesNs[mid]) / 2.0;
+
+  if (samplesNs.size() > 1) {
+    double sumSq = 0.0;
+    for (const double sample : samplesNs) {
+      sumSq += (sample - stats.meanNs) * (sample - stats.meanNs);
+    }
+    stats.stddevNs = std::sqrt(sumSq / (count - 1.0));
+  }
+  return stats;
+}
+
+std::string formatNs(const double ns) {
+  if (ns < 1e3) {
+    return fmt::format("{:.0f}ns", ns);
+  }
+  if (ns < 1e6) {
+    return fmt::format("{:.2f}us", ns / 1e3);
+  }
+  if (ns < 1e9) {
+    return fmt::format("{:.2f}ms", ns / 1e6);
+  }
+  return fmt::format("{:.3f}s", ns / 1e9);
+}
+
+} // namespace
+
+rs::Result<void> Builder::bench(std::optional<std::string> benchName) {
+  rs_try(ensurePlanned());
+
+  const Manifest& mf = graphState->manifest();
+  const std::vector<BuildGraph::BenchTarget>& targets =
+      graphState->benchTargets();
+  if (targets.empty()) {
+    Diag::warn("No bench targets found");
+    return rs::Ok();
+  }
+
+  ExitStatus status(EXIT_SUCCESS);
+  if (graphState->hasLibraryTarget()) {
+    status = rs_try(
+        graphState->buildTargets({ graphState->libraryName() },
+                                 fmt::format("{}(lib)", mf.package.name)));
+    rs_ensure(status.success(), "build failed");
+  }
+
+  std::vector<std::string> names;
+  names.reserve(targets.size());
+  for (const auto& target : targets) {
+    names.push_back(target.ninjaTarget);
+  }
+  status = rs_try(graphState->buildTargets(
+      names, fmt::format("{}(bench)", mf.package.name)));
+  rs_ensure(status.success(), "build failed");
+
+  // Previous results, for run-over-run comparison.
+  const fs::path resultsPath = outDir / "bench" / "results.json";
+  nlohmann::json previous = nlohmann::json::object();
+  if (fs::exists(resultsPath)) {
+    try {
+      std::ifstream ifs(resultsPath);
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (loaded.is_object() && loaded.contains("benches")) {
+        previous = loaded["benches"];
+      }
+    } catch (const nlohmann::json::parse_error& e) {
+      spdlog::debug("discarding bench results: {}", e.what());
+    }
+  }
+
+  nlohmann::json results = nlohmann::json::object();
+  for (const auto& target : targets) {
+    if (benchName.has_value()
+        && !target.ninjaTarget.contains(benchName.value())) {
+      continue;
+    }
+
+    const fs::path absoluteBinary = outDir / target.ninjaTarget;
+    Diag::info("Benchmarking", "{} ({})", target.sourcePath,
+               fs::relative(absoluteBinary, mf.path.parent_path()).string());
+
+    const auto runOnce = [&]() -> rs::Result<double> {
+      const auto start = std::chrono::steady_clock::now();
+      const ExitStatus exitStatus =
+          rs_try(execCmd(Command(absoluteBinary.string())));
+      const auto end = std::chrono::steady_clock::now();
+      rs_ensure(exitStatus.success(), "bench {} {}", target.ninjaTarget,
+                exitStatus);
+      return rs::Ok(static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count()));
+    };
+
+    // Warmup run, whose time also calibrates the sample count: aim for
+    // ~3s of total measurement, bounded to [10, 100] runs.
+    const double warmupNs = rs_try(runOnce());
+    static constexpr double targetTotalNs = 3e9;
+    static constexpr std::size_t minRuns = 10;
+    static constexpr std::size_t maxRuns = 100;
+    const std::size_t runs = std::clamp(
+        static_cast<std::size_t>(targetTotalNs / std::max(warmupNs, 1.0)),
+        minRuns, maxRuns);
+
+    std::vector<double> samplesNs;
+    samplesNs.reserve(runs);
+    for (std::size_t i = 0; i < runs; ++i) {
+      samplesNs.push_back(rs_try(runOnce()));
+    }
+
+    const BenchStats stats = computeStats(std::move(samplesNs));
+    std::string change;
+    if (previous.contains(target.ninjaTarget)
+        && previous[target.ninjaTarget].contains("meanNs")) {
+      const double prevMeanNs = previous[target.ninjaTarget]["meanNs"];
+      if (prevMeanNs > 0.0) {
+        const double delta = (stats.meanNs - prevMeanNs) / prevMeanNs * 100.0;
+        change = fmt::format("; {:+.1f}% vs previous run", delta);
+      }
+    }
+    Diag::info("Bench",
+               "{}: mean {}, median {}, stddev {} ({} runs{})",
+               target.ninjaTarget, formatNs(stats.meanNs),
+               formatNs(stats.medianNs), formatNs(stats.stddevNs), runs,
+               change);
+
+    results[target.ninjaTarget] = { { "meanNs", stats.meanNs },
+                                    { "medianNs", stats.medianNs },
+                                    { "stddevNs", stats.stddevNs },
+                                    { "runs", runs } };
+  }
+
+  if (!results.empty()) {
+    nlohmann::json json;
+    json["version"] = 1;
+    json["benches"] = std::move(results);
+    fs::create_directories(resultsPath.parent_path());
+    std::ofstream ofs(resultsPath);
+    ofs << json.dump();
+  }
+  return rs::Ok();
+}
+
 rs::Result<void> Builder::run(const std::vector<std::string>& args) {
-  rs_try(build());
+  rs_try(buildBinary());
 
   const Manifest& mf = graphState->manifest();
   Diag::info("Running", "`{}/{}`",
@@ -3,7 +3,9 @@
 #include "Builder/BuildGraph.hpp"
 #include "Builder/BuildProfile.hpp"
 #include "Builder/DepGraph.hpp"
+#include "Manifest.hpp"
 
+#include <cstddef>
 #include <filesystem>
 #include <optional>
 #include <rs/result.hpp>
@@ -17,9 +19,27 @@ namespace fs = std::filesystem;
 struct ScheduleOptions {
   bool includeDevDeps = false;
   bool enableCoverage = false;
+  bool includeBenches = false;
   bool suppressAnalysisLog = false;
   bool suppressFinishLog = false;
   bool suppressDepDiag = false;
+  /// Keep scanning after the first failure and report every error at the
+  /// end (ninja's -k); by default parallel scans cancel on first error.
+  bool keepGoing = false;
+  /// Coordinate duplicated template instantiations into one shared TU
+  /// (see TemplateDedup); the first such build is a calibration pass.
+  bool dedupTemplates = false;
+  /// Compile with -ftime-trace and merge the per-object traces into one
+  /// aggregated compile-time report after the build.
+  bool timeTrace = false;
+  /// Link every unit-test TU into one forking runner binary instead of
+  /// one binary per file (see BuildGraph::enableCombinedTests).
+  bool combinedTests = false;
+  std::size_t unityGroupSize = 0; // 0: normal per-file compilation
+  /// Per-package profile override from the workspace root
+  /// (`[profile.<key>.package.<name>]`), applied on top of this
+  /// package's own profile.
+  std::optional<ProfileOverride> profileOverride;
 };
 
 class Builder {
@@ -27,8 +47,24 @@ public:
   Builder(fs::path rootPath, BuildProfile buildProfile);
 
   rs::Result<void> schedule(const ScheduleOptions& options = {});
+  rs::Result<void> replan();
   rs::Result<void> build();
-  rs::Result<void> test(std::optional<std::string> testName);
+  /// Builds only the binary target's dependency closure, skipping the
+  /// separate library phase that `build()` runs first.  `run` uses this
+  /// so its latency approaches pure link+exec on small changes.
+  rs::Result<void> buildBinary();
+  /// One CI node's slice of the test list: 1-based shard `index` out of
+  /// `count` deterministic buckets.
+  struct TestShard {
+    std::size_t index = 1;
+    std::size_t count = 1;
+  };
+
+  rs::Result<void> test(std::optional<std::string> testName,
+                        bool noCache = false,
+                        std::optional<TestShard> shard = {},
+                        bool buildAll = false);
+  rs::Result<void> bench(std::optional<std::string> benchName);
   rs::Result<void> run(const std::vector<std::string>& args);
 
   const BuildGraph& graph() const;
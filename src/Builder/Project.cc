@@ -2,13 +2,21 @@
 
 #include "Algos.hpp"
 #include "Builder/BuildProfile.hpp"
+#include "Builder/ScanCache.hpp"
 #include "Git2.hpp"
 #include "TermColor.hpp"
 
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
 #include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
 #include <rs/result.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -75,15 +83,153 @@ static std::vector<std::string> getEnvFlags(const char* name) {
   return {};
 }
 
+static constexpr const char* OPTS_SNAPSHOT_FILE = "compiler-opts.json";
+
+static std::string statOf(const fs::path& path) {
+  std::error_code ec;
+  const std::uintmax_t size = fs::file_size(path, ec);
+  if (ec) {
+    return "missing";
+  }
+  const auto mtime = fs::last_write_time(path, ec);
+  if (ec) {
+    return "missing";
+  }
+  return fmt::format("{}:{}", size, mtime.time_since_epoch().count());
+}
+
+// Validity digest for the resolved-flags snapshot.  Everything the
+// resolution reads is folded in: the manifest (profiles, edition, package
+// metadata), the effective profile (which may differ from the manifest's
+// when a workspace override applies), the env flag strings, the color
+// decision, the existence of the implicit include roots, and the git
+// state that feeds the COMMIT_* macros (HEAD content catches branch
+// switches, the index stat catches new commits on the same branch).
+static std::string snapshotKey(const BuildProfile& buildProfile,
+                               const Profile& profile,
+                               const fs::path& rootPath,
+                               const fs::path& manifestPath) {
+  const auto env = [](const char* name) {
+    const char* val = std::getenv(name);
+    return val != nullptr ? std::string_view(val) : std::string_view();
+  };
+  return digestString(fmt::format(
+      "{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}{}{}\x1f{}\x1f{}",
+      fmt::format("{}", buildProfile), digestString(fmt::format("{:?}", profile)),
+      digestFile(manifestPath),
+      env("CXXFLAGS"), env("LDFLAGS"), shouldColorStderr() ? 1 : 0,
+      fs::exists(rootPath / "src") ? 1 : 0,
+      fs::exists(rootPath / "include") ? 1 : 0,
+      fs::exists(rootPath / "tests") ? 1 : 0,
+      digestFile(rootPath / ".git" / "HEAD"),
+      statOf(rootPath / ".git" / "index")));
+}
+
+// One contiguous read and parse instead of re-running env parsing, the
+// libgit2 HEAD lookup, and the per-macro formatting on every command
+// that constructs a Project.
+static std::optional<CompilerOpts> loadOptsSnapshot(const fs::path& path,
+                                                    const std::string& key) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    return std::nullopt;
+  }
+  try {
+    const nlohmann::json snap = nlohmann::json::parse(ifs);
+    if (!snap.is_object() || snap.value("version", 0) != 1
+        || snap.at("key") != key) {
+      return std::nullopt;
+    }
+    CompilerOpts opts;
+    for (const nlohmann::json& macro : snap.at("macros")) {
+      opts.cFlags.macros.emplace_back(macro.at(0).get<std::string>(),
+                                      macro.at(1).get<std::string>());
+    }
+    for (const nlohmann::json& inc : snap.at("includeDirs")) {
+      opts.cFlags.includeDirs.emplace_back(
+          fs::path(inc.at(0).get<std::string>()), inc.at(1).get<bool>());
+    }
+    for (const nlohmann::json& other : snap.at("cOthers")) {
+      opts.cFlags.others.emplace_back(other.get<std::string>());
+    }
+    for (const nlohmann::json& dir : snap.at("libDirs")) {
+      opts.ldFlags.libDirs.emplace_back(fs::path(dir.get<std::string>()));
+    }
+    for (const nlohmann::json& lib : snap.at("libs")) {
+      opts.ldFlags.libs.emplace_back(lib.get<std::string>());
+    }
+    for (const nlohmann::json& other : snap.at("ldOthers")) {
+      opts.ldFlags.others.emplace_back(other.get<std::string>());
+    }
+    return opts;
+  } catch (const std::exception& e) {
+    spdlog::debug("discarding compiler opts snapshot: {}", e.what());
+    return std::nullopt;
+  }
+}
+
+static void saveOptsSnapshot(const fs::path& path, const std::string& key,
+                             const CompilerOpts& opts) {
+  nlohmann::json snap;
+  snap["version"] = 1;
+  snap["key"] = key;
+  snap["macros"] = nlohmann::json::array();
+  for (const Macro& macro : opts.cFlags.macros) {
+    snap["macros"].push_back({ macro.name, macro.value });
+  }
+  snap["includeDirs"] = nlohmann::json::array();
+  for (const IncludeDir& inc : opts.cFlags.includeDirs) {
+    snap["includeDirs"].push_back({ inc.dir.string(), inc.isSystem });
+  }
+  snap["cOthers"] = opts.cFlags.others;
+  snap["libDirs"] = nlohmann::json::array();
+  for (const LibDir& dir : opts.ldFlags.libDirs) {
+    snap["libDirs"].push_back(dir.dir.string());
+  }
+  snap["libs"] = nlohmann::json::array();
+  for (const Lib& lib : opts.ldFlags.libs) {
+    snap["libs"].push_back(lib.name);
+  }
+  snap["ldOthers"] = opts.ldFlags.others;
+
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  std::ofstream ofs(path);
+  ofs << snap.dump();
+}
+
 Project::Project(const BuildProfile& buildProfile, Manifest m,
-                 CompilerOpts opts)
+                 CompilerOpts opts,
+                 const std::optional<ProfileOverride>& profileOverride)
     : rootPath(m.path.parent_path()),
       outBasePath(rootPath / "cabin-out" / fmt::format("{}", buildProfile)),
       buildOutPath(outBasePath / (m.package.name + ".d")),
       unittestOutPath(outBasePath / "unit"),
-      integrationTestOutPath(outBasePath / "intg"), manifest(std::move(m)),
+      integrationTestOutPath(outBasePath / "intg"),
+      benchOutPath(outBasePath / "bench"), manifest(std::move(m)),
+      profile(profileOverride
+                  ? profileOverride->applyTo(manifest.profiles.at(buildProfile))
+                  : manifest.profiles.at(buildProfile)),
       compilerOpts(std::move(opts)) //
 {
+  // The fully resolved flag set is snapshotted per profile: on a warm run
+  // with an unchanged manifest, environment, and git HEAD, the snapshot
+  // is rehydrated instead of resolved.  Dependency flags are merged into
+  // `compilerOpts` later, after the snapshot point, so they never leak
+  // into the cache.
+  const fs::path snapshotPath = outBasePath / OPTS_SNAPSHOT_FILE;
+  const std::string key =
+      snapshotKey(buildProfile, profile, rootPath, manifest.path);
+  if (std::optional<CompilerOpts> snapshot =
+          loadOptsSnapshot(snapshotPath, key)) {
+    compilerOpts = std::move(*snapshot);
+    return;
+  }
+  resolveCompilerOpts(buildProfile);
+  saveOptsSnapshot(snapshotPath, key, compilerOpts);
+}
+
+void Project::resolveCompilerOpts(const BuildProfile& buildProfile) {
   includeIfExist(rootPath / "src", /*isSystem=*/false);
   includeIfExist(rootPath / "include", /*isSystem=*/false);
   if (buildProfile == BuildProfile::Test) {
@@ -96,19 +242,30 @@ Project::Project(const BuildProfile& buildProfile, Manifest m,
     compilerOpts.cFlags.others.emplace_back("-fdiagnostics-color");
   }
 
-  const Profile& profile = manifest.profiles.at(buildProfile);
   if (profile.debug) {
     compilerOpts.cFlags.others.emplace_back("-g");
     compilerOpts.cFlags.macros.emplace_back("DEBUG", "");
   } else {
     compilerOpts.cFlags.macros.emplace_back("NDEBUG", "");
   }
+  if (profile.splitDebugInfo) {
+    // Debug info goes to .dwo side files instead of the objects, keeping
+    // them small and off the link line; the index flag makes debuggers
+    // find the fission output quickly.
+    compilerOpts.cFlags.others.emplace_back("-gsplit-dwarf");
+    compilerOpts.ldFlags.others.emplace_back("-Wl,--gdb-index");
+  }
   compilerOpts.cFlags.others.emplace_back(
       fmt::format("-O{}", profile.optLevel));
   if (profile.lto) {
     compilerOpts.cFlags.others.emplace_back("-flto");
     compilerOpts.ldFlags.others.emplace_back("-flto");
   }
+  if (manifest.package.libType == Package::LibType::Shared) {
+    // Any object may end up in the shared library, so compile them all as
+    // position-independent code.
+    compilerOpts.cFlags.others.emplace_back("-fPIC");
+  }
   for (const std::string& flag : profile.cxxflags) {
     compilerOpts.cFlags.others.emplace_back(flag);
   }
@@ -176,7 +333,7 @@ Project::Project(const BuildProfile& buildProfile, Manifest m,
   for (const std::string& flag : getEnvFlags("LDFLAGS")) {
     compilerOpts.ldFlags.others.emplace_back(flag);
   }
-};
+}
 
 void Project::includeIfExist(const fs::path& path, bool isSystem) {
   if (fs::exists(path)) {
@@ -184,15 +341,19 @@ void Project::includeIfExist(const fs::path& path, bool isSystem) {
   }
 }
 
-rs::Result<Project> Project::init(const BuildProfile& buildProfile,
-                                  const fs::path& rootDir) {
+rs::Result<Project>
+Project::init(const BuildProfile& buildProfile, const fs::path& rootDir,
+              const std::optional<ProfileOverride>& profileOverride) {
   Manifest manifest = rs_try(Manifest::tryParse(rootDir / Manifest::FILE_NAME));
-  return rs::Ok(Project(buildProfile, std::move(manifest), CompilerOpts()));
+  return rs::Ok(Project(buildProfile, std::move(manifest), CompilerOpts(),
+                        profileOverride));
 }
 
-rs::Result<Project> Project::init(const BuildProfile& buildProfile,
-                                  const Manifest& manifest) {
-  return rs::Ok(Project(buildProfile, manifest, CompilerOpts()));
+rs::Result<Project>
+Project::init(const BuildProfile& buildProfile, const Manifest& manifest,
+              const std::optional<ProfileOverride>& profileOverride) {
+  return rs::Ok(Project(buildProfile, manifest, CompilerOpts(),
+                        profileOverride));
 }
 
 } // namespace cabin
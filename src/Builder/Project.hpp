@@ -5,6 +5,7 @@
 #include "Manifest.hpp"
 
 #include <filesystem>
+#include <optional>
 #include <rs/result.hpp>
 
 namespace cabin {
@@ -13,7 +14,13 @@ namespace fs = std::filesystem;
 
 class Project {
   Project(const BuildProfile& buildProfile, Manifest manifest,
-          CompilerOpts compilerOpts);
+          CompilerOpts compilerOpts,
+          const std::optional<ProfileOverride>& profileOverride);
+
+  /// Cold path of the constructor: derives the full flag set from the
+  /// manifest profile, the environment, and the git HEAD.  Warm runs
+  /// rehydrate the same result from the per-profile snapshot instead.
+  void resolveCompilerOpts(const BuildProfile& buildProfile);
 
   void includeIfExist(const fs::path& path, bool isSystem = false);
 
@@ -23,14 +30,20 @@ public:
   const fs::path buildOutPath;
   const fs::path unittestOutPath;
   const fs::path integrationTestOutPath;
+  const fs::path benchOutPath;
   const Manifest manifest;
+  /// The effective profile: the manifest's entry for this build profile
+  /// with any per-package override from the workspace root applied.
+  const Profile profile;
   CompilerOpts compilerOpts;
 
-  static rs::Result<Project> init(const BuildProfile& buildProfile,
-                                  const fs::path& rootDir);
+  static rs::Result<Project>
+  init(const BuildProfile& buildProfile, const fs::path& rootDir,
+       const std::optional<ProfileOverride>& profileOverride = {});
 
-  static rs::Result<Project> init(const BuildProfile& buildProfile,
-                                  const Manifest& manifest);
+  static rs::Result<Project>
+  init(const BuildProfile& buildProfile, const Manifest& manifest,
+       const std::optional<ProfileOverride>& profileOverride = {});
 };
 
 } // namespace cabin
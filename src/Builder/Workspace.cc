@@ -0,0 +1,180 @@
+#include "Builder/Workspace.hpp"
+
+#include "Dependency.hpp"
+#include "Diag.hpp"
+#include "Manifest.hpp"
+#include "Parallelism.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <string>
+#include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <toml.hpp>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cabin {
+
+static fs::path canonicalMemberPath(const fs::path& baseDir,
+                                    const std::string& relPath) {
+  std::error_code ec;
+  fs::path memberRoot = fs::weakly_canonical(baseDir / relPath, ec);
+  if (ec) {
+    memberRoot = fs::absolute(baseDir / relPath);
+  }
+  return memberRoot;
+}
+
+rs::Result<std::optional<Workspace>>
+Workspace::load(const fs::path& rootDir) noexcept {
+  const fs::path manifestPath = rootDir / Manifest::FILE_NAME;
+  if (!fs::exists(manifestPath)) {
+    return rs::Ok(std::optional<Workspace>{});
+  }
+
+  try {
+    const toml::value val = toml::parse(manifestPath);
+    if (!val.contains("workspace")) {
+      return rs::Ok(std::optional<Workspace>{});
+    }
+
+    const auto memberPaths =
+        toml::find<std::vector<std::string>>(val, "workspace", "members");
+    rs_ensure(!memberPaths.empty(), "[workspace] must list at least one member");
+
+    std::vector<fs::path> members;
+    members.reserve(memberPaths.size());
+    for (const std::string& relPath : memberPaths) {
+      fs::path memberRoot = canonicalMemberPath(rootDir, relPath);
+      rs_ensure(fs::exists(memberRoot / Manifest::FILE_NAME),
+                "workspace member `{}` has no {}", relPath,
+                Manifest::FILE_NAME);
+      members.push_back(std::move(memberRoot));
+    }
+
+    ProfileOverrideMap overrides;
+    overrides.emplace(BuildProfile::Dev,
+                      rs_try(ProfileOverride::mapFromToml(val, "dev")));
+    overrides.emplace(BuildProfile::Release,
+                      rs_try(ProfileOverride::mapFromToml(val, "release")));
+    overrides.emplace(BuildProfile::Test,
+                      rs_try(ProfileOverride::mapFromToml(val, "test")));
+
+    return rs::Ok(std::optional<Workspace>(
+        Workspace(rootDir, std::move(members), std::move(overrides))));
+  } catch (const std::exception& e) {
+    rs_bail("failed to parse {}: {}", manifestPath.string(), e.what());
+  }
+}
+
+rs::Result<void> Workspace::buildAll(const BuildProfile& buildProfile,
+                                     const ScheduleOptions& options) const {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::unordered_map<std::string, std::size_t> indexOf;
+  for (std::size_t i = 0; i < members.size(); ++i) {
+    indexOf.emplace(members[i].generic_string(), i);
+  }
+
+  // Cross-member edges come from path dependencies: a member only starts
+  // once every member it links against has been built.
+  std::vector<std::vector<std::size_t>> dependsOn(members.size());
+  std::vector<std::string> names(members.size());
+  for (std::size_t i = 0; i < members.size(); ++i) {
+    const Manifest manifest =
+        rs_try(Manifest::tryParse(members[i] / Manifest::FILE_NAME, false));
+    names[i] = manifest.package.name;
+    for (const Dependency& dep : manifest.dependencies) {
+      if (const auto* pathDep = std::get_if<PathDependency>(&dep)) {
+        const fs::path depRoot =
+            canonicalMemberPath(members[i], pathDep->path);
+        const auto it = indexOf.find(depRoot.generic_string());
+        if (it != indexOf.end()) {
+          dependsOn[i].push_back(it->second);
+        }
+      }
+    }
+  }
+
+  const auto buildMember = [&](const std::size_t idx) -> rs::Result<void> {
+    Diag::info("Building", "{} ({})", names[idx], members[idx].string());
+    Builder builder(members[idx], buildProfile);
+    ScheduleOptions memberOptions = options;
+    memberOptions.suppressAnalysisLog = true;
+    memberOptions.suppressFinishLog = true;
+    memberOptions.suppressDepDiag = true;
+    if (const auto perProfile = profileOverrides.find(buildProfile);
+        perProfile != profileOverrides.end()) {
+      if (const auto it = perProfile->second.find(names[idx]);
+          it != perProfile->second.end()) {
+        memberOptions.profileOverride = it->second;
+      }
+    }
+    rs_try(builder.schedule(memberOptions));
+    return builder.build();
+  };
+
+  std::vector<bool> built(members.size(), false);
+  std::size_t numBuilt = 0;
+  while (numBuilt < members.size()) {
+    // Kahn-style wave: everything whose dependencies are satisfied.
+    std::vector<std::size_t> wave;
+    for (std::size_t i = 0; i < members.size(); ++i) {
+      if (built[i]) {
+        continue;
+      }
+      bool ready = true;
+      for (const std::size_t dep : dependsOn[i]) {
+        if (!built[dep]) {
+          ready = false;
+          break;
+        }
+      }
+      if (ready) {
+        wave.push_back(i);
+      }
+    }
+    rs_ensure(!wave.empty(),
+              "cyclic path dependencies among workspace members");
+
+    if (wave.size() > 1 && isParallel()) {
+      tbb::concurrent_vector<std::string> errors;
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, wave.size()),
+                        [&](const tbb::blocked_range<std::size_t>& rng) {
+                          for (std::size_t i = rng.begin(); i != rng.end();
+                               ++i) {
+                            auto result = buildMember(wave[i]);
+                            if (result.is_err()) {
+                              errors.push_back(result.unwrap_err()->what());
+                            }
+                          }
+                        });
+      rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+    } else {
+      for (const std::size_t idx : wave) {
+        rs_try(buildMember(idx));
+      }
+    }
+
+    for (const std::size_t idx : wave) {
+      built[idx] = true;
+    }
+    numBuilt += wave.size();
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = end - start;
+  Diag::info("Finished", "workspace [{} member(s)] in {:.2f}s", members.size(),
+             elapsed.count());
+  return rs::Ok();
+}
+
+} // namespace cabin
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Builder/BuildProfile.hpp"
+#include "Builder/Builder.hpp"
+#include "Manifest.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <rs/result.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+/// A Cargo-style workspace: a root cabin.toml whose `[workspace]` table
+/// lists member package directories.  Members are wired together through
+/// their path dependencies, so independent members build concurrently
+/// under the shared parallelism budget.
+class Workspace {
+public:
+  /// Loads the workspace described by `rootDir/cabin.toml`, or nullopt if
+  /// that manifest has no `[workspace]` table.
+  static rs::Result<std::optional<Workspace>>
+  load(const fs::path& rootDir) noexcept;
+
+  /// Builds every member in dependency order.  Members whose
+  /// intra-workspace dependencies are already built run concurrently.
+  rs::Result<void> buildAll(const BuildProfile& buildProfile,
+                            const ScheduleOptions& options) const;
+
+  const std::vector<fs::path>& memberRoots() const { return members; }
+
+private:
+  using ProfileOverrideMap =
+      std::unordered_map<BuildProfile,
+                         std::unordered_map<std::string, ProfileOverride>>;
+
+  Workspace(fs::path rootDir, std::vector<fs::path> members,
+            ProfileOverrideMap profileOverrides)
+      : rootDir(std::move(rootDir)), members(std::move(members)),
+        profileOverrides(std::move(profileOverrides)) {}
+
+  fs::path rootDir;
+  std::vector<fs::path> members; // canonical absolute member roots
+  /// `[profile.<key>.package.<name>]` tables from the root manifest,
+  /// applied on top of the named member's own profile.
+  ProfileOverrideMap profileOverrides;
+};
+
+} // namespace cabin
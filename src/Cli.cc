@@ -292,9 +292,21 @@ Cli& Cli::addSubcmd(const Subcmd& subcmd) noexcept {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   const_cast<Subcmd&>(subcmd).setCmdName(name).setGlobalOpts(globalOpts);
 
-  subcmds.insert_or_assign(subcmd.name, subcmd);
+  const std::size_t idx = subcmds.size();
+  subcmds.push_back(subcmd);
+  const auto indexName = [this, idx](const std::string_view key) {
+    const auto pos = std::ranges::lower_bound(
+        subcmdIndex, key, {},
+        &std::pair<std::string_view, std::size_t>::first);
+    if (pos != subcmdIndex.end() && pos->first == key) {
+      pos->second = idx; // re-registration replaces, like the old map did
+    } else {
+      subcmdIndex.insert(pos, { key, idx });
+    }
+  };
+  indexName(subcmd.name);
   if (subcmd.hasShort()) {
-    subcmds.insert_or_assign(subcmd.shortName, subcmd);
+    indexName(subcmd.shortName);
   }
   return *this;
 }
@@ -309,16 +321,25 @@ Cli& Cli::addOpt(Opt opt) noexcept {
   return *this;
 }
 
+const Subcmd* Cli::findSubcmd(const std::string_view name) const noexcept {
+  const auto pos = std::ranges::lower_bound(
+      subcmdIndex, name, {}, &std::pair<std::string_view, std::size_t>::first);
+  if (pos != subcmdIndex.end() && pos->first == name) {
+    return &subcmds[pos->second];
+  }
+  return nullptr;
+}
+
 bool Cli::hasSubcmd(std::string_view subcmd) const noexcept {
-  return subcmds.contains(subcmd);
+  return findSubcmd(subcmd) != nullptr;
 }
 
 [[nodiscard]] rs::AnyhowErr Cli::noSuchArg(std::string_view arg) const {
   std::vector<std::string_view> candidates;
   for (const auto& cmd : subcmds) {
-    candidates.push_back(cmd.second.name);
-    if (!cmd.second.shortName.empty()) {
-      candidates.push_back(cmd.second.shortName);
+    candidates.push_back(cmd.name);
+    if (!cmd.shortName.empty()) {
+      candidates.push_back(cmd.shortName);
     }
   }
   addOptCandidates(candidates, globalOpts);
@@ -339,7 +360,9 @@ bool Cli::hasSubcmd(std::string_view subcmd) const noexcept {
 
 [[nodiscard]] rs::Result<void> Cli::exec(const std::string_view subcmd,
                                          const CliArgsView args) const {
-  return subcmds.at(subcmd).mainFn(args);
+  const Subcmd* cmd = findSubcmd(subcmd);
+  assert(cmd != nullptr && "exec called with an unregistered subcommand");
+  return cmd->mainFn(args);
 }
 
 [[nodiscard]] rs::Result<Cli::ControlFlow>
@@ -453,13 +476,14 @@ Cli::expandOpts(const std::span<const char* const> args) const noexcept {
 
     // Subcmd case, remains the same as before
     if (!curSubcmd.has_value() && !arg.starts_with("-")) {
-      if (!subcmds.contains(arg)) {
+      const Subcmd* subcmd = findSubcmd(arg);
+      if (subcmd == nullptr) {
         return noSuchArg(arg);
       }
       expanded.emplace_back(arg);
 
-      curSubcmd = subcmds.at(arg);
-      curLocalOpts = subcmds.at(arg).localOpts;
+      curSubcmd = *subcmd;
+      curLocalOpts = subcmd->localOpts;
       curLocalShortOpts = ShortOpts{ curLocalOpts.get() };
       curMaxShortSize = std::max(globalShortOpts.maxShortSize,
                                  curLocalShortOpts.maxShortSize);
@@ -585,7 +609,7 @@ Cli::expandOpts(const std::span<const char* const> args) const noexcept {
 }
 
 void Cli::printSubcmdHelp(const std::string_view subcmd) const noexcept {
-  fmt::print("{}", subcmds.at(subcmd).formatHelp());
+  fmt::print("{}", findSubcmd(subcmd)->formatHelp());
 }
 
 std::size_t Cli::calcMaxShortSize() const noexcept {
@@ -603,13 +627,13 @@ std::size_t Cli::calcMaxOffset(const std::size_t maxShortSize) const noexcept {
   maxOffset = std::max(maxOffset, calcOptMaxOffset(globalOpts, maxShortSize));
   maxOffset = std::max(maxOffset, calcOptMaxOffset(localOpts, maxShortSize));
 
-  for (const auto& [name, cmd] : subcmds) {
+  for (const auto& cmd : subcmds) {
     if (cmd.isHidden) {
       // Hidden command should not affect maxOffset.
       continue;
     }
 
-    std::size_t offset = name.size(); // "build"
+    std::size_t offset = cmd.name.size(); // "build"
     if (!cmd.shortName.empty()) {
       offset += 2;                    // ", "
       offset += cmd.shortName.size(); // "b"
@@ -621,13 +645,13 @@ std::size_t Cli::calcMaxOffset(const std::size_t maxShortSize) const noexcept {
 
 std::string Cli::formatAllSubcmds(const bool showHidden,
                                   std::size_t maxOffset) const noexcept {
-  for (const auto& [name, cmd] : subcmds) {
+  for (const auto& cmd : subcmds) {
     if (!showHidden && cmd.isHidden) {
       // Hidden command should not affect maxOffset if `showHidden` is false.
       continue;
     }
 
-    std::size_t offset = name.size(); // "build"
+    std::size_t offset = cmd.name.size(); // "build"
     if (!cmd.shortName.empty()) {
       offset += 2;                    // ", "
       offset += cmd.shortName.size(); // "b"
@@ -636,20 +660,215 @@ std::string Cli::formatAllSubcmds(const bool showHidden,
   }
 
   std::string str;
-  for (const auto& [name, cmd] : subcmds) {
+  for (const auto& cmd : subcmds) {
     if (!showHidden && cmd.isHidden) {
       // We don't print hidden subcommands if `showHidden` is false.
       continue;
     }
-    if (cmd.hasShort() && name == cmd.shortName) {
-      // We don't print an abbreviation.
-      continue;
-    }
     str += cmd.format(maxOffset);
   }
   return str;
 }
 
+static std::string escapeSingleQuotes(const std::string_view str) noexcept {
+  std::string out;
+  for (const char c : str) {
+    if (c == '\'') {
+      out += "'\\''";
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+[[nodiscard]] rs::Result<std::string>
+Cli::formatCompletion(const std::string_view shell) const noexcept {
+  // All word lists come from the registered tables; nothing here touches
+  // the manifest or the filesystem.
+  const auto optWords = [](std::string& words, const Opts& opts) {
+    for (const Opt& opt : opts) {
+      if (opt.isHidden) {
+        continue;
+      }
+      if (!opt.shortName.empty()) {
+        words += opt.shortName;
+        words += ' ';
+      }
+      words += opt.name;
+      words += ' ';
+    }
+  };
+
+  std::string globalWords;
+  optWords(globalWords, globalOpts);
+
+  if (shell == "bash") {
+    std::string topWords;
+    for (const Subcmd& cmd : subcmds) {
+      if (cmd.isHidden) {
+        continue;
+      }
+      topWords += cmd.name;
+      topWords += ' ';
+      if (cmd.hasShort()) {
+        topWords += cmd.shortName;
+        topWords += ' ';
+      }
+    }
+    topWords += globalWords;
+    optWords(topWords, localOpts);
+
+    std::string script =
+        fmt::format("_cabin() {{\n"
+                    "  local cur=\"${{COMP_WORDS[COMP_CWORD]}}\"\n"
+                    "  if [[ ${{COMP_CWORD}} -eq 1 ]]; then\n"
+                    "    COMPREPLY=($(compgen -W '{}' -- \"${{cur}}\"))\n"
+                    "    return 0\n"
+                    "  fi\n"
+                    "  case \"${{COMP_WORDS[1]}}\" in\n",
+                    topWords);
+    for (const Subcmd& cmd : subcmds) {
+      if (cmd.isHidden) {
+        continue;
+      }
+      std::string pattern(cmd.name);
+      if (cmd.hasShort()) {
+        pattern += '|';
+        pattern += cmd.shortName;
+      }
+      std::string words = globalWords;
+      optWords(words, cmd.localOpts);
+      script +=
+          fmt::format("    {})\n"
+                      "      COMPREPLY=($(compgen -W '{}' -- \"${{cur}}\"))\n"
+                      "      ;;\n",
+                      pattern, words);
+    }
+    script += "    *) COMPREPLY=() ;;\n"
+              "  esac\n"
+              "  return 0\n"
+              "}\n"
+              "complete -F _cabin cabin\n";
+    return rs::Ok(std::move(script));
+  }
+
+  if (shell == "zsh") {
+    const auto optEntries = [](std::string& out, const Opts& opts) {
+      for (const Opt& opt : opts) {
+        if (opt.isHidden) {
+          continue;
+        }
+        if (!opt.shortName.empty()) {
+          out += fmt::format("      '{}:{}'\n", opt.shortName,
+                             escapeSingleQuotes(opt.desc));
+        }
+        out += fmt::format("      '{}:{}'\n", opt.name,
+                           escapeSingleQuotes(opt.desc));
+      }
+    };
+
+    std::string script = "#compdef cabin\n"
+                         "_cabin() {\n"
+                         "  local -a reply\n"
+                         "  if (( CURRENT == 2 )); then\n"
+                         "    reply=(\n";
+    for (const Subcmd& cmd : subcmds) {
+      if (cmd.isHidden) {
+        continue;
+      }
+      script += fmt::format("      '{}:{}'\n", cmd.name,
+                            escapeSingleQuotes(cmd.desc));
+      if (cmd.hasShort()) {
+        script += fmt::format("      '{}:{}'\n", cmd.shortName,
+                              escapeSingleQuotes(cmd.desc));
+      }
+    }
+    optEntries(script, globalOpts);
+    optEntries(script, localOpts);
+    script += "    )\n"
+              "    _describe 'cabin command' reply\n"
+              "    return\n"
+              "  fi\n"
+              "  case \"${words[2]}\" in\n";
+    for (const Subcmd& cmd : subcmds) {
+      if (cmd.isHidden) {
+        continue;
+      }
+      std::string pattern(cmd.name);
+      if (cmd.hasShort()) {
+        pattern += '|';
+        pattern += cmd.shortName;
+      }
+      std::string entries;
+      optEntries(entries, cmd.localOpts);
+      optEntries(entries, globalOpts);
+      script += fmt::format("    {})\n"
+                            "      reply=(\n"
+                            "{}"
+                            "      )\n"
+                            "      ;;\n",
+                            pattern, entries);
+    }
+    script += "    *) reply=() ;;\n"
+              "  esac\n"
+              "  _describe 'cabin option' reply\n"
+              "}\n"
+              "_cabin \"$@\"\n";
+    return rs::Ok(std::move(script));
+  }
+
+  if (shell == "fish") {
+    std::string script = "complete -c cabin -f\n";
+    const auto fishOpt = [&script](const Opt& opt,
+                                   const std::string_view cond) {
+      if (opt.isHidden) {
+        return;
+      }
+      std::string spec;
+      if (!cond.empty()) {
+        spec += fmt::format(" -n '{}'", cond);
+      }
+      if (opt.shortName.size() == 2) {
+        spec += fmt::format(" -s {}", opt.shortName.substr(1));
+      }
+      if (opt.name.starts_with("--")) {
+        spec += fmt::format(" -l {}", opt.name.substr(2));
+      }
+      script += fmt::format("complete -c cabin{} -d '{}'\n", spec,
+                            escapeSingleQuotes(opt.desc));
+    };
+
+    for (const Opt& opt : globalOpts) {
+      fishOpt(opt, "");
+    }
+    for (const Opt& opt : localOpts) {
+      fishOpt(opt, "__fish_use_subcommand");
+    }
+    for (const Subcmd& cmd : subcmds) {
+      if (cmd.isHidden) {
+        continue;
+      }
+      std::string names(cmd.name);
+      if (cmd.hasShort()) {
+        names += ' ';
+        names += cmd.shortName;
+      }
+      script += fmt::format(
+          "complete -c cabin -n __fish_use_subcommand -a '{}' -d '{}'\n",
+          names, escapeSingleQuotes(cmd.desc));
+      const std::string cond =
+          fmt::format("__fish_seen_subcommand_from {}", names);
+      for (const Opt& opt : cmd.localOpts) {
+        fishOpt(opt, cond);
+      }
+    }
+    return rs::Ok(std::move(script));
+  }
+
+  rs_bail("unsupported shell `{}` (expected bash, zsh, or fish)", shell);
+}
+
 std::string Cli::formatCmdHelp() const noexcept {
   // Print help message for cabin itself
   const std::size_t maxShortSize = calcMaxShortSize();
@@ -11,8 +11,8 @@
 #include <span>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace cabin {
@@ -216,7 +216,12 @@ private:
 };
 
 class Cli : public CliBase<Cli> {
-  std::unordered_map<std::string_view, Subcmd> subcmds;
+  // One Subcmd per registration, in registration order (which is also the
+  // help order).  Dispatch goes through `subcmdIndex`: sorted
+  // (name, index) pairs covering long and short names, binary-searched so
+  // lookups never hash or allocate.
+  std::vector<Subcmd> subcmds;
+  std::vector<std::pair<std::string_view, std::size_t>> subcmdIndex;
   Opts globalOpts;
   Opts localOpts;
 
@@ -235,6 +240,12 @@ public:
   std::size_t calcMaxOffset(std::size_t maxShortSize) const noexcept;
   std::string formatAllSubcmds(bool showHidden,
                                std::size_t maxOffset = 0) const noexcept;
+  /// Renders a completion script for `shell` (bash, zsh, or fish) from the
+  /// registered subcommand and option tables.  Every candidate word is
+  /// embedded in the script, so the shell completes from its own tables
+  /// instead of re-invoking cabin per keystroke.
+  [[nodiscard]] rs::Result<std::string>
+  formatCompletion(std::string_view shell) const noexcept;
 
   enum class ControlFlow : std::uint8_t {
     Return,
@@ -258,6 +269,8 @@ public:
 private:
   rs::Result<void> parseArgs(CliArgsView args) const noexcept;
 
+  const Subcmd* findSubcmd(std::string_view name) const noexcept;
+
   std::size_t calcMaxShortSize() const noexcept;
 
   /// Format help message for cabin itself.
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "Cmd/Add.hpp"
+#include "Cmd/Bench.hpp"
 #include "Cmd/Build.hpp"
 #include "Cmd/Clean.hpp"
+#include "Cmd/Complete.hpp"
 #include "Cmd/Fmt.hpp"
 #include "Cmd/Help.hpp"
 #include "Cmd/Init.hpp"
 #include "Cmd/Lint.hpp"
+#include "Cmd/Metadata.hpp"
 #include "Cmd/New.hpp"
 #include "Cmd/Remove.hpp"
 #include "Cmd/Run.hpp"
@@ -14,3 +17,4 @@
 #include "Cmd/Test.hpp"
 #include "Cmd/Tidy.hpp"
 #include "Cmd/Version.hpp"
+#include "Cmd/Watch.hpp"
@@ -3,17 +3,26 @@
 #include "Cli.hpp"
 #include "Diag.hpp"
 #include "Manifest.hpp"
+#include "RegistryIndex.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
 #include <cstdlib>
+#include <exception>
 #include <fmt/std.h>
 #include <fstream>
 #include <functional>
 #include <rs/result.hpp>
+#include <spdlog/spdlog.h>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <toml.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace cabin {
 
@@ -91,11 +100,247 @@ static std::string getDependencyName(const std::string_view dep) {
   return name;
 }
 
+// `user/repo@^1.2` requests the best registry version matching the
+// requirement; everything else is taken verbatim.
+static std::pair<std::string_view, std::string_view>
+splitVersionReq(const std::string_view dep) {
+  if (dep.contains("://")) {
+    return { dep, {} };
+  }
+  const std::size_t at = dep.find('@');
+  if (at == std::string_view::npos) {
+    return { dep, {} };
+  }
+  return { dep.substr(0, at), dep.substr(at + 1) };
+}
+
+/// One resolved dependency ready to be written: the table key plus its
+/// inline fields with already-TOML-formatted values.
+struct NewDep {
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> fields;
+};
+
+static std::string tomlQuote(const std::string_view value) {
+  std::string quoted = "\"";
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  quoted += '"';
+  return quoted;
+}
+
+static std::string tomlKey(const std::string& name) {
+  const bool bare = !name.empty()
+                    && std::ranges::all_of(name, [](const unsigned char c) {
+                         return std::isalnum(c) != 0 || c == '-' || c == '_';
+                       });
+  return bare ? name : tomlQuote(name);
+}
+
+static std::string formatDepLine(const NewDep& dep) {
+  std::string fields;
+  for (const auto& [key, value] : dep.fields) {
+    if (!fields.empty()) {
+      fields += ", ";
+    }
+    fields += fmt::format("{} = {}", key, value);
+  }
+  return fmt::format("{} = {{{}}}", tomlKey(dep.name), fields);
+}
+
+static std::vector<std::string> splitLines(const std::string& content) {
+  std::vector<std::string> lines;
+  std::string::size_type pos = 0;
+  while (pos < content.size()) {
+    const std::string::size_type nl = content.find('\n', pos);
+    if (nl == std::string::npos) {
+      lines.push_back(content.substr(pos));
+      break;
+    }
+    lines.push_back(content.substr(pos, nl - pos));
+    pos = nl + 1;
+  }
+  return lines;
+}
+
+static std::string_view trimmed(const std::string& line) {
+  std::string_view view = line;
+  while (!view.empty() && (view.front() == ' ' || view.front() == '\t')) {
+    view.remove_prefix(1);
+  }
+  while (!view.empty() && (view.back() == ' ' || view.back() == '\t'
+                           || view.back() == '\r')) {
+    view.remove_suffix(1);
+  }
+  return view;
+}
+
+// Inserts `name = {...}` lines directly under the `[dependencies]`
+// header (appending the table at EOF when absent) without rewriting any
+// other byte, so comments, formatting, and unrelated sections survive
+// verbatim.  Returns false — writing nothing — whenever the layout is
+// not the plain one-entry-per-line shape or the edited text does not
+// reparse into exactly the expected dependency set; the caller then
+// falls back to the full DOM rewrite.
+static bool spliceInDeps(const fs::path& manifestPath,
+                         const std::vector<NewDep>& entries) {
+  std::ifstream ifs(manifestPath);
+  std::ostringstream oss;
+  oss << ifs.rdbuf();
+  const std::string content = oss.str();
+
+  toml::value data;
+  try {
+    data = toml::parse_str(content);
+  } catch (const std::exception& e) {
+    spdlog::debug("manifest splice skipped: {}", e.what());
+    return false;
+  }
+
+  const std::vector<std::string> lines = splitLines(content);
+  std::vector<bool> drop(lines.size(), false);
+  std::size_t headerLine = 0; // 1-based; 0 means no table yet
+
+  if (data.contains("dependencies")) {
+    const toml::value& deps = data.at("dependencies");
+    const toml::source_location loc = deps.location();
+    if (!loc.is_ok() || loc.first_line_number() == 0
+        || loc.first_line_number() > lines.size()) {
+      return false;
+    }
+    headerLine = loc.first_line_number();
+    // A dotted header like `[dependencies.foo]` would make us insert
+    // into the wrong table; only the literal header is splice-safe.
+    if (trimmed(lines[headerLine - 1]) != "[dependencies]") {
+      return false;
+    }
+    // Re-adding an existing name replaces its one-line entry.
+    for (const NewDep& entry : entries) {
+      if (!deps.contains(entry.name)) {
+        continue;
+      }
+      const toml::source_location old = deps.at(entry.name).location();
+      if (!old.is_ok() || old.first_line_number() == 0
+          || old.first_line_number() != old.last_line_number()
+          || old.first_line_number() > lines.size()) {
+        return false;
+      }
+      drop[old.first_line_number() - 1] = true;
+    }
+  }
+
+  std::string edited;
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    if (!drop[i]) {
+      edited += lines[i];
+      edited += '\n';
+    }
+    if (headerLine != 0 && i + 1 == headerLine) {
+      for (const NewDep& entry : entries) {
+        edited += formatDepLine(entry);
+        edited += '\n';
+      }
+    }
+  }
+  if (headerLine == 0) {
+    if (!edited.empty() && !edited.ends_with("\n\n")) {
+      edited += '\n';
+    }
+    edited += "[dependencies]\n";
+    for (const NewDep& entry : entries) {
+      edited += formatDepLine(entry);
+      edited += '\n';
+    }
+  }
+
+  try {
+    const toml::value reparsed = toml::parse_str(edited);
+    if (!reparsed.contains("dependencies")) {
+      return false;
+    }
+    const toml::value& after = reparsed.at("dependencies");
+    for (const NewDep& entry : entries) {
+      if (!after.contains(entry.name)) {
+        return false;
+      }
+    }
+    if (data.contains("dependencies")) {
+      for (const auto& entry : data.at("dependencies").as_table()) {
+        if (!after.contains(entry.first)) {
+          return false;
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    spdlog::debug("manifest splice failed to reparse: {}", e.what());
+    return false;
+  }
+
+  std::ofstream ofs(manifestPath);
+  ofs << edited;
+  return true;
+}
+
 static rs::Result<void>
 addDependencyToManifest(const std::unordered_set<std::string_view>& newDeps,
+                        const std::unordered_map<std::string_view, std::string>&
+                            resolvedTags,
                         bool isSystemDependency, std::string& version,
                         std::string& tag, std::string& rev,
                         std::string& branch) {
+  const fs::path manifestPath = rs_try(Manifest::findPath());
+
+  // Fast path: resolve every dependency to one `name = {...}` line and
+  // splice just those lines into the file.
+  std::vector<NewDep> entries;
+  for (const auto& dep : newDeps) {
+    NewDep entry;
+    if (isSystemDependency) {
+      rs_ensure(!version.empty(),
+                "The `--version` option is required for system dependencies");
+      entry.name = std::string(dep);
+      entry.fields.emplace_back("version", tomlQuote(version));
+      entry.fields.emplace_back("system", "true");
+    } else {
+      const std::string_view spec = splitVersionReq(dep).first;
+      const std::string gitUrl = getDependencyGitUrl(spec);
+      entry.name = getDependencyName(spec);
+      rs_ensure(!gitUrl.empty() && !entry.name.empty(),
+                "git URL or dependency name must not be empty: {}", dep);
+
+      entry.fields.emplace_back("git", tomlQuote(gitUrl));
+      if (const auto resolved = resolvedTags.find(dep);
+          resolved != resolvedTags.end()) {
+        entry.fields.emplace_back("tag", tomlQuote(resolved->second));
+      } else if (!tag.empty()) {
+        entry.fields.emplace_back("tag", tomlQuote(tag));
+      }
+      if (!rev.empty()) {
+        entry.fields.emplace_back("rev", tomlQuote(rev));
+      }
+      if (!branch.empty()) {
+        entry.fields.emplace_back("branch", tomlQuote(branch));
+      }
+    }
+    entries.push_back(std::move(entry));
+  }
+
+  if (spliceInDeps(manifestPath, entries)) {
+    // Re-parse right away so the manifest snapshot is re-keyed to the
+    // edited bytes; the next command then starts from the warm cache.
+    if (const auto warmed = Manifest::tryParse(manifestPath);
+        warmed.is_err()) {
+      spdlog::debug("manifest snapshot not refreshed: {}",
+                    warmed.unwrap_err()->what());
+    }
+    Diag::info("Added", "to the cabin.toml");
+    return rs::Ok();
+  }
+
   toml::value depData = toml::table{};
   // Set the formatting for the dependency data table to be on a single line.
   // e.g. dep = { git = "https://github.com/user/repo.git", tag = "v1.0.0" }
@@ -119,7 +364,6 @@ addDependencyToManifest(const std::unordered_set<std::string_view>& newDeps,
   }
 
   // Keep the order of the tables.
-  const fs::path manifestPath = rs_try(Manifest::findPath());
   auto data = toml::parse<toml::ordered_type_config>(manifestPath);
 
   // Check if the dependencies table exists, if not create it.
@@ -130,13 +374,18 @@ addDependencyToManifest(const std::unordered_set<std::string_view>& newDeps,
 
   for (const auto& dep : newDeps) {
     if (!isSystemDependency) {
-      const std::string gitUrl = getDependencyGitUrl(dep);
-      const std::string depName = getDependencyName(dep);
+      const std::string_view spec = splitVersionReq(dep).first;
+      const std::string gitUrl = getDependencyGitUrl(spec);
+      const std::string depName = getDependencyName(spec);
 
       rs_ensure(!gitUrl.empty() && !depName.empty(),
                 "git URL or dependency name must not be empty: {}", dep);
 
       deps[depName] = depData;
+      if (const auto resolved = resolvedTags.find(dep);
+          resolved != resolvedTags.end()) {
+        deps[depName]["tag"] = resolved->second;
+      }
       deps[depName]["git"] = gitUrl;
     } else {
       deps[std::string(dep)] = depData;
@@ -145,6 +394,13 @@ addDependencyToManifest(const std::unordered_set<std::string_view>& newDeps,
 
   std::ofstream ofs(manifestPath);
   ofs << data;
+  ofs.close();
+
+  if (const auto warmed = Manifest::tryParse(manifestPath);
+      warmed.is_err()) {
+    spdlog::debug("manifest snapshot not refreshed: {}",
+                  warmed.unwrap_err()->what());
+  }
 
   Diag::info("Added", "to the cabin.toml");
   return rs::Ok();
@@ -217,8 +473,31 @@ static rs::Result<void> addMain(const CliArgsView args) {
     }
   }
 
-  return addDependencyToManifest(newDeps, isSystemDependency, version, tag, rev,
-                                 branch);
+  // Resolve every `name@req` spec against the registry index in one
+  // parallel batch before touching the manifest, so adding ten such
+  // dependencies pays for one index load and one matching pass.
+  std::unordered_map<std::string_view, std::string> resolvedTags;
+  if (!isSystemDependency) {
+    std::vector<std::pair<std::string, std::string>> reqs;
+    std::vector<std::string_view> reqSpecs;
+    for (const std::string_view dep : newDeps) {
+      const auto [spec, req] = splitVersionReq(dep);
+      if (!req.empty()) {
+        reqs.emplace_back(getDependencyName(spec), std::string(req));
+        reqSpecs.push_back(dep);
+      }
+    }
+    if (!reqs.empty()) {
+      const RegistryIndex index = rs_try(RegistryIndex::load());
+      const std::vector<std::string> best = rs_try(index.resolveAll(reqs));
+      for (std::size_t i = 0; i < best.size(); ++i) {
+        resolvedTags.emplace(reqSpecs[i], best[i]);
+      }
+    }
+  }
+
+  return addDependencyToManifest(newDeps, resolvedTags, isSystemDependency,
+                                 version, tag, rev, branch);
 }
 
 } // namespace cabin
@@ -0,0 +1,70 @@
+#include "Bench.hpp"
+
+#include "Algos.hpp"
+#include "Builder/BuildProfile.hpp"
+#include "Builder/Builder.hpp"
+#include "Cli.hpp"
+#include "Common.hpp"
+#include "Manifest.hpp"
+#include "Parallelism.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <rs/result.hpp>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace cabin {
+
+static rs::Result<void> benchMain(CliArgsView args);
+
+const Subcmd BENCH_CMD = //
+    Subcmd{ "bench" }
+        .setDesc("Run the benchmarks of a local package")
+        .addOpt(OPT_JOBS)
+        .setArg(Arg{ "BENCHNAME" }.setRequired(false).setDesc(
+            "Benchmark name to launch"))
+        .setMainFn(benchMain);
+
+static rs::Result<void> benchMain(const CliArgsView args) {
+  std::optional<std::string> benchName;
+
+  for (auto itr = args.begin(); itr != args.end(); ++itr) {
+    const std::string_view arg = *itr;
+
+    const auto control =
+        rs_try(Cli::handleGlobalOpts(itr, args.end(), "bench"));
+    if (control == Cli::Return) {
+      return rs::Ok();
+    }
+    if (control == Cli::Continue) {
+      continue;
+    }
+    if (matchesAny(arg, { "-j", "--jobs" })) {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      const std::string_view nextArg = *++itr;
+
+      uint64_t numThreads{};
+      auto [ptr, ec] =
+          std::from_chars(nextArg.begin(), nextArg.end(), numThreads);
+      rs_ensure(ec == std::errc(), "invalid number of threads: {}", nextArg);
+      setParallelism(numThreads);
+    } else if (!benchName) {
+      benchName = arg;
+    } else {
+      return BENCH_CMD.noSuchArg(arg);
+    }
+  }
+
+  // Benchmarks only make sense against optimized code.
+  const Manifest manifest = rs_try(Manifest::tryParse());
+  Builder builder(manifest.path.parent_path(), BuildProfile::Release);
+  rs_try(builder.schedule(ScheduleOptions{ .includeBenches = true }));
+  return builder.bench(std::move(benchName));
+}
+
+} // namespace cabin
@@ -3,6 +3,9 @@
 #include "Algos.hpp"
 #include "Builder/BuildProfile.hpp"
 #include "Builder/Builder.hpp"
+#include "Builder/FreshToken.hpp"
+#include "Builder/Timings.hpp"
+#include "Builder/Workspace.hpp"
 #include "Cli.hpp"
 #include "Common.hpp"
 #include "Diag.hpp"
@@ -16,6 +19,7 @@
 #include <filesystem>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <system_error>
@@ -25,6 +29,19 @@ namespace cabin {
 
 static rs::Result<void> buildMain(CliArgsView args);
 
+// Emits the `--timings` reports under `outDir` and tells the user where
+// they landed.  No-op unless timing collection was enabled.
+static rs::Result<void> writeTimingReports(const fs::path& baseDir,
+                                           const fs::path& outDir) {
+  if (!Timings::instance().isEnabled()) {
+    return rs::Ok();
+  }
+  rs_try(Timings::instance().write(outDir));
+  Diag::info("Timings", "report saved to {}/timings.html",
+             fs::relative(outDir, baseDir).string());
+  return rs::Ok();
+}
+
 const Subcmd BUILD_CMD =
     Subcmd{ "build" }
         .setShort("b")
@@ -32,6 +49,20 @@ const Subcmd BUILD_CMD =
         .addOpt(OPT_RELEASE)
         .addOpt(Opt{ "--compdb" }.setDesc(
             "Generate compilation database instead of building"))
+        .addOpt(Opt{ "--unity" }.setDesc(
+            "Compile sources as unity groups of N files (default: 16)"))
+        .addOpt(Opt{ "--timings" }.setDesc(
+            "Report build timings as HTML and a Chrome trace"))
+        .addOpt(Opt{ "--time-trace" }.setDesc(
+            "Compile with -ftime-trace and merge per-TU traces into a "
+            "compile-time report"))
+        .addOpt(Opt{ "--background" }.setDesc(
+            "Run the build at idle CPU and IO priority"))
+        .addOpt(Opt{ "--keep-going" }.setShort("-k").setDesc(
+            "Keep scanning after the first error and report all of them"))
+        .addOpt(Opt{ "--dedup-templates" }.setDesc(
+            "Share duplicated template instantiations via one generated TU"))
+        .addOpt(OPT_MESSAGE_FORMAT)
         .addOpt(OPT_JOBS)
         .setMainFn(buildMain);
 
@@ -39,6 +70,10 @@ static rs::Result<void> buildMain(const CliArgsView args) {
   // Parse args
   BuildProfile buildProfile = BuildProfile::Dev;
   bool buildCompdb = false;
+  bool keepGoing = false;
+  bool dedupTemplates = false;
+  bool timeTrace = false;
+  std::size_t unityGroupSize = 0;
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
 
@@ -52,6 +87,30 @@ static rs::Result<void> buildMain(const CliArgsView args) {
       buildProfile = BuildProfile::Release;
     } else if (arg == "--compdb") {
       buildCompdb = true;
+    } else if (arg == "--message-format"
+               || arg.starts_with("--message-format=")) {
+      rs_try(parseMessageFormat(arg, itr, args.end()));
+    } else if (matchesAny(arg, { "-k", "--keep-going" })) {
+      keepGoing = true;
+    } else if (arg == "--dedup-templates") {
+      dedupTemplates = true;
+    } else if (arg == "--time-trace") {
+      timeTrace = true;
+    } else if (arg == "--timings") {
+      Timings::instance().enable();
+    } else if (arg == "--background") {
+      // Full -j parallelism, but every job yields to interactive work.
+      lowerProcessPriority(19, "idle");
+    } else if (arg == "--unity" || arg.starts_with("--unity=")) {
+      static constexpr std::size_t defaultUnityGroupSize = 16;
+      unityGroupSize = defaultUnityGroupSize;
+      if (arg.starts_with("--unity=")) {
+        const std::string_view value = arg.substr(std::size("--unity=") - 1);
+        auto [ptr, ec] =
+            std::from_chars(value.begin(), value.end(), unityGroupSize);
+        rs_ensure(ec == std::errc() && unityGroupSize > 0,
+                  "invalid unity group size: {}", value);
+      }
     } else if (matchesAny(arg, { "-j", "--jobs" })) {
       if (itr + 1 == args.end()) {
         return Subcmd::missingOptArgumentFor(arg);
@@ -68,9 +127,41 @@ static rs::Result<void> buildMain(const CliArgsView args) {
     }
   }
 
+  const fs::path manifestPath = rs_try(Manifest::findPath());
+  const fs::path manifestDir = manifestPath.parent_path();
+  if (const std::optional<Workspace> workspace =
+          rs_try(Workspace::load(manifestDir))) {
+    rs_ensure(!buildCompdb, "--compdb is not supported for workspace roots");
+    ScheduleOptions options;
+    options.keepGoing = keepGoing;
+    options.unityGroupSize = unityGroupSize;
+    rs_try(workspace->buildAll(buildProfile, options));
+    return writeTimingReports(manifestDir, manifestDir / "cabin-out");
+  }
+
+  // No-op fast path: a valid fresh token proves the last build finished
+  // and nothing feeding it changed, so skip manifest parsing, planning,
+  // and the executor entirely.  Watch loops and git hooks call no-op
+  // builds constantly; this keeps them at a few stats plus one journal
+  // replay.
+  const fs::path outBase =
+      manifestDir / "cabin-out" / fmt::format("{}", buildProfile);
+  if (!buildCompdb && !dedupTemplates && !timeTrace && unityGroupSize == 0
+      && !Timings::instance().isEnabled()
+      && FreshToken::isFresh(manifestPath, outBase)) {
+    Diag::info("Finished", "`{}` profile target(s) are up to date",
+               buildProfile);
+    return rs::Ok();
+  }
+
   const Manifest manifest = rs_try(Manifest::tryParse());
   Builder builder(manifest.path.parent_path(), buildProfile);
-  rs_try(builder.schedule());
+  ScheduleOptions options;
+  options.keepGoing = keepGoing;
+  options.dedupTemplates = dedupTemplates;
+  options.timeTrace = timeTrace;
+  options.unityGroupSize = unityGroupSize;
+  rs_try(builder.schedule(options));
 
   if (buildCompdb) {
     Diag::info("Generated", "{}/compile_commands.json",
@@ -79,7 +170,14 @@ static rs::Result<void> buildMain(const CliArgsView args) {
     return rs::Ok();
   }
 
-  return builder.build();
+  FreshToken::invalidate(builder.outDirPath());
+  rs_try(builder.build());
+  FreshToken::write(manifest.path, builder.outDirPath(),
+                    builder.graph().cxxPath(), FreshToken::Scope::All,
+                    builder.graph().hasBinaryTarget() ? manifest.package.name
+                                                      : "");
+  return writeTimingReports(manifest.path.parent_path(),
+                            builder.outDirPath());
 }
 
 } // namespace cabin
@@ -1,13 +1,23 @@
 #include "Clean.hpp"
 
 #include "Cli.hpp"
+#include "Dependency.hpp"
 #include "Diag.hpp"
+#include "Lockfile.hpp"
 #include "Manifest.hpp"
 
 #include <cstdlib>
+#include <fmt/format.h>
+#include <optional>
 #include <rs/result.hpp>
 #include <string>
 #include <string_view>
+#include <sys/types.h>
+#include <system_error>
+#include <tbb/task_group.h>
+#include <unistd.h>
+#include <variant>
+#include <vector>
 
 namespace cabin {
 
@@ -20,13 +30,138 @@ const Subcmd CLEAN_CMD = //
                     .setShort("-p")
                     .setDesc("Clean artifacts of the specified profile")
                     .setPlaceholder("<PROFILE>"))
+        .addOpt(Opt{ "--deps" }
+                    .setDesc("Clean the built artifacts of one dependency")
+                    .setPlaceholder("<NAME>"))
+        .addOpt(Opt{ "--tests" }.setDesc(
+            "Clean only test and benchmark artifacts"))
+        .addOpt(Opt{ "--async" }.setDesc(
+            "Return immediately and delete in a background process"))
         .setMainFn(cleanMain);
 
+// Depth-first parallel delete: sibling subtrees unlink concurrently,
+// which is where the time goes on large object trees (one task per
+// directory, files unlinked inline).  Symlinks are removed as links.
+static void removeTreeParallel(const fs::path& dir) { // NOLINT(misc-no-recursion)
+  tbb::task_group group;
+  std::error_code ec;
+  for (const fs::directory_entry& entry : fs::directory_iterator(dir, ec)) {
+    if (entry.is_directory() && !entry.is_symlink()) {
+      group.run([path = entry.path()] { removeTreeParallel(path); });
+    } else {
+      fs::remove(entry.path(), ec);
+    }
+  }
+  group.wait();
+  fs::remove(dir, ec);
+}
+
+static void removeDir(const fs::path& dir, const bool async) {
+  std::error_code ec;
+  if (!fs::exists(dir, ec)) {
+    return;
+  }
+  Diag::info("Removing", "{}", fs::canonical(dir).string());
+
+  // Move the tree aside first: the rename is atomic and frees the name
+  // immediately, so a follow-up build starts while the unlinking is
+  // still in flight.  The trash name includes the pid so concurrent
+  // cleans cannot collide; leftovers from an interrupted delete match
+  // the same pattern and are swept up with the current one.
+  std::vector<fs::path> doomed;
+  const std::string trashPrefix = dir.filename().string() + ".trash-";
+  for (const fs::directory_entry& entry :
+       fs::directory_iterator(dir.parent_path(), ec)) {
+    if (entry.path().filename().string().starts_with(trashPrefix)) {
+      doomed.push_back(entry.path());
+    }
+  }
+  const fs::path trash =
+      dir.parent_path() / fmt::format("{}{}", trashPrefix, ::getpid());
+  fs::rename(dir, trash, ec);
+  if (ec) {
+    // Exotic filesystems may refuse the rename; delete in place.
+    fs::remove_all(dir, ec);
+  } else {
+    doomed.push_back(trash);
+  }
+
+  if (doomed.empty()) {
+    return;
+  }
+  if (async) {
+    // The child outlives us and is reaped by init; anything it fails to
+    // delete still matches the trash pattern for the next clean.
+    const pid_t child = ::fork();
+    if (child == 0) {
+      for (const fs::path& path : doomed) {
+        removeTreeParallel(path);
+      }
+      ::_exit(0);
+    }
+    if (child > 0) {
+      return;
+    }
+    // fork failed; fall through to the synchronous delete.
+  }
+  for (const fs::path& path : doomed) {
+    removeTreeParallel(path);
+  }
+}
+
+// Root of the named dependency's own `cabin-out`, where its objects and
+// library land (dependencies build in their source root, not ours).  The
+// lock is applied first so a locked git dependency resolves to the same
+// checkout the build used.
+static rs::Result<fs::path> depOutBaseDir(const Manifest& manifest,
+                                          const std::string_view name) {
+  const fs::path basePath = manifest.path.parent_path();
+  const Lockfile lockfile = rs_try(Lockfile::load(basePath));
+
+  std::vector<const Dependency*> deps;
+  for (const Dependency& dep : manifest.dependencies) {
+    deps.push_back(&dep);
+  }
+  for (const Dependency& dep : manifest.devDependencies) {
+    deps.push_back(&dep);
+  }
+
+  for (const Dependency* dep : deps) {
+    const std::string& depName = std::visit(
+        [](const auto& d) -> const std::string& { return d.name; }, *dep);
+    if (depName != name) {
+      continue;
+    }
+    if (const auto* gitDep = std::get_if<GitDependency>(dep)) {
+      std::optional<std::string> rev =
+          lockfile.lookup(gitDep->name, gitDep->url, gitDep->target);
+      if (rev.has_value()) {
+        return rs::Ok(GitDependency(gitDep->name, gitDep->url, std::move(rev))
+                          .installDir()
+                      / "cabin-out");
+      }
+      return rs::Ok(gitDep->installDir() / "cabin-out");
+    }
+    if (const auto* tarDep = std::get_if<TarballDependency>(dep)) {
+      return rs::Ok(tarDep->installDir() / "cabin-out");
+    }
+    if (const auto* pathDep = std::get_if<PathDependency>(dep)) {
+      return rs::Ok(fs::absolute(basePath / pathDep->path) / "cabin-out");
+    }
+    rs_bail("dependency `{}` is a system package; nothing to clean", name);
+  }
+  rs_bail("no dependency named `{}` in {}", name, Manifest::FILE_NAME);
+}
+
 static rs::Result<void> cleanMain(CliArgsView args) noexcept {
   // TODO: share across sources
   fs::path outDir = rs_try(Manifest::findPath()).parent_path() / "cabin-out";
 
   // Parse args
+  std::string_view profile;
+  std::string_view depToClean;
+  bool testsOnly = false;
+  bool async = false;
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
 
@@ -42,20 +177,62 @@ static rs::Result<void> cleanMain(CliArgsView args) noexcept {
       }
 
       const std::string_view nextArg = *++itr;
-      if (!matchesAny(nextArg, { "dev", "release" })) {
+      if (!matchesAny(nextArg, { "dev", "release", "test" })) {
         rs_bail("Invalid argument for {}: {}", arg, nextArg);
       }
 
-      outDir /= nextArg;
+      profile = nextArg;
+    } else if (arg == "--deps") {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      depToClean = *++itr;
+    } else if (arg == "--tests") {
+      testsOnly = true;
+    } else if (arg == "--async") {
+      async = true;
     } else {
       return CLEAN_CMD.noSuchArg(arg);
     }
   }
 
-  if (fs::exists(outDir)) {
-    Diag::info("Removing", "{}", fs::canonical(outDir).string());
-    fs::remove_all(outDir);
+  if (!depToClean.empty()) {
+    const Manifest manifest = rs_try(Manifest::tryParse());
+    fs::path depOut = rs_try(depOutBaseDir(manifest, depToClean));
+    if (!profile.empty()) {
+      depOut /= profile;
+    }
+    removeDir(depOut, async);
+    return rs::Ok();
+  }
+
+  if (testsOnly) {
+    // Only the test and benchmark object trees (the `unit`, `intg`, and
+    // `bench` subdirectories Project lays out per profile); library and
+    // binary objects stay warm.
+    std::vector<fs::path> profileDirs;
+    if (!profile.empty()) {
+      profileDirs.emplace_back(outDir / profile);
+    } else if (fs::exists(outDir)) {
+      for (const fs::directory_entry& entry :
+           fs::directory_iterator(outDir)) {
+        if (entry.is_directory()) {
+          profileDirs.emplace_back(entry.path());
+        }
+      }
+    }
+    for (const fs::path& profileDir : profileDirs) {
+      removeDir(profileDir / "unit", async);
+      removeDir(profileDir / "intg", async);
+      removeDir(profileDir / "bench", async);
+    }
+    return rs::Ok();
+  }
+
+  if (!profile.empty()) {
+    outDir /= profile;
   }
+  removeDir(outDir, async);
   return rs::Ok();
 }
 
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Builder/BuildEvents.hpp"
 #include "Cli.hpp"
 #include "Parallelism.hpp"
 
+#include <iterator>
+#include <rs/result.hpp>
+#include <string_view>
+
 namespace cabin {
 
 inline constinit const Opt OPT_RELEASE =
@@ -20,4 +25,31 @@ inline const Opt OPT_JOBS =
         .setPlaceholder("<NUM>")
         .setDefault(NUM_DEFAULT_THREADS);
 
+inline const Opt OPT_MESSAGE_FORMAT =
+    Opt{ "--message-format" }
+        .setDesc("Output format for build messages (human, json)")
+        .setPlaceholder("<FMT>");
+
+/// Handles `--message-format <FMT>` and `--message-format=<FMT>`,
+/// enabling the NDJSON build event stream for `json`.
+template <typename Itr>
+inline rs::Result<void> parseMessageFormat(const std::string_view arg,
+                                           Itr& itr, const Itr end) {
+  std::string_view value;
+  if (arg.starts_with("--message-format=")) {
+    value = arg.substr(std::size("--message-format=") - 1);
+  } else {
+    if (itr + 1 == end) {
+      return Subcmd::missingOptArgumentFor(arg);
+    }
+    value = *++itr;
+  }
+  if (value == "json") {
+    BuildEvents::enable();
+  } else {
+    rs_ensure(value == "human", "invalid message format: {}", value);
+  }
+  return rs::Ok();
+}
+
 } // namespace cabin
@@ -0,0 +1,47 @@
+#include "Complete.hpp"
+
+#include "Cli.hpp"
+
+#include <fmt/core.h>
+#include <rs/result.hpp>
+#include <string_view>
+
+namespace cabin {
+
+static rs::Result<void> completeMain(CliArgsView args) noexcept;
+
+const Subcmd COMPLETE_CMD = //
+    Subcmd{ "complete" }
+        .setDesc("Print a shell completion script to stdout")
+        .setArg(Arg{ "SHELL" }.setDesc("Shell to complete for: bash, zsh, "
+                                       "or fish"))
+        .setMainFn(completeMain);
+
+static rs::Result<void> completeMain(const CliArgsView args) noexcept {
+  // Parse args
+  std::string_view shell;
+  for (auto itr = args.begin(); itr != args.end(); ++itr) {
+    const std::string_view arg = *itr;
+
+    const auto control =
+        rs_try(Cli::handleGlobalOpts(itr, args.end(), "complete"));
+    if (control == Cli::Return) {
+      return rs::Ok();
+    } else if (control == Cli::Continue) {
+      continue;
+    } else if (shell.empty() && !arg.starts_with('-')) {
+      shell = arg;
+    } else {
+      return COMPLETE_CMD.noSuchArg(arg);
+    }
+  }
+  rs_ensure(!shell.empty(), "missing argument for `SHELL`");
+
+  // The script embeds every subcommand and option, so completion answers
+  // come from the shell's own tables; cabin is only re-run to regenerate
+  // the script after an upgrade.
+  fmt::print("{}", rs_try(getCli().formatCompletion(shell)));
+  return rs::Ok();
+}
+
+} // namespace cabin
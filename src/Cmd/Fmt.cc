@@ -1,22 +1,30 @@
 #include "Fmt.hpp"
 
 #include "Algos.hpp"
+#include "Builder/ScanCache.hpp"
 #include "Builder/SourceLayout.hpp"
 #include "Cli.hpp"
+#include "Command.hpp"
 #include "Diag.hpp"
 #include "Git2/Exception.hpp"
 #include "Git2/Repository.hpp"
 #include "Manifest.hpp"
+#include "Parallelism.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
 #include <ranges>
 #include <rs/result.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <tbb/spin_mutex.h>
 #include <utility>
 #include <vector>
 
@@ -70,37 +78,51 @@ collectFormatTargets(const fs::path& manifestDir,
            != excludes.end();
   };
 
-  // Automatically collects format-target files
-  std::vector<TargetFile> files;
-  for (auto entry = fs::recursive_directory_iterator(manifestDir);
-       entry != fs::recursive_directory_iterator(); ++entry) {
-    if (entry->is_directory()) {
-      const std::string path =
-          fs::relative(entry->path(), manifestDir).string();
-      if (entry->path() != manifestDir
-          && fs::exists(entry->path() / Manifest::FILE_NAME)) {
-        spdlog::debug("Ignore nested project: {}", path);
-        entry.disable_recursion_pending();
-        continue;
-      }
-      if ((hasGitRepo && repo.isIgnored(path)) || isExcluded(path)) {
-        spdlog::debug("Ignore: {}", path);
-        entry.disable_recursion_pending();
-        continue;
-      }
-    } else if (entry->is_regular_file()) {
-      const fs::path path = fs::relative(entry->path(), manifestDir);
-      if ((hasGitRepo && repo.isIgnored(path.string()))
-          || isExcluded(path.string())) {
-        spdlog::debug("Ignore: {}", path.string());
-        continue;
-      }
+  // libgit2 ignore checks are not thread-safe on a shared repository
+  // handle; the walk itself still fans out per subdirectory.
+  tbb::spin_mutex repoMtx;
+  const auto isIgnored = [&](const std::string& path) {
+    if (!hasGitRepo) {
+      return false;
+    }
+    const tbb::spin_mutex::scoped_lock lock(repoMtx);
+    return repo.isIgnored(path);
+  };
 
-      const std::string ext = path.extension().string();
-      if (SOURCE_FILE_EXTS.contains(ext) || HEADER_FILE_EXTS.contains(ext)) {
-        files.emplace_back(path.string());
-      }
+  // Automatically collects format-target files
+  WalkOptions options;
+  options.enterDir = [&](const fs::path& dirPath) {
+    const std::string path = fs::relative(dirPath, manifestDir).string();
+    if (fs::exists(dirPath / Manifest::FILE_NAME)) {
+      spdlog::debug("Ignore nested project: {}", path);
+      return false;
+    }
+    if (isIgnored(path) || isExcluded(path)) {
+      spdlog::debug("Ignore: {}", path);
+      return false;
     }
+    return true;
+  };
+  options.includeEntry = [&](const fs::directory_entry& entry) {
+    if (!entry.is_regular_file()) {
+      return false;
+    }
+    const std::string path =
+        fs::relative(entry.path(), manifestDir).string();
+    const std::string ext = entry.path().extension().string();
+    if (!SOURCE_FILE_EXTS.contains(ext) && !HEADER_FILE_EXTS.contains(ext)) {
+      return false;
+    }
+    if (isIgnored(path) || isExcluded(path)) {
+      spdlog::debug("Ignore: {}", path);
+      return false;
+    }
+    return true;
+  };
+
+  std::vector<TargetFile> files;
+  for (const fs::path& path : walkDirParallel(manifestDir, options)) {
+    files.emplace_back(fs::relative(path, manifestDir).string());
   }
   return files;
 }
@@ -149,14 +171,14 @@ static rs::Result<void> fmtMain(const CliArgsView args) {
             "fmt command requires clang-format; try installing it by:\n"
             "  apt/brew install clang-format");
 
-  const auto manifest = rs_try(Manifest::tryParse());
   std::vector<std::string> clangFormatArgs{
     "--style=file",
     "--fallback-style=LLVM",
     "-Werror",
   };
 
-  const fs::path projectPath = manifest.path.parent_path();
+  // Formatting only needs the project root; no manifest validation.
+  const fs::path projectPath = rs_try(Manifest::findPath()).parent_path();
   const std::vector<TargetFile> files =
       collectFormatTargets(projectPath, excludes, useVcsIgnoreFiles);
   if (files.empty()) {
@@ -172,28 +194,117 @@ static rs::Result<void> fmtMain(const CliArgsView args) {
   } else {
     clangFormatArgs.emplace_back("-i");
   }
-  clangFormatArgs.reserve(clangFormatArgs.size() + files.size());
-  std::ranges::copy(files | std::views::transform(&TargetFile::path),
-                    std::back_inserter(clangFormatArgs));
+
+  // Format-state cache: a file whose content hash matches its state at
+  // the last successful format needs no work.  A changed .clang-format
+  // invalidates everything.
+  const fs::path cachePath = projectPath / "cabin-out" / "fmt-cache.json";
+  const fs::path styleFile = projectPath / ".clang-format";
+  const std::string styleDigest =
+      fs::exists(styleFile) ? digestFile(styleFile) : std::string();
+  nlohmann::json formatted = nlohmann::json::object();
+  if (fs::exists(cachePath)) {
+    try {
+      std::ifstream ifs(cachePath);
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (loaded.is_object() && loaded.contains("formatted")
+          && loaded.contains("style") && loaded["style"] == styleDigest) {
+        formatted = loaded["formatted"];
+      }
+    } catch (const nlohmann::json::parse_error& e) {
+      spdlog::debug("discarding format cache: {}", e.what());
+    }
+  }
+
+  std::vector<const TargetFile*> pending;
+  pending.reserve(files.size());
+  for (const TargetFile& file : files) {
+    const std::string digest = digestFile(projectPath / file.path);
+    if (formatted.contains(file.path) && formatted[file.path] == digest) {
+      continue;
+    }
+    pending.push_back(&file);
+  }
 
   const char* cabinFmt = std::getenv("CABIN_FMT");
   if (cabinFmt == nullptr) {
     cabinFmt = "clang-format";
   }
 
-  const Command clangFormat = Command(cabinFmt, std::move(clangFormatArgs))
-                                  .setWorkingDirectory(projectPath.string());
+  ExitStatus exitStatus(EXIT_SUCCESS);
+  if (!pending.empty()) {
+    // Split the worklist into parallel clang-format invocations sized to
+    // the job budget; each batch's verdict is recorded independently so
+    // one unformatted file only evicts its own batch from the cache.
+    const std::size_t numBatches =
+        std::min(std::max<std::size_t>(getParallelism(), 1), pending.size());
+    const std::size_t perBatch = (pending.size() + numBatches - 1) / numBatches;
+
+    std::vector<Child> children;
+    std::vector<std::vector<const TargetFile*>> batches;
+    children.reserve(numBatches);
+    batches.reserve(numBatches);
+    for (std::size_t base = 0; base < pending.size(); base += perBatch) {
+      const std::size_t count = std::min(perBatch, pending.size() - base);
+      std::vector<std::string> batchArgs = clangFormatArgs;
+      std::vector<const TargetFile*> batch;
+      batch.reserve(count);
+      for (std::size_t i = 0; i < count; ++i) {
+        batchArgs.push_back(pending[base + i]->path);
+        batch.push_back(pending[base + i]);
+      }
+      Command clangFormat = Command(cabinFmt, std::move(batchArgs))
+                                .setWorkingDirectory(projectPath.string());
+      clangFormat.setStdOutConfig(Command::IOConfig::Piped);
+      clangFormat.setStdErrConfig(Command::IOConfig::Piped);
+      children.push_back(rs_try(clangFormat.spawn()));
+      batches.push_back(std::move(batch));
+    }
+
+    const std::vector<CommandOutput> outputs =
+        rs_try(waitAllWithOutput(children));
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+      const CommandOutput& output = outputs[i];
+      if (!output.stdOut.empty()) {
+        fmt::print("{}", output.stdOut);
+      }
+      if (!output.stdErr.empty()) {
+        fmt::print(stderr, "{}", output.stdErr);
+      }
+      if (output.exitStatus.success()) {
+        for (const TargetFile* file : batches[i]) {
+          // -i may have just rewritten the file; hash what is on disk now.
+          formatted[file->path] = digestFile(projectPath / file->path);
+        }
+      } else {
+        for (const TargetFile* file : batches[i]) {
+          formatted.erase(file->path);
+        }
+        exitStatus = output.exitStatus;
+      }
+    }
+  }
+
+  {
+    fs::create_directories(cachePath.parent_path());
+    nlohmann::json json;
+    json["version"] = 1;
+    json["style"] = styleDigest;
+    json["formatted"] = std::move(formatted);
+    std::ofstream ofs(cachePath);
+    ofs << json.dump();
+  }
 
-  const ExitStatus exitStatus = rs_try(execCmd(clangFormat));
   if (exitStatus.success()) {
     const std::size_t numFiles = files.size();
+    const std::size_t numCached = numFiles - pending.size();
     if (isCheck) {
-      Diag::info("Checked", "{} file{} with no format required", numFiles,
-                 numFiles == 1 ? "" : "s");
+      Diag::info("Checked", "{} file{} with no format required ({} cached)",
+                 numFiles, numFiles == 1 ? "" : "s", numCached);
     } else {
       const std::size_t modifiedFiles = countModifiedFiles(files);
-      Diag::info("Formatted", "{} out of {} file{}", modifiedFiles, numFiles,
-                 numFiles == 1 ? "" : "s");
+      Diag::info("Formatted", "{} out of {} file{} ({} cached)", modifiedFiles,
+                 numFiles, numFiles == 1 ? "" : "s", numCached);
     }
     return rs::Ok();
   } else {
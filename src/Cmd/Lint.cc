@@ -1,24 +1,40 @@
 #include "Lint.hpp"
 
 #include "Algos.hpp"
+#include "Builder/ScanCache.hpp"
+#include "Builder/SourceLayout.hpp"
 #include "Cli.hpp"
 #include "Command.hpp"
 #include "Diag.hpp"
+#include "Git2/Exception.hpp"
+#include "Git2/Repository.hpp"
 #include "Manifest.hpp"
+#include "Parallelism.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
 #include <fstream>
+#include <nlohmann/json.hpp>
 #include <rs/result.hpp>
+#include <span>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace cabin {
 
+namespace fs = std::filesystem;
+
 static rs::Result<void> lintMain(CliArgsView args);
 
 const Subcmd LINT_CMD =
@@ -29,72 +45,236 @@ const Subcmd LINT_CMD =
                     .setPlaceholder("<FILE>"))
         .addOpt(Opt{ "--no-ignore-vcs" }.setDesc(
             "Do not exclude git-ignored files from linting"))
+        .addOpt(Opt{ "--no-cache" }.setDesc(
+            "Lint every file even if it was clean last run"))
         .setMainFn(lintMain);
 
-struct LintArgs {
-  std::vector<std::string> excludes;
-};
-
+// Walks the project for lintable sources, skipping nested projects,
+// excluded paths, and (by default) git-ignored files.  Paths come back
+// relative to the project root in sorted order, so batching and the
+// merged diagnostics stay deterministic.
 static std::vector<std::string>
-collectNestedProjectExcludes(const fs::path& manifestDir) {
-  std::vector<std::string> excludes;
-  for (auto entry = fs::recursive_directory_iterator(manifestDir);
-       entry != fs::recursive_directory_iterator(); ++entry) {
-    if (!entry->is_directory()) {
-      continue;
+collectLintTargets(const fs::path& manifestDir,
+                   const std::vector<fs::path>& excludes,
+                   bool useVcsIgnoreFiles) {
+  git2::Repository repo = git2::Repository();
+  bool hasGitRepo = false;
+  if (useVcsIgnoreFiles) {
+    try {
+      repo.open(manifestDir.string());
+      hasGitRepo = true;
+    } catch (const git2::Exception& e) {
+      spdlog::debug("No git repository found");
     }
-    if (entry->path() == manifestDir) {
-      continue;
+  }
+
+  const auto isExcluded = [&](std::string_view path) -> bool {
+    return std::ranges::find(
+               excludes, path,
+               [&](const fs::path& candidate) {
+                 return fs::relative(candidate, manifestDir).string();
+               })
+           != excludes.end();
+  };
+
+  // libgit2 ignore checks are not thread-safe on a shared repository
+  // handle; the walk itself still fans out per subdirectory.
+  tbb::spin_mutex repoMtx;
+  const auto isIgnored = [&](const std::string& path) {
+    if (!hasGitRepo) {
+      return false;
+    }
+    const tbb::spin_mutex::scoped_lock lock(repoMtx);
+    return repo.isIgnored(path);
+  };
+
+  WalkOptions options;
+  options.enterDir = [&](const fs::path& dirPath) {
+    const std::string path = fs::relative(dirPath, manifestDir).string();
+    if (fs::exists(dirPath / Manifest::FILE_NAME)) {
+      spdlog::debug("Ignore nested project: {}", path);
+      return false;
+    }
+    if (isIgnored(path) || isExcluded(path)) {
+      spdlog::debug("Ignore: {}", path);
+      return false;
+    }
+    return true;
+  };
+  options.includeEntry = [&](const fs::directory_entry& entry) {
+    if (!entry.is_regular_file()) {
+      return false;
     }
-    if (fs::exists(entry->path() / Manifest::FILE_NAME)) {
-      std::error_code ec;
-      const fs::path rel = fs::relative(entry->path(), manifestDir, ec);
-      if (!ec) {
-        excludes.emplace_back("--exclude=" + rel.generic_string());
+    const std::string path = fs::relative(entry.path(), manifestDir).string();
+    const std::string ext = entry.path().extension().string();
+    if (!SOURCE_FILE_EXTS.contains(ext) && !HEADER_FILE_EXTS.contains(ext)) {
+      return false;
+    }
+    if (isIgnored(path) || isExcluded(path)) {
+      spdlog::debug("Ignore: {}", path);
+      return false;
+    }
+    return true;
+  };
+
+  std::vector<std::string> files;
+  for (const fs::path& path : walkDirParallel(manifestDir, options)) {
+    files.push_back(fs::relative(path, manifestDir).generic_string());
+  }
+  return files;
+}
+
+// Scans cpplint output for `path:line:` prefixes to recover per-file
+// verdicts from a batched invocation.
+static std::unordered_set<std::string>
+parseDirtyFiles(const std::string_view output,
+                const std::unordered_set<std::string>& batchFiles) {
+  std::unordered_set<std::string> dirty;
+  std::size_t begin = 0;
+  while (begin < output.size()) {
+    std::size_t end = output.find('\n', begin);
+    if (end == std::string_view::npos) {
+      end = output.size();
+    }
+    const std::string_view line = output.substr(begin, end - begin);
+    if (const std::size_t colon = line.find(':');
+        colon != std::string_view::npos) {
+      const std::string candidate(line.substr(0, colon));
+      if (batchFiles.contains(candidate)) {
+        dirty.insert(candidate);
       }
-      entry.disable_recursion_pending();
     }
+    begin = end + 1;
   }
-  return excludes;
+  return dirty;
 }
 
 static rs::Result<void> lint(const std::string_view name,
-                             const std::vector<std::string>& cpplintArgs,
-                             bool useVcsIgnoreFiles) {
+                             const fs::path& projectDir,
+                             std::vector<std::string> cpplintArgs,
+                             const std::vector<std::string>& files,
+                             const bool noCache) {
   Diag::info("Linting", "{}", name);
-
-  Command cpplintCmd("cpplint", cpplintArgs);
   if (!isVerbose()) {
-    cpplintCmd.addArg("--quiet");
+    cpplintArgs.emplace_back("--quiet");
   }
 
-  // If gitignored files need to be ignored, read .gitignore if exists
-  if (useVcsIgnoreFiles && fs::exists(".gitignore")) {
-    std::ifstream ifs(".gitignore");
-    std::string line;
-    while (std::getline(ifs, line)) {
-      if (line.empty() || line[0] == '#') {
-        continue;
+  // Clean verdicts hold per file as long as its content, the cpplint
+  // arguments, and CPPLINT.cfg are all unchanged.
+  const fs::path cfgPath = projectDir / "CPPLINT.cfg";
+  const std::string flagsDigest = digestString(
+      fmt::format("{}\x1f{}", fmt::join(cpplintArgs, " "),
+                  fs::exists(cfgPath) ? digestFile(cfgPath) : std::string()));
+
+  const fs::path cachePath = projectDir / "cabin-out" / "lint-cache.json";
+  nlohmann::json cleanVerdicts = nlohmann::json::object();
+  if (fs::exists(cachePath)) {
+    try {
+      std::ifstream ifs(cachePath);
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (loaded.is_object() && loaded.contains("clean")
+          && loaded.contains("flags") && loaded["flags"] == flagsDigest) {
+        cleanVerdicts = loaded["clean"];
       }
+    } catch (const nlohmann::json::parse_error& e) {
+      spdlog::debug("discarding lint cache: {}", e.what());
+    }
+  }
 
-      cpplintCmd.addArg("--exclude=" + line);
+  std::vector<std::string> pending;
+  std::unordered_map<std::string, std::string> digests;
+  pending.reserve(files.size());
+  for (const std::string& file : files) {
+    const std::string digest = digestFile(projectDir / file);
+    digests.emplace(file, digest);
+    if (!noCache && cleanVerdicts.contains(file)
+        && cleanVerdicts[file] == digest) {
+      continue;
     }
+    pending.push_back(file);
   }
-  // NOTE: This should come after the `--exclude` options.
-  cpplintCmd.addArg("--recursive");
-  cpplintCmd.addArg(".");
 
-  const ExitStatus exitStatus = rs_try(execCmd(cpplintCmd));
-  if (exitStatus.success()) {
-    return rs::Ok();
-  } else {
-    rs_bail("cpplint {}", exitStatus);
+  bool failed = false;
+  if (!pending.empty()) {
+    // Shard the worklist into parallel cpplint invocations sized to the
+    // job budget; outputs are buffered and replayed in batch order.
+    const std::size_t numBatches =
+        std::min(std::max<std::size_t>(getParallelism(), 1), pending.size());
+    const std::size_t perBatch = (pending.size() + numBatches - 1) / numBatches;
+
+    std::vector<Child> children;
+    std::vector<std::vector<std::string>> batches;
+    children.reserve(numBatches);
+    batches.reserve(numBatches);
+    for (std::size_t base = 0; base < pending.size(); base += perBatch) {
+      const std::size_t count = std::min(perBatch, pending.size() - base);
+      std::vector<std::string> batch(pending.begin() + base,
+                                     pending.begin() + base + count);
+      Command cpplintCmd("cpplint", cpplintArgs);
+      cpplintCmd.addArgs(std::span<const std::string>(batch));
+      cpplintCmd.setWorkingDirectory(projectDir);
+      cpplintCmd.setStdOutConfig(Command::IOConfig::Piped);
+      cpplintCmd.setStdErrConfig(Command::IOConfig::Piped);
+      children.push_back(rs_try(cpplintCmd.spawn()));
+      batches.push_back(std::move(batch));
+    }
+
+    const std::vector<CommandOutput> outputs =
+        rs_try(waitAllWithOutput(children));
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+      const CommandOutput& output = outputs[i];
+      if (!output.stdOut.empty()) {
+        fmt::print("{}", output.stdOut);
+      }
+      if (!output.stdErr.empty()) {
+        fmt::print(stderr, "{}", output.stdErr);
+      }
+
+      const std::unordered_set<std::string> batchFiles(batches[i].begin(),
+                                                       batches[i].end());
+      std::unordered_set<std::string> dirty;
+      if (!output.exitStatus.success()) {
+        failed = true;
+        dirty = parseDirtyFiles(output.stdErr, batchFiles);
+        const std::unordered_set<std::string> dirtyOut =
+            parseDirtyFiles(output.stdOut, batchFiles);
+        dirty.insert(dirtyOut.begin(), dirtyOut.end());
+        // If no per-file diagnostics could be recovered, be conservative
+        // and treat the whole batch as dirty.
+        if (dirty.empty()) {
+          dirty = batchFiles;
+        }
+      }
+      for (const std::string& file : batches[i]) {
+        if (dirty.contains(file)) {
+          cleanVerdicts.erase(file);
+        } else {
+          cleanVerdicts[file] = digests.at(file);
+        }
+      }
+    }
+  }
+
+  {
+    fs::create_directories(cachePath.parent_path());
+    nlohmann::json json;
+    json["version"] = 1;
+    json["flags"] = flagsDigest;
+    json["clean"] = std::move(cleanVerdicts);
+    std::ofstream ofs(cachePath);
+    ofs << json.dump();
   }
+
+  rs_ensure(!failed, "cpplint reported issues");
+  Diag::info("Checked", "{} file(s) ({} cached)", files.size(),
+             files.size() - pending.size());
+  return rs::Ok();
 }
 
 static rs::Result<void> lintMain(const CliArgsView args) {
-  LintArgs lintArgs;
+  std::vector<fs::path> excludes;
   bool useVcsIgnoreFiles = true;
+  bool noCache = false;
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
 
@@ -107,10 +287,11 @@ static rs::Result<void> lintMain(const CliArgsView args) {
       if (itr + 1 == args.end()) {
         return Subcmd::missingOptArgumentFor(arg);
       }
-
-      lintArgs.excludes.push_back("--exclude=" + std::string(*++itr));
+      excludes.emplace_back(*++itr);
     } else if (arg == "--no-ignore-vcs") {
       useVcsIgnoreFiles = false;
+    } else if (arg == "--no-cache") {
+      noCache = true;
     } else {
       return LINT_CMD.noSuchArg(arg);
     }
@@ -121,22 +302,27 @@ static rs::Result<void> lintMain(const CliArgsView args) {
             "  pip install cpplint");
   }
 
-  const auto manifest = rs_try(Manifest::tryParse());
-
-  std::vector<std::string> cpplintArgs = std::move(lintArgs.excludes);
+  // Only [package] and [lint] matter here; skip full manifest validation.
+  const auto manifest = rs_try(ManifestLite::tryParse());
   const fs::path projectDir = manifest.path.parent_path();
-  const std::vector<std::string> nestedExcludes =
-      collectNestedProjectExcludes(projectDir);
-  cpplintArgs.insert(cpplintArgs.end(), nestedExcludes.begin(),
-                     nestedExcludes.end());
-  if (fs::exists("CPPLINT.cfg")) {
+
+  const std::vector<std::string> files =
+      collectLintTargets(projectDir, excludes, useVcsIgnoreFiles);
+  if (files.empty()) {
+    Diag::warn("no files to lint");
+    return rs::Ok();
+  }
+
+  std::vector<std::string> cpplintArgs;
+  if (fs::exists(projectDir / "CPPLINT.cfg")) {
     spdlog::debug("Using CPPLINT.cfg for lint ...");
-    return lint(manifest.package.name, cpplintArgs, useVcsIgnoreFiles);
+    return lint(manifest.package.name, projectDir, std::move(cpplintArgs),
+                files, noCache);
   }
 
-  if (fs::exists("include")) {
+  if (fs::exists(projectDir / "include")) {
     cpplintArgs.emplace_back("--root=include");
-  } else if (fs::exists("src")) {
+  } else if (fs::exists(projectDir / "src")) {
     cpplintArgs.emplace_back("--root=src");
   }
 
@@ -152,14 +338,16 @@ static rs::Result<void> lintMain(const CliArgsView args) {
     // Remove last comma
     filterArg.pop_back();
     cpplintArgs.push_back(filterArg);
-    return lint(manifest.package.name, cpplintArgs, useVcsIgnoreFiles);
+    return lint(manifest.package.name, projectDir, std::move(cpplintArgs),
+                files, noCache);
   } else {
     spdlog::debug("Using default arguments for lint ...");
     if (Edition::Cpp11 < manifest.package.edition) {
       // Disable C++11-related lints
       cpplintArgs.emplace_back("--filter=-build/c++11");
     }
-    return lint(manifest.package.name, cpplintArgs, useVcsIgnoreFiles);
+    return lint(manifest.package.name, projectDir, std::move(cpplintArgs),
+                files, noCache);
   }
 }
 
@@ -0,0 +1,240 @@
+#include "Metadata.hpp"
+
+#include "Builder/NinjaPlan.hpp"
+#include "Builder/PlanCache.hpp"
+#include "Cli.hpp"
+#include "Manifest.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <rs/result.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+static rs::Result<void> metadataMain(CliArgsView args) noexcept;
+
+const Subcmd METADATA_CMD = //
+    Subcmd{ "metadata" }
+        .setDesc("Query the saved build plan without replanning")
+        .addOpt(Opt{ "--profile" }
+                    .setShort("-p")
+                    .setDesc("Query the plan of the specified profile")
+                    .setPlaceholder("<PROFILE>"))
+        .addOpt(Opt{ "--closure" }
+                    .setDesc("List everything built to produce the target")
+                    .setPlaceholder("<TARGET>"))
+        .addOpt(Opt{ "--includers" }
+                    .setDesc("List translation units depending on the header")
+                    .setPlaceholder("<PATH>"))
+        .setMainFn(metadataMain);
+
+// The query argument either equals the planned path or names its suffix
+// at a path-component boundary, so `--includers Manifest.hpp` works
+// without spelling the full include directory.
+static bool pathMatches(const std::string_view planned,
+                        const std::string_view query) {
+  if (planned == query) {
+    return true;
+  }
+  return planned.size() > query.size() && planned.ends_with(query)
+         && planned[planned.size() - query.size() - 1] == '/';
+}
+
+// Walks the edge list from every edge producing `target`, following
+// inputs that are themselves built outputs.  This is the snapshot-side
+// equivalent of the planner's collectBinDepObjs recursion: the edges
+// already encode which objects feed which link.
+static nlohmann::json
+targetClosure(const std::vector<NinjaEdge>& edges,
+              const std::string_view target) {
+  std::unordered_map<std::string_view, std::size_t> producerOf;
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    for (const std::string& output : edges[i].outputs) {
+      producerOf.emplace(output, i);
+    }
+    for (const std::string& output : edges[i].implicitOutputs) {
+      producerOf.emplace(output, i);
+    }
+  }
+
+  std::vector<std::string> closure;
+  std::unordered_set<std::size_t> visitedEdges;
+  std::deque<std::size_t> pending;
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    const auto matches = [&](const std::string& output) {
+      return pathMatches(output, target);
+    };
+    if (std::ranges::any_of(edges[i].outputs, matches)
+        && visitedEdges.insert(i).second) {
+      pending.push_back(i);
+    }
+  }
+
+  while (!pending.empty()) {
+    const NinjaEdge& edge = edges[pending.front()];
+    pending.pop_front();
+
+    const auto visitInput = [&](const std::string& input) {
+      const auto producer = producerOf.find(input);
+      if (producer == producerOf.end()) {
+        return; // a plain source or header; not built by the plan
+      }
+      if (edges[producer->second].rule == "phony") {
+        return; // a header-alias node, not a built artifact
+      }
+      closure.push_back(input);
+      if (visitedEdges.insert(producer->second).second) {
+        pending.push_back(producer->second);
+      }
+    };
+    std::ranges::for_each(edge.inputs, visitInput);
+    std::ranges::for_each(edge.implicitInputs, visitInput);
+    std::ranges::for_each(edge.orderOnlyInputs, visitInput);
+  }
+
+  std::ranges::sort(closure);
+  const auto dup = std::ranges::unique(closure);
+  closure.erase(dup.begin(), dup.end());
+
+  return nlohmann::json{ { "target", target }, { "closure", closure } };
+}
+
+// Inverts the header dependencies the compile edges recorded at plan
+// time: every implicit input of a compile edge is a header its first
+// input (the translation unit) includes, directly or transitively.
+// Reduced edges name shared alias nodes instead of the flat closure, so
+// the check follows phony alias edges back to the headers they stand
+// for, with one memoized verdict per alias across the whole plan.
+static nlohmann::json includersOf(const std::vector<NinjaEdge>& edges,
+                                  const std::string_view header) {
+  std::unordered_map<std::string_view, const NinjaEdge*> aliasOf;
+  for (const NinjaEdge& edge : edges) {
+    if (edge.rule == "phony" && !edge.outputs.empty()) {
+      aliasOf.emplace(edge.outputs.front(), &edge);
+    }
+  }
+
+  std::unordered_map<std::string_view, bool> verdicts;
+  const auto covers = [&](const auto& self,
+                          const std::string& input) -> bool {
+    const auto alias = aliasOf.find(input);
+    if (alias == aliasOf.end()) {
+      return pathMatches(input, header);
+    }
+    if (const auto found = verdicts.find(input); found != verdicts.end()) {
+      return found->second;
+    }
+    bool result = false;
+    for (const std::string& sub : alias->second->inputs) {
+      if (self(self, sub)) {
+        result = true;
+        break;
+      }
+    }
+    verdicts.emplace(input, result);
+    return result;
+  };
+
+  std::vector<std::string> includers;
+  for (const NinjaEdge& edge : edges) {
+    if (!edge.rule.starts_with("cxx_compile") || edge.inputs.empty()) {
+      continue;
+    }
+    const auto matches = [&](const std::string& input) {
+      return covers(covers, input);
+    };
+    if (std::ranges::any_of(edge.implicitInputs, matches)) {
+      includers.push_back(edge.inputs.front());
+    }
+  }
+
+  std::ranges::sort(includers);
+  const auto dup = std::ranges::unique(includers);
+  includers.erase(dup.begin(), dup.end());
+
+  return nlohmann::json{ { "header", header }, { "includers", includers } };
+}
+
+static nlohmann::json planSummary(const PlanSnapshot& snapshot) {
+  nlohmann::json testTargets = nlohmann::json::array();
+  for (const PlanSnapshot::TestTarget& target : snapshot.testTargets) {
+    testTargets.push_back(target.ninjaTarget);
+  }
+  return nlohmann::json{
+    { "edges", snapshot.edges.size() },
+    { "default-targets", snapshot.defaultTargets },
+    { "test-targets", std::move(testTargets) },
+    { "has-binary", snapshot.hasBinaryTarget },
+    { "has-library", snapshot.hasLibraryTarget },
+  };
+}
+
+static rs::Result<void> metadataMain(const CliArgsView args) noexcept {
+  std::string profile = "dev";
+  std::string_view closureTarget;
+  std::string_view includersHeader;
+  for (auto itr = args.begin(); itr != args.end(); ++itr) {
+    const std::string_view arg = *itr;
+
+    const auto control =
+        rs_try(Cli::handleGlobalOpts(itr, args.end(), "metadata"));
+    if (control == Cli::Return) {
+      return rs::Ok();
+    } else if (control == Cli::Continue) {
+      continue;
+    } else if (matchesAny(arg, { "-p", "--profile" })) {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      const std::string_view nextArg = *++itr;
+      if (!matchesAny(nextArg, { "dev", "release", "test" })) {
+        rs_bail("Invalid argument for {}: {}", arg, nextArg);
+      }
+      profile = nextArg;
+    } else if (arg == "--closure") {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      closureTarget = *++itr;
+    } else if (arg == "--includers") {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      includersHeader = *++itr;
+    } else {
+      return METADATA_CMD.noSuchArg(arg);
+    }
+  }
+
+  const fs::path outBasePath =
+      rs_try(Manifest::findPath()).parent_path() / "cabin-out" / profile;
+  const std::optional<PlanSnapshot> snapshot = PlanCache::load(outBasePath);
+  rs_ensure(snapshot.has_value(),
+            "no saved plan for the `{}` profile; run `cabin build` first",
+            profile);
+
+  nlohmann::json result;
+  if (!closureTarget.empty()) {
+    result = targetClosure(snapshot->edges, closureTarget);
+  } else if (!includersHeader.empty()) {
+    result = includersOf(snapshot->edges, includersHeader);
+  } else {
+    result = planSummary(*snapshot);
+  }
+  fmt::print("{}\n", result.dump());
+  return rs::Ok();
+}
+
+} // namespace cabin
@@ -7,13 +7,17 @@
 #include "Git2.hpp"
 #include "Manifest.hpp"
 
+#include <charconv>
+#include <cstddef>
 #include <cstdlib>
 #include <format>
 #include <fstream>
+#include <optional>
 #include <rs/result.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace cabin {
@@ -25,6 +29,10 @@ const Subcmd NEW_CMD = //
         .setDesc("Create a new cabin project")
         .addOpt(OPT_BIN)
         .addOpt(OPT_LIB)
+        .addOpt(Opt{ "--synthetic" }
+                    .setDesc("Generate a synthetic source tree for "
+                             "scalability testing")
+                    .setPlaceholder("<files=N,headers=M,fanout=F>"))
         .setArg(Arg{ "name" })
         .setMainFn(newMain);
 
@@ -153,9 +161,111 @@ void hello_world() {{
   return rs::Ok();
 }
 
+/// Shape of a generated scalability fixture; the defaults give a tree
+/// small enough to plan in seconds but large enough to exercise the
+/// parallel walk and scan batching.
+struct SyntheticSpec {
+  std::size_t files = 1000;
+  std::size_t headers = 200;
+  std::size_t fanout = 4;
+};
+
+static rs::Result<SyntheticSpec>
+parseSyntheticSpec(const std::string_view spec) {
+  SyntheticSpec result;
+  std::string_view rest = spec;
+  while (!rest.empty()) {
+    const std::size_t comma = rest.find(',');
+    const std::string_view entry = rest.substr(0, comma);
+    rest = comma == std::string_view::npos ? std::string_view()
+                                           : rest.substr(comma + 1);
+
+    const std::size_t eq = entry.find('=');
+    rs_ensure(eq != std::string_view::npos,
+              "invalid synthetic spec entry `{}`; expected key=N", entry);
+    const std::string_view key = entry.substr(0, eq);
+    const std::string_view valueStr = entry.substr(eq + 1);
+    std::size_t value{};
+    const auto [ptr, ec] =
+        std::from_chars(valueStr.begin(), valueStr.end(), value);
+    rs_ensure(ec == std::errc() && ptr == valueStr.end() && value > 0,
+              "invalid synthetic spec value `{}`", entry);
+
+    if (key == "files") {
+      result.files = value;
+    } else if (key == "headers") {
+      result.headers = value;
+    } else if (key == "fanout") {
+      result.fanout = value;
+    } else {
+      rs_bail("unknown synthetic spec key `{}`; expected files, headers, "
+              "or fanout",
+              key);
+    }
+  }
+  return rs::Ok(result);
+}
+
+/// Emits a parameterized binary project: `spec.headers` headers forming
+/// a binary-tree include hierarchy (so scans see transitive closures,
+/// not flat lists) and `spec.files` sources each including `spec.fanout`
+/// of them.  Deterministic, so two people generating the same spec can
+/// compare timings on identical trees.
+static rs::Result<void> createSyntheticFiles(const fs::path& root,
+                                             const std::string_view projectName,
+                                             const SyntheticSpec& spec) {
+  static constexpr std::size_t FILES_PER_DIR = 100;
+
+  const std::string ns = toNamespaceName(projectName);
+  const fs::path includeDir = root / "include" / projectName;
+  fs::create_directories(includeDir);
+  fs::create_directories(root / "src");
+
+  rs_try(writeToFile(root / "cabin.toml", createCabinToml(projectName)));
+  rs_try(writeToFile(root / ".gitignore", "/cabin-out"));
+  rs_try(writeToFile(root / "src" / "main.cc", std::string(MAIN_CC)));
+
+  for (std::size_t j = 0; j < spec.headers; ++j) {
+    std::string header = "#pragma once\n";
+    if (j > 0) {
+      // Each header includes its parent, so including h<j> pulls in a
+      // log-depth chain the way real umbrella headers do.
+      header += std::format("#include \"{}/h{}.hpp\"\n", projectName,
+                            (j - 1) / 2);
+    }
+    header += std::format("namespace {} {{\n"
+                          "inline int value{}() {{ return {}; }}\n"
+                          "}}  // namespace {}\n",
+                          ns, j, j, ns);
+    rs_try(writeToFile(includeDir / std::format("h{}.hpp", j), header));
+  }
+
+  for (std::size_t i = 0; i < spec.files; ++i) {
+    const fs::path dir = root / "src" / std::format("mod{}", i / FILES_PER_DIR);
+    fs::create_directories(dir);
+
+    std::string source;
+    std::string sum;
+    for (std::size_t inc = 0; inc < spec.fanout; ++inc) {
+      const std::size_t header = (i * 31 + inc * 7) % spec.headers;
+      source += std::format("#include \"{}/h{}.hpp\"\n", projectName, header);
+      sum += std::format("{}{}::value{}()", inc == 0 ? "" : " + ", ns, header);
+    }
+    source += std::format("int func{}() {{ return {}; }}\n", i, sum);
+    rs_try(writeToFile(dir / std::format("f{}.cc", i % FILES_PER_DIR),
+                       source));
+  }
+
+  Diag::info("Created",
+             "synthetic package `{}` ({} sources, {} headers, fanout {})",
+             projectName, spec.files, spec.headers, spec.fanout);
+  return rs::Ok();
+}
+
 static rs::Result<void> newMain(const CliArgsView args) {
   // Parse args
   bool isBin = true;
+  std::optional<SyntheticSpec> synthetic;
   std::string packageName;
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
@@ -169,6 +279,11 @@ static rs::Result<void> newMain(const CliArgsView args) {
       isBin = true;
     } else if (matchesAny(arg, { "-l", "--lib" })) {
       isBin = false;
+    } else if (arg == "--synthetic") {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      synthetic = rs_try(parseSyntheticSpec(*++itr));
     } else if (packageName.empty()) {
       packageName = arg;
     } else {
@@ -180,7 +295,12 @@ static rs::Result<void> newMain(const CliArgsView args) {
   rs_ensure(!fs::exists(packageName), "directory `{}` already exists",
             packageName);
 
-  rs_try(createProjectFiles(isBin, fs::path(packageName), packageName));
+  if (synthetic.has_value()) {
+    rs_try(createSyntheticFiles(fs::path(packageName), packageName,
+                                synthetic.value()));
+  } else {
+    rs_try(createProjectFiles(isBin, fs::path(packageName), packageName));
+  }
   git2::Repository().init(packageName);
   return rs::Ok();
 }
@@ -4,13 +4,20 @@
 #include "Diag.hpp"
 #include "Manifest.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
+#include <exception>
 #include <fmt/ranges.h>
 #include <fstream>
 #include <rs/result.hpp>
+#include <spdlog/spdlog.h>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <toml.hpp>
 #include <toml11/types.hpp>
+#include <utility>
 #include <vector>
 
 namespace cabin {
@@ -26,19 +33,108 @@ const Subcmd REMOVE_CMD = //
                     .setVariadic(true))
         .setMainFn(removeMain);
 
+static std::vector<std::string> splitLines(const std::string& content) {
+  std::vector<std::string> lines;
+  std::string::size_type pos = 0;
+  while (pos < content.size()) {
+    const std::string::size_type nl = content.find('\n', pos);
+    if (nl == std::string::npos) {
+      lines.push_back(content.substr(pos));
+      break;
+    }
+    lines.push_back(content.substr(pos, nl - pos));
+    pos = nl + 1;
+  }
+  return lines;
+}
+
+// Splices the given 1-based manifest lines out and rewrites the file,
+// touching nothing else — comments, formatting, and unrelated sections
+// keep their exact bytes.  Returns false (writing nothing) unless the
+// result still parses and holds exactly the dependencies it should, in
+// which case the caller falls back to the DOM rewrite.
+static bool spliceOutLines(const fs::path& manifestPath,
+                           const std::string& content,
+                           const std::vector<std::size_t>& dropLines,
+                           const std::vector<std::string_view>& removedDeps,
+                           const toml::value& depsBefore) {
+  const std::vector<std::string> lines = splitLines(content);
+  std::vector<bool> drop(lines.size(), false);
+  for (const std::size_t lineNo : dropLines) {
+    if (lineNo == 0 || lineNo > lines.size()) {
+      return false;
+    }
+    drop[lineNo - 1] = true;
+  }
+
+  std::string edited;
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    if (!drop[i]) {
+      edited += lines[i];
+      edited += '\n';
+    }
+  }
+
+  try {
+    const toml::value reparsed = toml::parse_str(edited);
+    const toml::value* after = reparsed.contains("dependencies")
+                                   ? &reparsed.at("dependencies")
+                                   : nullptr;
+    for (const auto& entry : depsBefore.as_table()) {
+      const std::string& name = entry.first;
+      const bool shouldStay =
+          std::ranges::find(removedDeps, name) == removedDeps.end();
+      const bool stays = after != nullptr && after->contains(name);
+      if (stays != shouldStay) {
+        return false;
+      }
+    }
+    // No stray keys may have drifted into the table either.
+    const std::size_t expectedSize =
+        depsBefore.as_table().size()
+        - static_cast<std::size_t>(std::ranges::count_if(
+            depsBefore.as_table(), [&](const auto& entry) {
+              return std::ranges::find(removedDeps, entry.first)
+                     != removedDeps.end();
+            }));
+    if (after != nullptr && after->as_table().size() != expectedSize) {
+      return false;
+    }
+  } catch (const std::exception& e) {
+    spdlog::debug("manifest splice failed to reparse: {}", e.what());
+    return false;
+  }
+
+  std::ofstream ofs(manifestPath);
+  ofs << edited;
+  return true;
+}
+
 static rs::Result<void> removeMain(const CliArgsView args) {
   rs_ensure(!args.empty(), "`cabin remove` requires at least one argument");
 
   std::vector<std::string_view> removedDeps = {};
   const fs::path manifestPath = rs_try(Manifest::findPath());
-  auto data = toml::parse<toml::ordered_type_config>(manifestPath);
-  auto& deps = data["dependencies"];
-
-  rs_ensure(!deps.is_empty(), "No dependencies to remove");
+  const toml::value data = toml::parse(manifestPath);
+  rs_ensure(data.contains("dependencies")
+                && !data.at("dependencies").as_table().empty(),
+            "No dependencies to remove");
+  const toml::value& deps = data.at("dependencies");
 
+  // One-line entries (the format `cabin add` writes) are removed by
+  // splicing exactly those lines; anything fancier — multi-line tables,
+  // `[dependencies.<name>]` headers — forces the whole-DOM rewrite.
+  std::vector<std::size_t> dropLines;
+  bool spliceable = true;
   for (const std::string& dep : args) {
     if (deps.contains(dep)) {
-      deps.as_table().erase(dep);
+      const toml::source_location loc = deps.at(dep).location();
+      if (loc.is_ok() && loc.first_line_number() == loc.last_line_number()
+          && loc.first_line_number() > 0) {
+        dropLines.push_back(loc.first_line_number());
+      } else {
+        spliceable = false;
+      }
       removedDeps.push_back(dep);
     } else {
       // manifestPath needs to be converted to string
@@ -47,12 +143,38 @@ static rs::Result<void> removeMain(const CliArgsView args) {
     }
   }
 
-  if (!removedDeps.empty()) {
+  if (removedDeps.empty()) {
+    return rs::Ok();
+  }
+
+  bool wrote = false;
+  if (spliceable) {
+    std::ifstream ifs(manifestPath);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    wrote =
+        spliceOutLines(manifestPath, oss.str(), dropLines, removedDeps, deps);
+  }
+  if (!wrote) {
+    // Keep the order of the tables.
+    auto ordered = toml::parse<toml::ordered_type_config>(manifestPath);
+    for (const std::string_view dep : removedDeps) {
+      ordered["dependencies"].as_table().erase(std::string(dep));
+    }
     std::ofstream out(manifestPath);
-    out << data;
-    Diag::info("Removed", "{} from {}", fmt::join(removedDeps, ", "),
-               manifestPath.string());
+    out << ordered;
   }
+
+  // Re-parse immediately so the manifest snapshot is re-keyed to the
+  // edited file and the next build skips the cold DOM parse.
+  if (const auto warmed = Manifest::tryParse(manifestPath);
+      warmed.is_err()) {
+    spdlog::debug("manifest snapshot not refreshed: {}",
+                  warmed.unwrap_err()->what());
+  }
+
+  Diag::info("Removed", "{} from {}", fmt::join(removedDeps, ", "),
+             manifestPath.string());
   return rs::Ok();
 }
 
@@ -3,6 +3,7 @@
 #include "Algos.hpp"
 #include "Builder/BuildProfile.hpp"
 #include "Builder/Builder.hpp"
+#include "Builder/FreshToken.hpp"
 #include "Cli.hpp"
 #include "Command.hpp"
 #include "Common.hpp"
@@ -14,6 +15,8 @@
 #include <cstdint>
 #include <cstdlib>
 #include <filesystem>
+#include <fmt/format.h>
+#include <optional>
 #include <rs/result.hpp>
 #include <string>
 #include <string_view>
@@ -72,23 +75,47 @@ static rs::Result<void> runMain(const CliArgsView args) {
     runArgs.emplace_back(*itr);
   }
 
-  const auto manifest = rs_try(Manifest::tryParse());
-  Builder builder(manifest.path.parent_path(), buildProfile);
-  rs_try(builder.schedule());
-  rs_try(builder.build());
+  const fs::path manifestPath = rs_try(Manifest::findPath());
+  const fs::path manifestDir = manifestPath.parent_path();
+
+  const auto execBinary = [&](const fs::path& binPath) -> rs::Result<void> {
+    Diag::info("Running", "`{}`",
+               fs::relative(binPath, manifestDir).string());
+    const Command command(binPath.string(), runArgs);
+    const ExitStatus exitStatus = rs_try(execCmd(command));
+    if (exitStatus.success()) {
+      return rs::Ok();
+    } else {
+      rs_bail("run {}", exitStatus);
+    }
+  };
 
-  Diag::info(
-      "Running", "`{}/{}`",
-      fs::relative(builder.outDirPath(), manifest.path.parent_path()).string(),
-      manifest.package.name);
-  const Command command((builder.outDirPath() / manifest.package.name).string(),
-                        runArgs);
-  const ExitStatus exitStatus = rs_try(execCmd(command));
-  if (exitStatus.success()) {
-    return rs::Ok();
-  } else {
-    rs_bail("run {}", exitStatus);
+  // No-op fast path: a valid fresh token memoizing the binary name proves
+  // the last plan's inputs are unchanged and the binary is already
+  // linked, so hand off to the user program without parsing the manifest
+  // or constructing a Builder — one token read, one journal replay, one
+  // binary stat.
+  const fs::path outBase =
+      manifestDir / "cabin-out" / fmt::format("{}", buildProfile);
+  if (const std::optional<fs::path> binPath =
+          FreshToken::freshBinary(manifestPath, outBase)) {
+    return execBinary(*binPath);
   }
+
+  const auto manifest = rs_try(Manifest::tryParse(manifestPath));
+  Builder builder(manifestDir, buildProfile);
+  rs_try(builder.schedule());
+  // Only the binary's dependency closure: the link edge pulls in exactly
+  // the objects it needs, so unrelated targets never gate the exec.
+  FreshToken::invalidate(builder.outDirPath());
+  rs_try(builder.buildBinary());
+  // Binary scope: this run did not build the library or test targets, so
+  // the token must not certify a full `cabin build`.
+  FreshToken::write(manifest.path, builder.outDirPath(),
+                    builder.graph().cxxPath(), FreshToken::Scope::Binary,
+                    manifest.package.name);
+
+  return execBinary(builder.outDirPath() / manifest.package.name);
 }
 
 } // namespace cabin
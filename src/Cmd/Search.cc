@@ -2,16 +2,17 @@
 
 #include "Cli.hpp"
 #include "Diag.hpp"
+#include "RegistryIndex.hpp"
 
+#include <algorithm>
 #include <cstddef>
-#include <cstdlib>
-#include <curl/curl.h>
 #include <iomanip>
 #include <iostream>
-#include <nlohmann/json.hpp>
 #include <rs/result.hpp>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace cabin {
 
@@ -37,45 +38,7 @@ struct SearchArgs {
   std::size_t page = 1;
 };
 
-static std::size_t writeCallback(void* contents, std::size_t size,
-                                 std::size_t nmemb, std::string* userp) {
-  userp->append(static_cast<char*>(contents), size * nmemb);
-  return size * nmemb;
-}
-
-static nlohmann::json searchPackages(const SearchArgs& args) {
-  nlohmann::json req;
-  req["query"] =
-#include "GraphQL/SearchPackages.gql"
-      ;
-  req["variables"]["name"] = "%" + args.name + "%";
-  req["variables"]["limit"] = args.perPage;
-  req["variables"]["offset"] = (args.page - 1) * args.perPage;
-
-  const std::string reqStr = req.dump();
-  std::string resStr;
-
-  CURL* curl = curl_easy_init();
-  if (!curl) {
-    Diag::error("curl_easy_init() failed");
-    return EXIT_FAILURE;
-  }
-
-  curl_easy_setopt(curl, CURLOPT_URL, "https://cabin.hasura.app/v1/graphql");
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resStr);
-  curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, reqStr.c_str());
-  curl_easy_perform(curl); // TODO: Handle CURLCode
-
-  curl_easy_cleanup(curl);
-
-  const nlohmann::json res = nlohmann::json::parse(resStr);
-  const nlohmann::json packages = res["data"]["packages"];
-  return packages;
-}
-
-static void printTable(const nlohmann::json& packages) {
+static void printTable(const std::span<const IndexEntry* const> packages) {
   constexpr int tableWidth = 80;
   constexpr int nameWidth = 30;
   constexpr int verWidth = 10;
@@ -83,13 +46,14 @@ static void printTable(const nlohmann::json& packages) {
   std::cout << std::left << std::setw(nameWidth) << "Name"
             << std::setw(verWidth) << "Version" << "Description" << '\n';
   std::cout << std::string(tableWidth, '-') << '\n';
-  for (const auto& package : packages) {
-    const std::string name = package["name"];
-    const std::string version = package["version"];
-    const std::string description = package["description"];
-
-    std::cout << std::left << std::setw(nameWidth) << name
-              << std::setw(verWidth) << version << description << '\n';
+  for (const IndexEntry* package : packages) {
+    const std::string_view version =
+        package->versions.empty() ? std::string_view()
+                                  : package->versions.back();
+
+    std::cout << std::left << std::setw(nameWidth) << package->name
+              << std::setw(verWidth) << version << package->description
+              << '\n';
   }
 }
 
@@ -118,13 +82,20 @@ static rs::Result<void> searchMain(const CliArgsView args) {
   }
   rs_ensure(!searchArgs.name.empty(), "missing package name");
 
-  const nlohmann::json packages = searchPackages(searchArgs);
-  if (packages.empty()) {
+  // Search runs against the local index; the network is only touched
+  // when the index needs a refresh.
+  const RegistryIndex index = rs_try(RegistryIndex::load());
+  const std::vector<const IndexEntry*> matches = index.search(searchArgs.name);
+
+  const std::size_t begin = (searchArgs.page - 1) * searchArgs.perPage;
+  if (begin >= matches.size()) {
     Diag::warn("no packages found");
     return rs::Ok();
   }
+  const std::size_t count =
+      std::min(searchArgs.perPage, matches.size() - begin);
 
-  printTable(packages);
+  printTable(std::span(matches).subspan(begin, count));
   return rs::Ok();
 }
 
@@ -10,7 +10,9 @@
 #include "Parallelism.hpp"
 
 #include <charconv>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <rs/result.hpp>
 #include <string>
 #include <string_view>
@@ -26,14 +28,28 @@ const Subcmd TEST_CMD = //
         .setShort("t")
         .setDesc("Run the tests of a local package")
         .addOpt(OPT_JOBS)
+        .addOpt(OPT_MESSAGE_FORMAT)
         .addOpt(Opt{ "--coverage" }.setDesc("Enable code coverage analysis"))
+        .addOpt(Opt{ "--no-cache" }.setDesc(
+            "Run every test even if its binary passed unchanged"))
+        .addOpt(Opt{ "--shard" }
+                    .setDesc("Build and run only shard K of N (e.g. 2/4)")
+                    .setPlaceholder("<K/N>"))
+        .addOpt(Opt{ "--all" }.setDesc(
+            "Build every test binary, not just the affected ones"))
+        .addOpt(Opt{ "--combined" }.setDesc(
+            "Link all unit tests into one forking runner binary"))
         .setArg(
             Arg{ "TESTNAME" }.setRequired(false).setDesc("Test name to launch"))
         .setMainFn(testMain);
 
 static rs::Result<void> testMain(const CliArgsView args) {
   bool enableCoverage = false;
+  bool noCache = false;
+  bool buildAll = false;
+  bool combined = false;
   std::optional<std::string> testName;
+  std::optional<Builder::TestShard> shard;
 
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
@@ -56,8 +72,35 @@ static rs::Result<void> testMain(const CliArgsView args) {
           std::from_chars(nextArg.begin(), nextArg.end(), numThreads);
       rs_ensure(ec == std::errc(), "invalid number of threads: {}", nextArg);
       setParallelism(numThreads);
+    } else if (arg == "--message-format"
+               || arg.starts_with("--message-format=")) {
+      rs_try(parseMessageFormat(arg, itr, args.end()));
     } else if (arg == "--coverage") {
       enableCoverage = true;
+    } else if (arg == "--no-cache") {
+      noCache = true;
+    } else if (arg == "--all") {
+      buildAll = true;
+    } else if (arg == "--combined") {
+      combined = true;
+    } else if (arg == "--shard") {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      const std::string_view value = *++itr;
+      const std::size_t slash = value.find('/');
+      rs_ensure(slash != std::string_view::npos,
+                "invalid shard `{}`; expected K/N", value);
+      const std::string_view kStr = value.substr(0, slash);
+      const std::string_view nStr = value.substr(slash + 1);
+      std::size_t index{};
+      std::size_t count{};
+      const auto [kPtr, kEc] = std::from_chars(kStr.begin(), kStr.end(), index);
+      const auto [nPtr, nEc] = std::from_chars(nStr.begin(), nStr.end(), count);
+      rs_ensure(kEc == std::errc() && nEc == std::errc() && count > 0
+                    && index > 0 && index <= count,
+                "invalid shard `{}`; expected K/N with 1 <= K <= N", value);
+      shard = Builder::TestShard{ .index = index, .count = count };
     } else if (!testName) {
       testName = arg;
     } else {
@@ -68,8 +111,9 @@ static rs::Result<void> testMain(const CliArgsView args) {
   const Manifest manifest = rs_try(Manifest::tryParse());
   Builder builder(manifest.path.parent_path(), BuildProfile::Test);
   rs_try(builder.schedule(ScheduleOptions{ .includeDevDeps = true,
-                                           .enableCoverage = enableCoverage }));
-  return builder.test(std::move(testName));
+                                           .enableCoverage = enableCoverage,
+                                           .combinedTests = combined }));
+  return builder.test(std::move(testName), noCache, shard, buildAll);
 }
 
 } // namespace cabin
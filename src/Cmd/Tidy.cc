@@ -3,6 +3,7 @@
 #include "Algos.hpp"
 #include "Builder/BuildProfile.hpp"
 #include "Builder/Builder.hpp"
+#include "Builder/ScanCache.hpp"
 #include "Cli.hpp"
 #include "Command.hpp"
 #include "Common.hpp"
@@ -13,13 +14,24 @@
 #include <array>
 #include <charconv>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
 #include <rs/result.hpp>
+#include <spdlog/spdlog.h>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <unordered_set>
+#include <vector>
 
 namespace cabin {
 
@@ -29,29 +41,62 @@ static rs::Result<void> tidyMain(CliArgsView args);
 
 const Subcmd TIDY_CMD =
     Subcmd{ "tidy" }
-        .setDesc("Execute run-clang-tidy")
+        .setDesc("Execute clang-tidy over the compilation database")
         .addOpt(Opt{ "--fix" }.setDesc("Automatically apply lint suggestions"))
+        .addOpt(Opt{ "--no-cache" }.setDesc(
+            "Check every file even if it was clean last run"))
         .addOpt(OPT_JOBS)
         .setMainFn(tidyMain);
 
-static rs::Result<void> tidyImpl(const Command& makeCmd) {
-  const auto start = std::chrono::steady_clock::now();
+namespace {
 
-  const ExitStatus exitStatus = rs_try(execCmd(makeCmd));
+struct TidyJob {
+  std::string file;
+  std::string commandDigest;
+  std::string cacheKey;
+};
 
-  const auto end = std::chrono::steady_clock::now();
-  const std::chrono::duration<double> elapsed = end - start;
+struct TidyResult {
+  bool spawned = false;
+  // Teed output already reached the terminal; the report loop must not
+  // print it again.
+  bool teed = false;
+  ExitStatus exitStatus;
+  std::string stdOut;
+  std::string stdErr;
+};
 
-  if (exitStatus.success()) {
-    Diag::info("Finished", "run-clang-tidy in {:.2f}s", elapsed.count());
-    return rs::Ok();
+} // namespace
+
+static Command makeTidyCommand(const std::string& clangTidy,
+                               const std::string& compdbDir,
+                               const fs::path& configPath, const bool fix) {
+  Command cmd("");
+  if (commandExists("xcrun")) {
+    cmd = Command("xcrun");
+    cmd.addArg(clangTidy);
+  } else {
+    cmd = Command(clangTidy);
+  }
+  cmd.addArg("-p").addArg(compdbDir);
+  if (fs::exists(configPath)) {
+    cmd.addArg("-config-file=" + configPath.string());
+  }
+  if (!isVerbose()) {
+    cmd.addArg("-quiet");
+  }
+  if (fix) {
+    cmd.addArg("-fix");
   }
-  rs_bail("run-clang-tidy {}", exitStatus);
+  cmd.setStdOutConfig(Command::IOConfig::Piped);
+  cmd.setStdErrConfig(Command::IOConfig::Piped);
+  return cmd;
 }
 
 static rs::Result<void> tidyMain(const CliArgsView args) {
   // Parse args
   bool fix = false;
+  bool noCache = false;
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
     const std::string_view arg = *itr;
 
@@ -62,6 +107,8 @@ static rs::Result<void> tidyMain(const CliArgsView args) {
       continue;
     } else if (arg == "--fix") {
       fix = true;
+    } else if (arg == "--no-cache") {
+      noCache = true;
     } else if (matchesAny(arg, { "-j", "--jobs" })) {
       if (itr + 1 == args.end()) {
         return Subcmd::missingOptArgumentFor(arg);
@@ -105,37 +152,163 @@ static rs::Result<void> tidyMain(const CliArgsView args) {
     isFirstProfile = false;
   }
 
-  std::string runClangTidy = "run-clang-tidy";
+  std::string clangTidy = "clang-tidy";
   if (const char* tidyEnv = std::getenv("CABIN_TIDY")) {
-    runClangTidy = tidyEnv;
+    clangTidy = tidyEnv;
   }
-  rs_ensure(commandExists(runClangTidy), "run-clang-tidy is required");
+  rs_ensure(commandExists(clangTidy), "clang-tidy is required");
 
-  Command runCmd("");
-  if (commandExists("xcrun")) {
-    runCmd = Command("xcrun");
-    runCmd.addArg(runClangTidy);
-  } else {
-    runCmd = Command(runClangTidy);
+  const fs::path compdbPath = fs::path(compdbDir) / "compile_commands.json";
+  nlohmann::json compdb;
+  try {
+    std::ifstream ifs(compdbPath);
+    compdb = nlohmann::json::parse(ifs);
+  } catch (const std::exception& e) {
+    rs_bail("failed to read {}: {}", compdbPath.string(), e.what());
   }
-  runCmd.addArg("-p").addArg(compdbDir);
+  rs_ensure(compdb.is_array(), "malformed compilation database: {}",
+            compdbPath.string());
+
+  // A file's verdict holds as long as its content, its compile command,
+  // and the .clang-tidy config are all unchanged.
   const fs::path configPath = projectRoot / ".clang-tidy";
-  if (fs::exists(configPath)) {
-    runCmd.addArg("-config-file=" + configPath.string());
+  const std::string configDigest =
+      fs::exists(configPath) ? digestFile(configPath) : std::string();
+
+  const fs::path cachePath = fs::path(compdbDir) / "tidy-cache.json";
+  nlohmann::json cleanVerdicts = nlohmann::json::object();
+  if (fs::exists(cachePath)) {
+    try {
+      std::ifstream ifs(cachePath);
+      const nlohmann::json loaded = nlohmann::json::parse(ifs);
+      if (loaded.is_object() && loaded.contains("clean")) {
+        cleanVerdicts = loaded["clean"];
+      }
+    } catch (const nlohmann::json::parse_error& e) {
+      spdlog::debug("discarding tidy cache: {}", e.what());
+    }
   }
-  if (!isVerbose()) {
-    runCmd.addArg("-quiet");
+
+  std::size_t numCached = 0;
+  std::vector<TidyJob> jobs;
+  std::unordered_set<std::string> seenFiles;
+  for (const auto& entry : compdb) {
+    if (!entry.contains("file")) {
+      continue;
+    }
+    const std::string file = entry["file"];
+    if (!seenFiles.insert(file).second) {
+      continue;
+    }
+    std::error_code ec;
+    if (!fs::exists(file, ec)) {
+      continue;
+    }
+    const std::string commandLine =
+        entry.contains("command") ? std::string(entry["command"]) : "";
+    const std::string commandDigest = digestString(commandLine);
+    const std::string cacheKey = digestString(fmt::format(
+        "{}\x1f{}\x1f{}", digestFile(file), commandDigest, configDigest));
+    if (!noCache && cleanVerdicts.contains(file)
+        && cleanVerdicts[file] == cacheKey) {
+      ++numCached;
+      continue;
+    }
+    jobs.push_back(TidyJob{ .file = file,
+                            .commandDigest = commandDigest,
+                            .cacheKey = cacheKey });
   }
-  if (fix) {
-    runCmd.addArg("-fix");
+
+  Diag::info("Running", "clang-tidy on {} file(s) ({} cached)", jobs.size(),
+             numCached);
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<TidyResult> results(jobs.size());
+  tbb::concurrent_vector<std::string> errors;
+  const auto runOne = [&](const std::size_t idx, const bool tee) {
+    Command cmd = makeTidyCommand(clangTidy, compdbDir, configPath, fix);
+    cmd.addArg(jobs[idx].file);
+    auto output = [&]() -> rs::Result<CommandOutput> {
+      if (!tee) {
+        return cmd.output();
+      }
+      // Serial runs stream diagnostics to the terminal as they appear
+      // instead of holding every file's flood until the report loop; the
+      // retained tail still answers the emptiness check below.
+      cmd.setStdOutConfig(Command::IOConfig::Tee);
+      // stderr is only surfaced under -v, matching the buffered path.
+      cmd.setStdErrConfig(isVerbose() ? Command::IOConfig::Tee
+                                      : Command::IOConfig::Piped);
+      return rs_try(cmd.spawn()).waitWithOutput();
+    }();
+    if (output.is_err()) {
+      errors.push_back(output.unwrap_err()->what());
+      return;
+    }
+    CommandOutput out = output.unwrap();
+    results[idx] = TidyResult{ .spawned = true,
+                               .teed = tee,
+                               .exitStatus = out.exitStatus,
+                               .stdOut = out.stdOut,
+                               .stdErr = out.stdErr };
+  };
+
+  if (isParallel() && jobs.size() > 1) {
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, jobs.size()),
+                      [&](const tbb::blocked_range<std::size_t>& rng) {
+                        for (std::size_t i = rng.begin(); i != rng.end();
+                             ++i) {
+                          runOne(i, /*tee=*/false);
+                        }
+                      });
+  } else {
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+      runOne(i, /*tee=*/true);
+    }
   }
-  const std::size_t jobs = getParallelism();
-  if (jobs > 0) {
-    runCmd.addArg("-j").addArg(std::to_string(jobs));
+  rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+
+  // Report in database order so the output is deterministic.  A file is
+  // clean only if clang-tidy exited successfully and emitted nothing.
+  std::size_t numDirty = 0;
+  for (std::size_t i = 0; i < jobs.size(); ++i) {
+    const TidyResult& result = results[i];
+    if (!result.teed && !result.stdOut.empty()) {
+      fmt::print("{}", result.stdOut);
+    }
+    if (!result.teed && isVerbose() && !result.stdErr.empty()) {
+      fmt::print(stderr, "{}", result.stdErr);
+    }
+    if (result.spawned && result.exitStatus.success()
+        && result.stdOut.empty()) {
+      // With --fix the file may have just been rewritten; re-key it so
+      // the fixed content is what future runs match against.
+      cleanVerdicts[jobs[i].file] =
+          fix ? digestString(fmt::format("{}\x1f{}\x1f{}",
+                                         digestFile(jobs[i].file),
+                                         jobs[i].commandDigest, configDigest))
+              : jobs[i].cacheKey;
+    } else {
+      cleanVerdicts.erase(jobs[i].file);
+      ++numDirty;
+    }
+  }
+
+  {
+    nlohmann::json json;
+    json["version"] = 1;
+    json["clean"] = std::move(cleanVerdicts);
+    std::ofstream ofs(cachePath);
+    ofs << json.dump();
   }
 
-  Diag::info("Running", "run-clang-tidy");
-  return tidyImpl(runCmd);
+  const auto end = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = end - start;
+  rs_ensure(numDirty == 0, "clang-tidy reported issues in {} file(s)",
+            numDirty);
+  Diag::info("Finished", "clang-tidy on {} file(s) ({} cached) in {:.2f}s",
+             jobs.size(), numCached, elapsed.count());
+  return rs::Ok();
 }
 
 } // namespace cabin
@@ -129,6 +129,10 @@ static constinit const char COMPILE_DATE[] = {
   '\0'
 };
 
+void printVersionLine() noexcept {
+  fmt::print("cabin {}{}\n", CABIN_CABIN_PKG_VERSION, commitInfo());
+}
+
 rs::Result<void> versionMain(const CliArgsView args) noexcept {
   // Parse args
   for (auto itr = args.begin(); itr != args.end(); ++itr) {
@@ -145,8 +149,10 @@ rs::Result<void> versionMain(const CliArgsView args) noexcept {
     return VERSION_CMD.noSuchArg(arg);
   }
 
-  fmt::print("cabin {}{}\n", CABIN_CABIN_PKG_VERSION, commitInfo());
+  printVersionLine();
   if (isVerbose()) {
+    // The library-version queries live here, not above: a plain version
+    // query must not touch libgit2 or libcurl at all.
     fmt::print("release: {}\n"
                "commit-hash: {}\n"
                "commit-date: {}\n"
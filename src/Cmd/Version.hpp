@@ -6,4 +6,10 @@ namespace cabin {
 
 extern const Subcmd VERSION_CMD;
 
+/// Prints the one-line version banner that a bare `cabin version` /
+/// `-V` / `--version` emits.  All the information is baked in at build
+/// time, so callers can answer a version query without constructing the
+/// CLI or touching any library.
+void printVersionLine() noexcept;
+
 } // namespace cabin
@@ -0,0 +1,135 @@
+#include "Watch.hpp"
+
+#include "Algos.hpp"
+#include "Builder/BuildProfile.hpp"
+#include "Builder/Builder.hpp"
+#include "Cli.hpp"
+#include "Common.hpp"
+#include "Diag.hpp"
+#include "FileWatcher.hpp"
+#include "Manifest.hpp"
+#include "Parallelism.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <rs/result.hpp>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+static rs::Result<void> watchMain(CliArgsView args);
+
+const Subcmd WATCH_CMD =
+    Subcmd{ "watch" }
+        .setDesc("Rerun build, fmt, or lint on every source change")
+        .addOpt(OPT_RELEASE)
+        .addOpt(OPT_JOBS)
+        .setArg(Arg{ "COMMAND" }
+                    .setDesc("Command to rerun (build, fmt, or lint); "
+                             "trailing arguments are passed through")
+                    .setVariadic(true)
+                    .setRequired(false))
+        .setMainFn(watchMain);
+
+static rs::Result<void> watchMain(const CliArgsView args) {
+  // Parse args
+  BuildProfile buildProfile = BuildProfile::Dev;
+  std::string command = "build";
+  std::vector<std::string> commandArgs;
+  for (auto itr = args.begin(); itr != args.end(); ++itr) {
+    const std::string_view arg = *itr;
+
+    const auto control =
+        rs_try(Cli::handleGlobalOpts(itr, args.end(), "watch"));
+    if (control == Cli::Return) {
+      return rs::Ok();
+    } else if (control == Cli::Continue) {
+      continue;
+    } else if (matchesAny(arg, { "-r", "--release" })) {
+      buildProfile = BuildProfile::Release;
+    } else if (matchesAny(arg, { "-j", "--jobs" })) {
+      if (itr + 1 == args.end()) {
+        return Subcmd::missingOptArgumentFor(arg);
+      }
+      const std::string_view nextArg = *++itr;
+
+      uint64_t numThreads{};
+      auto [ptr, ec] =
+          std::from_chars(nextArg.begin(), nextArg.end(), numThreads);
+      rs_ensure(ec == std::errc(), "invalid number of threads: {}", nextArg);
+      setParallelism(numThreads);
+    } else if (!arg.starts_with('-')) {
+      command = arg;
+      // Everything after the command belongs to it.
+      commandArgs.assign(itr + 1, args.end());
+      break;
+    } else {
+      return WATCH_CMD.noSuchArg(arg);
+    }
+  }
+  rs_ensure(matchesAny(command, { "build", "fmt", "lint" }),
+            "cannot watch `{}`; supported commands are build, fmt, and lint",
+            command);
+
+  const Manifest manifest = rs_try(Manifest::tryParse());
+  const fs::path rootPath = manifest.path.parent_path();
+
+  // One watcher covers the same roots isUpToDate scans, so every rerun
+  // starts from a kernel-reported change set instead of re-walking the
+  // tree to discover whether anything happened.
+  FileWatcher watcher = rs_try(FileWatcher::create({
+      rootPath / "src",
+      rootPath / "lib",
+      rootPath / "include",
+      rootPath / "tests",
+      manifest.path,
+  }));
+
+  // For build, the parsed manifest, resolved dependencies, and probed
+  // compiler stay resident across iterations; each change only replans
+  // (scan-cache-backed) and rebuilds, so iterations skip the fixed
+  // startup cost a fresh `cabin build` pays.  fmt and lint reuse their
+  // own digest caches, so their reruns only touch changed files.
+  std::optional<Builder> builder;
+  if (command == "build") {
+    builder.emplace(rootPath, buildProfile);
+    rs_try(builder->schedule());
+  }
+
+  const auto runOnce = [&]() {
+    rs::Result<void> result = rs::Ok();
+    if (builder.has_value()) {
+      result = builder->build();
+    } else {
+      result = getCli().exec(command, commandArgs);
+    }
+    if (result.is_err()) {
+      Diag::error("{}", result.unwrap_err()->what());
+    }
+  };
+  runOnce();
+
+  constexpr std::chrono::milliseconds debounce(100);
+  Diag::info("Watching", "for changes... (Ctrl-C to stop)");
+  while (true) {
+    rs_try(watcher.waitForChange(debounce));
+    if (builder.has_value()) {
+      rs_try(builder->replan());
+    }
+    runOnce();
+    // Changes made by the run itself (fmt -i rewrites, regenerated
+    // files) are already accounted for; do not report them again.
+    watcher.drainPendingEvents();
+    Diag::info("Watching", "for changes...");
+  }
+}
+
+} // namespace cabin
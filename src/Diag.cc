@@ -0,0 +1,222 @@
+#include "Diag.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <tbb/concurrent_queue.h>
+#include <tbb/spin_mutex.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace cabin {
+
+namespace {
+
+struct Msg {
+  std::string text;
+  std::atomic<bool>* flushed = nullptr; // flush marker when set
+  bool status = false;                  // text replaces the status line
+  bool stop = false;                    // writer-shutdown sentinel
+};
+
+// Set after the writer joins during static destruction; late
+// diagnostics fall back to direct writes.
+std::atomic<bool> writerStopped{ false };
+
+// Lines produced while a TaskGroup is active on this thread.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+thread_local std::string* tlGroup = nullptr;
+
+class Writer {
+public:
+  static Writer& instance() {
+    static Writer writer;
+    return writer;
+  }
+
+  void push(Msg msg) { queue.push(std::move(msg)); }
+
+  ~Writer() {
+    queue.push(Msg{ .stop = true });
+    thread.join();
+    writerStopped.store(true, std::memory_order_release);
+  }
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+  Writer(Writer&&) = delete;
+  Writer& operator=(Writer&&) = delete;
+
+private:
+  Writer() : thread([this]() { run(); }) {}
+
+  std::string status;      // current status line, empty when cleared
+  bool statusShown = false; // a status line is on the terminal
+  bool statusDirty = false;
+
+  // Clears the shown status line, prints the batched regular lines
+  // above it, and redraws the status — all in one stderr write.
+  void emit(std::string& buffer) {
+    if (buffer.empty() && !statusDirty) {
+      return;
+    }
+    std::string out;
+    if (statusShown) {
+      out += "\r\x1b[K"; // return to column 0 and clear the line
+    }
+    out += buffer;
+    buffer.clear();
+    out += status;
+    statusShown = !status.empty();
+    statusDirty = false;
+    if (!out.empty()) {
+      std::fwrite(out.data(), 1, out.size(), stderr);
+    }
+  }
+
+  void run() {
+    constexpr std::size_t maxBatch = 64UL * 1024;
+    std::string buffer;
+    for (;;) {
+      Msg msg;
+      queue.pop(msg); // blocks until a message arrives
+      for (;;) {
+        if (msg.stop) {
+          status.clear();
+          statusDirty = true;
+          emit(buffer);
+          std::fflush(stderr);
+          return;
+        }
+        if (msg.flushed != nullptr) {
+          // Hand the terminal over with no status line pending; it is
+          // redrawn by the next regular update.
+          const std::string savedStatus = std::exchange(status, {});
+          statusDirty = true;
+          emit(buffer);
+          std::fflush(stderr);
+          status = savedStatus;
+          msg.flushed->store(true, std::memory_order_release);
+          msg.flushed->notify_one();
+        } else if (msg.status) {
+          status = std::move(msg.text);
+          statusDirty = true;
+        } else {
+          buffer += msg.text;
+        }
+        // Batch whatever is already queued into one write before
+        // touching stderr again.
+        if (buffer.size() >= maxBatch || !queue.try_pop(msg)) {
+          break;
+        }
+      }
+      emit(buffer);
+    }
+  }
+
+  tbb::concurrent_bounded_queue<Msg> queue;
+  std::thread thread;
+};
+
+} // namespace
+
+void DiagSink::writeLine(std::string line) noexcept {
+  try {
+    if (tlGroup != nullptr) {
+      *tlGroup += line;
+      return;
+    }
+    if (writerStopped.load(std::memory_order_acquire)) {
+      std::fwrite(line.data(), 1, line.size(), stderr);
+      return;
+    }
+    Writer::instance().push(Msg{ .text = std::move(line) });
+  } catch (...) {
+    std::fwrite(line.data(), 1, line.size(), stderr);
+  }
+}
+
+void DiagSink::flush() noexcept {
+  try {
+    if (writerStopped.load(std::memory_order_acquire)) {
+      std::fflush(stderr);
+      return;
+    }
+    std::atomic<bool> flushed{ false };
+    Writer::instance().push(Msg{ .flushed = &flushed });
+    flushed.wait(false, std::memory_order_acquire);
+  } catch (...) {
+    std::fflush(stderr);
+  }
+}
+
+DiagSink::TaskGroup::TaskGroup() noexcept
+    : previous_(std::exchange(tlGroup, &buffer_)) {}
+
+DiagSink::TaskGroup::~TaskGroup() noexcept {
+  tlGroup = previous_;
+  if (!buffer_.empty()) {
+    writeLine(std::move(buffer_));
+  }
+}
+
+void DiagSink::setStatus(std::string line) noexcept {
+  try {
+    if (writerStopped.load(std::memory_order_acquire)) {
+      return;
+    }
+    Writer::instance().push(Msg{ .text = std::move(line), .status = true });
+  } catch (...) {
+    // Progress is cosmetic; losing an update is fine.
+  }
+}
+
+Progress::Progress(const std::size_t total) noexcept
+    : total_(total),
+      active_(total > 0 && isatty(fileno(stderr)) != 0 && !isVerbose()
+              && !isQuiet()),
+      start_(std::chrono::steady_clock::now()) {}
+
+Progress::~Progress() noexcept {
+  if (active_) {
+    DiagSink::setStatus("");
+  }
+}
+
+void Progress::completed(const std::string_view target) noexcept {
+  if (!active_) {
+    return;
+  }
+  const std::size_t done =
+      done_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  const auto now = std::chrono::steady_clock::now();
+  {
+    constexpr std::chrono::milliseconds redrawInterval(100);
+    const tbb::spin_mutex::scoped_lock lock(drawMtx);
+    if (done != total_ && now - lastDraw_ < redrawInterval) {
+      return;
+    }
+    lastDraw_ = now;
+  }
+
+  const double elapsed =
+      std::chrono::duration_cast<std::chrono::duration<double>>(now - start_)
+          .count();
+  const double rate = elapsed > 0.0 ? static_cast<double>(done) / elapsed
+                                    : 0.0;
+  // Mirror Diag::info's right-aligned bold-green header.
+  constexpr int headerMaxLength = 12;
+  constexpr int headerEscapeSequenceOffset = 11;
+  DiagSink::setStatus(fmt::format(
+      "{:>{}} [{}/{}] {} ({:.0f}/s)", Bold(Green("Building")).toErrStr(),
+      shouldColorStderr() ? headerMaxLength + headerEscapeSequenceOffset
+                          : headerMaxLength,
+      done, total_, target, rate));
+}
+
+} // namespace cabin
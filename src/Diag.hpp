@@ -2,16 +2,61 @@
 
 #include "TermColor.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <cstdio>
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <functional>
+#include <iterator>
+#include <string>
 #include <string_view>
+#include <tbb/spin_mutex.h>
 #include <type_traits>
 #include <utility>
 
 namespace cabin {
 
+/// Asynchronous stderr sink behind Diag: callers enqueue fully formatted
+/// lines into a concurrent queue and one writer thread batches them to
+/// stderr, so worker threads in parallel phases (dependency install, the
+/// test runner) never block on terminal I/O and cannot interleave
+/// mid-line.  Queued output is flushed in order on process exit.
+class DiagSink {
+public:
+  /// Hands one formatted line (newline included) to the writer thread.
+  /// Inside a TaskGroup the line is buffered with the group instead.
+  static void writeLine(std::string line) noexcept;
+
+  /// Blocks until everything enqueued so far has reached stderr; call
+  /// before handing the terminal to a child process.
+  static void flush() noexcept;
+
+  /// Replaces the in-place status line at the bottom of the output (an
+  /// empty string clears it).  Regular lines are printed above it; the
+  /// writer thread redraws it after each batch.
+  static void setStatus(std::string line) noexcept;
+
+  /// Buffers the current thread's diagnostics and emits them as one
+  /// block when the guard leaves scope, so the output of parallel tasks
+  /// keeps each task's lines together (one dependency's `Downloaded`
+  /// lines, one test's failures).
+  class [[nodiscard]] TaskGroup {
+  public:
+    TaskGroup() noexcept;
+    ~TaskGroup() noexcept;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+  private:
+    std::string buffer_;
+    std::string* previous_ = nullptr;
+  };
+};
+
 enum class DiagLevel : uint8_t {
   Off = 0, // --quiet, -q
   Error = 1,
@@ -119,15 +164,57 @@ private:
   template <typename... Args>
   void log(DiagLevel level, HeadProcessor auto&& processHead, auto&& head,
            fmt::format_string<Args...> fmt, Args&&... args) noexcept {
-    if (level <= this->level) {
-      fmt::print(stderr, "{}{}\n",
-                 std::invoke(std::forward<decltype(processHead)>(processHead),
-                             std::forward<decltype(head)>(head)),
-                 fmt::format(fmt, std::forward<Args>(args)...));
+    if (level > this->level) {
+      // Suppressed severities return before any formatting happens, so
+      // high-frequency callers pay one predictable branch.
+      return;
     }
+    // One reusable per-thread buffer instead of the two temporary
+    // strings a nested fmt::format would allocate per line; the queue
+    // still needs an owning string, so exactly one allocation remains.
+    thread_local fmt::memory_buffer buffer;
+    buffer.clear();
+    fmt::format_to(std::back_inserter(buffer), "{}",
+                   std::invoke(std::forward<decltype(processHead)>(processHead),
+                               std::forward<decltype(head)>(head)));
+    fmt::format_to(std::back_inserter(buffer), fmt,
+                   std::forward<Args>(args)...);
+    buffer.push_back('\n');
+    DiagSink::writeLine(std::string(buffer.data(), buffer.size()));
   }
 };
 
+/// Cargo-style single-line progress renderer: one in-place updated
+/// stderr line with completed/total edge counts, the most recently
+/// finished target, and the edge rate, redrawn at most every 100 ms so
+/// hundreds of edges cost a handful of terminal writes instead of a
+/// scrolling line each.  Inactive — no output at all — when stderr is
+/// not a terminal, under --verbose (full command lines print instead),
+/// or under --quiet.
+class Progress {
+public:
+  explicit Progress(std::size_t total) noexcept;
+  ~Progress() noexcept; // clears the status line
+
+  Progress(const Progress&) = delete;
+  Progress& operator=(const Progress&) = delete;
+  Progress(Progress&&) = delete;
+  Progress& operator=(Progress&&) = delete;
+
+  /// Records one finished edge and redraws if the redraw window has
+  /// passed (always redraws the final edge).  Safe to call from
+  /// parallel workers.
+  void completed(std::string_view target) noexcept;
+
+private:
+  std::size_t total_ = 0;
+  bool active_ = false;
+  std::atomic<std::size_t> done_{ 0 };
+  std::chrono::steady_clock::time_point start_;
+  tbb::spin_mutex drawMtx;
+  std::chrono::steady_clock::time_point lastDraw_;
+};
+
 inline void setDiagLevel(DiagLevel level) noexcept { Diag::setLevel(level); }
 inline DiagLevel getDiagLevel() noexcept { return Diag::getLevel(); }
 
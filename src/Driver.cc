@@ -62,19 +62,23 @@ const Cli& getCli() noexcept {
                       .setGlobal(false)
                       .setHidden(true))
           .addSubcmd(ADD_CMD)
+          .addSubcmd(BENCH_CMD)
           .addSubcmd(BUILD_CMD)
           .addSubcmd(CLEAN_CMD)
+          .addSubcmd(COMPLETE_CMD)
           .addSubcmd(FMT_CMD)
           .addSubcmd(HELP_CMD)
           .addSubcmd(INIT_CMD)
           .addSubcmd(LINT_CMD)
+          .addSubcmd(METADATA_CMD)
           .addSubcmd(NEW_CMD)
           .addSubcmd(REMOVE_CMD)
           .addSubcmd(RUN_CMD)
           .addSubcmd(SEARCH_CMD)
           .addSubcmd(TEST_CMD)
           .addSubcmd(TIDY_CMD)
-          .addSubcmd(VERSION_CMD);
+          .addSubcmd(VERSION_CMD)
+          .addSubcmd(WATCH_CMD);
   return cli;
 }
 
@@ -90,13 +94,26 @@ static std::string colorizeAnyhowError(std::string s) {
 
 rs::Result<void, void> run(int argc,
                            char* argv[]) noexcept { // NOLINT(*-avoid-c-arrays)
-  // Set up logger
-  spdlog::cfg::load_env_levels(LOG_ENV);
+  // Set up logger.  load_env_levels walks the whole spdlog registry, so
+  // only pay for it when the user actually set the env var; trivial
+  // commands like `cabin --version` then skip logger setup entirely.
+  if (std::getenv(LOG_ENV_USED)) {
+    spdlog::cfg::load_env_levels(LOG_ENV);
+  }
   if (std::getenv(LOG_ENV_UNUSED)) {
     Diag::warn("{} is set but not used. Use {} instead.", LOG_ENV_UNUSED,
                LOG_ENV_USED);
   }
 
+  // Wrapper scripts tend to query the version once per invocation.
+  // Answer a bare version query right here, before the Cli object is
+  // assembled (every subcommand table entry is copied into it): the
+  // banner is baked in at build time, so nothing else needs to run.
+  if (argc == 2 && matchesAny(argv[1], { "version", "-V", "--version" })) {
+    printVersionLine();
+    return rs::Ok();
+  }
+
   return getCli()
       .parseArgs(argc, argv)
       .map_err([](const auto& e) { return colorizeAnyhowError(e->what()); })
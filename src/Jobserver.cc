@@ -0,0 +1,155 @@
+#include "Jobserver.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+// Extracts the value of `--jobserver-auth=` (or the older
+// `--jobserver-fds=`) from a $MAKEFLAGS string.
+static std::string_view findAuthValue(const std::string_view makeflags) {
+  for (const std::string_view key :
+       { "--jobserver-auth=", "--jobserver-fds=" }) {
+    const std::size_t pos = makeflags.find(key);
+    if (pos == std::string_view::npos) {
+      continue;
+    }
+    std::string_view value = makeflags.substr(pos + key.size());
+    if (const std::size_t end = value.find(' ');
+        end != std::string_view::npos) {
+      value = value.substr(0, end);
+    }
+    return value;
+  }
+  return {};
+}
+
+Jobserver::Jobserver() noexcept {
+  const char* makeflags = std::getenv("MAKEFLAGS");
+  if (makeflags == nullptr) {
+    return;
+  }
+  const std::string_view auth = findAuthValue(makeflags);
+  if (auth.empty()) {
+    return;
+  }
+
+  if (auth.starts_with("fifo:")) {
+    const std::string path(auth.substr(5));
+    // O_RDWR so the fifo never sees EOF while we hold it; O_NONBLOCK keeps
+    // token claims from stalling the build.
+    const int fd =
+        open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC); // NOLINT
+    if (fd >= 0) {
+      inheritedRead_ = fd;
+      inheritedWrite_ = fd;
+      spdlog::debug("inherited jobserver fifo {}", path);
+    }
+    return;
+  }
+
+  // Pipe style: "R,W" file descriptor numbers.
+  int readFd = -1;
+  int writeFd = -1;
+  if (std::sscanf(auth.data(), "%d,%d", &readFd, &writeFd) == 2 // NOLINT
+      && readFd >= 0 && writeFd >= 0
+      && fcntl(readFd, F_GETFD) != -1 && fcntl(writeFd, F_GETFD) != -1) {
+    inheritedRead_ = readFd;
+    inheritedWrite_ = writeFd;
+    spdlog::debug("inherited jobserver pipe {},{}", readFd, writeFd);
+  }
+}
+
+Jobserver::~Jobserver() noexcept {
+  if (!heldTokens_.empty() && inheritedWrite_ >= 0) {
+    // Tokens are arbitrary bytes and must be returned verbatim.
+    [[maybe_unused]] const ssize_t written =
+        write(inheritedWrite_, heldTokens_.data(), heldTokens_.size());
+  }
+  if (hostFd_ >= 0) {
+    close(hostFd_);
+    unlink(hostPath_.c_str());
+  }
+}
+
+Jobserver& Jobserver::instance() noexcept {
+  static Jobserver instance;
+  return instance;
+}
+
+std::size_t Jobserver::claimSlots(const std::size_t requested) noexcept {
+  if (inheritedRead_ < 0 || requested <= 1) {
+    return requested;
+  }
+
+  // Pipe-style fds from make are blocking and shared with sibling
+  // processes; flip O_NONBLOCK around the claim so an empty pipe means a
+  // smaller budget, not a stall.
+  const int flags = fcntl(inheritedRead_, F_GETFL);
+  if (flags != -1 && (flags & O_NONBLOCK) == 0) {
+    fcntl(inheritedRead_, F_SETFL, flags | O_NONBLOCK);
+  }
+  while (heldTokens_.size() + 1 < requested) {
+    char token = 0;
+    if (read(inheritedRead_, &token, 1) != 1) {
+      break;
+    }
+    heldTokens_.push_back(token);
+  }
+  if (flags != -1 && (flags & O_NONBLOCK) == 0) {
+    fcntl(inheritedRead_, F_SETFL, flags);
+  }
+
+  const std::size_t granted = heldTokens_.size() + 1;
+  if (granted < requested) {
+    spdlog::debug("jobserver granted {} of {} requested slots", granted,
+                  requested);
+  }
+  return granted;
+}
+
+std::string Jobserver::childMakeflags(const std::size_t slots) noexcept {
+  if (slots <= 1) {
+    return "";
+  }
+
+  if (hostFd_ < 0) {
+    std::string path =
+        (fs::temp_directory_path() / fmt::format("cabin-jobserver-{}",
+                                                 getpid()))
+            .string();
+    if (mkfifo(path.c_str(), 0600) != 0) {
+      return "";
+    }
+    const int fd = open(path.c_str(), O_RDWR | O_CLOEXEC); // NOLINT
+    if (fd < 0) {
+      unlink(path.c_str());
+      return "";
+    }
+    // One token per slot beyond the implicit one every client owns.
+    const std::string tokens(slots - 1, '+');
+    if (write(fd, tokens.data(), tokens.size())
+        != static_cast<ssize_t>(tokens.size())) {
+      close(fd);
+      unlink(path.c_str());
+      return "";
+    }
+    hostFd_ = fd;
+    hostPath_ = std::move(path);
+  }
+
+  return fmt::format("-j{} --jobserver-auth=fifo:{}", slots, hostPath_);
+}
+
+} // namespace cabin
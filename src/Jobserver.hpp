@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace cabin {
+
+/// Coarse-grained GNU make jobserver integration.  As a client, cabin
+/// claims its whole parallelism budget up front from an inherited token
+/// pipe (`--jobserver-auth` in $MAKEFLAGS) and holds the tokens for the
+/// run; as a host, it exposes a token fifo so spawned tools — ninja,
+/// recursive cabin, nested make — share one budget instead of each
+/// assuming the whole machine.
+class Jobserver {
+public:
+  Jobserver(const Jobserver&) = delete;
+  Jobserver& operator=(const Jobserver&) = delete;
+  Jobserver(Jobserver&&) noexcept = delete;
+  Jobserver& operator=(Jobserver&&) noexcept = delete;
+
+  static Jobserver& instance() noexcept;
+
+  /// Caps `requested` against an inherited jobserver: acquires up to
+  /// `requested - 1` tokens without blocking and returns one plus the
+  /// tokens obtained (every client owns one implicit slot).  Returns
+  /// `requested` unchanged when no jobserver was inherited.
+  std::size_t claimSlots(std::size_t requested) noexcept;
+
+  /// $MAKEFLAGS value advertising `slots` job slots to child processes,
+  /// creating the token fifo on first use.  Empty when `slots <= 1` or
+  /// the fifo cannot be created.
+  std::string childMakeflags(std::size_t slots) noexcept;
+
+private:
+  Jobserver() noexcept;
+  ~Jobserver() noexcept;
+
+  int inheritedRead_ = -1;  // token pipe from the parent jobserver
+  int inheritedWrite_ = -1; // where claimed tokens are returned
+  std::string heldTokens_;  // claimed token bytes, returned verbatim on exit
+
+  std::string hostPath_; // fifo advertised to children; empty until used
+  int hostFd_ = -1;      // keeps the fifo open so tokens persist
+};
+
+} // namespace cabin
@@ -1,15 +1,34 @@
 #include "Parallelism.hpp"
 
 #include "Diag.hpp"
+#include "GlobalConfig.hpp"
+#include "Jobserver.hpp"
 
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <sys/resource.h>
 #include <tbb/global_control.h>
 #include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#  include <sys/syscall.h>
+#endif
 
 namespace cabin {
 
 std::size_t numThreads() noexcept {
+  // A `[build] jobs` entry in the global config caps the default budget
+  // (shared machines, laptops); an explicit `-j` still overrides it via
+  // setParallelism.
+  const std::size_t configJobs = GlobalConfig::instance().defaultJobs();
+  if (configJobs > 0) {
+    return configJobs;
+  }
   const unsigned int numThreads = std::thread::hardware_concurrency();
   if (numThreads > 1) {
     return numThreads;
@@ -53,7 +72,10 @@ private:
 };
 
 void setParallelism(const std::size_t numThreads) noexcept {
-  ParallelismState::instance().set(numThreads);
+  // An inherited GNU make jobserver owns the machine-wide budget; claim
+  // our share from it instead of assuming the whole machine.
+  ParallelismState::instance().set(
+      Jobserver::instance().claimSlots(numThreads));
 }
 
 std::size_t getParallelism() noexcept {
@@ -62,4 +84,37 @@ std::size_t getParallelism() noexcept {
 
 bool isParallel() noexcept { return getParallelism() > 1; }
 
+void lowerProcessPriority(const int nice,
+                          const std::string_view ioClass) noexcept {
+  if (nice != 0) {
+    // Children inherit the niceness across fork/exec, so lowering cabin
+    // itself covers every compiler and linker it spawns.
+    if (setpriority(PRIO_PROCESS, 0, nice) == -1) {
+      Diag::warn("failed to set nice {}: {}", nice, strerror(errno));
+    } else {
+      spdlog::debug("running at nice {}", nice);
+    }
+  }
+
+  if (ioClass.empty()) {
+    return;
+  }
+#ifdef __linux__
+  // ioprio_set has no glibc wrapper.  Class 2 is best-effort, 3 is idle;
+  // the class sits in the top bits of the priority value.
+  constexpr int ioprioWhoProcess = 1;
+  constexpr int ioprioClassShift = 13;
+  const int ioprioClass = ioClass == "idle" ? 3 : 2;
+  if (syscall(SYS_ioprio_set, ioprioWhoProcess, 0,
+              ioprioClass << ioprioClassShift)
+      == -1) {
+    Diag::warn("failed to set io-class `{}`: {}", ioClass, strerror(errno));
+  } else {
+    spdlog::debug("running with `{}` IO priority", ioClass);
+  }
+#else
+  Diag::warn("io-class is not supported on this platform");
+#endif
+}
+
 } // namespace cabin
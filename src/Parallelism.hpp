@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace cabin {
 
@@ -12,4 +13,11 @@ void setParallelism(std::size_t numThreads) noexcept;
 std::size_t getParallelism() noexcept;
 bool isParallel() noexcept;
 
+/// Lowers the scheduling priority of this process -- and therefore of
+/// every child it spawns -- to keep full -j parallelism from starving
+/// interactive sessions on shared machines.  `nice` of 0 and an empty
+/// `ioClass` (`idle` or `best-effort`) each leave the inherited value
+/// alone.  Failures are logged, not fatal.
+void lowerProcessPriority(int nice, std::string_view ioClass) noexcept;
+
 } // namespace cabin
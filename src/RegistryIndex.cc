@@ -0,0 +1,363 @@
+#include "RegistryIndex.hpp"
+
+#include "Algos.hpp"
+#include "Builder/ScanCache.hpp"
+#include "Diag.hpp"
+#include "GlobalConfig.hpp"
+#include "HttpClient.hpp"
+#include "Semver.hpp"
+#include "VersionReq.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <rs/result.hpp>
+#include <span>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tbb/blocked_range.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <tbb/spin_mutex.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+namespace fs = std::filesystem;
+
+static constexpr std::string_view REGISTRY_URL =
+    "https://cabin.hasura.app/v1/graphql";
+
+// The global config can point syncs at a registry mirror.
+static std::string registryUrl() {
+  const std::string& mirror = GlobalConfig::instance().registryUrl();
+  return mirror.empty() ? std::string(REGISTRY_URL) : mirror;
+}
+static constexpr std::string_view EPOCH_TS = "1970-01-01T00:00:00+00:00";
+// How long a synced index stays fresh before the next search triggers an
+// incremental refresh.
+static constexpr std::chrono::seconds REFRESH_INTERVAL =
+    std::chrono::hours(24);
+static constexpr std::size_t SYNC_PAGE_SIZE = 500;
+
+static fs::path indexPath() {
+  if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+      xdgCacheHome != nullptr && *xdgCacheHome != '\0') {
+    return fs::path(xdgCacheHome) / "cabin" / "index" / "packages.json";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && *home != '\0') {
+    return fs::path(home) / ".cache" / "cabin" / "index" / "packages.json";
+  }
+  return {};
+}
+
+namespace {
+
+struct LoadedIndex {
+  std::vector<IndexEntry> entries;
+  std::string lastUpdate;    // registry timestamp of the newest synced row
+  std::int64_t syncedAt = 0; // unix seconds of the last successful refresh
+};
+
+} // namespace
+
+static std::optional<LoadedIndex> loadFile(const fs::path& path) {
+  nlohmann::json json;
+  try {
+    std::ifstream ifs(path);
+    json = nlohmann::json::parse(ifs);
+  } catch (const nlohmann::json::parse_error& e) {
+    spdlog::debug("discarding package index: {}", e.what());
+    return std::nullopt;
+  }
+
+  try {
+    if (!json.is_object() || json.value("version", 0) != 1) {
+      spdlog::debug("discarding package index: version mismatch");
+      return std::nullopt;
+    }
+    LoadedIndex loaded;
+    loaded.lastUpdate = json.value("lastUpdate", "");
+    loaded.syncedAt = json.value("syncedAt", std::int64_t(0));
+    for (const auto& pkg : json["packages"]) {
+      loaded.entries.push_back(IndexEntry{
+          .name = pkg["name"],
+          .versions = pkg["versions"],
+          .description = pkg.value("description", ""),
+      });
+    }
+    return loaded;
+  } catch (const nlohmann::json::exception& e) {
+    spdlog::debug("discarding package index: {}", e.what());
+    return std::nullopt;
+  }
+}
+
+static void saveFile(const fs::path& path, const LoadedIndex& loaded) {
+  nlohmann::json packages = nlohmann::json::array();
+  for (const IndexEntry& entry : loaded.entries) {
+    packages.push_back({ { "name", entry.name },
+                         { "versions", entry.versions },
+                         { "description", entry.description } });
+  }
+  nlohmann::json json;
+  json["version"] = 1;
+  json["lastUpdate"] = loaded.lastUpdate;
+  json["syncedAt"] = loaded.syncedAt;
+  json["packages"] = std::move(packages);
+
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  std::ofstream ofs(path, std::ios::trunc);
+  if (ofs.is_open()) {
+    ofs << json.dump();
+  }
+}
+
+/// Pulls every registry row updated since `loaded.lastUpdate` into
+/// `loaded.entries`, page by page, and advances `lastUpdate` to the
+/// newest timestamp seen.
+static rs::Result<void> fetchUpdates(LoadedIndex& loaded) {
+  std::unordered_map<std::string, std::size_t> byName;
+  for (std::size_t i = 0; i < loaded.entries.size(); ++i) {
+    byName.emplace(loaded.entries[i].name, i);
+  }
+
+  const std::string since =
+      loaded.lastUpdate.empty() ? std::string(EPOCH_TS) : loaded.lastUpdate;
+  std::string newest = loaded.lastUpdate;
+  std::size_t offset = 0;
+  for (;;) {
+    nlohmann::json req;
+    req["query"] =
+#include "GraphQL/AllPackages.gql"
+        ;
+    req["variables"]["since"] = since;
+    req["variables"]["limit"] = SYNC_PAGE_SIZE;
+    req["variables"]["offset"] = offset;
+
+    const std::string resStr = rs_try(HttpClient::instance().perform({
+        .url = registryUrl(),
+        .body = req.dump(),
+    }));
+    const nlohmann::json res = nlohmann::json::parse(resStr);
+    rs_ensure(res.contains("data") && res["data"].contains("packages"),
+              "unexpected registry response: {}", resStr);
+
+    const nlohmann::json& pkgs = res["data"]["packages"];
+    for (const auto& pkg : pkgs) {
+      const std::string name = pkg["name"];
+      const std::string version = pkg["version"];
+      const std::string description = pkg.value("description", "");
+      const std::string updatedAt = pkg.value("updated_at", "");
+
+      if (const auto it = byName.find(name); it != byName.end()) {
+        IndexEntry& entry = loaded.entries[it->second];
+        entry.description = description;
+        if (std::ranges::find(entry.versions, version)
+            == entry.versions.end()) {
+          entry.versions.push_back(version);
+        }
+      } else {
+        byName.emplace(name, loaded.entries.size());
+        loaded.entries.push_back(IndexEntry{
+            .name = name,
+            .versions = { version },
+            .description = description,
+        });
+      }
+      // ISO 8601 timestamps compare lexicographically.
+      if (updatedAt > newest) {
+        newest = updatedAt;
+      }
+    }
+
+    if (pkgs.size() < SYNC_PAGE_SIZE) {
+      break;
+    }
+    offset += SYNC_PAGE_SIZE;
+  }
+
+  loaded.lastUpdate = std::move(newest);
+  return rs::Ok();
+}
+
+rs::Result<RegistryIndex> RegistryIndex::load() noexcept {
+  const fs::path path = indexPath();
+  LoadedIndex loaded;
+  if (!path.empty() && fs::exists(path)) {
+    if (auto cached = loadFile(path)) {
+      loaded = std::move(*cached);
+    }
+  }
+
+  const std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now()
+                                   .time_since_epoch())
+                               .count();
+  const bool fresh = loaded.syncedAt != 0
+                     && now - loaded.syncedAt < REFRESH_INTERVAL.count();
+
+  if (!fresh) {
+    rs::Result<void> refreshed = rs::Ok();
+    try {
+      refreshed = fetchUpdates(loaded);
+    } catch (const std::exception& e) {
+      refreshed = rs::Err(rs::anyhow("{}", e.what()));
+    }
+    if (refreshed.is_err()) {
+      // A stale index still answers searches; only a missing one is
+      // fatal.
+      rs_ensure(!loaded.entries.empty(), "failed to sync package index: {}",
+                refreshed.unwrap_err()->what());
+      Diag::warn("using stale package index: {}",
+                 refreshed.unwrap_err()->what());
+    } else {
+      loaded.syncedAt = now;
+      if (!path.empty()) {
+        saveFile(path, loaded);
+      }
+    }
+  }
+
+  RegistryIndex index;
+  index.entries = std::move(loaded.entries);
+  return rs::Ok(std::move(index));
+}
+
+std::vector<const IndexEntry*>
+RegistryIndex::search(const std::string_view query) const noexcept {
+  const auto lowered = [](const std::string_view str) {
+    std::string out;
+    out.reserve(str.size());
+    for (const char c : str) {
+      out += toLower(c);
+    }
+    return out;
+  };
+  const std::string loweredQuery = lowered(query);
+
+  std::vector<const IndexEntry*> results;
+  for (const IndexEntry& entry : entries) {
+    if (lowered(entry.name).find(loweredQuery) != std::string::npos
+        || lowered(entry.description).find(loweredQuery)
+               != std::string::npos) {
+      results.push_back(&entry);
+    }
+  }
+  if (!results.empty()) {
+    return results;
+  }
+
+  // No substring hit: fall back to a fuzzy pass over names for typos.
+  std::vector<std::string_view> names;
+  names.reserve(entries.size());
+  for (const IndexEntry& entry : entries) {
+    names.push_back(entry.name);
+  }
+  if (const auto similar = findSimilarStr(query, names)) {
+    for (const IndexEntry& entry : entries) {
+      if (entry.name == similar.value()) {
+        results.push_back(&entry);
+      }
+    }
+  }
+  return results;
+}
+
+// Best-match verdict for one requirement against one candidate list,
+// memoized on (requirement, candidate-list digest) for the whole run.
+// nullopt means no candidate satisfies the requirement.
+static rs::Result<std::optional<std::string>>
+resolveBest(const std::string& req, std::span<const std::string> versions) {
+  static tbb::spin_mutex memoMtx;
+  static std::unordered_map<std::string, std::optional<std::string>> memo;
+
+  std::string joined;
+  for (const std::string& ver : versions) {
+    joined += ver;
+    joined += '\x1f';
+  }
+  const std::string key = fmt::format("{}\x1f{}", req, digestString(joined));
+  {
+    const tbb::spin_mutex::scoped_lock lock(memoMtx);
+    if (const auto found = memo.find(key); found != memo.end()) {
+      return rs::Ok(found->second);
+    }
+  }
+
+  std::vector<std::string_view> views(versions.begin(), versions.end());
+  const std::vector<Version> parsed = rs_try(Version::parseMany(views));
+  const CompiledVersionReq compiled =
+      rs_try(VersionReq::parse(req)).compile();
+
+  // matchAll packs one bit per candidate; pick the highest matching
+  // version rather than trusting registry order.
+  const std::vector<uint64_t> bits = compiled.matchAll(parsed);
+  std::optional<std::size_t> best;
+  for (std::size_t i = 0; i < parsed.size(); ++i) {
+    if ((bits[i / 64] & (uint64_t{ 1 } << (i % 64))) == 0) {
+      continue;
+    }
+    if (!best.has_value() || parsed[*best] < parsed[i]) {
+      best = i;
+    }
+  }
+  std::optional<std::string> result;
+  if (best.has_value()) {
+    result = versions[*best];
+  }
+
+  const tbb::spin_mutex::scoped_lock lock(memoMtx);
+  return rs::Ok(memo.emplace(key, std::move(result)).first->second);
+}
+
+rs::Result<std::vector<std::string>> RegistryIndex::resolveAll(
+    const std::span<const std::pair<std::string, std::string>> reqs)
+    const noexcept {
+  std::vector<std::string> resolved(reqs.size());
+  tbb::concurrent_vector<std::string> errors;
+
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, reqs.size()),
+      [&](const tbb::blocked_range<std::size_t>& rng) {
+        for (std::size_t i = rng.begin(); i != rng.end(); ++i) {
+          const auto& [name, req] = reqs[i];
+          const auto entry =
+              std::ranges::find(entries, name, &IndexEntry::name);
+          if (entry == entries.end()) {
+            errors.push_back(fmt::format(
+                "package `{}` not found in the registry index", name));
+            continue;
+          }
+          auto best = resolveBest(req, entry->versions);
+          if (best.is_err()) {
+            errors.push_back(fmt::format("{}: {}", name,
+                                         best.unwrap_err()->what()));
+          } else if (!best.unwrap().has_value()) {
+            errors.push_back(fmt::format(
+                "no version of `{}` satisfies `{}`", name, req));
+          } else {
+            resolved[i] = *best.unwrap();
+          }
+        }
+      });
+
+  rs_ensure(errors.empty(), "{}", fmt::join(errors, "\n"));
+  return rs::Ok(std::move(resolved));
+}
+
+} // namespace cabin
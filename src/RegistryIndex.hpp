@@ -0,0 +1,52 @@
+#pragma once
+
+#include <rs/result.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cabin {
+
+/// One package in the local registry index.
+struct IndexEntry {
+  std::string name;
+  std::vector<std::string> versions; // in registry order, newest last
+  std::string description;
+};
+
+/// Local mirror of the registry's package list, kept under
+/// `~/.cache/cabin/index` so searches run against local data and the
+/// network is only touched to refresh.  Refreshes are incremental: only
+/// packages updated since the last synced registry timestamp are
+/// fetched.
+class RegistryIndex {
+public:
+  /// Loads the on-disk index, refreshing it from the registry when it is
+  /// missing or older than the refresh interval.  A failed refresh falls
+  /// back to the stale index when one exists.
+  static rs::Result<RegistryIndex> load() noexcept;
+
+  /// Case-insensitive substring search over names and descriptions, with
+  /// a findSimilarStr fuzzy pass over names when nothing matches.
+  /// `query` must be non-empty; results keep index order.
+  std::vector<const IndexEntry*> search(std::string_view query) const noexcept;
+
+  /// Resolves each (package, requirement) pair to the highest indexed
+  /// version satisfying the requirement.  Pairs are evaluated in
+  /// parallel, and verdicts are memoized on (requirement,
+  /// candidate-list digest) for the rest of the run, so dependencies
+  /// sharing a requirement against the same candidate list match once.
+  /// Results keep input order; any failure names its pair.
+  rs::Result<std::vector<std::string>>
+  resolveAll(std::span<const std::pair<std::string, std::string>> reqs)
+      const noexcept;
+
+private:
+  RegistryIndex() noexcept = default;
+
+  std::vector<IndexEntry> entries;
+};
+
+} // namespace cabin
@@ -25,6 +25,33 @@ int main() {
     expect(!tests::fs::exists(outDir / "Makefile"));
   };
 
+  "cabin build no-op takes the fresh-token fast path"_test = [] {
+    const tests::TempDir tmp;
+    tests::runCabin({ "new", "fresh" }, tmp.path).unwrap();
+    const auto project = tmp.path / "fresh";
+
+    const auto first = tests::runCabin({ "build" }, project).unwrap();
+    expect(first.status.success()) << first.status.toString();
+    const auto outDir = project / "cabin-out" / "dev";
+    expect(tests::fs::is_regular_file(outDir / "fresh-token.json"));
+
+    const auto second = tests::runCabin({ "build" }, project).unwrap();
+    expect(second.status.success()) << second.status.toString();
+    expect(second.err.find("target(s) are up to date") != std::string::npos)
+        << second.err;
+
+    // Touching a source invalidates the token path; the build must run
+    // for real again.
+    {
+      std::ofstream ofs(project / "src" / "main.cc", std::ios::app);
+      ofs << "// edited\n";
+    }
+    const auto third = tests::runCabin({ "build" }, project).unwrap();
+    expect(third.status.success()) << third.status.toString();
+    expect(third.err.find("target(s) are up to date") == std::string::npos)
+        << third.err;
+  };
+
   "cabin build handles src-only packages"_test = [] {
     const tests::TempDir tmp;
     tests::runCabin({ "new", "binary_only" }, tmp.path).unwrap();
@@ -76,6 +76,50 @@ int main() {
     expect(implContent.contains("namespace my_lib"));
   };
 
+  "cabin new synthetic"_test = [] {
+    const tests::TempDir tmp;
+    const auto result =
+        tests::runCabin({ "new", "--synthetic", "files=10,headers=5,fanout=2",
+                          "fixture" },
+                        tmp.path)
+            .unwrap();
+
+    expect(result.status.success()) << result.status.toString();
+
+    const auto project = tmp.path / "fixture";
+    expect(tests::fs::is_regular_file(project / "cabin.toml"));
+    expect(tests::fs::is_regular_file(project / "src/main.cc"));
+    for (int i = 0; i < 5; ++i) {
+      expect(tests::fs::is_regular_file(
+          project / "include/fixture" / ("h" + std::to_string(i) + ".hpp")));
+    }
+    for (int i = 0; i < 10; ++i) {
+      expect(tests::fs::is_regular_file(
+          project / "src/mod0" / ("f" + std::to_string(i) + ".cc")));
+    }
+
+    // Each source includes exactly `fanout` headers.
+    const auto source = tests::readFile(project / "src/mod0/f0.cc");
+    expect(source.contains("#include \"fixture/h0.hpp\""));
+
+    auto sanitizedErr = tests::sanitizeOutput(result.err);
+    const std::string expectedErr =
+        "     Created synthetic package `fixture` (10 sources, 5 headers, "
+        "fanout 2)\n";
+    expect(sanitizedErr == expectedErr);
+  };
+
+  "cabin new synthetic rejects bad spec"_test = [] {
+    const tests::TempDir tmp;
+    const auto result =
+        tests::runCabin({ "new", "--synthetic", "files=ten", "fixture" },
+                        tmp.path)
+            .unwrap();
+
+    expect(!result.status.success());
+    expect(result.err.contains("invalid synthetic spec value"));
+  };
+
   "cabin new requires name"_test = [] {
     const tests::TempDir tmp;
     const auto result = tests::runCabin({ "new" }, tmp.path).unwrap();
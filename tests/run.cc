@@ -49,4 +49,22 @@ int main() {
     expect(result.err.contains("Finished `dev` profile"));
     expect(result.err.contains("Running `cabin-out/dev/hello_world`"));
   };
+
+  "cabin run warm"_test = [] {
+    const tests::TempDir tmp;
+    tests::runCabin({ "new", "hello_world" }, tmp.path).unwrap();
+
+    const auto project = tmp.path / "hello_world";
+    tests::runCabin({ "run" }, project).unwrap();
+
+    // Nothing changed: the fresh token memoizes the binary, so the second
+    // run execs straight away without re-planning.
+    const auto result = tests::runCabin({ "run" }, project).unwrap();
+    expect(result.status.success()) << result.status.toString();
+    const auto sanitizedOut = tests::sanitizeOutput(result.out);
+    expect(sanitizedOut == "Hello, world!\n") << sanitizedOut;
+    const auto sanitizedErr = tests::sanitizeOutput(result.err);
+    expect(sanitizedErr == "     Running `cabin-out/dev/hello_world`\n")
+        << sanitizedErr;
+  };
 }
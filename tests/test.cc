@@ -433,4 +433,49 @@ return 0;
                          .numFailed = 0,
                          .numFiltered = 1 }));
   };
+
+  "cabin test --combined links one runner binary"_test = [] {
+    const tests::TempDir tmp;
+    tests::runCabin({ "new", "combined_project" }, tmp.path).unwrap();
+    const auto project = tmp.path / "combined_project";
+
+    tests::writeFile(project / "src/main.cc",
+                     R"(#include <iostream>
+
+#ifdef CABIN_TEST
+int main() {
+  std::cout << "combined main test ... ok" << std::endl;
+  return 0;
+}
+#else
+int main() {
+  std::cout << "Hello, world!" << std::endl;
+  return 0;
+}
+#endif
+)");
+
+    tests::writeFile(project / "src/Other.cc",
+                     R"(#include <iostream>
+
+#ifdef CABIN_TEST
+int main() {
+  std::cout << "combined other test ... ok" << std::endl;
+  return 0;
+}
+#endif
+)");
+
+    const auto result =
+        tests::runCabin({ "test", "--combined" }, project).unwrap();
+    expect(result.status.success()) << result.status.toString();
+    const auto sanitizedOut = tests::sanitizeOutput(result.out);
+    expect(sanitizedOut.contains("combined main test ... ok"));
+    expect(sanitizedOut.contains("combined other test ... ok"));
+
+    const auto unitDir = project / "cabin-out" / "test" / "unit";
+    expect(tests::fs::is_regular_file(unitDir / "cabin-test-runner"));
+    expect(!tests::fs::exists(unitDir / "src" / "main.cc.test"));
+    expect(!tests::fs::exists(unitDir / "src" / "Other.cc.test"));
+  };
 }